@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "datatype_conversion.h"
+#include "packet_validator.h"
 
 static std::atomic<bool> running = true;
 static constexpr bool kPrintChannelOutput = false;
@@ -58,57 +59,68 @@ ChannelSim::ChannelSim(const Config* const config_bs,
   ul_data_plus_pilot_symbols_ =
       bscfg_->Frame().NumULSyms() + bscfg_->Frame().NumPilotSyms();
 
+  const size_t frame_wnd = bscfg_->FrameWnd();
   server_bs_.resize(bs_socket_num_);
   client_bs_.resize(bs_socket_num_);
   server_ue_.resize(user_socket_num_);
   client_ue_.resize(user_socket_num_);
 
   task_queue_bs_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * dl_data_plus_beacon_symbols_ * bscfg_->BsAntNum() *
+      frame_wnd * dl_data_plus_beacon_symbols_ * bscfg_->BsAntNum() *
       kDefaultQueueSize);
   task_queue_user_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * ul_data_plus_pilot_symbols_ * uecfg_->UeAntNum() *
+      frame_wnd * ul_data_plus_pilot_symbols_ * uecfg_->UeAntNum() *
       kDefaultQueueSize);
   message_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * bscfg_->Frame().NumTotalSyms() *
+      frame_wnd * bscfg_->Frame().NumTotalSyms() *
       (bscfg_->BsAntNum() + uecfg_->UeAntNum()) * kDefaultQueueSize);
 
   assert(bscfg_->PacketLength() == uecfg_->PacketLength());
   payload_length_ = bscfg_->PacketLength() - Packet::kOffsetOfData;
 
   // initialize bs-facing and client-facing data buffers
-  size_t tx_buffer_ue_size = kFrameWnd * dl_data_plus_beacon_symbols_ *
+  size_t tx_buffer_ue_size = frame_wnd * dl_data_plus_beacon_symbols_ *
                              uecfg_->UeAntNum() * payload_length_;
   tx_buffer_ue_.resize(tx_buffer_ue_size);
 
-  size_t tx_buffer_bs_size = kFrameWnd * ul_data_plus_pilot_symbols_ *
+  size_t tx_buffer_bs_size = frame_wnd * ul_data_plus_pilot_symbols_ *
                              bscfg_->BsAntNum() * payload_length_;
   tx_buffer_bs_.resize(tx_buffer_bs_size);
 
-  size_t rx_buffer_ue_size = kFrameWnd * ul_data_plus_pilot_symbols_ *
+  size_t rx_buffer_ue_size = frame_wnd * ul_data_plus_pilot_symbols_ *
                              uecfg_->UeAntNum() * payload_length_;
   rx_buffer_ue_.resize(rx_buffer_ue_size);
 
-  size_t rx_buffer_bs_size = kFrameWnd * dl_data_plus_beacon_symbols_ *
+  size_t rx_buffer_bs_size = frame_wnd * dl_data_plus_beacon_symbols_ *
                              bscfg_->BsAntNum() * payload_length_;
   rx_buffer_bs_.resize(rx_buffer_bs_size);
 
   // initilize rx and tx counters
-  bs_rx_counter_ = new size_t[dl_data_plus_beacon_symbols_ * kFrameWnd];
+  bs_rx_counter_ = new size_t[dl_data_plus_beacon_symbols_ * frame_wnd];
   std::memset(bs_rx_counter_, 0,
-              sizeof(size_t) * dl_data_plus_beacon_symbols_ * kFrameWnd);
+              sizeof(size_t) * dl_data_plus_beacon_symbols_ * frame_wnd);
 
-  user_rx_counter_ = new size_t[ul_data_plus_pilot_symbols_ * kFrameWnd];
+  user_rx_counter_ = new size_t[ul_data_plus_pilot_symbols_ * frame_wnd];
   std::memset(user_rx_counter_, 0,
-              sizeof(size_t) * ul_data_plus_pilot_symbols_ * kFrameWnd);
+              sizeof(size_t) * ul_data_plus_pilot_symbols_ * frame_wnd);
 
-  bs_tx_counter_.fill(0);
-  user_tx_counter_.fill(0);
+  bs_tx_counter_.assign(frame_wnd, 0);
+  user_tx_counter_.assign(frame_wnd, 0);
 
   // Initialize channel
   channel_ = std::make_unique<Channel>(config_bs, config_ue, channel_type_,
                                        channel_snr_);
 
+  // The BS side exchanges packets with Agora through shared memory if
+  // enabled, and the UE side always uses sockets
+  if ((bscfg_->UseIoUring() == false) && (bscfg_->UseShmTransport() == true)) {
+    shm_transport_ = std::make_unique<ShmTransport>(
+        bscfg_->ShmName(), false /* create */, bscfg_->NumRadios(),
+        bscfg_->ShmRingSlots(),
+        std::max(bscfg_->PacketLength(), bscfg_->DlPacketLength()));
+    shm_tx_mutexes_ = std::make_unique<std::mutex[]>(bscfg_->NumRadios());
+  }
+
   for (size_t i = 0; i < worker_thread_num; i++) {
     task_ptok_[i] = new moodycamel::ProducerToken(message_queue_);
   }
@@ -197,7 +209,7 @@ void ChannelSim::Start() {
               total_symbol_id = ul_symbol_id + bscfg_->Frame().NumPilotSyms();
             }
             size_t frame_offset =
-                (frame_id % kFrameWnd) * ul_data_plus_pilot_symbols_ +
+                bscfg_->FrameSlot(frame_id) * ul_data_plus_pilot_symbols_ +
                 total_symbol_id;
             user_rx_counter_[frame_offset]++;
             // when received all client antennas on this symbol, kick-off BS TX
@@ -218,7 +230,7 @@ void ChannelSim::Start() {
                      gen_tag_t::TagType::kAntennas) {
             size_t dl_symbol_id = GetDlSymbolIdx(symbol_id);
             size_t frame_offset =
-                (frame_id % kFrameWnd) * dl_data_plus_beacon_symbols_ +
+                bscfg_->FrameSlot(frame_id) * dl_data_plus_beacon_symbols_ +
                 dl_symbol_id;
             bs_rx_counter_[frame_offset]++;
 
@@ -240,7 +252,7 @@ void ChannelSim::Start() {
 
         case EventType::kPacketTX: {
           size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-          size_t offset = frame_id % kFrameWnd;
+          size_t offset = bscfg_->FrameSlot(frame_id);
           if (gen_tag_t(event.tags_[0]).tag_type_ ==
               gen_tag_t::TagType::kUsers) {
             user_tx_counter_[offset]++;
@@ -302,6 +314,9 @@ void* ChannelSim::TaskThread(int tid) {
 }
 
 void* ChannelSim::BsRxLoop(int tid) {
+  if (shm_transport_ != nullptr) {
+    return BsRxLoopShm(tid);
+  }
   size_t socket_lo = tid * bs_socket_num_ / bs_thread_num_;
   size_t socket_hi = (tid + 1) * bs_socket_num_ / bs_thread_num_;
 
@@ -331,30 +346,10 @@ void* ChannelSim::BsRxLoop(int tid) {
       std::printf("BS socket %zu receive failed\n", socket_id);
       throw std::runtime_error("ChannelSim: BS socket receive failed");
     } else if (static_cast<size_t>(rx_bytes) == udp_pkt_buf.size()) {
-      const auto* pkt = reinterpret_cast<Packet*>(&udp_pkt_buf[0]);
-
-      size_t frame_id = pkt->frame_id_;
-      size_t symbol_id = pkt->symbol_id_;
-      size_t ant_id = pkt->ant_id_;
       if (kDebugPrintInTask) {
-        std::printf(
-            "Received BS packet for frame %zu, symbol %zu, ant %zu from "
-            "socket %zu\n",
-            frame_id, symbol_id, ant_id, socket_id);
+        std::printf("Received BS packet from socket %zu\n", socket_id);
       }
-      size_t dl_symbol_id = GetDlSymbolIdx(symbol_id);
-      size_t symbol_offset =
-          (frame_id % kFrameWnd) * dl_data_plus_beacon_symbols_ + dl_symbol_id;
-      size_t offset = symbol_offset * bscfg_->BsAntNum() + ant_id;
-      std::memcpy(&rx_buffer_bs_[offset * payload_length_], pkt->data_,
-                  payload_length_);
-
-      RtAssert(message_queue_.enqueue(
-                   local_ptok,
-                   EventData(
-                       EventType::kPacketRX,
-                       gen_tag_t::FrmSymAnt(frame_id, symbol_id, ant_id).tag_)),
-               "BS socket message enqueue failed!");
+      BsRxPacket(reinterpret_cast<Packet*>(&udp_pkt_buf[0]), local_ptok);
       if (++socket_id == socket_hi) {
         socket_id = socket_lo;
       }
@@ -368,6 +363,53 @@ void* ChannelSim::BsRxLoop(int tid) {
   return nullptr;
 }
 
+void* ChannelSim::BsRxLoopShm(int tid) {
+  // Each downlink ring has one consumer, so threads split the radios
+  const size_t radio_lo = tid * bscfg_->NumRadios() / bs_thread_num_;
+  const size_t radio_hi = (tid + 1) * bscfg_->NumRadios() / bs_thread_num_;
+
+  moodycamel::ProducerToken local_ptok(message_queue_);
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_ + 1, tid);
+  std::printf("BS RX thread %d: receiving from the rings of radios %zu-%zu\n",
+              tid, radio_lo, radio_hi);
+
+  while (running) {
+    for (size_t radio_id = radio_lo; radio_id < radio_hi; radio_id++) {
+      ShmRing& ring = shm_transport_->Downlink(radio_id);
+      const uint8_t* slot = ring.Front();
+      if (slot != nullptr) {
+        BsRxPacket(reinterpret_cast<const Packet*>(slot), local_ptok);
+        ring.Pop();
+      }
+    }
+  }
+  return nullptr;
+}
+
+void ChannelSim::BsRxPacket(const Packet* pkt,
+                            moodycamel::ProducerToken& ptok) {
+  size_t frame_id = pkt->frame_id_;
+  size_t symbol_id = pkt->symbol_id_;
+  size_t ant_id = pkt->ant_id_;
+  if (kDebugPrintInTask) {
+    std::printf("Received BS packet for frame %zu, symbol %zu, ant %zu\n",
+                frame_id, symbol_id, ant_id);
+  }
+  size_t dl_symbol_id = GetDlSymbolIdx(symbol_id);
+  size_t symbol_offset =
+      bscfg_->FrameSlot(frame_id) * dl_data_plus_beacon_symbols_ +
+      dl_symbol_id;
+  size_t offset = symbol_offset * bscfg_->BsAntNum() + ant_id;
+  std::memcpy(&rx_buffer_bs_[offset * payload_length_], pkt->data_,
+              payload_length_);
+
+  RtAssert(message_queue_.enqueue(
+               ptok, EventData(EventType::kPacketRX,
+                               gen_tag_t::FrmSymAnt(frame_id, symbol_id,
+                                                    ant_id).tag_)),
+           "BS socket message enqueue failed!");
+}
+
 void* ChannelSim::UeRxLoop(int tid) {
   size_t socket_lo = tid * user_socket_num_ / user_thread_num_;
   size_t socket_hi = (tid + 1) * user_socket_num_ / user_thread_num_;
@@ -419,7 +461,7 @@ void* ChannelSim::UeRxLoop(int tid) {
             frame_id, symbol_id, ant_id, socket_id);
       }
       size_t symbol_offset =
-          (frame_id % kFrameWnd) * ul_data_plus_pilot_symbols_ +
+          bscfg_->FrameSlot(frame_id) * ul_data_plus_pilot_symbols_ +
           total_symbol_id;
       size_t offset = symbol_offset * uecfg_->UeAntNum() + ant_id;
       std::memcpy(&rx_buffer_ue_[offset * payload_length_], pkt->data_,
@@ -449,7 +491,7 @@ void ChannelSim::DoTx(size_t frame_id, size_t symbol_id, size_t max_ant,
                       std::vector<char>& tx_buffer, size_t buffer_offset,
                       std::vector<std::unique_ptr<UDPClient>>& udp_clients,
                       const std::string& dest_address, size_t dest_port,
-                      arma::cx_fmat& format_dest) {
+                      arma::cx_fmat& format_dest, ShmTransport* shm_transport) {
   auto* dst_ptr = reinterpret_cast<short*>(&tx_buffer.at(buffer_offset));
   SimdConvertFloatToShort(reinterpret_cast<float*>(format_dest.memptr()),
                           dst_ptr, 2 * bscfg_->SampsPerSymbol() * max_ant);
@@ -461,11 +503,31 @@ void ChannelSim::DoTx(size_t frame_id, size_t symbol_id, size_t max_ant,
     pkt->symbol_id_ = symbol_id;
     pkt->ant_id_ = ant_id;
     pkt->cell_id_ = 0;
+    pkt->magic_ = Packet::kMagic;
     std::memcpy(pkt->data_,
                 &tx_buffer[buffer_offset + ant_id * payload_length_],
                 payload_length_);
-    udp_clients.at(ant_id)->Send(dest_address, dest_port + ant_id,
-                                 udp_pkt_buf.data(), udp_pkt_buf.size());
+    if (bscfg_->PacketChecksum() == true) {
+      PacketValidator::StampChecksum(pkt, udp_pkt_buf.size());
+    }
+    if (shm_transport != nullptr) {
+      // Task threads share each radio's uplink ring, which has room for one
+      // producer only
+      const size_t radio_id = ant_id / bscfg_->NumChannels();
+      std::lock_guard<std::mutex> lock(shm_tx_mutexes_[radio_id]);
+      ShmRing& ring = shm_transport->Uplink(radio_id);
+      uint8_t* slot = ring.Reserve();
+      while ((slot == nullptr) && (running == true)) {
+        slot = ring.Reserve();
+      }
+      if (slot != nullptr) {
+        std::memcpy(slot, udp_pkt_buf.data(), udp_pkt_buf.size());
+        ring.Commit();
+      }
+    } else {
+      udp_clients.at(ant_id)->Send(dest_address, dest_port + ant_id,
+                                   udp_pkt_buf.data(), udp_pkt_buf.size());
+    }
   }
 }
 
@@ -488,7 +550,8 @@ void ChannelSim::DoTxBs(int tid, size_t tag) {
   }
 
   size_t symbol_offset =
-      (frame_id % kFrameWnd) * ul_data_plus_pilot_symbols_ + total_symbol_id;
+      bscfg_->FrameSlot(frame_id) * ul_data_plus_pilot_symbols_ +
+      total_symbol_id;
   size_t total_offset_ue = symbol_offset * payload_length_ * uecfg_->UeAntNum();
   size_t total_offset_bs = symbol_offset * payload_length_ * bscfg_->BsAntNum();
 
@@ -516,7 +579,8 @@ void ChannelSim::DoTxBs(int tid, size_t tag) {
   }
 
   DoTx(frame_id, symbol_id, bscfg_->BsAntNum(), tx_buffer_bs_, total_offset_bs,
-       client_bs_, bscfg_->BsServerAddr(), bscfg_->BsServerPort(), fmat_dst);
+       client_bs_, bscfg_->BsServerAddr(), bscfg_->BsServerPort(), fmat_dst,
+       shm_transport_.get());
 
   RtAssert(message_queue_.enqueue(
                *task_ptok_[tid],
@@ -538,7 +602,7 @@ void ChannelSim::DoTxUser(int tid, size_t tag) {
   }
 
   size_t symbol_offset =
-      (frame_id % kFrameWnd) * dl_data_plus_beacon_symbols_ + dl_symbol_id;
+      bscfg_->FrameSlot(frame_id) * dl_data_plus_beacon_symbols_ + dl_symbol_id;
   size_t total_offset_ue = symbol_offset * payload_length_ * uecfg_->UeAntNum();
   size_t total_offset_bs = symbol_offset * payload_length_ * bscfg_->BsAntNum();
 
@@ -11,6 +11,7 @@
 #include <armadillo>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <numeric>
 
 #include "buffer.h"
@@ -19,6 +20,7 @@
 #include "config.h"
 #include "gettime.h"
 #include "memory_manage.h"
+#include "shm_transport.h"
 #include "signal_handler.h"
 #include "symbols.h"
 #include "udp_client.h"
@@ -48,6 +50,9 @@ class ChannelSim {
   // Loop thread receiving symbols from BS antennas
   void* BsRxLoop(int tid);
 
+  // BsRxLoop in shared memory mode, receiving from downlink rings
+  void* BsRxLoopShm(int tid);
+
   // Transmits symbol to BS antennas after applying channel
   void DoTxBs(int tid, size_t tag);
 
@@ -64,13 +69,23 @@ class ChannelSim {
             std::vector<char>& tx_buffer, size_t buffer_offset,
             std::vector<std::unique_ptr<UDPClient>>& udp_clients,
             const std::string& dest_address, size_t dest_port,
-            arma::cx_fmat& format_dest);
+            arma::cx_fmat& format_dest, ShmTransport* shm_transport = nullptr);
+
+  // Copy a packet received from the BS into the downlink receive buffer and
+  // notify the master thread
+  void BsRxPacket(const Packet* pkt, moodycamel::ProducerToken& ptok);
 
   // BS-facing sending clients
   std::vector<std::unique_ptr<UDPClient>> client_bs_;
   // BS-facing sockets
   std::vector<std::unique_ptr<UDPServer>> server_bs_;
 
+  // BS-facing shared memory rings, in place of the BS-facing sockets in
+  // shared memory mode
+  std::unique_ptr<ShmTransport> shm_transport_;
+  // Serialize the task threads producing into each radio's uplink ring
+  std::unique_ptr<std::mutex[]> shm_tx_mutexes_;
+
   // UE-facing sending clients
   std::vector<std::unique_ptr<UDPClient>> client_ue_;
   // UE-facing sockets
@@ -120,8 +135,8 @@ class ChannelSim {
 
   size_t* bs_rx_counter_;
   size_t* user_rx_counter_;
-  std::array<size_t, kFrameWnd> bs_tx_counter_;
-  std::array<size_t, kFrameWnd> user_tx_counter_;
+  std::vector<size_t> bs_tx_counter_;
+  std::vector<size_t> user_tx_counter_;
 
   inline size_t GetDlSymbolIdx(size_t symbol_id) const {
     if (symbol_id == 0) {
@@ -4,15 +4,19 @@
  */
 #include "sender.h"
 
+#include <arpa/inet.h>
+
 #include <algorithm>
+#include <random>
 #include <thread>
 
 #include "datatype_conversion.h"
 #include "logger.h"
+#include "packet_validator.h"
 #include "udp_client.h"
 
-#if defined(USE_DPDK)
-#include <arpa/inet.h>
+#if !defined(USE_DPDK)
+#include "uring_transport.h"
 #endif
 
 static constexpr bool kDebugPrintSender = false;
@@ -36,12 +40,13 @@ void DelayTicks(uint64_t start, uint64_t ticks) {
 Sender::Sender(Config* cfg, size_t socket_thread_num, size_t core_offset,
                size_t frame_duration, size_t inter_frame_delay,
                size_t enable_slow_start, const std::string& server_mac_addr_str,
-               bool create_thread_for_master)
+               bool create_thread_for_master, double drop_rate)
     : cfg_(cfg),
       freq_ghz_(GetTime::MeasureRdtscFreq()),
       ticks_per_usec_(freq_ghz_ * 1e3),
       socket_thread_num_(socket_thread_num),
       enable_slow_start_(enable_slow_start),
+      drop_rate_(drop_rate),
       core_offset_(core_offset),
       inter_frame_delay_(inter_frame_delay),
       ticks_inter_frame_(inter_frame_delay_ * ticks_per_usec_) {
@@ -62,11 +67,12 @@ Sender::Sender(Config* cfg, size_t socket_thread_num, size_t core_offset,
 
   MLPD_INFO(
       "Initializing sender, sending to base station server at %s, frame "
-      "duration = %.2f ms, slow start = %s\n",
+      "duration = %.2f ms, slow start = %s, drop rate = %.4f\n",
       cfg->BsServerAddr().c_str(), frame_duration / 1000.0,
-      enable_slow_start == 1 ? "yes" : "no");
+      enable_slow_start == 1 ? "yes" : "no", drop_rate);
 
   unused(server_mac_addr_str);
+  packet_count_per_symbol_.resize(cfg->FrameWnd());
   for (auto& i : packet_count_per_symbol_) {
     i = new size_t[cfg->Frame().NumTotalSyms()]();
   }
@@ -129,6 +135,14 @@ Sender::Sender(Config* cfg, size_t socket_thread_num, size_t core_offset,
     std::printf("Number of DPDK cores: %d\n", rte_lcore_count());
   }
 
+#else
+  if ((cfg->UseIoUring() == false) && (cfg->UseShmTransport() == true)) {
+    // Waits for the server to create the region
+    shm_transport_ = std::make_unique<ShmTransport>(
+        cfg->ShmName(), false /* create */, cfg->NumRadios(),
+        cfg->ShmRingSlots(),
+        std::max(cfg->PacketLength(), cfg->DlPacketLength()));
+  }
 #endif
   num_workers_ready_atomic.store(0);
 }
@@ -224,7 +238,7 @@ void* Sender::MasterThread(int /*unused*/) {
     gen_tag_t ctag(0);  // The completion tag
     int ret = static_cast<int>(completion_queue_.try_dequeue(ctag.tag_));
     if (ret > 0) {
-      const size_t comp_frame_slot = (ctag.frame_id_ % kFrameWnd);
+      const size_t comp_frame_slot = cfg_->FrameSlot(ctag.frame_id_);
       packet_count_per_symbol_[comp_frame_slot][ctag.symbol_id_]++;
 
       if (kDebugPrintSender == true) {
@@ -333,14 +347,39 @@ void* Sender::WorkerThread(int tid) {
   rte_mbuf* tx_mbufs[kDequeueBulkSize];
 #else
   UDPClient udp_client;
+  // In io_uring mode, each packet of a batch has its own buffer and message,
+  // and the whole batch is sent with one submission
+  std::unique_ptr<Uring> uring;
+  UringSendMsg send_msgs[kDequeueBulkSize];
+  std::vector<sockaddr_in> server_addrs;
+  // In GSO mode, each packet of a batch has its own buffer, and the whole
+  // batch is sent to one radio's port with one send
+  const bool use_gso = (cfg_->UseIoUring() == false) &&
+                       (shm_transport_ == nullptr) && (cfg_->UdpGso() == true);
+  struct iovec gso_datagrams[kDequeueBulkSize];
+  if (cfg_->UseIoUring() == true) {
+    uring = std::make_unique<Uring>(kUringEntries, cfg_->IoUringSqPoll());
+    sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    RtAssert(inet_pton(AF_INET, cfg_->BsServerAddr().c_str(),
+                       &server_addr.sin_addr) == 1,
+             "Invalid server IP address");
+    for (size_t radio_id = radio_lo; radio_id < radio_hi; radio_id++) {
+      server_addr.sin_port = htons(cfg_->BsServerPort() + radio_id);
+      server_addrs.push_back(server_addr);
+    }
+  }
 #endif
 
   auto* fft_inout =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
           cfg_->OfdmCaNum() * sizeof(complex_float)));
-  auto* socks_pkt_buf = static_cast<Packet*>(PaddedAlignedAlloc(
-      Agora_memory::Alignment_t::kAlign32, cfg_->PacketLength()));
+  const size_t pkt_buf_stride = Roundup<64>(cfg_->PacketLength());
+  auto* socks_pkt_buf = static_cast<Packet*>(
+      PaddedAlignedAlloc(Agora_memory::Alignment_t::kAlign64,
+                         kDequeueBulkSize * pkt_buf_stride));
 
   double begin = GetTime::GetTimeUs();
   size_t total_tx_packets = 0;
@@ -356,11 +395,20 @@ void* Sender::WorkerThread(int tid) {
                (kUse12BitIQ ? 3 : 4) * (cfg_->CpLen() + cfg_->OfdmCaNum()));
   size_t ant_num_per_cell = cfg_->BsAntNum() / cfg_->NumCells();
 
+  std::mt19937 drop_rng(tid);
+  std::bernoulli_distribution drop_dist(drop_rate_);
+  size_t num_dropped = 0;
+
   size_t tags[kDequeueBulkSize];
   while (keep_running.load() == true) {
     size_t num_tags = this->send_queue_.try_dequeue_bulk_from_producer(
         *(this->task_ptok_[tid]), tags, kDequeueBulkSize);
     if (num_tags > 0) {
+      // Number of packets of the batch that are sent, not dropped
+      size_t num_tx = 0;
+#if !defined(USE_DPDK)
+      const size_t gso_radio = cur_radio;
+#endif
       for (size_t tag_id = 0; (tag_id < num_tags); tag_id++) {
         size_t start_tsc_send = GetTime::Rdtsc();
 
@@ -368,15 +416,45 @@ void* Sender::WorkerThread(int tid) {
         assert((cfg_->GetSymbolType(tag.symbol_id_) == SymbolType::kPilot) ||
                (cfg_->GetSymbolType(tag.symbol_id_) == SymbolType::kUL));
 
+        // Emulate packet loss. The symbol still counts as sent for pacing.
+        if ((drop_rate_ > 0) && (drop_dist(drop_rng) == true)) {
+          num_dropped++;
+          if (++cur_radio == radio_hi) {
+            cur_radio = radio_lo;
+          }
+          continue;
+        }
+
         // Send a message to the server. We assume that the server is running.
         Packet* pkt = socks_pkt_buf;
+#if !defined(USE_DPDK)
+        ShmRing* shm_ring = nullptr;
+        if ((uring != nullptr) || (use_gso == true)) {
+          pkt = reinterpret_cast<Packet*>(
+              reinterpret_cast<uint8_t*>(socks_pkt_buf) +
+              (num_tx * pkt_buf_stride));
+        } else if (shm_transport_ != nullptr) {
+          // Build the packet in place in the radio's uplink ring, waiting
+          // for the server to free a slot
+          shm_ring = &shm_transport_->Uplink(cur_radio);
+          uint8_t* slot = shm_ring->Reserve();
+          while ((slot == nullptr) && (keep_running.load() == true)) {
+            _mm_pause();
+            slot = shm_ring->Reserve();
+          }
+          if (slot == nullptr) {
+            break;
+          }
+          pkt = reinterpret_cast<Packet*>(slot);
+        }
+#endif
 #if defined(USE_DPDK)
-        tx_mbufs[tag_id] = DpdkTransport::AllocUdp(
+        tx_mbufs[num_tx] = DpdkTransport::AllocUdp(
             mbuf_pool_, sender_mac_addr_[port_id], server_mac_addr_[port_id],
             bs_rru_addr_, bs_server_addr_, this->cfg_->BsRruPort() + tid,
             this->cfg_->BsServerPort() + tid, this->cfg_->PacketLength());
         pkt = reinterpret_cast<Packet*>(
-            rte_pktmbuf_mtod(tx_mbufs[tag_id], uint8_t*) + kPayloadOffset);
+            rte_pktmbuf_mtod(tx_mbufs[num_tx], uint8_t*) + kPayloadOffset);
 #endif
 
         if ((kDebugPrintSender == true)) {
@@ -391,6 +469,7 @@ void* Sender::WorkerThread(int tid) {
         pkt->symbol_id_ = tag.symbol_id_;
         pkt->cell_id_ = tag.ant_id_ / ant_num_per_cell;
         pkt->ant_id_ = tag.ant_id_ - ant_num_per_cell * (pkt->cell_id_);
+        pkt->magic_ = Packet::kMagic;
         std::memcpy(
             pkt->data_,
             iq_data_short_[(pkt->symbol_id_ * cfg_->BsAntNum()) + tag.ant_id_],
@@ -398,12 +477,32 @@ void* Sender::WorkerThread(int tid) {
         if (cfg_->FftInRru() == true) {
           RunFft(pkt, fft_inout, mkl_handle);
         }
+        // For the server's fronthaul latency stats. Batched packets are
+        // timestamped when they are built, just before the batch is sent.
+        pkt->tx_time_ns_ = GetTime::RealtimeNs();
+        if (cfg_->PacketChecksum() == true) {
+          PacketValidator::StampChecksum(pkt, cfg_->PacketLength());
+        }
 
 #ifndef USE_DPDK
-        udp_client.Send(cfg_->BsServerAddr(), cfg_->BsServerPort() + cur_radio,
-                        reinterpret_cast<uint8_t*>(socks_pkt_buf),
-                        cfg_->PacketLength());
+        if (uring != nullptr) {
+          send_msgs[num_tx].Set(server_addrs.at(cur_radio - radio_lo), pkt,
+                                cfg_->PacketLength());
+          UringPrepSendMsg(uring->GetSqe(), udp_client.Fd(),
+                           &send_msgs[num_tx].msg_, num_tx);
+        } else if (shm_ring != nullptr) {
+          shm_ring->Commit();
+        } else if (use_gso == true) {
+          gso_datagrams[num_tx].iov_base = pkt;
+          gso_datagrams[num_tx].iov_len = cfg_->PacketLength();
+        } else {
+          udp_client.Send(cfg_->BsServerAddr(),
+                          cfg_->BsServerPort() + cur_radio,
+                          reinterpret_cast<uint8_t*>(socks_pkt_buf),
+                          cfg_->PacketLength());
+        }
 #endif
+        num_tx++;
 
         if (kDebugSenderReceiver == true) {
           std::printf(
@@ -436,14 +535,37 @@ void* Sender::WorkerThread(int tid) {
         }
       }
 
+#if !defined(USE_DPDK)
+      if (use_gso == true) {
+        udp_client.SendSegmented(cfg_->BsServerAddr(),
+                                 cfg_->BsServerPort() + gso_radio,
+                                 gso_datagrams, num_tx);
+      }
+      if ((uring != nullptr) && (num_tx > 0)) {
+        // One syscall for the batch, which also waits for the sends so that
+        // the buffers can be reused
+        uring->SubmitAndWait(num_tx);
+        for (size_t i = 0; i < num_tx;) {
+          io_uring_cqe* cqe = uring->PeekCqe();
+          if (cqe == nullptr) {
+            uring->SubmitAndWait(1);
+            continue;
+          }
+          RtAssert(cqe->res == static_cast<int>(cfg_->PacketLength()),
+                   "Sender: io_uring send failed");
+          uring->SeenCqe();
+          i++;
+        }
+      }
+#endif
 #if defined(USE_DPDK)
       size_t nb_tx_new = rte_eth_tx_burst(port_id + cfg_->DpdkPortOffset(),
-                                          queue_id, tx_mbufs, num_tags);
-      if (unlikely(nb_tx_new != num_tags)) {
+                                          queue_id, tx_mbufs, num_tx);
+      if (unlikely(nb_tx_new != num_tx)) {
         std::printf(
             "Thread %d rte_eth_tx_burst() failed, nb_tx_new: %zu, "
-            "num_tags: %zu\n",
-            tid, nb_tx_new, num_tags);
+            "num_tx: %zu\n",
+            tid, nb_tx_new, num_tx);
         keep_running.store(false);
         break;
       }
@@ -458,16 +580,17 @@ void* Sender::WorkerThread(int tid) {
   std::free(static_cast<void*>(socks_pkt_buf));
   std::free(static_cast<void*>(fft_inout));
   MLPD_FRAME("Sender: worker thread %d exit\n", tid);
-  std::printf("Sender: worker thread %d exit\n", tid);
+  std::printf("Sender: worker thread %d exit, %zu packets dropped\n", tid,
+              num_dropped);
   return nullptr;
 }
 
 uint64_t Sender::GetTicksForFrame(size_t frame_id) const {
   if (enable_slow_start_ == 0) {
     return ticks_all_;
-  } else if (frame_id < kFrameWnd) {
+  } else if (frame_id < cfg_->FrameWnd()) {
     return ticks_wnd1_;
-  } else if (frame_id < (kFrameWnd * 4)) {
+  } else if (frame_id < (cfg_->FrameWnd() * 4)) {
     return ticks_wnd2_;
   } else {
     return ticks_all_;
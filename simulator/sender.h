@@ -33,6 +33,10 @@
 #include "dpdk_transport.h"
 #endif
 
+#if !defined(USE_DPDK)
+#include "shm_transport.h"
+#endif
+
 class Sender {
  public:
   static constexpr size_t kDequeueBulkSize = 4;
@@ -54,12 +58,15 @@ class Sender {
    * duration larger than the TTI
    *
    * @param server_mac_addr_str The MAC address of the server's NIC
+   *
+   * @param drop_rate The probability with which each packet is dropped
+   * instead of sent, to emulate packet loss
    */
   Sender(Config* cfg, size_t socket_thread_num, size_t core_offset = 30,
          size_t frame_duration = 1000, size_t inter_frame_delay = 0,
          size_t enable_slow_start = 1,
          const std::string& server_mac_addr_str = "ff:ff:ff:ff:ff:ff",
-         bool create_thread_for_master = false);
+         bool create_thread_for_master = false, double drop_rate = 0.0);
 
   ~Sender();
 
@@ -107,6 +114,7 @@ class Sender {
   const double ticks_per_usec_;     // RDTSC frequency in GHz
   const size_t socket_thread_num_;  // Number of worker threads sending pkts
   const size_t enable_slow_start_;  // If 1, send frames slowly at first
+  const double drop_rate_;          // Probability of dropping each packet
 
   // The master thread runs on core core_offset. Worker threads use cores
   // {core_offset + 1, ..., core_offset + thread_num - 1}
@@ -138,13 +146,19 @@ class Sender {
   Table<unsigned short> iq_data_short_;
 
   // Number of packets transmitted for each symbol in a frame
-  size_t* packet_count_per_symbol_[kFrameWnd];
+  std::vector<size_t*> packet_count_per_symbol_;
 
   double* frame_start_;
   double* frame_end_;
 
   std::vector<std::thread> threads_;
 
+#if !defined(USE_DPDK)
+  // In shared memory mode, the rings that replace the server's UDP ports.
+  // Worker threads build their radios' packets in place in the uplink rings.
+  std::unique_ptr<ShmTransport> shm_transport_;
+#endif
+
 #if defined(USE_DPDK)
   struct rte_mempool* mbuf_pool_;
   uint32_t bs_rru_addr_;     // IPv4 address of this data sender
@@ -19,6 +19,8 @@ DEFINE_string(conf_file,
 DEFINE_uint64(
     enable_slow_start, 1,
     "Send frames slower than the specified frame duration during warmup");
+DEFINE_double(drop_rate, 0.0,
+              "Probability of dropping each packet instead of sending it");
 
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -33,7 +35,7 @@ int main(int argc, char* argv[]) {
       auto sender = std::make_unique<Sender>(
           cfg.get(), FLAGS_num_threads, FLAGS_core_offset, FLAGS_frame_duration,
           FLAGS_inter_frame_delay, FLAGS_enable_slow_start,
-          FLAGS_server_mac_addr);
+          FLAGS_server_mac_addr, false, FLAGS_drop_rate);
       sender->StartTx();
     }  // end context sender
   }    // end context Config
@@ -94,7 +94,7 @@ void Simulator::Start() {
             size_t frame_id = pkt->frame_id_ % kNumStatsFrames;
             size_t symbol_id = pkt->symbol_id_;
             size_t ant_id = pkt->ant_id_;
-            size_t frame_id_in_buffer = (frame_id % kFrameWnd);
+            size_t frame_id_in_buffer = config_->FrameSlot(frame_id);
             rx_packet->Free();
 
             // Only process the dl symbols & ignore beacon frames
@@ -228,10 +228,10 @@ void Simulator::FreeQueues() {
 void Simulator::InitializeBuffers() {
   socket_buffer_size_ = (long long)config_->PacketLength() *
                         config_->Frame().NumTotalSyms() * config_->BsAntNum() *
-                        kFrameWnd;
+                        config_->FrameWnd();
 
   /* initilize all uplink status checkers */
-  AllocBuffer1d(&rx_counter_packets_, kFrameWnd,
+  AllocBuffer1d(&rx_counter_packets_, config_->FrameWnd(),
                 Agora_memory::Alignment_t::kAlign64, 1);
 
   frame_start_.Calloc(socket_rx_thread_num_, kNumStatsFrames,
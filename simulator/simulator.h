@@ -67,10 +67,10 @@ class Simulator {
    *
    * First dimension: SOCKET_THREAD_NUM
    *
-   * Second dimension of socket_buffer: kFrameWnd * BS_ANT_NUM *
+   * Second dimension of socket_buffer: frame window * BS_ANT_NUM *
    * symbol_num_perframe * packet_length
    *
-   * Second dimension of buffer status: kFrameWnd * BS_ANT_NUM *
+   * Second dimension of buffer status: frame window * BS_ANT_NUM *
    * symbol_num_perframe
    */
   Table<char> socket_buffer_;
@@ -11,29 +11,41 @@
 static const bool kDebugDeferral = false;
 static const size_t kDefaultMessageQueueSize = 512;
 static const size_t kDefaultWorkerQueueSize = 256;
+// A worker sends its batched completions at most this long after the first
+static const double kCompletionFlushUs = 20.0;
+
+/// Return true if the downlink master handles the completions of tasks of
+/// this type when the master loops are split
+static bool IsDownlinkTask(EventType event_type) {
+  return (event_type == EventType::kEncode) ||
+         (event_type == EventType::kPrecode) ||
+         (event_type == EventType::kIFFT);
+}
 
-Agora::Agora(Config* const cfg)
+Agora::Agora(Config* const cfg, bool create_workers)
     : base_worker_core_offset_(cfg->CoreOffset() + 1 + cfg->SocketThreadNum()),
       config_(cfg),
       stats_(std::make_unique<Stats>(cfg)),
       phy_stats_(std::make_unique<PhyStats>(cfg)),
-      csi_buffers_(kFrameWnd, cfg->UeNum(),
+      csi_buffers_(cfg->FrameWnd(), cfg->UeNum(),
                    cfg->BsAntNum() * cfg->OfdmDataNum()),
-      ul_zf_matrices_(kFrameWnd, cfg->OfdmDataNum(),
+      ul_zf_matrices_(cfg->FrameWnd(), cfg->OfdmDataNum(),
                       cfg->BsAntNum() * cfg->UeNum()),
-      demod_buffers_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeNum(),
+      demod_buffers_(cfg->FrameWnd(), cfg->Frame().NumULSyms(), cfg->UeNum(),
                      kMaxModType * cfg->OfdmDataNum()),
-      decoded_buffer_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeNum(),
+      decoded_buffer_(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                      cfg->UeNum(),
                       cfg->LdpcConfig().NumBlocksInSymbol() *
                           Roundup<64>(cfg->NumBytesPerCb())),
-      dl_zf_matrices_(kFrameWnd, cfg->OfdmDataNum(),
+      fft_queue_arr_(cfg->FrameWnd()),
+      dl_zf_matrices_(cfg->FrameWnd(), cfg->OfdmDataNum(),
                       cfg->UeNum() * cfg->BsAntNum()) {
   std::string directory = TOSTRING(PROJECT_DIRECTORY);
   std::printf("Agora: project directory [%s], RDTSC frequency = %.2f GHz\n",
               directory.c_str(), cfg->FreqGhz());
 
   PinToCoreWithOffset(ThreadType::kMaster, cfg->CoreOffset(), 0,
-                      false /* quiet */);
+                      cfg->Placement(), false /* quiet */);
   CheckIncrementScheduleFrame(0, ScheduleProcessingFlags::kProcessingComplete);
   // Important to set cur_sche_frame_id_ after the call to
   // CheckIncrementScheduleFrame because it will be incremented however,
@@ -50,6 +62,11 @@ Agora::Agora(Config* const cfg)
   packet_tx_rx_ = std::make_unique<PacketTXRX>(
       cfg, cfg->CoreOffset() + 1, &message_queue_,
       GetConq(EventType::kPacketTX, 0), rx_ptoks_ptr_, tx_ptoks_ptr_);
+  packet_tx_rx_->SetRxPacketDrops(&stats_->RxPacketDrops());
+
+  if (cfg->MetricsSocket().empty() == false) {
+    InitializeMetrics();
+  }
 
   if (kEnableMac == true) {
     const size_t mac_cpu_core =
@@ -62,8 +79,10 @@ Agora::Agora(Config* const cfg)
         std::thread(&MacThreadBaseStation::RunEventLoop, mac_thread_.get());
   }
 
-  // Create worker threads
-  CreateThreads();
+  // Create worker threads, unless they are shared with other cells
+  if (create_workers == true) {
+    CreateThreads();
+  }
 
   MLPD_INFO(
       "Master thread core %zu, TX/RX thread cores %zu--%zu, worker thread "
@@ -72,9 +91,14 @@ Agora::Agora(Config* const cfg)
       cfg->CoreOffset() + 1 + cfg->SocketThreadNum() - 1,
       base_worker_core_offset_,
       base_worker_core_offset_ + cfg->WorkerThreadNum() - 1);
+  if (cfg->SplitMaster() == true) {
+    MLPD_INFO("Downlink master thread core %zu\n", DownlinkMasterCore());
+  }
 }
 
 Agora::~Agora() {
+  // The exporter samples the queues, so stop it first
+  metrics_exporter_.reset();
   if (kEnableMac == true) {
     mac_std_thread_.join();
   }
@@ -94,6 +118,10 @@ Agora::~Agora() {
 void Agora::Stop() {
   MLPD_INFO("Agora: terminating\n");
   config_->Running(false);
+  worker_parking_->Wake();
+  if (this->downlink_master_.joinable() == true) {
+    this->downlink_master_.join();
+  }
   usleep(1000);
   packet_tx_rx_.reset();
 }
@@ -116,7 +144,7 @@ void Agora::ScheduleDownlinkProcessing(size_t frame_id) {
   size_t num_pilot_symbols = config_->Frame().ClientDlPilotSymbols();
 
   for (size_t i = 0; i < num_pilot_symbols; i++) {
-    if (zf_last_frame_ == frame_id) {
+    if (dl_zf_last_frame_ == frame_id) {
       ScheduleSubcarriers(EventType::kPrecode, frame_id,
                           config_->Frame().GetDLSymbol(i));
     } else {
@@ -155,6 +183,7 @@ void Agora::ScheduleAntennas(EventType event_type, size_t frame_id,
     TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
                        event);
   }
+  worker_parking_->Wake();
 }
 
 void Agora::ScheduleAntennasTX(size_t frame_id, size_t symbol_id) {
@@ -228,6 +257,7 @@ void Agora::ScheduleSubcarriers(EventType event_type, size_t frame_id,
       base_tag.sc_id_ += block_size;
     }
   }
+  worker_parking_->Wake();
 }
 
 void Agora::ScheduleCodeblocks(EventType event_type, size_t frame_id,
@@ -263,6 +293,7 @@ void Agora::ScheduleCodeblocks(EventType event_type, size_t frame_id,
     TryEnqueueFallback(GetConq(event_type, qid), GetPtok(event_type, qid),
                        event);
   }
+  worker_parking_->Wake();
 }
 
 void Agora::ScheduleUsers(EventType event_type, size_t frame_id,
@@ -282,18 +313,24 @@ void Agora::Start() {
 
   // Start packet I/O
   if (packet_tx_rx_->StartTxRx(socket_buffer_,
-                               socket_buffer_size_ / cfg->PacketLength(),
+                               socket_buffer_size_ /
+                                   PacketTXRX::RxPacketStride(cfg),
                                this->stats_->FrameStart(), dl_socket_buffer_,
                                calib_dl_buffer_, calib_ul_buffer_) == false) {
     this->Stop();
     return;
   }
 
-  PinToCoreWithOffset(ThreadType::kMaster, cfg->CoreOffset(), 0);
+  PinToCoreWithOffset(ThreadType::kMaster, cfg->CoreOffset(), 0,
+                      cfg->Placement());
 
   // Counters for printing summary
-  size_t tx_count = 0;
-  double tx_begin = GetTime::GetTimeUs();
+  this->tx_count_ = 0;
+  this->tx_begin_us_ = GetTime::GetTimeUs();
+
+  if (cfg->SplitMaster() == true) {
+    this->downlink_master_ = std::thread(&Agora::DownlinkMaster, this);
+  }
 
   bool is_turn_to_dequeue_from_io = true;
   const size_t max_events_needed =
@@ -323,27 +360,82 @@ void Agora::Start() {
     }
     is_turn_to_dequeue_from_io = !is_turn_to_dequeue_from_io;
 
+    if ((this->frame_deadline_tsc_ > 0) && (this->CheckFrameDeadline())) {
+      goto finish;
+    }
+    if (this->antenna_erasure_tsc_ > 0) {
+      CheckAntennaErasures();
+    }
+
+    // The downlink master may have finished the downlink of the frames in
+    // scheduling or in processing
+    if (cfg->SplitMaster() == true) {
+      if (this->CheckDownlinkProgress() == true) {
+        goto finish;
+      }
+      ScheduleFft();
+    }
+
     // Handle each event
     for (size_t ev_i = 0; ev_i < num_events; ev_i++) {
       EventData& event = events_list[ev_i];
 
+      // The counters of a dropped frame are reset, so drop its late
+      // completions too
+      if (IsDroppedFrameEvent(event) == true) {
+        continue;
+      }
+
       // FFT processing is scheduled after falling through the switch
       switch (event.event_type_) {
         case EventType::kPacketRX: {
-          Packet* pkt = rx_tag_t(event.tags_[0]).rx_packet_->RawPacket();
-
-          if (pkt->frame_id_ >= ((this->cur_sche_frame_id_ + kFrameWnd))) {
-            MLPD_ERROR(
-                "Error: Received packet for future frame %u beyond "
-                "frame window (= %zu + %zu). This can happen if "
-                "Agora is running slowly, e.g., in debug mode\n",
-                pkt->frame_id_, this->cur_sche_frame_id_, kFrameWnd);
-            cfg->Running(false);
+          RxPacket* rx_packet = rx_tag_t(event.tags_[0]).rx_packet_;
+          Packet* pkt = rx_packet->RawPacket();
+          if (this->metrics_ != nullptr) {
+            this->master_metrics_.rx_packets_->Add(1);
+          }
+          if ((pkt->tx_time_ns_ != 0) && (rx_packet->RxTimeNs() != 0)) {
+            this->stats_->MasterUpdateFronthaul(
+                pkt->ant_id_, pkt->tx_time_ns_, rx_packet->RxTimeNs());
+          }
+
+          if ((this->frame_deadline_tsc_ > 0) &&
+              (this->dropped_frames_.IsDropped(pkt->frame_id_))) {
+            rx_packet->Free();
+            break;
+          }
+
+          if (pkt->frame_id_ >=
+              ((this->cur_sche_frame_id_ + cfg->FrameWnd()))) {
+            if (this->frame_deadline_tsc_ == 0) {
+              MLPD_ERROR(
+                  "Error: Received packet for future frame %u beyond "
+                  "frame window (= %zu + %zu). This can happen if "
+                  "Agora is running slowly, e.g., in debug mode\n",
+                  pkt->frame_id_, this->cur_sche_frame_id_, cfg->FrameWnd());
+              cfg->Running(false);
+              break;
+            }
+            // Make room for the new frame by dropping the oldest frames
+            while (pkt->frame_id_ >=
+                   (this->cur_sche_frame_id_ + cfg->FrameWnd())) {
+              bool work_finished = this->DropFrame(
+                  this->cur_proc_frame_id_, FrameDropReason::kWindowFull);
+              if (work_finished == true) {
+                rx_packet->Free();
+                goto finish;
+              }
+            }
+          }
+
+          if ((this->antenna_erasure_tsc_ > 0) &&
+              (TrackReceivedAntenna(pkt) == false)) {
+            rx_packet->Free();
             break;
           }
 
           UpdateRxCounters(pkt->frame_id_, pkt->symbol_id_);
-          fft_queue_arr_[pkt->frame_id_ % kFrameWnd].push(
+          fft_queue_arr_[cfg->FrameSlot(pkt->frame_id_)].push(
               fft_req_tag_t(event.tags_[0]));
         } break;
 
@@ -357,8 +449,11 @@ void Agora::Start() {
           for (size_t tag_id = 0; (tag_id < event.num_tags_); tag_id++) {
             size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
             PrintPerTaskDone(PrintType::kZF, frame_id, 0,
-                             zf_counters_.GetTaskCount(frame_id));
-            bool last_zf_task = this->zf_counters_.CompleteTask(frame_id);
+                             gen_tag_t(event.tags_[tag_id]).sc_id_);
+            // With worker-side counting, workers forward only the task that
+            // completes the frame's ZF
+            bool last_zf_task = (kUseAtomicFrameCounters == true) ||
+                                this->zf_counters_.CompleteTask(frame_id);
             if (last_zf_task == true) {
               this->stats_->MasterSetTsc(TsType::kZFDone, frame_id);
               zf_last_frame_ = frame_id;
@@ -371,70 +466,74 @@ void Agora::Start() {
                                       cfg->Frame().GetULSymbol(i));
                 }
               }
-              // Schedule precoding for downlink symbols
-              for (size_t i = 0; i < cfg->Frame().NumDLSyms(); i++) {
-                size_t last_encoded_frame =
-                    this->encode_cur_frame_for_symbol_.at(i);
-                if ((last_encoded_frame != SIZE_MAX) &&
-                    (last_encoded_frame >= frame_id)) {
-                  ScheduleSubcarriers(EventType::kPrecode, frame_id,
-                                      cfg->Frame().GetDLSymbol(i));
-                }
+              if (cfg->SplitMaster() == true) {
+                this->zf_progress_.MarkDone(frame_id);
+              } else {
+                HandleDownlinkZf(frame_id);
               }
+              CheckBigstationUplinkScheduled(frame_id);
             }  // end if (zf_counters_.last_task(frame_id) == true)
           }
         } break;
 
         case EventType::kDemul: {
-          size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-          size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
-          size_t base_sc_id = gen_tag_t(event.tags_[0]).sc_id_;
-
-          PrintPerTaskDone(PrintType::kDemul, frame_id, symbol_id, base_sc_id);
-          bool last_demul_task =
-              this->demul_counters_.CompleteTask(frame_id, symbol_id);
-
-          if (last_demul_task == true) {
-            ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id);
-            PrintPerSymbolDone(PrintType::kDemul, frame_id, symbol_id);
-            bool last_demul_symbol =
-                this->demul_counters_.CompleteSymbol(frame_id);
-            if (last_demul_symbol == true) {
-              this->demul_counters_.Reset(frame_id);
-              max_equaled_frame_ = frame_id;
-              if (cfg->BigstationMode() == false) {
-                assert(cur_sche_frame_id_ == frame_id);
-                CheckIncrementScheduleFrame(frame_id, kUplinkComplete);
-              } else {
-                ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id);
+          // Workers may coalesce completions of the same frame in one event
+          for (size_t tag_id = 0; tag_id < event.num_tags_; tag_id++) {
+            size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
+            size_t symbol_id = gen_tag_t(event.tags_[tag_id]).symbol_id_;
+            size_t base_sc_id = gen_tag_t(event.tags_[tag_id]).sc_id_;
+
+            PrintPerTaskDone(PrintType::kDemul, frame_id, symbol_id,
+                             base_sc_id);
+            bool last_demul_task =
+                (kUseAtomicFrameCounters == true) ||
+                this->demul_counters_.CompleteTask(frame_id, symbol_id);
+
+            if (last_demul_task == true) {
+              ScheduleCodeblocks(EventType::kDecode, frame_id, symbol_id);
+              PrintPerSymbolDone(PrintType::kDemul, frame_id, symbol_id);
+              bool last_demul_symbol =
+                  this->demul_counters_.CompleteSymbol(frame_id);
+              if (last_demul_symbol == true) {
+                this->demul_counters_.Reset(frame_id);
+                max_equaled_frame_ = frame_id;
+                // In Bigstation mode, the frame's uplink was scheduled when
+                // all of its demodulation tasks were
+                if (cfg->BigstationMode() == false) {
+                  assert(cur_sche_frame_id_ == frame_id);
+                  CheckIncrementScheduleFrame(frame_id, kUplinkComplete);
+                }
+                this->stats_->MasterSetTsc(TsType::kDemulDone, frame_id);
+                PrintPerFrameDone(PrintType::kDemul, frame_id);
               }
-              this->stats_->MasterSetTsc(TsType::kDemulDone, frame_id);
-              PrintPerFrameDone(PrintType::kDemul, frame_id);
             }
           }
         } break;
 
         case EventType::kDecode: {
-          size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-          size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
-
-          bool last_decode_task =
-              this->decode_counters_.CompleteTask(frame_id, symbol_id);
-          if (last_decode_task == true) {
-            if (kEnableMac == true) {
-              ScheduleUsers(EventType::kPacketToMac, frame_id, symbol_id);
-            }
-            PrintPerSymbolDone(PrintType::kDecode, frame_id, symbol_id);
-            bool last_decode_symbol =
-                this->decode_counters_.CompleteSymbol(frame_id);
-            if (last_decode_symbol == true) {
-              this->stats_->MasterSetTsc(TsType::kDecodeDone, frame_id);
-              PrintPerFrameDone(PrintType::kDecode, frame_id);
-              if (kEnableMac == false) {
-                assert(this->cur_proc_frame_id_ == frame_id);
-                bool work_finished = this->CheckFrameComplete(frame_id);
-                if (work_finished == true) {
-                  goto finish;
+          for (size_t tag_id = 0; tag_id < event.num_tags_; tag_id++) {
+            size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
+            size_t symbol_id = gen_tag_t(event.tags_[tag_id]).symbol_id_;
+
+            bool last_decode_task =
+                (kUseAtomicFrameCounters == true) ||
+                this->decode_counters_.CompleteTask(frame_id, symbol_id);
+            if (last_decode_task == true) {
+              if (kEnableMac == true) {
+                ScheduleUsers(EventType::kPacketToMac, frame_id, symbol_id);
+              }
+              PrintPerSymbolDone(PrintType::kDecode, frame_id, symbol_id);
+              bool last_decode_symbol =
+                  this->decode_counters_.CompleteSymbol(frame_id);
+              if (last_decode_symbol == true) {
+                this->stats_->MasterSetTsc(TsType::kDecodeDone, frame_id);
+                PrintPerFrameDone(PrintType::kDecode, frame_id);
+                if (kEnableMac == false) {
+                  assert(this->cur_proc_frame_id_ == frame_id);
+                  bool work_finished = this->CheckFrameComplete(frame_id);
+                  if (work_finished == true) {
+                    goto finish;
+                  }
                 }
               }
             }
@@ -489,7 +588,7 @@ void Agora::Start() {
               }
               this->encode_deferral_.push(frame_id);
             } else {
-              ScheduleDownlinkProcessing(frame_id);
+              RequestDownlinkProcessing(frame_id);
             }
             this->mac_to_phy_counters_.Reset(frame_id);
             PrintPerFrameDone(PrintType::kPacketFromMac, frame_id);
@@ -497,153 +596,28 @@ void Agora::Start() {
         } break;
 
         case EventType::kEncode: {
-          for (size_t i = 0; i < event.num_tags_; i++) {
-            size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
-            size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
-
-            bool last_encode_task =
-                encode_counters_.CompleteTask(frame_id, symbol_id);
-            if (last_encode_task == true) {
-              this->encode_cur_frame_for_symbol_.at(
-                  cfg->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
-              // If precoder of the current frame exists
-              if (zf_last_frame_ == frame_id) {
-                ScheduleSubcarriers(EventType::kPrecode, frame_id, symbol_id);
-              }
-              PrintPerSymbolDone(PrintType::kEncode, frame_id, symbol_id);
-
-              bool last_encode_symbol =
-                  this->encode_counters_.CompleteSymbol(frame_id);
-              if (last_encode_symbol == true) {
-                this->encode_counters_.Reset(frame_id);
-                this->stats_->MasterSetTsc(TsType::kEncodeDone, frame_id);
-                PrintPerFrameDone(PrintType::kEncode, frame_id);
-              }
-            }
-          }
+          HandleEventEncode(event);
         } break;
 
         case EventType::kPrecode: {
-          // Precoding is done, schedule ifft
-          size_t sc_id = gen_tag_t(event.tags_[0]).sc_id_;
-          size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-          size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
-          PrintPerTaskDone(PrintType::kPrecode, frame_id, symbol_id, sc_id);
-          bool last_precode_task =
-              this->precode_counters_.CompleteTask(frame_id, symbol_id);
-
-          if (last_precode_task == true) {
-            // precode_cur_frame_for_symbol_.at(
-            //    this->config_->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
-            ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
-            PrintPerSymbolDone(PrintType::kPrecode, frame_id, symbol_id);
-
-            bool last_precode_symbol =
-                this->precode_counters_.CompleteSymbol(frame_id);
-            if (last_precode_symbol == true) {
-              this->precode_counters_.Reset(frame_id);
-              this->stats_->MasterSetTsc(TsType::kPrecodeDone, frame_id);
-              PrintPerFrameDone(PrintType::kPrecode, frame_id);
-            }
-          }
+          HandleEventPrecode(event);
         } break;
 
         case EventType::kIFFT: {
-          for (size_t i = 0; i < event.num_tags_; i++) {
-            /* IFFT is done, schedule data transmission */
-            size_t ant_id = gen_tag_t(event.tags_[i]).ant_id_;
-            size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
-            size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
-            size_t symbol_idx_dl = cfg->Frame().GetDLSymbolIdx(symbol_id);
-            PrintPerTaskDone(PrintType::kIFFT, frame_id, symbol_id, ant_id);
-
-            bool last_ifft_task =
-                this->ifft_counters_.CompleteTask(frame_id, symbol_id);
-            if (last_ifft_task == true) {
-              ifft_cur_frame_for_symbol_.at(symbol_idx_dl) = frame_id;
-              if (symbol_idx_dl == ifft_next_symbol_) {
-                // Check the available symbols starting from the current symbol
-                // Only schedule symbols that are continuously avaialbe
-                for (size_t sym_id = symbol_idx_dl;
-                     sym_id <= ifft_counters_.GetSymbolCount(frame_id);
-                     sym_id++) {
-                  size_t symbol_ifft_frame =
-                      ifft_cur_frame_for_symbol_.at(sym_id);
-                  if (symbol_ifft_frame == frame_id) {
-                    ScheduleAntennasTX(frame_id,
-                                       cfg->Frame().GetDLSymbol(sym_id));
-                    ifft_next_symbol_++;
-                  } else {
-                    break;
-                  }
-                }
-              }
-              PrintPerSymbolDone(PrintType::kIFFT, frame_id, symbol_id);
-
-              bool last_ifft_symbol =
-                  this->ifft_counters_.CompleteSymbol(frame_id);
-              if (last_ifft_symbol == true) {
-                ifft_next_symbol_ = 0;
-                this->stats_->MasterSetTsc(TsType::kIFFTDone, frame_id);
-                PrintPerFrameDone(PrintType::kIFFT, frame_id);
-                assert(frame_id == this->cur_proc_frame_id_);
-                this->CheckIncrementScheduleFrame(frame_id, kDownlinkComplete);
-                bool work_finished = this->CheckFrameComplete(frame_id);
-                if (work_finished == true) {
-                  goto finish;
-                }
-              }
-            }
+          if (HandleEventIfft(event) == true) {
+            goto finish;
           }
         } break;
 
         case EventType::kPacketTX: {
-          // Data is sent
-          size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
-          size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-          size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
-          PrintPerTaskDone(PrintType::kPacketTX, frame_id, symbol_id, ant_id);
-
-          bool last_tx_task =
-              this->tx_counters_.CompleteTask(frame_id, symbol_id);
-          if (last_tx_task == true) {
-            PrintPerSymbolDone(PrintType::kPacketTX, frame_id, symbol_id);
-            // If tx of the first symbol is done
-            if (symbol_id == cfg->Frame().GetDLSymbol(0)) {
-              this->stats_->MasterSetTsc(TsType::kTXProcessedFirst, frame_id);
-              PrintPerFrameDone(PrintType::kPacketTXFirst, frame_id);
-            }
-
-            bool last_tx_symbol = this->tx_counters_.CompleteSymbol(frame_id);
-            if (last_tx_symbol == true) {
-              this->stats_->MasterSetTsc(TsType::kTXDone, frame_id);
-              PrintPerFrameDone(PrintType::kPacketTX, frame_id);
-
-              bool work_finished = this->CheckFrameComplete(frame_id);
-              if (work_finished == true) {
-                goto finish;
-              }
-            }
-
-            tx_count++;
-            if (tx_count == tx_counters_.MaxSymbolCount() * 9000) {
-              tx_count = 0;
-
-              double diff = GetTime::GetTimeUs() - tx_begin;
-              int samples_num_per_ue =
-                  cfg->OfdmDataNum() * tx_counters_.MaxSymbolCount() * 1000;
-
-              MLPD_INFO(
-                  "TX %d samples (per-client) to %zu clients "
-                  "in %f secs, throughtput %f bps per-client "
-                  "(16QAM), current tx queue length %zu\n",
-                  samples_num_per_ue, cfg->UeNum(), diff,
-                  samples_num_per_ue * std::log2(16.0f) / diff,
-                  GetConq(EventType::kPacketTX, 0)->size_approx());
-              unused(diff);
-              unused(samples_num_per_ue);
-              tx_begin = GetTime::GetTimeUs();
-            }
+          if (this->metrics_ != nullptr) {
+            this->master_metrics_.tx_packets_->Add(1);
+          }
+          if (cfg->SplitMaster() == true) {
+            // TX completions arrive with the received packets
+            TryEnqueueFallback(&dl_message_queue_, event);
+          } else if (HandleEventTx(event) == true) {
+            goto finish;
           }
         } break;
         default:
@@ -651,40 +625,7 @@ void Agora::Start() {
           std::exit(0);
       } /* End of switch */
 
-      // We schedule FFT processing if the event handling above results in
-      // either (a) sufficient packets received for the current frame,
-      // or (b) the current frame being updated.
-      std::queue<fft_req_tag_t>& cur_fftq =
-          fft_queue_arr_[(this->cur_sche_frame_id_ % kFrameWnd)];
-      size_t qid = this->cur_sche_frame_id_ & 0x1;
-      if (cur_fftq.size() >= config_->FftBlockSize()) {
-        size_t num_fft_blocks = cur_fftq.size() / config_->FftBlockSize();
-        for (size_t i = 0; i < num_fft_blocks; i++) {
-          EventData do_fft_task;
-          do_fft_task.num_tags_ = config_->FftBlockSize();
-          do_fft_task.event_type_ = EventType::kFFT;
-
-          for (size_t j = 0; j < config_->FftBlockSize(); j++) {
-            do_fft_task.tags_[j] = cur_fftq.front().tag_;
-            cur_fftq.pop();
-
-            if (this->fft_created_count_ == 0) {
-              this->stats_->MasterSetTsc(TsType::kProcessingStarted,
-                                         this->cur_sche_frame_id_);
-            }
-            this->fft_created_count_++;
-            if (this->fft_created_count_ == rx_counters_.num_pkts_per_frame_) {
-              this->fft_created_count_ = 0;
-              if (cfg->BigstationMode() == true) {
-                this->CheckIncrementScheduleFrame(cur_sche_frame_id_,
-                                                  kUplinkComplete);
-              }
-            }
-          }
-          TryEnqueueFallback(GetConq(EventType::kFFT, qid),
-                             GetPtok(EventType::kFFT, qid), do_fft_task);
-        }
-      }
+      ScheduleFft();
     } /* End of for */
   }   /* End of while */
 
@@ -699,6 +640,10 @@ finish:
     SaveTxDataToFile(this->stats_->LastFrameId());
   }
 
+  if (this->antenna_erasure_tsc_ > 0) {
+    MLPD_INFO("Agora: erased %zu antenna packets\n",
+              this->phy_stats_->TotalAntennaErasures());
+  }
   // Calculate and print per-user BER
   if ((kEnableMac == false) && (kPrintPhyStats == true)) {
     this->phy_stats_->PrintPhyStats();
@@ -706,6 +651,295 @@ finish:
   this->Stop();
 }
 
+void Agora::ScheduleFft() {
+  // The master calls this after each event, which may have resulted in
+  // either (a) sufficient packets received for the current frame,
+  // or (b) the current frame being updated.
+  // The frames in processing use the schedule queues by frame parity,
+  // so FFT of a new frame waits until a queue is free.
+  std::queue<fft_req_tag_t>& cur_fftq =
+      fft_queue_arr_[config_->FrameSlot(this->cur_sche_frame_id_)];
+  size_t qid = this->cur_sche_frame_id_ & 0x1;
+  if ((cur_fftq.size() >= config_->FftBlockSize()) &&
+      (this->cur_sche_frame_id_ <
+       this->cur_proc_frame_id_ + kScheduleQueues)) {
+    size_t num_fft_blocks = cur_fftq.size() / config_->FftBlockSize();
+    for (size_t i = 0; i < num_fft_blocks; i++) {
+      EventData do_fft_task;
+      do_fft_task.num_tags_ = config_->FftBlockSize();
+      do_fft_task.event_type_ = EventType::kFFT;
+
+      for (size_t j = 0; j < config_->FftBlockSize(); j++) {
+        do_fft_task.tags_[j] = cur_fftq.front().tag_;
+        cur_fftq.pop();
+
+        if (this->fft_created_count_ == 0) {
+          this->stats_->MasterSetTsc(TsType::kProcessingStarted,
+                                     this->cur_sche_frame_id_);
+        }
+        this->fft_created_count_++;
+        if (this->fft_created_count_ == rx_counters_.num_pkts_per_frame_) {
+          this->fft_created_count_ = 0;
+        }
+      }
+      TryEnqueueFallback(GetConq(EventType::kFFT, qid),
+                         GetPtok(EventType::kFFT, qid), do_fft_task);
+      worker_parking_->Wake();
+    }
+  }
+}
+
+void Agora::HandleDownlinkZf(size_t frame_id) {
+  this->dl_zf_last_frame_ = frame_id;
+  // Schedule precoding for downlink symbols
+  for (size_t i = 0; i < config_->Frame().NumDLSyms(); i++) {
+    size_t last_encoded_frame = this->encode_cur_frame_for_symbol_.at(i);
+    if ((last_encoded_frame != SIZE_MAX) && (last_encoded_frame >= frame_id)) {
+      ScheduleSubcarriers(EventType::kPrecode, frame_id,
+                          config_->Frame().GetDLSymbol(i));
+    }
+  }
+}
+
+void Agora::HandleEventEncode(const EventData& event) {
+  for (size_t i = 0; i < event.num_tags_; i++) {
+    size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
+    size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
+
+    bool last_encode_task = encode_counters_.CompleteTask(frame_id, symbol_id);
+    if (last_encode_task == true) {
+      this->encode_cur_frame_for_symbol_.at(
+          config_->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
+      // If precoder of the current frame exists
+      if (dl_zf_last_frame_ == frame_id) {
+        ScheduleSubcarriers(EventType::kPrecode, frame_id, symbol_id);
+      }
+      PrintPerSymbolDone(PrintType::kEncode, frame_id, symbol_id);
+
+      bool last_encode_symbol = this->encode_counters_.CompleteSymbol(frame_id);
+      if (last_encode_symbol == true) {
+        this->encode_counters_.Reset(frame_id);
+        this->stats_->MasterSetTsc(TsType::kEncodeDone, frame_id);
+        PrintPerFrameDone(PrintType::kEncode, frame_id);
+      }
+    }
+  }
+}
+
+void Agora::HandleEventPrecode(const EventData& event) {
+  for (size_t tag_id = 0; tag_id < event.num_tags_; tag_id++) {
+    // Precoding is done, schedule ifft
+    size_t sc_id = gen_tag_t(event.tags_[tag_id]).sc_id_;
+    size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
+    size_t symbol_id = gen_tag_t(event.tags_[tag_id]).symbol_id_;
+    PrintPerTaskDone(PrintType::kPrecode, frame_id, symbol_id, sc_id);
+    bool last_precode_task =
+        (kUseAtomicFrameCounters == true) ||
+        this->precode_counters_.CompleteTask(frame_id, symbol_id);
+
+    if (last_precode_task == true) {
+      // precode_cur_frame_for_symbol_.at(
+      //    this->config_->Frame().GetDLSymbolIdx(symbol_id)) =
+      //    frame_id;
+      ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
+      PrintPerSymbolDone(PrintType::kPrecode, frame_id, symbol_id);
+
+      bool last_precode_symbol =
+          this->precode_counters_.CompleteSymbol(frame_id);
+      if (last_precode_symbol == true) {
+        this->precode_counters_.Reset(frame_id);
+        this->stats_->MasterSetTsc(TsType::kPrecodeDone, frame_id);
+        PrintPerFrameDone(PrintType::kPrecode, frame_id);
+      }
+    }
+  }
+}
+
+bool Agora::HandleEventIfft(const EventData& event) {
+  const auto& cfg = config_;
+  for (size_t i = 0; i < event.num_tags_; i++) {
+    /* IFFT is done, schedule data transmission */
+    size_t ant_id = gen_tag_t(event.tags_[i]).ant_id_;
+    size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
+    size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
+    size_t symbol_idx_dl = cfg->Frame().GetDLSymbolIdx(symbol_id);
+    PrintPerTaskDone(PrintType::kIFFT, frame_id, symbol_id, ant_id);
+
+    bool last_ifft_task =
+        this->ifft_counters_.CompleteTask(frame_id, symbol_id);
+    if (last_ifft_task == true) {
+      ifft_cur_frame_for_symbol_.at(symbol_idx_dl) = frame_id;
+      if (symbol_idx_dl == ifft_next_symbol_) {
+        // Check the available symbols starting from the current symbol
+        // Only schedule symbols that are continuously avaialbe
+        for (size_t sym_id = symbol_idx_dl;
+             sym_id <= ifft_counters_.GetSymbolCount(frame_id); sym_id++) {
+          size_t symbol_ifft_frame = ifft_cur_frame_for_symbol_.at(sym_id);
+          if (symbol_ifft_frame == frame_id) {
+            ScheduleAntennasTX(frame_id, cfg->Frame().GetDLSymbol(sym_id));
+            ifft_next_symbol_++;
+          } else {
+            break;
+          }
+        }
+      }
+      PrintPerSymbolDone(PrintType::kIFFT, frame_id, symbol_id);
+
+      bool last_ifft_symbol = this->ifft_counters_.CompleteSymbol(frame_id);
+      if (last_ifft_symbol == true) {
+        ifft_next_symbol_ = 0;
+        this->stats_->MasterSetTsc(TsType::kIFFTDone, frame_id);
+        PrintPerFrameDone(PrintType::kIFFT, frame_id);
+        if (cfg->SplitMaster() == true) {
+          // The uplink master owns the schedule and processing frames
+          this->ifft_progress_.MarkDone(frame_id);
+        } else {
+          assert(frame_id == this->cur_proc_frame_id_);
+          this->CheckIncrementScheduleFrame(frame_id, kDownlinkComplete);
+          bool work_finished = this->CheckFrameComplete(frame_id);
+          if (work_finished == true) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool Agora::HandleEventTx(const EventData& event) {
+  const auto& cfg = config_;
+  // Data is sent
+  size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
+  size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+  size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+  PrintPerTaskDone(PrintType::kPacketTX, frame_id, symbol_id, ant_id);
+
+  bool last_tx_task = this->tx_counters_.CompleteTask(frame_id, symbol_id);
+  if (last_tx_task == false) {
+    return false;
+  }
+  PrintPerSymbolDone(PrintType::kPacketTX, frame_id, symbol_id);
+  // If tx of the first symbol is done
+  if (symbol_id == cfg->Frame().GetDLSymbol(0)) {
+    this->stats_->MasterSetTsc(TsType::kTXProcessedFirst, frame_id);
+    PrintPerFrameDone(PrintType::kPacketTXFirst, frame_id);
+  }
+
+  bool work_finished = false;
+  bool last_tx_symbol = this->tx_counters_.CompleteSymbol(frame_id);
+  if (last_tx_symbol == true) {
+    this->stats_->MasterSetTsc(TsType::kTXDone, frame_id);
+    PrintPerFrameDone(PrintType::kPacketTX, frame_id);
+
+    if (cfg->SplitMaster() == true) {
+      // The downlink of the frame is done, so the downlink master moves on
+      // to the next frame and the uplink master completes this one
+      this->ifft_counters_.Reset(frame_id);
+      this->tx_counters_.Reset(frame_id);
+      this->dl_proc_frame_id_++;
+      this->tx_progress_.MarkDone(frame_id);
+    } else {
+      work_finished = this->CheckFrameComplete(frame_id);
+    }
+  }
+
+  this->tx_count_++;
+  if (this->tx_count_ == tx_counters_.MaxSymbolCount() * 9000) {
+    this->tx_count_ = 0;
+
+    double diff = GetTime::GetTimeUs() - this->tx_begin_us_;
+    int samples_num_per_ue =
+        cfg->OfdmDataNum() * tx_counters_.MaxSymbolCount() * 1000;
+
+    MLPD_INFO(
+        "TX %d samples (per-client) to %zu clients "
+        "in %f secs, throughtput %f bps per-client "
+        "(16QAM), current tx queue length %zu\n",
+        samples_num_per_ue, cfg->UeNum(), diff,
+        samples_num_per_ue * std::log2(16.0f) / diff,
+        GetConq(EventType::kPacketTX, 0)->size_approx());
+    unused(diff);
+    unused(samples_num_per_ue);
+    this->tx_begin_us_ = GetTime::GetTimeUs();
+  }
+  return work_finished;
+}
+
+void Agora::RequestDownlinkProcessing(size_t frame_id) {
+  if (config_->SplitMaster() == true) {
+    TryEnqueueFallback(
+        &dl_message_queue_,
+        EventData(EventType::kDownlinkFrame,
+                  gen_tag_t::FrmSym(frame_id, 0).tag_));
+  } else {
+    ScheduleDownlinkProcessing(frame_id);
+  }
+}
+
+bool Agora::CheckDownlinkProgress() {
+  if (config_->Frame().NumDLSyms() == 0) {
+    return false;
+  }
+  if (((this->schedule_process_flags_ & kDownlinkComplete) == 0) &&
+      (this->ifft_progress_.Done(this->cur_sche_frame_id_) == true)) {
+    CheckIncrementScheduleFrame(this->cur_sche_frame_id_, kDownlinkComplete);
+  }
+  if (this->tx_progress_.Done(this->cur_proc_frame_id_) == true) {
+    return CheckFrameComplete(this->cur_proc_frame_id_);
+  }
+  return false;
+}
+
+void Agora::DownlinkMaster() {
+  // The downlink master is the second master thread
+  PinToCoreWithOffset(ThreadType::kMaster, DownlinkMasterCore() - 1, 1,
+                      config_->Placement());
+  const size_t max_events_needed =
+      kDequeueBulkSizeTXRX * config_->SocketThreadNum() +
+      kDequeueBulkSizeWorker * config_->WorkerThreadNum();
+  std::vector<EventData> events_list(max_events_needed);
+
+  while ((config_->Running() == true) &&
+         (SignalHandler::GotExitSignal() == false)) {
+    // ZF completes in frame order. dl_zf_last_frame_ starts at SIZE_MAX, so
+    // the first frame is zero.
+    while (this->zf_progress_.Done(this->dl_zf_last_frame_ + 1) == true) {
+      HandleDownlinkZf(this->dl_zf_last_frame_ + 1);
+    }
+
+    size_t num_events = dl_message_queue_.try_dequeue_bulk(
+        events_list.data(), kDequeueBulkSizeTXRX * config_->SocketThreadNum());
+    num_events += dl_complete_task_queue_[(this->dl_proc_frame_id_ & 0x1)]
+                      .try_dequeue_bulk(events_list.data() + num_events,
+                                        max_events_needed - num_events);
+    for (size_t ev_i = 0; ev_i < num_events; ev_i++) {
+      const EventData& event = events_list.at(ev_i);
+      switch (event.event_type_) {
+        case EventType::kDownlinkFrame:
+          ScheduleDownlinkProcessing(gen_tag_t(event.tags_[0]).frame_id_);
+          break;
+        case EventType::kEncode:
+          HandleEventEncode(event);
+          break;
+        case EventType::kPrecode:
+          HandleEventPrecode(event);
+          break;
+        case EventType::kIFFT:
+          HandleEventIfft(event);
+          break;
+        case EventType::kPacketTX:
+          HandleEventTx(event);
+          break;
+        default:
+          MLPD_ERROR("Wrong event type in downlink message queue!");
+          std::exit(0);
+      }
+    }
+  }
+  MLPD_SYMBOL("Agora: downlink master exit\n");
+}
+
 void Agora::HandleEventFft(size_t tag) {
   size_t frame_id = gen_tag_t(tag).frame_id_;
   size_t symbol_id = gen_tag_t(tag).symbol_id_;
@@ -752,6 +986,7 @@ void Agora::HandleEventFft(size_t tag) {
       bool last_uplink_fft = uplink_fft_counters_.CompleteSymbol(frame_id);
       if (last_uplink_fft == true) {
         uplink_fft_counters_.Reset(frame_id);
+        CheckBigstationUplinkScheduled(frame_id);
       }
     }
   } else if ((sym_type == SymbolType::kCalDL) ||
@@ -768,189 +1003,326 @@ void Agora::HandleEventFft(size_t tag) {
   }
 }
 
+bool Agora::TrackReceivedAntenna(const Packet* pkt) {
+  const SymbolType sym_type = config_->GetSymbolType(pkt->symbol_id_);
+  if ((sym_type != SymbolType::kPilot) && (sym_type != SymbolType::kUL)) {
+    return true;
+  }
+  if (this->antenna_erasures_.IsErased(pkt->frame_id_, pkt->symbol_id_,
+                                       pkt->ant_id_) == true) {
+    return false;
+  }
+  if (this->antenna_erasures_.MarkReceived(pkt->frame_id_, pkt->symbol_id_,
+                                           pkt->ant_id_,
+                                           GetTime::Rdtsc()) == true) {
+    // Track every pilot and uplink symbol from the frame's first packet, so
+    // that symbols that lose all their antennas time out too
+    for (size_t symbol_id = 0; symbol_id < config_->Frame().NumTotalSyms();
+         symbol_id++) {
+      const SymbolType type = config_->GetSymbolType(symbol_id);
+      if ((type == SymbolType::kPilot) || (type == SymbolType::kUL)) {
+        this->pending_symbols_.push({pkt->frame_id_, symbol_id});
+      }
+    }
+  }
+  return true;
+}
+
+void Agora::CheckAntennaErasures() {
+  const size_t cur_tsc = GetTime::Rdtsc();
+  while (this->pending_symbols_.empty() == false) {
+    const PendingSymbol& pending = this->pending_symbols_.front();
+    const bool dropped =
+        (this->frame_deadline_tsc_ > 0) &&
+        (this->dropped_frames_.IsDropped(pending.frame_id_) == true);
+    if ((dropped == false) &&
+        (this->antenna_erasures_.IsComplete(pending.frame_id_,
+                                            pending.symbol_id_) == false)) {
+      if (this->antenna_erasures_.TimedOut(pending.frame_id_,
+                                           pending.symbol_id_, cur_tsc,
+                                           this->antenna_erasure_tsc_) ==
+          false) {
+        break;
+      }
+      EraseMissingAntennas(pending.frame_id_, pending.symbol_id_);
+    }
+    this->pending_symbols_.pop();
+  }
+}
+
+void Agora::EraseMissingAntennas(size_t frame_id, size_t symbol_id) {
+  const std::bitset<kMaxAntennas> erased =
+      this->antenna_erasures_.EraseMissing(frame_id, symbol_id);
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  MLPD_FRAME("Agora: frame %zu symbol %zu: erasing %zu missing antennas\n",
+            frame_id, symbol_id, erased.count());
+  this->phy_stats_->UpdateAntennaErasures(erased);
+
+  for (size_t ant_id = 0; ant_id < config_->BsAntNum(); ant_id++) {
+    if (erased.test(ant_id) == false) {
+      continue;
+    }
+    const size_t packet_id =
+        (((frame_slot * config_->Frame().NumTotalSyms()) + symbol_id) *
+         config_->BsAntNum()) +
+        ant_id;
+    auto* pkt = new (&this->erased_packets_.at(packet_id *
+                                               Packet::kOffsetOfData))
+        Packet(frame_id, symbol_id, 0, ant_id);
+    pkt->magic_ = Packet::kErasedMagic;
+    RxPacket& rx_packet = this->erased_rx_packets_.at(packet_id);
+    RtAssert(rx_packet.Set(pkt) == true,
+             "Agora: placeholder of an erased antenna still in use");
+    rx_packet.Use();
+    UpdateRxCounters(frame_id, symbol_id);
+    this->fft_queue_arr_.at(frame_slot).push(fft_req_tag_t(rx_packet));
+  }
+  // No more packets may arrive for the symbol to trigger the scheduling
+  ScheduleFft();
+}
+
+void Agora::CheckBigstationUplinkScheduled(size_t frame_id) {
+  if ((config_->BigstationMode() == false) ||
+      (config_->Frame().NumULSyms() == 0) || (zf_last_frame_ != frame_id)) {
+    return;
+  }
+  for (size_t i = 0; i < config_->Frame().NumULSyms(); i++) {
+    if (this->fft_cur_frame_for_symbol_.at(i) != frame_id) {
+      return;
+    }
+  }
+  // All demodulation tasks of the frame are scheduled, so its FFT and ZF
+  // state may be reused by the next frame while the pools finish it
+  CheckIncrementScheduleFrame(frame_id, kUplinkComplete);
+}
+
 void Agora::Worker(int tid) {
-  PinToCoreWithOffset(ThreadType::kWorker, base_worker_core_offset_, tid);
+  RunWorker(ThreadType::kWorker, tid, {});
+}
+
+void Agora::RunWorker(ThreadType thread_type, int tid,
+                      const std::vector<EventType>& stages) {
+  PinToCoreWithOffset(thread_type, base_worker_core_offset_, tid,
+                      config_->Placement());
+  std::unique_ptr<WorkerContext> context = CreateWorkerContext(tid, stages);
+  WorkerIdler idler(worker_parking_, config_->WorkerIdleSpinPolls(),
+                    config_->WorkerIdlePausePolls(),
+                    config_->WorkerParkTimeoutUs());
+  while (this->config_->Running() == true) {
+    if (WorkerPoll(*context) == true) {
+      idler.Busy();
+    } else {
+      idler.Idle();
+    }
+  }
+  MLPD_SYMBOL("Agora worker %d (%s) exit\n", tid,
+              ThreadTypeStr(thread_type).c_str());
+}
+
+std::unique_ptr<Agora::WorkerContext> Agora::CreateWorkerContext(
+    int tid, const std::vector<EventType>& stages) {
+  auto context = std::make_unique<WorkerContext>();
+  auto runs_stage = [&stages](EventType event_type) {
+    return stages.empty() ||
+           (std::find(stages.begin(), stages.end(), event_type) !=
+            stages.end());
+  };
+  const bool uplink = config_->Frame().NumULSyms() > 0;
+  const bool downlink = config_->Frame().NumDLSyms() > 0;
 
   /* Initialize operators */
-  auto compute_zf = std::make_unique<DoZF>(
-      this->config_, tid, this->csi_buffers_, this->calib_dl_buffer_,
-      this->calib_ul_buffer_, this->ul_zf_matrices_, this->dl_zf_matrices_,
-      this->stats_.get());
+  const AntennaErasures* antenna_erasures =
+      (this->antenna_erasure_tsc_ > 0) ? &this->antenna_erasures_ : nullptr;
+  if (runs_stage(EventType::kZF) == true) {
+    context->compute_zf_ = std::make_unique<DoZF>(
+        this->config_, tid, this->csi_buffers_, this->calib_dl_buffer_,
+        this->calib_ul_buffer_, this->ul_zf_matrices_, this->dl_zf_matrices_,
+        this->stats_.get(), antenna_erasures);
+  }
 
-  auto compute_fft = std::make_unique<DoFFT>(
-      this->config_, tid, this->data_buffer_, this->csi_buffers_,
-      this->calib_dl_buffer_, this->calib_ul_buffer_, this->phy_stats_.get(),
-      this->stats_.get());
+  if (runs_stage(EventType::kFFT) == true) {
+    context->compute_fft_ = std::make_unique<DoFFT>(
+        this->config_, tid, this->data_buffer_, this->csi_buffers_,
+        this->calib_dl_buffer_, this->calib_ul_buffer_,
+        this->phy_stats_.get(), this->stats_.get());
+  }
 
   // Downlink workers
-  auto compute_ifft =
-      std::make_unique<DoIFFT>(this->config_, tid, this->dl_ifft_buffer_,
-                               this->dl_socket_buffer_, this->stats_.get());
+  if ((downlink == true) && (runs_stage(EventType::kIFFT) == true)) {
+    context->compute_ifft_ =
+        std::make_unique<DoIFFT>(this->config_, tid, this->dl_ifft_buffer_,
+                                 this->dl_socket_buffer_, this->stats_.get());
+  }
 
-  auto compute_precode = std::make_unique<DoPrecode>(
-      this->config_, tid, this->dl_zf_matrices_, this->dl_ifft_buffer_,
-      this->dl_encoded_buffer_, this->stats_.get());
+  if ((downlink == true) && (runs_stage(EventType::kPrecode) == true)) {
+    context->compute_precode_ = std::make_unique<DoPrecode>(
+        this->config_, tid, this->dl_zf_matrices_, this->dl_ifft_buffer_,
+        this->dl_encoded_buffer_, this->stats_.get());
+  }
 
-  auto compute_encoding = std::make_unique<DoEncode>(
-      config_, tid, (kEnableMac == true) ? dl_bits_buffer_ : config_->DlBits(),
-      (kEnableMac == true) ? kFrameWnd : 1, dl_encoded_buffer_,
-      this->stats_.get());
+  if ((downlink == true) && (runs_stage(EventType::kEncode) == true)) {
+    context->compute_encoding_ = std::make_unique<DoEncode>(
+        config_, tid,
+        (kEnableMac == true) ? dl_bits_buffer_ : config_->DlBits(),
+        (kEnableMac == true) ? config_->FrameWnd() : 1, dl_encoded_buffer_,
+        this->stats_.get());
+  }
 
   // Uplink workers
-  auto compute_decoding = std::make_unique<DoDecode>(
-      this->config_, tid, this->demod_buffers_, this->decoded_buffer_,
-      this->phy_stats_.get(), this->stats_.get());
-
-  auto compute_demul = std::make_unique<DoDemul>(
-      this->config_, tid, this->data_buffer_, this->ul_zf_matrices_,
-      this->ue_spec_pilot_buffer_, this->equal_buffer_, this->demod_buffers_,
-      this->phy_stats_.get(), this->stats_.get());
-
-  std::vector<Doer*> computers_vec;
-  std::vector<EventType> events_vec;
-  ///*************************
-  computers_vec.push_back(compute_zf.get());
-  computers_vec.push_back(compute_fft.get());
-  events_vec.push_back(EventType::kZF);
-  events_vec.push_back(EventType::kFFT);
+  if ((uplink == true) && (runs_stage(EventType::kDecode) == true)) {
+    context->compute_decoding_ = std::make_unique<DoDecode>(
+        this->config_, tid, this->demod_buffers_, this->decoded_buffer_,
+        this->phy_stats_.get(), this->stats_.get());
+  }
 
-  if (config_->Frame().NumULSyms() > 0) {
-    computers_vec.push_back(compute_decoding.get());
-    computers_vec.push_back(compute_demul.get());
-    events_vec.push_back(EventType::kDecode);
-    events_vec.push_back(EventType::kDemul);
+  if ((uplink == true) && (runs_stage(EventType::kDemul) == true)) {
+    context->compute_demul_ = std::make_unique<DoDemul>(
+        this->config_, tid, this->data_buffer_, this->ul_zf_matrices_,
+        this->ue_spec_pilot_buffer_, this->equal_buffer_,
+        this->demod_buffers_, this->phy_stats_.get(), this->stats_.get());
   }
 
-  if (config_->Frame().NumDLSyms() > 0) {
-    computers_vec.push_back(compute_ifft.get());
-    computers_vec.push_back(compute_precode.get());
-    computers_vec.push_back(compute_encoding.get());
-    events_vec.push_back(EventType::kIFFT);
-    events_vec.push_back(EventType::kPrecode);
-    events_vec.push_back(EventType::kEncode);
+  if (kUseAtomicFrameCounters == true) {
+    if (context->compute_zf_ != nullptr) {
+      context->compute_zf_->SetTaskCounters(&zf_task_counters_);
+    }
+    if (context->compute_demul_ != nullptr) {
+      context->compute_demul_->SetTaskCounters(&demul_task_counters_);
+    }
+    if (context->compute_decoding_ != nullptr) {
+      context->compute_decoding_->SetTaskCounters(&decode_task_counters_);
+    }
+    if (context->compute_precode_ != nullptr) {
+      context->compute_precode_->SetTaskCounters(&precode_task_counters_);
+    }
   }
 
-  size_t cur_qid = 0;
-  size_t empty_queue_itrs = 0;
-  bool empty_queue = true;
-  while (this->config_->Running() == true) {
-    for (size_t i = 0; i < computers_vec.size(); i++) {
-      if (computers_vec.at(i)->TryLaunch(*GetConq(events_vec.at(i), cur_qid),
-                                         complete_task_queue_[cur_qid],
-                                         worker_ptoks_ptr_[tid][cur_qid])) {
-        empty_queue = false;
-        break;
+  std::array<Doer*, kNumEventTypes> computers{};
+  computers.at(static_cast<size_t>(EventType::kZF)) =
+      context->compute_zf_.get();
+  computers.at(static_cast<size_t>(EventType::kFFT)) =
+      context->compute_fft_.get();
+  computers.at(static_cast<size_t>(EventType::kDecode)) =
+      context->compute_decoding_.get();
+  computers.at(static_cast<size_t>(EventType::kDemul)) =
+      context->compute_demul_.get();
+  computers.at(static_cast<size_t>(EventType::kIFFT)) =
+      context->compute_ifft_.get();
+  computers.at(static_cast<size_t>(EventType::kPrecode)) =
+      context->compute_precode_.get();
+  computers.at(static_cast<size_t>(EventType::kEncode)) =
+      context->compute_encoding_.get();
+
+  // FFT tasks are tagged by packet, so the master drops their completions
+  if (this->frame_deadline_tsc_ > 0) {
+    for (EventType event_type :
+         {EventType::kZF, EventType::kIFFT, EventType::kPrecode,
+          EventType::kEncode, EventType::kDecode, EventType::kDemul}) {
+      Doer* computer = computers.at(static_cast<size_t>(event_type));
+      if (computer != nullptr) {
+        computer->SetDroppedFrames(&dropped_frames_);
       }
     }
-    // If all queues in this set are empty for 5 iterations,
-    // check the other set of queues
-    if (empty_queue == true) {
-      empty_queue_itrs++;
-      if (empty_queue_itrs == 5) {
-        if (this->cur_sche_frame_id_ != this->cur_proc_frame_id_) {
-          cur_qid ^= 0x1;
-        } else {
-          cur_qid = (this->cur_sche_frame_id_ & 0x1);
+  }
+
+  // Count the events of the tasks of each doer. The counters are opened for
+  // the calling thread, which runs the worker.
+  if (config_->UsePerfCounters() == true) {
+    context->perf_counters_ = std::make_unique<PerfCounters>();
+    if (context->perf_counters_->IsOpen() == true) {
+      for (const auto& [event_type, doer_type] :
+           {std::make_pair(EventType::kZF, DoerType::kZF),
+            std::make_pair(EventType::kFFT, DoerType::kFFT),
+            std::make_pair(EventType::kDecode, DoerType::kDecode),
+            std::make_pair(EventType::kDemul, DoerType::kDemul),
+            std::make_pair(EventType::kIFFT, DoerType::kIFFT),
+            std::make_pair(EventType::kPrecode, DoerType::kPrecode),
+            std::make_pair(EventType::kEncode, DoerType::kEncode)}) {
+        Doer* computer = computers.at(static_cast<size_t>(event_type));
+        if (computer != nullptr) {
+          computer->SetPerfCounters(context->perf_counters_.get(),
+                                    this->stats_->GetPerfStat(doer_type, tid));
         }
-        empty_queue_itrs = 0;
       }
-    } else {
-      empty_queue = true;
     }
   }
-  MLPD_SYMBOL("Agora worker %d exit\n", tid);
-}
-
-void Agora::WorkerFft(int tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerFFT, base_worker_core_offset_, tid);
-
-  /* Initialize FFT operator */
-  std::unique_ptr<DoFFT> compute_fft(
-      new DoFFT(config_, tid, data_buffer_, csi_buffers_, calib_dl_buffer_,
-                calib_ul_buffer_, this->phy_stats_.get(), this->stats_.get()));
-  std::unique_ptr<DoIFFT> compute_ifft(new DoIFFT(
-      config_, tid, dl_ifft_buffer_, dl_socket_buffer_, this->stats_.get()));
 
-  while (this->config_->Running() == true) {
-    // TODO refactor the if / else
-    if (compute_fft->TryLaunch(*GetConq(EventType::kFFT, 0),
-                               complete_task_queue_[0],
-                               worker_ptoks_ptr_[tid][0]) == true) {
-      // Do nothing
-    } else if ((config_->Frame().NumDLSyms() > 0) &&
-               (compute_ifft->TryLaunch(*GetConq(EventType::kIFFT, 0),
-                                        complete_task_queue_[0],
-                                        worker_ptoks_ptr_[tid][0]) == true)) {
-      // Do nothing
+  // Completions are sent to the master in batches, one per schedule queue
+  const size_t flush_timeout_tsc =
+      GetTime::UsToCycles(kCompletionFlushUs, config_->FreqGhz());
+  for (size_t qid = 0; qid < kScheduleQueues; qid++) {
+    context->completions_.emplace_back(&complete_task_queue_[qid],
+                                       worker_ptoks_ptr_[tid][qid],
+                                       flush_timeout_tsc);
+    if (config_->SplitMaster() == true) {
+      context->dl_completions_.emplace_back(&dl_complete_task_queue_[qid],
+                                            dl_worker_ptoks_ptr_[tid][qid],
+                                            flush_timeout_tsc);
     }
   }
-}
-
-void Agora::WorkerZf(int tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerZF, base_worker_core_offset_, tid);
-
-  /* Initialize ZF operator */
-  std::unique_ptr<DoZF> compute_zf(
-      new DoZF(config_, tid, csi_buffers_, calib_dl_buffer_, calib_ul_buffer_,
-               ul_zf_matrices_, dl_zf_matrices_, this->stats_.get()));
 
-  while (this->config_->Running() == true) {
-    compute_zf->TryLaunch(*GetConq(EventType::kZF, 0), complete_task_queue_[0],
-                          worker_ptoks_ptr_[tid][0]);
+  // Poll the stages in the configured priority order
+  for (EventType event_type : config_->WorkerStagePriority()) {
+    Doer* computer = computers.at(static_cast<size_t>(event_type));
+    if (computer != nullptr) {
+      context->computers_vec_.push_back(computer);
+      context->events_vec_.push_back(event_type);
+      context->completions_vec_.push_back(
+          ((config_->SplitMaster() == true) && IsDownlinkTask(event_type))
+              ? &context->dl_completions_
+              : &context->completions_);
+    }
   }
+  return context;
 }
 
-void Agora::WorkerDemul(int tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerDemul, base_worker_core_offset_, tid);
-
-  std::unique_ptr<DoDemul> compute_demul(
-      new DoDemul(config_, tid, data_buffer_, ul_zf_matrices_,
-                  ue_spec_pilot_buffer_, equal_buffer_, demod_buffers_,
-                  this->phy_stats_.get(), this->stats_.get()));
-
-  /* Initialize Precode operator */
-  std::unique_ptr<DoPrecode> compute_precode(
-      new DoPrecode(config_, tid, dl_zf_matrices_, dl_ifft_buffer_,
-                    dl_encoded_buffer_, this->stats_.get()));
-
-  assert(false);
-
-  while (this->config_->Running() == true) {
-    if (config_->Frame().NumDLSyms() > 0) {
-      compute_precode->TryLaunch(*GetConq(EventType::kDemul, 0),
-                                 complete_task_queue_[0],
-                                 worker_ptoks_ptr_[tid][0]);
-    } else {
-      compute_demul->TryLaunch(*GetConq(EventType::kPrecode, 0),
-                               complete_task_queue_[0],
-                               worker_ptoks_ptr_[tid][0]);
+bool Agora::WorkerPoll(WorkerContext& context) {
+  // Earliest deadline first: serve the oldest frame in processing before
+  // the next one. The frames use the schedule queues by frame parity.
+  const size_t oldest_qid = (this->cur_proc_frame_id_ & 0x1);
+  bool launched = false;
+  for (size_t i = 0; (i < kScheduleQueues) && (launched == false); i++) {
+    const size_t qid = oldest_qid ^ i;
+    for (size_t j = 0; j < context.computers_vec_.size(); j++) {
+      if (context.computers_vec_.at(j)->TryLaunch(
+              *GetConq(context.events_vec_.at(j), qid),
+              context.completions_vec_.at(j)->at(qid))) {
+        launched = true;
+        break;
+      }
+    }
+  }
+  for (auto* batches : {&context.completions_, &context.dl_completions_}) {
+    for (auto& batch : *batches) {
+      // Do not hold completions while there is no work
+      if (launched == true) {
+        batch.FlushIfExpired();
+      } else {
+        batch.Flush();
+      }
     }
   }
+  return launched;
 }
 
-void Agora::WorkerDecode(int tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerDecode, base_worker_core_offset_, tid);
+// In Bigstation mode, each pool serves one uplink stage and the downlink
+// stage that runs at the same point of the pipeline
+void Agora::WorkerFft(int tid) {
+  RunWorker(ThreadType::kWorkerFFT, tid, {EventType::kFFT, EventType::kIFFT});
+}
 
-  std::unique_ptr<DoEncode> compute_encoding(new DoEncode(
-      config_, tid, (kEnableMac == true) ? dl_bits_buffer_ : config_->DlBits(),
-      (kEnableMac == true) ? kFrameWnd : 1, dl_encoded_buffer_,
-      this->stats_.get()));
+void Agora::WorkerZf(int tid) {
+  RunWorker(ThreadType::kWorkerZF, tid, {EventType::kZF});
+}
 
-  std::unique_ptr<DoDecode> compute_decoding(
-      new DoDecode(config_, tid, demod_buffers_, decoded_buffer_,
-                   this->phy_stats_.get(), this->stats_.get()));
+void Agora::WorkerDemul(int tid) {
+  RunWorker(ThreadType::kWorkerDemul, tid,
+            {EventType::kDemul, EventType::kPrecode});
+}
 
-  while (this->config_->Running() == true) {
-    if (config_->Frame().NumDLSyms() > 0) {
-      compute_encoding->TryLaunch(*GetConq(EventType::kEncode, 0),
-                                  complete_task_queue_[0],
-                                  worker_ptoks_ptr_[tid][0]);
-    } else {
-      compute_decoding->TryLaunch(*GetConq(EventType::kDecode, 0),
-                                  complete_task_queue_[0],
-                                  worker_ptoks_ptr_[tid][0]);
-    }
-  }
+void Agora::WorkerDecode(int tid) {
+  RunWorker(ThreadType::kWorkerDecode, tid,
+            {EventType::kDecode, EventType::kEncode});
 }
 
 void Agora::CreateThreads() {
@@ -986,7 +1358,7 @@ void Agora::UpdateRanConfig(RanConfig rc) {
 }
 
 void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   if (config_->IsPilot(frame_id, symbol_id)) {
     rx_counters_.num_pilot_pkts_[frame_slot]++;
     if (rx_counters_.num_pilot_pkts_[frame_slot] ==
@@ -1016,13 +1388,22 @@ void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
         }
         this->encode_deferral_.push(frame_id);
       } else {
-        ScheduleDownlinkProcessing(frame_id);
+        RequestDownlinkProcessing(frame_id);
       }
     }
     this->stats_->MasterSetTsc(TsType::kFirstSymbolRX, frame_id);
+    if (this->frame_deadline_tsc_ > 0) {
+      this->frame_rx_start_tsc_.at(frame_slot) = GetTime::Rdtsc();
+      // Workers may have counted a task of the frame previously dropped in
+      // this slot after the drop reset the counters
+      if ((frame_id >= config_->FrameWnd()) &&
+          (this->dropped_frames_.IsDropped(frame_id - config_->FrameWnd()))) {
+        ResetTaskCounters(frame_id);
+      }
+    }
     if (kDebugPrintPerFrameStart) {
-      const size_t prev_frame_slot = (frame_slot + kFrameWnd - 1) % kFrameWnd;
-      std::printf(
+      const size_t prev_frame_slot = config_->FrameSlot(frame_id - 1);
+      MLPD_INFO(
           "Main [frame %zu + %.2f ms since last frame]: Received "
           "first packet. Remaining packets in prev frame: %zu\n",
           frame_id,
@@ -1044,44 +1425,44 @@ void Agora::PrintPerFrameDone(PrintType print_type, size_t frame_id) {
   if (kDebugPrintPerFrameDone == true) {
     switch (print_type) {
       case (PrintType::kPacketRXPilots):
-        std::printf("Main [frame %zu + %.2f ms]: Received all pilots\n",
-                    frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kPilotAllRX, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Received all pilots\n",
+                  frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kPilotAllRX, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kPacketRX):
-        std::printf("Main [frame %zu + %.2f ms]: Received all packets\n",
-                    frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kRXDone, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Received all packets\n",
+                  frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kRXDone, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kFFTPilots):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: FFT-ed all pilots\n", frame_id,
             this->stats_->MasterGetDeltaMs(TsType::kFFTPilotsDone,
                                            TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kFFTCal):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: FFT-ed all calibration symbols\n",
             frame_id,
             this->stats_->MasterGetUsSince(TsType::kRCAllRX, frame_id) /
                 1000.0);
         break;
       case (PrintType::kZF):
-        std::printf("Main [frame %zu + %.2f ms]: Completed zero-forcing\n",
-                    frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kZFDone, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Completed zero-forcing\n",
+                  frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kZFDone, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kDemul):
-        std::printf("Main [frame %zu + %.2f ms]: Completed demodulation\n",
-                    frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kDemulDone, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Completed demodulation\n",
+                  frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kDemulDone, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kDecode):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed LDPC decoding (%zu UL "
             "symbols)\n",
             frame_id,
@@ -1090,36 +1471,36 @@ void Agora::PrintPerFrameDone(PrintType print_type, size_t frame_id) {
             config_->Frame().NumULSyms());
         break;
       case (PrintType::kPacketFromMac):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed MAC RX \n", frame_id,
             this->stats_->MasterGetMsSince(TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kEncode):
-        std::printf("Main [frame %zu + %.2f ms]: Completed LDPC encoding\n",
-                    frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kEncodeDone, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Completed LDPC encoding\n",
+                  frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kEncodeDone, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kPrecode):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed precoding\n", frame_id,
             this->stats_->MasterGetDeltaMs(TsType::kPrecodeDone,
                                            TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kIFFT):
-        std::printf("Main [frame %zu + %.2f ms]: Completed IFFT\n", frame_id,
-                    this->stats_->MasterGetDeltaMs(
-                        TsType::kIFFTDone, TsType::kFirstSymbolRX, frame_id));
+        MLPD_INFO("Main [frame %zu + %.2f ms]: Completed IFFT\n", frame_id,
+                  this->stats_->MasterGetDeltaMs(
+                      TsType::kIFFTDone, TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kPacketTXFirst):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed TX of first symbol\n",
             frame_id,
             this->stats_->MasterGetDeltaMs(TsType::kTXProcessedFirst,
                                            TsType::kFirstSymbolRX, frame_id));
         break;
       case (PrintType::kPacketTX):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed TX (%zu DL symbols)\n",
             frame_id,
             this->stats_->MasterGetDeltaMs(TsType::kTXDone,
@@ -1127,12 +1508,12 @@ void Agora::PrintPerFrameDone(PrintType print_type, size_t frame_id) {
             config_->Frame().NumDLSyms());
         break;
       case (PrintType::kPacketToMac):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu + %.2f ms]: Completed MAC TX \n", frame_id,
             this->stats_->MasterGetMsSince(TsType::kFirstSymbolRX, frame_id));
         break;
       default:
-        std::printf("Wrong task type in frame done print!");
+        MLPD_ERROR("Wrong task type in frame done print!\n");
     }
   }
 }
@@ -1142,7 +1523,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
   if (kDebugPrintPerSymbolDone == true) {
     switch (print_type) {
       case (PrintType::kFFTPilots):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: FFT-ed pilot symbol, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1150,7 +1531,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             pilot_fft_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kFFTData):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: FFT-ed data symbol, "
             "%zu precoder status: %d\n",
             frame_id, symbol_id,
@@ -1159,7 +1540,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             static_cast<int>(zf_last_frame_ == frame_id));
         break;
       case (PrintType::kDemul):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed "
             "demodulation, "
             "%zu symbols done\n",
@@ -1168,7 +1549,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             demul_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kDecode):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed decoding, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1176,7 +1557,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             decode_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kEncode):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed encoding, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1184,7 +1565,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             encode_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kPrecode):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed precoding, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1192,7 +1573,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             precode_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kIFFT):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed IFFT, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1200,7 +1581,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             ifft_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kPacketTX):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed TX, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1208,7 +1589,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             tx_counters_.GetSymbolCount(frame_id) + 1);
         break;
       case (PrintType::kPacketToMac):
-        std::printf(
+        MLPD_INFO(
             "Main [frame %zu symbol %zu + %.3f ms]: Completed MAC TX, "
             "%zu symbols done\n",
             frame_id, symbol_id,
@@ -1216,7 +1597,7 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
             tomac_counters_.GetSymbolCount(frame_id) + 1);
         break;
       default:
-        std::printf("Wrong task type in symbol done print!");
+        MLPD_ERROR("Wrong task type in symbol done print!\n");
     }
   }
 }
@@ -1224,52 +1605,66 @@ void Agora::PrintPerSymbolDone(PrintType print_type, size_t frame_id,
 void Agora::PrintPerTaskDone(PrintType print_type, size_t frame_id,
                              size_t symbol_id, size_t ant_or_sc_id) {
   if (kDebugPrintPerTaskDone == true) {
+    // With worker-side counting the master only sees the task that completes
+    // the symbol (the atomic counter has already reset itself), so all of the
+    // symbol's tasks are done
     switch (print_type) {
       case (PrintType::kZF):
-        std::printf("Main thread: ZF done frame: %zu, subcarrier %zu\n",
-                    frame_id, ant_or_sc_id);
+        MLPD_INFO(
+            "Main thread: ZF done frame: %zu, subcarrier %zu, num tasks "
+            "done: %zu\n",
+            frame_id, ant_or_sc_id,
+            (kUseAtomicFrameCounters == true)
+                ? zf_task_counters_.MaxTaskCount()
+                : zf_counters_.GetTaskCount(frame_id));
         break;
       case (PrintType::kRC):
-        std::printf("Main thread: RC done frame: %zu, subcarrier %zu\n",
-                    frame_id, ant_or_sc_id);
+        MLPD_INFO("Main thread: RC done frame: %zu, subcarrier %zu\n",
+                  frame_id, ant_or_sc_id);
         break;
       case (PrintType::kDemul):
-        std::printf(
+        MLPD_INFO(
             "Main thread: Demodulation done frame: %zu, symbol: %zu, sc: "
             "%zu, num blocks done: %zu\n",
             frame_id, symbol_id, ant_or_sc_id,
-            demul_counters_.GetTaskCount(frame_id, symbol_id));
+            (kUseAtomicFrameCounters == true)
+                ? demul_task_counters_.MaxTaskCount()
+                : demul_counters_.GetTaskCount(frame_id, symbol_id));
         break;
       case (PrintType::kDecode):
-        std::printf(
+        MLPD_INFO(
             "Main thread: Decoding done frame: %zu, symbol: %zu, sc: %zu, "
             "num blocks done: %zu\n",
             frame_id, symbol_id, ant_or_sc_id,
-            decode_counters_.GetTaskCount(frame_id, symbol_id));
+            (kUseAtomicFrameCounters == true)
+                ? decode_task_counters_.MaxTaskCount()
+                : decode_counters_.GetTaskCount(frame_id, symbol_id));
         break;
       case (PrintType::kPrecode):
-        std::printf(
+        MLPD_INFO(
             "Main thread: Precoding done frame: %zu, symbol: %zu, "
             "subcarrier: %zu, total SCs: %zu\n",
             frame_id, symbol_id, ant_or_sc_id,
-            precode_counters_.GetTaskCount(frame_id, symbol_id));
+            (kUseAtomicFrameCounters == true)
+                ? precode_task_counters_.MaxTaskCount()
+                : precode_counters_.GetTaskCount(frame_id, symbol_id));
         break;
       case (PrintType::kIFFT):
-        std::printf(
+        MLPD_INFO(
             "Main thread: IFFT done frame: %zu, symbol: %zu, antenna: %zu, "
             "total ants: %zu\n",
             frame_id, symbol_id, ant_or_sc_id,
             ifft_counters_.GetTaskCount(frame_id, symbol_id));
         break;
       case (PrintType::kPacketTX):
-        std::printf(
+        MLPD_INFO(
             "Main thread: TX done frame: %zu, symbol: %zu, antenna: %zu, "
             "total packets: %zu\n",
             frame_id, symbol_id, ant_or_sc_id,
             tx_counters_.GetTaskCount(frame_id, symbol_id));
         break;
       default:
-        std::printf("Wrong task type in task done print!");
+        MLPD_ERROR("Wrong task type in task done print!\n");
     }
   }
 }
@@ -1283,6 +1678,13 @@ void Agora::InitializeQueues() {
   for (auto& c : complete_task_queue_) {
     c = mt_queue_t(kDefaultWorkerQueueSize * data_symbol_num_perframe);
   }
+  if (config_->SplitMaster() == true) {
+    dl_message_queue_ =
+        mt_queue_t(kDefaultMessageQueueSize * data_symbol_num_perframe);
+    for (auto& c : dl_complete_task_queue_) {
+      c = mt_queue_t(kDefaultWorkerQueueSize * data_symbol_num_perframe);
+    }
+  }
   // Create concurrent queues for each Doer
   for (auto& vec : sched_info_arr_) {
     for (auto& s : vec) {
@@ -1302,6 +1704,10 @@ void Agora::InitializeQueues() {
     for (size_t j = 0; j < kScheduleQueues; j++) {
       worker_ptoks_ptr_[i][j] =
           new moodycamel::ProducerToken(complete_task_queue_[j]);
+      dl_worker_ptoks_ptr_[i][j] =
+          (config_->SplitMaster() == true)
+              ? new moodycamel::ProducerToken(dl_complete_task_queue_[j])
+              : nullptr;
     }
   }
 }
@@ -1322,19 +1728,21 @@ void Agora::FreeQueues() {
   for (size_t i = 0; i < config_->WorkerThreadNum(); i++) {
     for (size_t j = 0; j < kScheduleQueues; j++) {
       delete worker_ptoks_ptr_[i][j];
+      delete dl_worker_ptoks_ptr_[i][j];
     }
   }
 }
 
 void Agora::InitializeUplinkBuffers() {
   const auto& cfg = config_;
-  const size_t task_buffer_symbol_num_ul = cfg->Frame().NumULSyms() * kFrameWnd;
+  const size_t task_buffer_symbol_num_ul =
+      cfg->Frame().NumULSyms() * cfg->FrameWnd();
 
-  socket_buffer_size_ = cfg->PacketLength() * cfg->BsAntNum() * kFrameWnd *
-                        cfg->Frame().NumTotalSyms();
+  socket_buffer_size_ = PacketTXRX::RxPacketStride(cfg) * cfg->BsAntNum() *
+                        cfg->FrameWnd() * cfg->Frame().NumTotalSyms();
 
   socket_buffer_.Malloc(cfg->SocketThreadNum() /* RX */, socket_buffer_size_,
-                        Agora_memory::Alignment_t::kAlign64);
+                        PacketTXRX::kRxBufferAlignment);
 
   data_buffer_.Malloc(task_buffer_symbol_num_ul,
                       cfg->OfdmDataNum() * cfg->BsAntNum(),
@@ -1344,9 +1752,10 @@ void Agora::InitializeUplinkBuffers() {
                        cfg->OfdmDataNum() * cfg->UeNum(),
                        Agora_memory::Alignment_t::kAlign64);
   ue_spec_pilot_buffer_.Calloc(
-      kFrameWnd, cfg->Frame().ClientUlPilotSymbols() * cfg->UeNum(),
+      cfg->FrameWnd(), cfg->Frame().ClientUlPilotSymbols() * cfg->UeNum(),
       Agora_memory::Alignment_t::kAlign64);
 
+  rx_counters_.Init(cfg->FrameWnd());
   rx_counters_.num_pkts_per_frame_ =
       cfg->BsAntNum() *
       (cfg->Frame().NumPilotSyms() + cfg->Frame().NumULSyms() +
@@ -1355,22 +1764,55 @@ void Agora::InitializeUplinkBuffers() {
       cfg->BsAntNum() * cfg->Frame().NumPilotSyms();
   rx_counters_.num_reciprocity_pkts_per_frame_ = cfg->BsAntNum();
 
+  dropped_frames_.Init(cfg->FrameWnd());
+  frame_rx_start_tsc_ = std::vector<size_t>(cfg->FrameWnd(), 0);
+  frame_deadline_tsc_ = GetTime::UsToCycles(
+      static_cast<double>(cfg->FrameDeadlineUs()), cfg->FreqGhz());
+  // Dropping a frame resets the state of both directions at once
+  RtAssert((cfg->SplitMaster() == false) || (frame_deadline_tsc_ == 0),
+           "Agora: split_master does not support frame_deadline_us");
+  antenna_erasure_tsc_ = GetTime::UsToCycles(
+      static_cast<double>(cfg->AntennaErasureTimeoutUs()), cfg->FreqGhz());
+  if (antenna_erasure_tsc_ > 0) {
+    antenna_erasures_.Init(cfg->FrameWnd(), cfg->Frame().NumTotalSyms(),
+                           cfg->BsAntNum());
+    const size_t num_erased_packets =
+        cfg->FrameWnd() * cfg->Frame().NumTotalSyms() * cfg->BsAntNum();
+    erased_packets_ =
+        std::vector<uint8_t>(num_erased_packets * Packet::kOffsetOfData);
+    erased_rx_packets_ = std::vector<RxPacket>(num_erased_packets);
+  }
+  zf_progress_.Init(cfg->FrameWnd());
+  ifft_progress_.Init(cfg->FrameWnd());
+  tx_progress_.Init(cfg->FrameWnd());
+
   fft_created_count_ = 0;
-  pilot_fft_counters_.Init(cfg->Frame().NumPilotSyms(), cfg->BsAntNum());
-  uplink_fft_counters_.Init(cfg->Frame().NumULSyms(), cfg->BsAntNum());
+  pilot_fft_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumPilotSyms(),
+                           cfg->BsAntNum());
+  uplink_fft_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                            cfg->BsAntNum());
   fft_cur_frame_for_symbol_ =
       std::vector<size_t>(cfg->Frame().NumULSyms(), SIZE_MAX);
 
-  rc_counters_.Init(cfg->BsAntNum());
+  rc_counters_.Init(cfg->FrameWnd(), cfg->BsAntNum());
 
-  zf_counters_.Init(cfg->ZfEventsPerSymbol());
+  zf_counters_.Init(cfg->FrameWnd(), cfg->ZfEventsPerSymbol());
+  // All ZF tasks of a frame are tagged with symbol 0
+  zf_task_counters_.Init(cfg->FrameWnd(), 1, cfg->ZfEventsPerSymbol());
 
-  demul_counters_.Init(cfg->Frame().NumULSyms(), cfg->DemulEventsPerSymbol());
+  demul_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                       cfg->DemulEventsPerSymbol());
+  demul_task_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                            cfg->DemulEventsPerSymbol());
 
-  decode_counters_.Init(cfg->Frame().NumULSyms(),
+  decode_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
                         cfg->LdpcConfig().NumBlocksInSymbol() * cfg->UeNum());
+  decode_task_counters_.Init(
+      cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+      cfg->LdpcConfig().NumBlocksInSymbol() * cfg->UeNum());
 
-  tomac_counters_.Init(cfg->Frame().NumULSyms(), cfg->UeNum());
+  tomac_counters_.Init(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                       cfg->UeNum());
 }
 
 void Agora::InitializeDownlinkBuffers() {
@@ -1378,7 +1820,7 @@ void Agora::InitializeDownlinkBuffers() {
     std::printf("Agora: Initializing downlink buffers\n");
 
     const size_t task_buffer_symbol_num =
-        config_->Frame().NumDLSyms() * kFrameWnd;
+        config_->Frame().NumDLSyms() * config_->FrameWnd();
 
     size_t dl_socket_buffer_status_size =
         config_->BsAntNum() * task_buffer_symbol_num;
@@ -1389,25 +1831,26 @@ void Agora::InitializeDownlinkBuffers() {
     AllocBuffer1d(&dl_socket_buffer_status_, dl_socket_buffer_status_size,
                   Agora_memory::Alignment_t::kAlign64, 1);
 
-    size_t dl_bits_buffer_size = kFrameWnd * config_->DlMacBytesNumPerframe();
+    size_t dl_bits_buffer_size =
+        config_->FrameWnd() * config_->DlMacBytesNumPerframe();
     this->dl_bits_buffer_.Calloc(config_->UeNum(), dl_bits_buffer_size,
                                  Agora_memory::Alignment_t::kAlign64);
-    this->dl_bits_buffer_status_.Calloc(config_->UeNum(), kFrameWnd,
+    this->dl_bits_buffer_status_.Calloc(config_->UeNum(), config_->FrameWnd(),
                                         Agora_memory::Alignment_t::kAlign64);
 
     dl_ifft_buffer_.Calloc(config_->BsAntNum() * task_buffer_symbol_num,
                            config_->OfdmCaNum(),
                            Agora_memory::Alignment_t::kAlign64);
-    calib_dl_buffer_.Calloc(kFrameWnd,
+    calib_dl_buffer_.Calloc(config_->FrameWnd(),
                             config_->BfAntNum() * config_->OfdmDataNum(),
                             Agora_memory::Alignment_t::kAlign64);
-    calib_ul_buffer_.Calloc(kFrameWnd,
+    calib_ul_buffer_.Calloc(config_->FrameWnd(),
                             config_->BfAntNum() * config_->OfdmDataNum(),
                             Agora_memory::Alignment_t::kAlign64);
     // initialize the content of the last window to 1
     for (size_t i = 0; i < config_->OfdmDataNum() * config_->BfAntNum(); i++) {
-      calib_dl_buffer_[kFrameWnd - 1][i] = {1, 0};
-      calib_ul_buffer_[kFrameWnd - 1][i] = {1, 0};
+      calib_dl_buffer_[config_->FrameWnd() - 1][i] = {1, 0};
+      calib_ul_buffer_[config_->FrameWnd() - 1][i] = {1, 0};
     }
     dl_encoded_buffer_.Calloc(
         task_buffer_symbol_num,
@@ -1415,21 +1858,27 @@ void Agora::InitializeDownlinkBuffers() {
         Agora_memory::Alignment_t::kAlign64);
 
     encode_counters_.Init(
-        config_->Frame().NumDlDataSyms(),
+        config_->FrameWnd(), config_->Frame().NumDlDataSyms(),
         config_->LdpcConfig().NumBlocksInSymbol() * config_->UeNum());
     encode_cur_frame_for_symbol_ =
         std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
     ifft_cur_frame_for_symbol_ =
         std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
-    precode_counters_.Init(config_->Frame().NumDLSyms(),
+    precode_counters_.Init(config_->FrameWnd(), config_->Frame().NumDLSyms(),
                            config_->DemulEventsPerSymbol());
+    precode_task_counters_.Init(config_->FrameWnd(),
+                                config_->Frame().NumDLSyms(),
+                                config_->DemulEventsPerSymbol());
     // precode_cur_frame_for_symbol_ =
     //    std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
-    ifft_counters_.Init(config_->Frame().NumDLSyms(), config_->BsAntNum());
-    tx_counters_.Init(config_->Frame().NumDLSyms(), config_->BsAntNum());
     // mac data is sent per frame, so we set max symbol to 1
-    mac_to_phy_counters_.Init(1, config_->UeNum());
+    mac_to_phy_counters_.Init(config_->FrameWnd(), 1, config_->UeNum());
   }
+  // CheckFrameComplete() reads these even when there are no downlink symbols
+  ifft_counters_.Init(config_->FrameWnd(), config_->Frame().NumDLSyms(),
+                      config_->BsAntNum());
+  tx_counters_.Init(config_->FrameWnd(), config_->Frame().NumDLSyms(),
+                    config_->BsAntNum());
 }
 
 void Agora::FreeUplinkBuffers() {
@@ -1453,6 +1902,22 @@ void Agora::FreeDownlinkBuffers() {
   }
 }
 
+size_t Agora::GetUlBitErrors() const {
+  size_t bit_errors = 0;
+  for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+    bit_errors += this->phy_stats_->GetBitErrors(ue_id);
+  }
+  return bit_errors;
+}
+
+size_t Agora::GetUlDecodedBits() const {
+  size_t decoded_bits = 0;
+  for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+    decoded_bits += this->phy_stats_->GetDecodedBits(ue_id);
+  }
+  return decoded_bits;
+}
+
 void Agora::SaveDecodeDataToFile(int frame_id) {
   const auto& cfg = config_;
   const size_t num_decoded_bytes =
@@ -1465,7 +1930,7 @@ void Agora::SaveDecodeDataToFile(int frame_id) {
 
   for (size_t i = 0; i < cfg->Frame().NumULSyms(); i++) {
     for (size_t j = 0; j < cfg->UeNum(); j++) {
-      int8_t* ptr = decoded_buffer_[(frame_id % kFrameWnd)][i][j];
+      int8_t* ptr = decoded_buffer_[cfg->FrameSlot(frame_id)][i][j];
       std::fwrite(ptr, num_decoded_bytes, sizeof(uint8_t), fp);
     }
   }
@@ -1532,23 +1997,40 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
       static_cast<int>(this->tomac_counters_.IsLastSymbol(frame_id)),
       static_cast<int>(this->tx_counters_.IsLastSymbol(frame_id)));
 
+  // With split master loops, the downlink master reports the transmitted
+  // frames and resets its own counters
+  const bool downlink_done =
+      (config_->SplitMaster() == true)
+          ? ((config_->Frame().NumDLSyms() == 0) ||
+             (this->tx_progress_.Done(frame_id) == true))
+          : ((true == this->ifft_counters_.IsLastSymbol(frame_id)) &&
+             (true == this->tx_counters_.IsLastSymbol(frame_id)));
+
   // Complete if last frame and ifft / decode complete
-  if ((true == this->ifft_counters_.IsLastSymbol(frame_id)) &&
-      (true == this->tx_counters_.IsLastSymbol(frame_id)) &&
+  if ((true == downlink_done) &&
       (((false == kEnableMac) &&
         (true == this->decode_counters_.IsLastSymbol(frame_id))) ||
        ((true == kEnableMac) &&
         (true == this->tomac_counters_.IsLastSymbol(frame_id))))) {
+    this->stats_->MasterSetTsc(TsType::kFrameDone, frame_id);
     this->stats_->UpdateStats(frame_id);
+    this->phy_stats_->ReduceFrame(frame_id);
+    if (this->metrics_ != nullptr) {
+      UpdateFrameMetrics(frame_id);
+    }
+    this->num_frames_completed_++;
     assert(frame_id == this->cur_proc_frame_id_);
     this->decode_counters_.Reset(frame_id);
     this->tomac_counters_.Reset(frame_id);
-    this->ifft_counters_.Reset(frame_id);
-    this->tx_counters_.Reset(frame_id);
+    if (config_->SplitMaster() == false) {
+      this->ifft_counters_.Reset(frame_id);
+      this->tx_counters_.Reset(frame_id);
+    }
     if (config_->Frame().NumDLSyms() > 0) {
       for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++)
-        this->dl_bits_buffer_status_[ue_id][frame_id % kFrameWnd] = 0;
+        this->dl_bits_buffer_status_[ue_id][config_->FrameSlot(frame_id)] = 0;
     }
+    this->frame_rx_start_tsc_.at(config_->FrameSlot(frame_id)) = 0;
     this->cur_proc_frame_id_++;
 
     if (this->encode_deferral_.empty() == false) {
@@ -1562,7 +2044,7 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
           RtAssert(deferred_frame >= this->cur_proc_frame_id_,
                    "Error scheduling encoding because deferral frame is less "
                    "than current frame");
-          ScheduleDownlinkProcessing(frame_id);
+          RequestDownlinkProcessing(deferred_frame);
           this->encode_deferral_.pop();
         } else {
           // No need to check the next frame because it is too large
@@ -1578,6 +2060,226 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
   return finished;
 }
 
+bool Agora::CheckFrameDeadline() {
+  const size_t start_tsc =
+      this->frame_rx_start_tsc_.at(config_->FrameSlot(cur_proc_frame_id_));
+  if ((start_tsc == 0) ||
+      ((GetTime::Rdtsc() - start_tsc) <= this->frame_deadline_tsc_)) {
+    return false;
+  }
+  return DropFrame(cur_proc_frame_id_, FrameDropReason::kDeadline);
+}
+
+bool Agora::DropFrame(size_t frame_id, FrameDropReason reason) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  assert(frame_id == this->cur_proc_frame_id_);
+  MLPD_WARN("Agora: dropping frame %zu (%s), %.2f ms since first packet\n",
+            frame_id,
+            (reason == FrameDropReason::kDeadline) ? "deadline missed"
+                                                   : "frame window full",
+            this->stats_->MasterGetMsSince(TsType::kFirstSymbolRX, frame_id));
+
+  // Workers skip queued tasks of the frame from now on
+  this->dropped_frames_.Drop(frame_id);
+  this->stats_->MasterCountDroppedFrame(reason);
+  if (this->metrics_ != nullptr) {
+    this->master_metrics_.frames_dropped_.at(static_cast<size_t>(reason))
+        ->Add(1);
+  }
+
+  // Release the received packets whose FFT is not scheduled yet
+  std::queue<fft_req_tag_t>& fftq = fft_queue_arr_.at(frame_slot);
+  while (fftq.empty() == false) {
+    fftq.front().rx_packet_->Free();
+    fftq.pop();
+  }
+
+  ResetFrameCounters(frame_id);
+  this->rx_counters_.num_pkts_.at(frame_slot) = 0;
+  this->rx_counters_.num_pilot_pkts_.at(frame_slot) = 0;
+  this->rx_counters_.num_reciprocity_pkts_.at(frame_slot) = 0;
+  this->frame_rx_start_tsc_.at(frame_slot) = 0;
+  if (config_->Frame().NumDLSyms() > 0) {
+    for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+      this->dl_bits_buffer_status_[ue_id][frame_slot] = 0;
+    }
+    this->ifft_next_symbol_ = 0;
+  }
+
+  if (kEnableMac == true) {
+    TryEnqueueFallback(&mac_request_queue_,
+                       EventData(EventType::kFrameDropped,
+                                 gen_tag_t::FrmSym(frame_id, 0).tag_));
+  }
+
+  // Hand the slot to the next frame
+  if (this->cur_sche_frame_id_ == frame_id) {
+    this->fft_created_count_ = 0;
+    this->schedule_process_flags_ = ScheduleProcessingFlags::kNone;
+    this->CheckIncrementScheduleFrame(
+        frame_id, ScheduleProcessingFlags::kProcessingComplete);
+  }
+  while ((this->encode_deferral_.empty() == false) &&
+         (this->encode_deferral_.front() <= frame_id)) {
+    this->encode_deferral_.pop();
+  }
+  this->cur_proc_frame_id_++;
+  while ((this->encode_deferral_.empty() == false) &&
+         (this->encode_deferral_.front() <
+          (this->cur_proc_frame_id_ + kScheduleQueues))) {
+    RequestDownlinkProcessing(this->encode_deferral_.front());
+    this->encode_deferral_.pop();
+  }
+  return (frame_id == (this->config_->FramesToTest() - 1));
+}
+
+void Agora::ResetFrameCounters(size_t frame_id) {
+  this->pilot_fft_counters_.Reset(frame_id);
+  this->uplink_fft_counters_.Reset(frame_id);
+  this->rc_counters_.Reset(frame_id);
+  this->zf_counters_.Reset(frame_id);
+  this->demul_counters_.Reset(frame_id);
+  this->decode_counters_.Reset(frame_id);
+  this->tomac_counters_.Reset(frame_id);
+  this->ifft_counters_.Reset(frame_id);
+  this->tx_counters_.Reset(frame_id);
+  if (config_->Frame().NumDLSyms() > 0) {
+    this->encode_counters_.Reset(frame_id);
+    this->precode_counters_.Reset(frame_id);
+  }
+  ResetTaskCounters(frame_id);
+}
+
+void Agora::ResetTaskCounters(size_t frame_id) {
+  this->zf_task_counters_.Reset(frame_id);
+  this->demul_task_counters_.Reset(frame_id);
+  this->decode_task_counters_.Reset(frame_id);
+  if (config_->Frame().NumDLSyms() > 0) {
+    this->precode_task_counters_.Reset(frame_id);
+  }
+}
+
+void Agora::InitializeMetrics() {
+  metrics_ = std::make_unique<Metrics>();
+  auto& m = master_metrics_;
+  m.frames_done_ = metrics_->AddCounter("agora_frames_done_total",
+                                        "Frames processed completely");
+  m.frames_dropped_.at(static_cast<size_t>(FrameDropReason::kDeadline)) =
+      metrics_->AddCounter("agora_frames_dropped_total",
+                           "Frames dropped before they were processed",
+                           "reason=\"deadline\"");
+  m.frames_dropped_.at(static_cast<size_t>(FrameDropReason::kWindowFull)) =
+      metrics_->AddCounter("agora_frames_dropped_total",
+                           "Frames dropped before they were processed",
+                           "reason=\"window_full\"");
+  m.rx_packets_ = metrics_->AddCounter(
+      "agora_rx_packets_total", "Packets received by the TXRX threads");
+  m.tx_packets_ = metrics_->AddCounter("agora_tx_packets_total",
+                                       "Packets sent by the TXRX threads");
+
+  // The stages the frames of this config go through
+  std::vector<std::pair<TsType, std::string>> stages = {
+      {TsType::kRXDone, "rx"}, {TsType::kZFDone, "zf"}};
+  if (config_->Frame().NumULSyms() > 0) {
+    stages.emplace_back(TsType::kDemulDone, "demul");
+    stages.emplace_back(TsType::kDecodeDone, "decode");
+  }
+  if (config_->Frame().NumDLSyms() > 0) {
+    stages.emplace_back(TsType::kTXDone, "tx");
+  }
+  stages.emplace_back(TsType::kFrameDone, "frame");
+  for (const auto& stage : stages) {
+    m.stage_latency_us_.emplace_back(
+        stage.first,
+        metrics_->AddGauge("agora_stage_latency_us",
+                           "Time from the first packet of the last complete "
+                           "frame to the end of each stage",
+                           "stage=\"" + stage.second + "\""));
+  }
+
+  for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+    const std::string label = "ue=\"" + std::to_string(ue_id) + "\"";
+    m.ue_bler_.push_back(metrics_->AddGauge(
+        "agora_ue_bler", "Uplink block error rate over the frame window",
+        label));
+    m.ue_pilot_snr_.push_back(metrics_->AddGauge(
+        "agora_ue_pilot_snr_db", "Pilot SNR of the last complete frame",
+        label));
+  }
+
+  // Queue depths, sampled by the exporter
+  const std::vector<std::pair<EventType, std::string>> task_types = {
+      {EventType::kFFT, "fft"},         {EventType::kZF, "zf"},
+      {EventType::kDemul, "demul"},     {EventType::kDecode, "decode"},
+      {EventType::kEncode, "encode"},   {EventType::kPrecode, "precode"},
+      {EventType::kIFFT, "ifft"},       {EventType::kPacketTX, "tx"}};
+  for (size_t qid = 0; qid < kScheduleQueues; qid++) {
+    const std::string queue = "queue=\"" + std::to_string(qid) + "\"";
+    for (const auto& task_type : task_types) {
+      auto* conq = GetConq(task_type.first, qid);
+      metrics_->AddSampledGauge(
+          "agora_sched_queue_depth", "Tasks waiting for the workers",
+          queue + ",task=\"" + task_type.second + "\"",
+          [conq]() { return static_cast<double>(conq->size_approx()); });
+    }
+    auto* complete_q = &complete_task_queue_[qid];
+    metrics_->AddSampledGauge(
+        "agora_complete_queue_depth",
+        "Task completions waiting for the master thread", queue,
+        [complete_q]() {
+          return static_cast<double>(complete_q->size_approx());
+        });
+  }
+  metrics_->AddSampledGauge(
+      "agora_message_queue_depth",
+      "Packets and MAC events waiting for the master thread", "",
+      [this]() { return static_cast<double>(message_queue_.size_approx()); });
+
+  metrics_exporter_ = std::make_unique<MetricsExporter>(
+      config_->MetricsSocket(), metrics_.get());
+}
+
+void Agora::UpdateFrameMetrics(size_t frame_id) {
+  auto& m = master_metrics_;
+  m.frames_done_->Add(1);
+  for (const auto& stage : m.stage_latency_us_) {
+    stage.second->Set(this->stats_->MasterGetDeltaUs(
+        stage.first, TsType::kFirstSymbolRX, frame_id));
+  }
+  if (config_->Frame().NumULSyms() > 0) {
+    for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+      m.ue_bler_.at(ue_id)->Set(this->phy_stats_->GetBlockErrorRate(ue_id));
+    }
+  }
+  if (config_->Frame().NumPilotSyms() > 0) {
+    for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+      m.ue_pilot_snr_.at(ue_id)->Set(
+          this->phy_stats_->GetPilotSnr(frame_id, ue_id));
+    }
+  }
+}
+
+bool Agora::IsDroppedFrameEvent(const EventData& event) const {
+  if (this->frame_deadline_tsc_ == 0) {
+    return false;
+  }
+  switch (event.event_type_) {
+    case EventType::kFFT:
+    case EventType::kZF:
+    case EventType::kDemul:
+    case EventType::kDecode:
+    case EventType::kEncode:
+    case EventType::kPrecode:
+    case EventType::kIFFT:
+    case EventType::kPacketTX:
+    case EventType::kPacketToMac:
+      return this->dropped_frames_.IsDropped(
+          gen_tag_t(event.tags_[0]).frame_id_);
+    default:
+      return false;
+  }
+}
+
 extern "C" {
 EXPORT Agora* AgoraNew(Config* cfg) {
   // std::printf("Size of Agora: %d\n",sizeof(Agora *));
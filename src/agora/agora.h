@@ -28,11 +28,13 @@
 #include "dozf.h"
 #include "mac_thread_basestation.h"
 #include "memory_manage.h"
+#include "metrics.h"
 #include "phy_stats.h"
 #include "signal_handler.h"
 #include "stats.h"
 #include "txrx.h"
 #include "utils.h"
+#include "worker_parking.h"
 
 class Agora {
  public:
@@ -43,13 +45,90 @@ class Agora {
   static const size_t kMaxWorkerNum = 50;
   static const size_t kScheduleQueues = 2;
 
-  explicit Agora(
-      Config* /*cfg*/);  /// Create an Agora object and start the worker threads
+  /// The doers of one worker thread for this Agora object, and the batches
+  /// of their completions to the master
+  struct WorkerContext {
+    std::unique_ptr<DoZF> compute_zf_;
+    std::unique_ptr<DoFFT> compute_fft_;
+    std::unique_ptr<DoIFFT> compute_ifft_;
+    std::unique_ptr<DoPrecode> compute_precode_;
+    std::unique_ptr<DoEncode> compute_encoding_;
+    std::unique_ptr<DoDecode> compute_decoding_;
+    std::unique_ptr<DoDemul> compute_demul_;
+    // The doers in polling order, and the task type of each
+    std::vector<Doer*> computers_vec_;
+    std::vector<EventType> events_vec_;
+    std::vector<CompletionBatch> completions_;
+    // Completions for the downlink master when the master loops are split
+    std::vector<CompletionBatch> dl_completions_;
+    // The completion batches of each doer in computers_vec_
+    std::vector<std::vector<CompletionBatch>*> completions_vec_;
+    // The performance counters of the worker thread, if enabled
+    std::unique_ptr<PerfCounters> perf_counters_;
+  };
+
+  /// Create an Agora object and start the worker threads. If create_workers
+  /// is false, the caller runs the workers with CreateWorkerContext() and
+  /// WorkerPoll(), e.g., to share them between cells.
+  explicit Agora(Config* /*cfg*/, bool create_workers = true);
   ~Agora();
 
   void Start();  /// The main Agora event loop
   void Stop();
+
+  /// Create the doers of worker thread tid for this Agora object. If stages
+  /// is not empty, the worker runs only the tasks of those types.
+  std::unique_ptr<WorkerContext> CreateWorkerContext(
+      int tid, const std::vector<EventType>& stages = {});
+  /// Run at most one task of this Agora object on the calling worker thread.
+  /// Returns true if a task was run.
+  bool WorkerPoll(WorkerContext& context);
+  /// Make this Agora object wake the workers parked on [parking] when it
+  /// schedules tasks. Must be called before the workers start.
+  inline void SetWorkerParking(WorkerParking* parking) {
+    this->worker_parking_ = parking;
+  }
+  inline Config* GetConfig() const { return config_; }
   void GetEqualData(float** ptr, int* size);
+  /// Return the [percentile] of the frame processing latency in microseconds
+  double GetFrameLatencyUs(double percentile) const {
+    return stats_->FrameLatencyPercentileUs(percentile);
+  }
+
+  /// Return the [percentile] (0 -- 100) of the one-way fronthaul latency in
+  /// microseconds of the packets received from antenna [ant_id]
+  double GetFronthaulLatencyUs(size_t ant_id, double percentile) const {
+    return stats_->FronthaulLatencyPercentileUs(ant_id, percentile);
+  }
+
+  /// Return the [percentile] (0 -- 100) of the fronthaul jitter in
+  /// microseconds of the packets received from antenna [ant_id]
+  double GetFronthaulJitterUs(size_t ant_id, double percentile) const {
+    return stats_->FronthaulJitterPercentileUs(ant_id, percentile);
+  }
+
+  /// Return the number of frames whose processing completed, not counting
+  /// dropped frames
+  inline size_t NumFramesCompleted() const {
+    return this->num_frames_completed_;
+  }
+
+  /// Return the number of frames dropped for [reason]
+  inline size_t NumFramesDropped(FrameDropReason reason) const {
+    return stats_->NumDroppedFrames(reason);
+  }
+
+  /// Return the time in TSC cycles that the processing of [frame_id]
+  /// completed
+  size_t GetFrameDoneTsc(size_t frame_id) const {
+    return stats_->MasterGetTsc(TsType::kFrameDone, frame_id);
+  }
+
+  /// Return the uplink bit errors of all UEs over the completed frames, which
+  /// the decoders count against the transmitted bits
+  size_t GetUlBitErrors() const;
+  /// Return the uplink bits decoded for all UEs over the completed frames
+  size_t GetUlDecodedBits() const;
 
   // Flags that allow developer control over Agora internals
   struct {
@@ -82,11 +161,85 @@ class Agora {
   void CheckIncrementScheduleFrame(size_t frame_id,
                                    ScheduleProcessingFlags completed);
 
+  /// Abort the processing of frame_id, which must be cur_proc_frame_id_.
+  /// Tasks of the frame still queued or in flight are discarded, its counters
+  /// are reset, and its slot is handed to the next frame. Returns true if
+  /// frame_id is the last frame to test. False otherwise.
+  bool DropFrame(size_t frame_id, FrameDropReason reason);
+
+  /// Drop cur_proc_frame_id_ if it is not processed within the frame deadline
+  /// of its first received packet. Returns true if the dropped frame is the
+  /// last frame to test. False otherwise.
+  bool CheckFrameDeadline();
+
+  /// Reset all the per-frame counters in the slot of frame_id
+  void ResetFrameCounters(size_t frame_id);
+  /// Reset the task counters updated by the workers in the slot of frame_id
+  void ResetTaskCounters(size_t frame_id);
+
+  /// Record the antenna of a received pilot or uplink packet for antenna
+  /// erasures. Returns false if the antenna has already been erased from
+  /// the packet's symbol, in which case the packet must be discarded.
+  bool TrackReceivedAntenna(const Packet* pkt);
+  /// Erase the missing antennas of the symbols that have waited longer than
+  /// the antenna erasure timeout: since their first packet, or since the
+  /// latest packet of their frame if they have none
+  void CheckAntennaErasures();
+  /// Erase the antennas of symbol_id of frame_id that have not been
+  /// received. Each one is counted as received and handed to FFT as a
+  /// placeholder packet, for which the FFT writes zeros.
+  void EraseMissingAntennas(size_t frame_id, size_t symbol_id);
+
+  /// In Bigstation mode, mark the uplink of frame_id as scheduled once its
+  /// ZF and the FFT of all its uplink symbols are done
+  void CheckBigstationUplinkScheduled(size_t frame_id);
+
+  /// Create FFT tasks for the received packets of the frame in scheduling
+  void ScheduleFft();
+
+  /// Schedule the downlink of frame_id, on the downlink master if the master
+  /// loops are split
+  void RequestDownlinkProcessing(size_t frame_id);
+  /// Schedule precoding for the encoded downlink symbols of frame_id, whose
+  /// ZF is done
+  void HandleDownlinkZf(size_t frame_id);
+  void HandleEventEncode(const EventData& event);
+  void HandleEventPrecode(const EventData& event);
+  /// Returns true if the frame is complete and it is the last frame to test
+  bool HandleEventIfft(const EventData& event);
+  /// Returns true if the frame is complete and it is the last frame to test
+  bool HandleEventTx(const EventData& event);
+
+  /// With split master loops, act on the frames whose downlink the downlink
+  /// master finished. Returns true if the last frame to test is complete.
+  bool CheckDownlinkProgress();
+  /// The event loop of the downlink master: encode, precode, IFFT, and TX
+  void DownlinkMaster();
+  /// The downlink master runs after the TXRX, worker, and MAC threads
+  inline size_t DownlinkMasterCore() const {
+    return config_->CoreOffset() + 1 + config_->SocketThreadNum() +
+           config_->WorkerThreadNum() + (kEnableMac ? 1 : 0);
+  }
+
+  /// Register the metrics that the master thread updates and the sampled
+  /// queue depths, and start serving them on the configured socket
+  void InitializeMetrics();
+  /// Update the frame, stage latency, and per-UE metrics with frame_id,
+  /// whose processing is complete
+  void UpdateFrameMetrics(size_t frame_id);
+
+  /// Return true if the event reports completed tasks of a dropped frame
+  bool IsDroppedFrameEvent(const EventData& event) const;
+
   void WorkerFft(int tid);
   void WorkerZf(int tid);
   void WorkerDemul(int tid);
   void WorkerDecode(int tid);
   void Worker(int tid);
+  /// Run worker thread tid on the tasks of the given types (all types if
+  /// stages is empty) until the config stops running
+  void RunWorker(ThreadType thread_type, int tid,
+                 const std::vector<EventType>& stages);
 
   void CreateThreads();  /// Launch worker threads
 
@@ -148,8 +301,8 @@ class Agora {
   std::string GetFftQueueSizesString() const {
     std::ostringstream ret;
     ret << "[";
-    for (size_t i = 0; i < kFrameWnd; i++) {
-      ret << std::to_string(fft_queue_arr_[i].size()) << " ";
+    for (const auto& fft_queue : fft_queue_arr_) {
+      ret << std::to_string(fft_queue.size()) << " ";
     }
     ret << "]";
     return ret.str();
@@ -172,6 +325,22 @@ class Agora {
   std::unique_ptr<Stats> stats_;
   std::unique_ptr<PhyStats> phy_stats_;
 
+  // Live metrics, served by metrics_exporter_ if the config sets a metrics
+  // socket. Null otherwise. The master thread is the only writer of the
+  // values in master_metrics_.
+  std::unique_ptr<Metrics> metrics_;
+  std::unique_ptr<MetricsExporter> metrics_exporter_;
+  struct {
+    MetricValue* frames_done_;
+    std::array<MetricValue*, kNumFrameDropReasons> frames_dropped_;
+    MetricValue* rx_packets_;
+    MetricValue* tx_packets_;
+    // The latency from the first packet of a frame to each of its stages
+    std::vector<std::pair<TsType, MetricValue*>> stage_latency_us_;
+    std::vector<MetricValue*> ue_bler_;
+    std::vector<MetricValue*> ue_pilot_snr_;
+  } master_metrics_;
+
   /*****************************************************
    * Buffers
    *****************************************************/
@@ -187,10 +356,10 @@ class Agora {
 
   // Preliminary CSI buffers. Each buffer has [number of antennas] rows and
   // [number of OFDM data subcarriers] columns.
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffers_;
+  PtrGrid<kMaxUEs, complex_float> csi_buffers_;
 
   // Data symbols after FFT
-  // 1st dimension: kFrameWnd * uplink data symbols per frame
+  // 1st dimension: frame window * uplink data symbols per frame
   // 2nd dimension: number of antennas * number of OFDM data subcarriers
   //
   // 2nd dimension data order: 32 blocks each with 32 subcarriers each:
@@ -200,19 +369,19 @@ class Agora {
 
   // Calculated uplink zeroforcing detection matrices. Each matrix has
   // [number of antennas] rows and [number of UEs] columns.
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices_;
+  PtrGrid<kMaxDataSCs, complex_float> ul_zf_matrices_;
 
   // Data after equalization
-  // 1st dimension: kFrameWnd * uplink data symbols per frame
+  // 1st dimension: frame window * uplink data symbols per frame
   // 2nd dimension: number of OFDM data subcarriers * number of UEs
   Table<complex_float> equal_buffer_;
 
   // Data after demodulation. Each buffer has kMaxModType * number of OFDM
   // data subcarriers
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> demod_buffers_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t> demod_buffers_;
 
   // Data after LDPC decoding. Each buffer [decoded bytes per UE] bytes.
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> decoded_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t> decoded_buffer_;
 
   Table<complex_float> ue_spec_pilot_buffer_;
 
@@ -230,10 +399,76 @@ class Agora {
   FrameCounters mac_to_phy_counters_;
   FrameCounters rc_counters_;
   RxCounters rx_counters_;
+
+  // Task counters updated directly by the workers (kUseAtomicFrameCounters)
+  AtomicFrameCounters zf_task_counters_;
+  AtomicFrameCounters demul_task_counters_;
+  AtomicFrameCounters decode_task_counters_;
+  AtomicFrameCounters precode_task_counters_;
+  // Frames dropped by the master, shared with the workers
+  DroppedFrames dropped_frames_;
+  // Frame deadline in TSC cycles. Zero disables dropping late frames.
+  size_t frame_deadline_tsc_ = 0;
+  // frame_rx_start_tsc_[i] is the TSC at which the first packet of the frame
+  // in slot i was received, or zero if no frame is in progress in slot i
+  std::vector<size_t> frame_rx_start_tsc_;
+
+  // Antenna erasure timeout in TSC cycles. Zero disables antenna erasures.
+  size_t antenna_erasure_tsc_ = 0;
+  // Antennas received and erased per symbol, shared with the workers
+  AntennaErasures antenna_erasures_;
+  struct PendingSymbol {
+    size_t frame_id_;
+    size_t symbol_id_;
+  };
+  // Pilot and uplink symbols that may still miss antennas, in the order of
+  // their frames' first packets
+  std::queue<PendingSymbol> pending_symbols_;
+  // Placeholder packets of erased antennas, one per antenna of each symbol
+  // in the frame window. erased_rx_packets_[i] holds the header at
+  // erased_packets_[i * Packet::kOffsetOfData].
+  std::vector<uint8_t> erased_packets_;
+  std::vector<RxPacket> erased_rx_packets_;
+  // Idle workers park on worker_parking_ until the master schedules tasks.
+  // It points to own_worker_parking_ unless the workers are shared.
+  WorkerParking own_worker_parking_;
+  WorkerParking* worker_parking_ = &own_worker_parking_;
+
   size_t zf_last_frame_ = SIZE_MAX;
   size_t rc_last_frame_ = SIZE_MAX;
   size_t ifft_next_symbol_ = 0;
 
+  /*****************************************************
+   * Split master loops (split_master)
+   *
+   * The uplink master runs Start(): packet RX, FFT, ZF, demodulation,
+   * decoding, MAC, and frame completion. The downlink master runs
+   * DownlinkMaster(): encoding, precoding, IFFT, and TX. Without
+   * split_master, Start() does both.
+   *****************************************************/
+  std::thread downlink_master_;
+  // The last frame whose ZF the downlink side has seen. Only the thread
+  // handling the downlink reads and writes it.
+  size_t dl_zf_last_frame_ = SIZE_MAX;
+  // The oldest frame whose downlink is not transmitted yet (downlink master)
+  size_t dl_proc_frame_id_ = 0;
+  // Written by the uplink master, polled by the downlink master
+  FrameProgress zf_progress_;
+  // Written by the downlink master, polled by the uplink master
+  FrameProgress ifft_progress_;
+  FrameProgress tx_progress_;
+  // Frames to schedule and TX completions, forwarded by the uplink master
+  moodycamel::ConcurrentQueue<EventData> dl_message_queue_;
+  // Completions of downlink tasks from the workers
+  moodycamel::ConcurrentQueue<EventData>
+      dl_complete_task_queue_[kScheduleQueues];
+  moodycamel::ProducerToken* dl_worker_ptoks_ptr_[kMaxThreads]
+                                                 [kScheduleQueues];
+
+  // Counters for printing the TX summary
+  size_t tx_count_ = 0;
+  double tx_begin_us_ = 0;
+
   // Agora schedules and processes a frame in FIFO order
   // cur_proc_frame_id is the frame that is currently being processed.
   // cur_sche_frame_id is the frame that is currently being scheduled.
@@ -241,6 +476,8 @@ class Agora {
   // variables are possible to have different values.
   size_t cur_proc_frame_id_ = 0;
   size_t cur_sche_frame_id_ = 0;
+  // The number of frames whose processing completed, without dropped frames
+  size_t num_frames_completed_ = 0;
 
   // The frame index for a symbol whose FFT is done
   std::vector<size_t> fft_cur_frame_for_symbol_;
@@ -254,33 +491,33 @@ class Agora {
 
   // Per-frame queues of delayed FFT tasks. The queue contains offsets into
   // TX/RX buffers.
-  std::array<std::queue<fft_req_tag_t>, kFrameWnd> fft_queue_arr_;
+  std::vector<std::queue<fft_req_tag_t>> fft_queue_arr_;
 
   // Data for IFFT
-  // 1st dimension: kFrameWnd * number of antennas * number of
+  // 1st dimension: frame window * number of antennas * number of
   // data symbols per frame
   // 2nd dimension: number of OFDM carriers (including non-data carriers)
   Table<complex_float> dl_ifft_buffer_;
 
   // Calculated uplink zeroforcing detection matrices. Each matrix has
   // [number of UEs] rows and [number of antennas] columns.
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_zf_matrices_;
+  PtrGrid<kMaxDataSCs, complex_float> dl_zf_matrices_;
 
-  // 1st dimension: kFrameWnd
+  // 1st dimension: frame window
   // 2nd dimension: number of OFDM data subcarriers * number of antennas
   Table<complex_float> calib_ul_buffer_;
   Table<complex_float> calib_dl_buffer_;
 
-  // 1st dimension: kFrameWnd * number of data symbols per frame
+  // 1st dimension: frame window * number of data symbols per frame
   // 2nd dimension: number of OFDM data subcarriers * number of UEs
   Table<int8_t> dl_encoded_buffer_;
 
-  // 1st dimension: kFrameWnd * number of DL data symbols per frame
+  // 1st dimension: frame window * number of DL data symbols per frame
   // 2nd dimension: number of OFDM data subcarriers * number of UEs
   Table<int8_t> dl_bits_buffer_;
 
   // 1st dimension: number of UEs
-  // 2nd dimension: number of OFDM data subcarriers * kFrameWnd
+  // 2nd dimension: number of OFDM data subcarriers * frame window
   //                * number of DL data symbols per frame
   // Use different dimensions from dl_bits_buffer_ to avoid cache false sharing
   Table<int8_t> dl_bits_buffer_status_;
@@ -289,7 +526,7 @@ class Agora {
    * Data for transmission
    *
    * Number of downlink socket buffers and status entries:
-   * kFrameWnd * symbol_num_perframe * BS_ANT_NUM
+   * frame window * symbol_num_perframe * BS_ANT_NUM
    *
    * Size of each downlink socket buffer entry: packet_length bytes
    * Size of each downlink socket buffer status entry: one integer
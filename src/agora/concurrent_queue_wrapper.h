@@ -8,6 +8,7 @@
 
 #include "buffer.h"
 #include "concurrentqueue.h"
+#include "gettime.h"
 #include "utils.h"
 
 /// Enqueue one event to a concurrent queue and print a warning message
@@ -45,4 +46,82 @@ static inline void TryEnqueueBulkFallback(
   }
 }
 
+/**
+ * @brief Completion events of one worker thread waiting to be sent to a master
+ * queue. Events are coalesced into the tag array of the previous event when
+ * they have the same type and frame, and the batch is sent with one bulk
+ * enqueue. The worker must call Flush() when it goes idle, and
+ * FlushIfExpired() after each task to bound the latency of completions.
+ */
+class CompletionBatch {
+ public:
+  static constexpr size_t kMaxEvents = 8;
+
+  /**
+   * @param mc_queue The master queue of completion events
+   * @param producer_token The worker's producer token for mc_queue
+   * @param timeout_tsc Flush a batch this many TSC cycles after its first
+   * event
+   */
+  CompletionBatch(moodycamel::ConcurrentQueue<EventData>* mc_queue,
+                  moodycamel::ProducerToken* producer_token,
+                  size_t timeout_tsc)
+      : mc_queue_(mc_queue),
+        producer_token_(producer_token),
+        timeout_tsc_(timeout_tsc) {}
+
+  /// Add a completion event whose tags are gen_tag_t of the same frame
+  void Add(const EventData& event) {
+    if (num_events_ > 0) {
+      EventData& last = events_.at(num_events_ - 1);
+      if ((last.event_type_ == event.event_type_) &&
+          (gen_tag_t(last.tags_[0]).frame_id_ ==
+           gen_tag_t(event.tags_[0]).frame_id_) &&
+          (last.num_tags_ + event.num_tags_ <= EventData::kMaxTags)) {
+        for (size_t i = 0; i < event.num_tags_; i++) {
+          last.tags_[last.num_tags_] = event.tags_[i];
+          last.num_tags_++;
+        }
+        return;
+      }
+    } else {
+      first_event_tsc_ = GetTime::Rdtsc();
+    }
+    events_.at(num_events_) = event;
+    num_events_++;
+    if (num_events_ == kMaxEvents) {
+      Flush();
+    }
+  }
+
+  /// Send the pending events to the master queue
+  void Flush() {
+    if (num_events_ > 0) {
+      TryEnqueueBulkFallback(mc_queue_, producer_token_, events_.data(),
+                             num_events_);
+      num_events_ = 0;
+    }
+  }
+
+  /// Send the pending events if the oldest one has waited for the timeout
+  void FlushIfExpired() {
+    if ((num_events_ > 0) &&
+        (GetTime::Rdtsc() - first_event_tsc_ >= timeout_tsc_)) {
+      Flush();
+    }
+  }
+
+  inline size_t NumEvents() const { return num_events_; }
+
+ private:
+  moodycamel::ConcurrentQueue<EventData>* mc_queue_;
+  moodycamel::ProducerToken* producer_token_;
+  const size_t timeout_tsc_;
+
+  std::array<EventData, kMaxEvents> events_;
+  size_t num_events_ = 0;
+  // TSC at which the first pending event was added
+  size_t first_event_tsc_ = 0;
+};
+
 #endif  // CONCURRENT_QUEUE_WRAPPER_H_
@@ -15,8 +15,8 @@ static constexpr size_t kVarNodesSize = 1024 * 1024 * sizeof(int16_t);
 
 DoDecode::DoDecode(
     Config* in_config, int in_tid,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
     PhyStats* in_phy_stats, Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       demod_buffers_(demod_buffers),
@@ -24,6 +24,8 @@ DoDecode::DoDecode(
       phy_stats_(in_phy_stats),
       scrambler_(std::make_unique<AgoraScrambler::Scrambler>()) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kDecode, in_tid);
+  duration_hist_ =
+      in_stats_manager->GetDurationHistogram(DoerType::kDecode, in_tid);
   resp_var_nodes_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64, kVarNodesSize));
 }
@@ -40,7 +42,7 @@ EventData DoDecode::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
   const size_t cur_cb_id = (cb_id % cfg_->LdpcConfig().NumBlocksInSymbol());
   const size_t ue_id = (cb_id / cfg_->LdpcConfig().NumBlocksInSymbol());
-  const size_t frame_slot = (frame_id % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   if (kDebugPrintInTask == true) {
     std::printf(
         "In doDecode thread %d: frame: %zu, symbol: %zu, code block: "
@@ -112,28 +114,30 @@ EventData DoDecode::Launch(size_t tag) {
 
   if ((kEnableMac == false) && (kPrintPhyStats == true) &&
       (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols())) {
-    phy_stats_->UpdateDecodedBits(ue_id, symbol_offset,
+    phy_stats_->UpdateDecodedBits(tid_, ue_id, symbol_offset,
                                   cfg_->NumBytesPerCb() * 8);
-    phy_stats_->IncrementDecodedBlocks(ue_id, symbol_offset);
+    phy_stats_->IncrementDecodedBlocks(tid_, ue_id, symbol_offset);
     size_t block_error(0);
     for (size_t i = 0; i < cfg_->NumBytesPerCb(); i++) {
       uint8_t rx_byte = decoded_buffer_ptr[i];
       auto tx_byte = static_cast<uint8_t>(cfg_->GetInfoBits(
           cfg_->UlBits(), symbol_idx_ul, ue_id, cur_cb_id)[i]);
-      phy_stats_->UpdateBitErrors(ue_id, symbol_offset, tx_byte, rx_byte);
+      phy_stats_->UpdateBitErrors(tid_, ue_id, symbol_offset, tx_byte,
+                                  rx_byte);
       if (rx_byte != tx_byte) {
         block_error++;
       }
     }
-    phy_stats_->UpdateBlockErrors(ue_id, symbol_offset, block_error);
+    phy_stats_->UpdateBlockErrors(tid_, ue_id, symbol_offset, block_error);
   }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
   duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
   duration_stat_->task_count_++;
   if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
-    std::printf("Thread %d Decode takes %.2f\n", tid_,
-                GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
+    MLPD_WARN("Thread %d Decode takes %.2f\n", tid_,
+              GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
   }
 
   return EventData(EventType::kDecode, tag);
@@ -19,8 +19,8 @@
 class DoDecode : public Doer {
  public:
   DoDecode(Config* in_config, int in_tid,
-           PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-           PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+           PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
+           PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
            PhyStats* in_phy_stats, Stats* in_stats_manager);
   ~DoDecode() override;
 
@@ -28,10 +28,11 @@ class DoDecode : public Doer {
 
  private:
   int16_t* resp_var_nodes_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers_;
   PhyStats* phy_stats_;
   DurationStat* duration_stat_;
+  LatencyHistogram* duration_hist_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
 };
 
@@ -10,10 +10,10 @@ static constexpr bool kUseSIMDGather = true;
 
 DoDemul::DoDemul(
     Config* config, int tid, Table<complex_float>& data_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
+    PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices,
     Table<complex_float>& ue_spec_pilot_buffer,
     Table<complex_float>& equal_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
     PhyStats* in_phy_stats, Stats* stats_manager)
     : Doer(config, tid),
       data_buffer_(data_buffer),
@@ -23,6 +23,7 @@ DoDemul::DoDemul(
       demod_buffers_(demod_buffers),
       phy_stats_(in_phy_stats) {
   duration_stat_ = stats_manager->GetDurationStat(DoerType::kDemul, tid);
+  duration_hist_ = stats_manager->GetDurationHistogram(DoerType::kDemul, tid);
 
   data_gather_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
@@ -86,7 +87,7 @@ EventData DoDemul::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
   const complex_float* data_buf = data_buffer_[total_data_symbol_idx_ul];
 
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   size_t start_tsc = GetTime::WorkerRdtsc();
 
   if (kDebugPrintInTask == true) {
@@ -216,14 +217,14 @@ EventData DoDemul::Launch(size_t tag) {
         if (symbol_idx_ul == 0 && cur_sc_id == 0) {
           // Reset previous frame
           auto* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
-              ue_spec_pilot_buffer_[(frame_id - 1) % kFrameWnd]);
+              ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id - 1)]);
           arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeNum(),
                                         cfg_->Frame().ClientUlPilotSymbols(),
                                         false);
           mat_phase_shift.fill(0);
         }
         auto* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
-            &ue_spec_pilot_buffer_[frame_id % kFrameWnd]
+            &ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id)]
                                   [symbol_idx_ul * cfg_->UeNum()]);
         arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeNum(), 1, false);
         arma::cx_fmat shift_sc =
@@ -233,7 +234,7 @@ EventData DoDemul::Launch(size_t tag) {
       // apply previously calc'ed phase shift to data
       else if (cfg_->Frame().ClientUlPilotSymbols() > 0) {
         auto* pilot_corr_ptr = reinterpret_cast<arma::cx_float*>(
-            ue_spec_pilot_buffer_[frame_id % kFrameWnd]);
+            ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id)]);
         arma::cx_fmat pilot_corr_mat(pilot_corr_ptr, cfg_->UeNum(),
                                      cfg_->Frame().ClientUlPilotSymbols(),
                                      false);
@@ -254,7 +255,7 @@ EventData DoDemul::Launch(size_t tag) {
 
         // Measure EVM from ground truth
         if (symbol_idx_ul == cfg_->Frame().ClientUlPilotSymbols()) {
-          phy_stats_->UpdateEvmStats(frame_id, cur_sc_id, mat_equaled);
+          phy_stats_->UpdateEvmStats(tid_, frame_id, cur_sc_id, mat_equaled);
           if (kPrintPhyStats && cur_sc_id == 0) {
             phy_stats_->PrintEvmStats(frame_id - 1);
           }
@@ -315,6 +316,8 @@ EventData DoDemul::Launch(size_t tag) {
   }
 
   duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
-  duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
+  duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
   return EventData(EventType::kDemul, tag);
 }
@@ -22,10 +22,10 @@
 class DoDemul : public Doer {
  public:
   DoDemul(Config* config, int tid, Table<complex_float>& data_buffer,
-          PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
+          PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices,
           Table<complex_float>& ue_spec_pilot_buffer,
           Table<complex_float>& equal_buffer,
-          PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
+          PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
           PhyStats* in_phy_stats, Stats* in_stats_manager);
   ~DoDemul() override;
 
@@ -59,11 +59,12 @@ class DoDemul : public Doer {
 
  private:
   Table<complex_float>& data_buffer_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices_;
+  PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices_;
   Table<complex_float>& ue_spec_pilot_buffer_;
   Table<complex_float>& equal_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
   DurationStat* duration_stat_;
+  LatencyHistogram* duration_hist_;
   PhyStats* phy_stats_;
 
   /// Intermediate buffer to gather raw data. Size = subcarriers per cacheline
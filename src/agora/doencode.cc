@@ -22,6 +22,8 @@ DoEncode::DoEncode(Config* in_config, int in_tid,
       encoded_buffer_(in_encoded_buffer),
       scrambler_(std::make_unique<AgoraScrambler::Scrambler>()) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kEncode, in_tid);
+  duration_hist_ =
+      in_stats_manager->GetDurationHistogram(DoerType::kEncode, in_tid);
   parity_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64,
       LdpcEncodingParityBufSize(cfg_->LdpcConfig().BaseGraph(),
@@ -139,6 +141,7 @@ EventData DoEncode::Launch(size_t tag) {
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
   duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
   duration_stat_->task_count_++;
   if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
     std::printf("Thread %d Encode takes %.2f\n", tid_,
@@ -41,6 +41,7 @@ class DoEncode : public Doer {
   int8_t* scrambler_buffer_;
 
   DurationStat* duration_stat_;
+  LatencyHistogram* duration_hist_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
 };
 
@@ -18,26 +18,51 @@ class Doer {
       moodycamel::ConcurrentQueue<EventData>& task_queue,
       moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
       moodycamel::ProducerToken* worker_ptok) {
-    EventData req_event;
-    if (task_queue.try_dequeue(req_event)) {
-      // We will enqueue one response event containing results for all
-      // request tags in the request event
-      EventData resp_event;
-      resp_event.num_tags_ = req_event.num_tags_;
-
-      for (size_t i = 0; i < req_event.num_tags_; i++) {
-        EventData resp_i = Launch(req_event.tags_[i]);
-        RtAssert(resp_i.num_tags_ == 1, "Invalid num_tags in resp");
-        resp_event.tags_[i] = resp_i.tags_[0];
-        resp_event.event_type_ = resp_i.event_type_;
+    EventData resp_event;
+    if (LaunchNext(task_queue, resp_event) == true) {
+      if (resp_event.num_tags_ > 0) {
+        TryEnqueueFallback(&complete_task_queue, worker_ptok, resp_event);
       }
+      return true;
+    }
+    return false;
+  }
 
-      TryEnqueueFallback(&complete_task_queue, worker_ptok, resp_event);
+  /// Like TryLaunch(), but add the response event to the worker's batch of
+  /// completions instead of enqueuing it to the master immediately
+  bool TryLaunch(moodycamel::ConcurrentQueue<EventData>& task_queue,
+                 CompletionBatch& completions) {
+    EventData resp_event;
+    if (LaunchNext(task_queue, resp_event) == true) {
+      if (resp_event.num_tags_ > 0) {
+        completions.Add(resp_event);
+      }
       return true;
     }
     return false;
   }
 
+  /// Count task completions in counters shared by all workers. Once set,
+  /// TryLaunch() reports only the tasks that complete a symbol to the master.
+  void SetTaskCounters(AtomicFrameCounters* task_counters) {
+    task_counters_ = task_counters;
+  }
+
+  /// Skip the tasks of frames dropped by the master. Only for Doers whose
+  /// tags are gen_tag_t.
+  void SetDroppedFrames(const DroppedFrames* dropped_frames) {
+    dropped_frames_ = dropped_frames;
+  }
+
+  /// Count the events of each task with the worker thread's [perf_counters]
+  /// and accumulate them in [perf_stat]
+  void SetPerfCounters(const PerfCounters* perf_counters,
+                       PerfStat* perf_stat) {
+    perf_counters_ = perf_counters;
+    perf_stat_ = perf_stat;
+    perf_stat_->counted_mask_ = perf_counters->CountedMask();
+  }
+
   /// The main event handling function that performs Doer-specific work.
   /// Doers that handle only one event type use this signature.
   virtual EventData Launch(size_t tag) {
@@ -60,7 +85,61 @@ class Doer {
 
   virtual ~Doer() = default;
 
+  /// Dequeue one request event and launch its tasks. On success, resp_event
+  /// holds the tags to report to the master, which may be none.
+  bool LaunchNext(moodycamel::ConcurrentQueue<EventData>& task_queue,
+                  EventData& resp_event) {
+    EventData req_event;
+    if (task_queue.try_dequeue(req_event) == false) {
+      return false;
+    }
+    // We will enqueue one response event containing results for all
+    // request tags in the request event
+    resp_event.num_tags_ = 0;
+
+    for (size_t i = 0; i < req_event.num_tags_; i++) {
+      // Discard the queued tasks of frames dropped by the master
+      if (IsFrameDropped(req_event.tags_[i]) == true) {
+        continue;
+      }
+      PerfCounters::Values perf_start{};
+      if (perf_counters_ != nullptr) {
+        perf_counters_->Read(perf_start);
+      }
+      EventData resp_i = Launch(req_event.tags_[i]);
+      if (perf_counters_ != nullptr) {
+        perf_stat_->Add(*perf_counters_, perf_start);
+      }
+      RtAssert(resp_i.num_tags_ == 1, "Invalid num_tags in resp");
+      resp_event.event_type_ = resp_i.event_type_;
+      // The frame may have been dropped and its counters reset while this
+      // task was running
+      if (IsFrameDropped(resp_i.tags_[0]) == true) {
+        continue;
+      }
+      // With worker-side counting, only report tags that complete a symbol
+      if ((task_counters_ != nullptr) &&
+          (task_counters_->CompleteTask(
+               gen_tag_t(resp_i.tags_[0]).frame_id_,
+               gen_tag_t(resp_i.tags_[0]).symbol_id_) == false)) {
+        continue;
+      }
+      resp_event.tags_[resp_event.num_tags_] = resp_i.tags_[0];
+      resp_event.num_tags_++;
+    }
+    return true;
+  }
+
+  inline bool IsFrameDropped(size_t tag) const {
+    return (dropped_frames_ != nullptr) &&
+           dropped_frames_->IsDropped(gen_tag_t(tag).frame_id_);
+  }
+
   Config* cfg_;
   int tid_;  // Thread ID of this Doer
+  AtomicFrameCounters* task_counters_ = nullptr;
+  const DroppedFrames* dropped_frames_ = nullptr;
+  const PerfCounters* perf_counters_ = nullptr;
+  PerfStat* perf_stat_ = nullptr;
 };
 #endif  // DOER_H_
@@ -11,7 +11,7 @@ static constexpr bool kPrintFFTInput = false;
 static constexpr bool kPrintPilotCorrStats = false;
 
 DoFFT::DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
-             PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+             PtrGrid<kMaxUEs, complex_float>& csi_buffers,
              Table<complex_float>& calib_dl_buffer,
              Table<complex_float>& calib_ul_buffer, PhyStats* in_phy_stats,
              Stats* stats_manager)
@@ -23,6 +23,8 @@ DoFFT::DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
       phy_stats_(in_phy_stats) {
   duration_stat_fft_ = stats_manager->GetDurationStat(DoerType::kFFT, tid);
   duration_stat_csi_ = stats_manager->GetDurationStat(DoerType::kCSI, tid);
+  duration_hist_fft_ = stats_manager->GetDurationHistogram(DoerType::kFFT, tid);
+  duration_hist_csi_ = stats_manager->GetDurationHistogram(DoerType::kCSI, tid);
   DftiCreateDescriptor(&mkl_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
                        cfg_->OfdmCaNum());
   DftiCommitDescriptor(mkl_handle_);
@@ -83,12 +85,16 @@ EventData DoFFT::Launch(size_t tag) {
   size_t start_tsc = GetTime::WorkerRdtsc();
   Packet* pkt = fft_req_tag_t(tag).rx_packet_->RawPacket();
   size_t frame_id = pkt->frame_id_;
-  size_t frame_slot = frame_id % kFrameWnd;
+  size_t frame_slot = cfg_->FrameSlot(frame_id);
   size_t symbol_id = pkt->symbol_id_;
   size_t ant_id = pkt->ant_id_;
   SymbolType sym_type = cfg_->GetSymbolType(symbol_id);
+  const bool erased = (pkt->magic_ == Packet::kErasedMagic);
 
-  if (cfg_->FftInRru() == true) {
+  if (erased == true) {
+    // The packet is a placeholder without samples
+    std::memset(fft_inout_, 0, cfg_->OfdmCaNum() * sizeof(complex_float));
+  } else if (cfg_->FftInRru() == true) {
     SimdConvertFloat16ToFloat32(
         reinterpret_cast<float*>(fft_inout_),
         reinterpret_cast<float*>(&pkt->data_[2 * cfg_->OfdmRxZeroPrefixBs()]),
@@ -148,10 +154,13 @@ EventData DoFFT::Launch(size_t tag) {
 
   DurationStat dummy_duration_stat;  // TODO: timing for calibration symbols
   DurationStat* duration_stat = nullptr;
+  LatencyHistogram* duration_hist = nullptr;
   if (sym_type == SymbolType::kUL) {
     duration_stat = duration_stat_fft_;
+    duration_hist = duration_hist_fft_;
   } else if (sym_type == SymbolType::kPilot) {
     duration_stat = duration_stat_csi_;
+    duration_hist = duration_hist_csi_;
   } else {
     duration_stat = &dummy_duration_stat;  // For calibration symbols
   }
@@ -159,7 +168,7 @@ EventData DoFFT::Launch(size_t tag) {
   size_t start_tsc1 = GetTime::WorkerRdtsc();
   duration_stat->task_duration_[1] += start_tsc1 - start_tsc;
 
-  if (!cfg_->FftInRru() == true) {
+  if ((!cfg_->FftInRru() == true) && (erased == false)) {
     DftiComputeForward(
         mkl_handle_,
         reinterpret_cast<float*>(fft_inout_));  // Compute FFT in-place
@@ -170,7 +179,7 @@ EventData DoFFT::Launch(size_t tag) {
 
   if (sym_type == SymbolType::kPilot) {
     size_t pilot_symbol_id = cfg_->Frame().GetPilotSymbolIdx(symbol_id);
-    if (kCollectPhyStats) {
+    if (kCollectPhyStats && (erased == false)) {
       phy_stats_->UpdatePilotSnr(frame_id, pilot_symbol_id, fft_inout_);
     }
     const size_t ue_id = pilot_symbol_id;
@@ -186,7 +195,7 @@ EventData DoFFT::Launch(size_t tag) {
         ant_id / cfg_->AntPerGroup() ==
             (frame_id - TX_FRAME_DELTA) % cfg_->AntGroupNum()) {
       size_t frame_grp_id = (frame_id - TX_FRAME_DELTA) / cfg_->AntGroupNum();
-      size_t frame_grp_slot = frame_grp_id % kFrameWnd;
+      size_t frame_grp_slot = cfg_->FrameSlot(frame_grp_id);
       PartialTranspose(
           &calib_ul_buffer_[frame_grp_slot][ant_id * cfg_->OfdmDataNum()],
           ant_id, sym_type);
@@ -194,7 +203,7 @@ EventData DoFFT::Launch(size_t tag) {
   } else if (sym_type == SymbolType::kCalDL && ant_id == cfg_->RefAnt()) {
     if (frame_id >= TX_FRAME_DELTA) {
       size_t frame_grp_id = (frame_id - TX_FRAME_DELTA) / cfg_->AntGroupNum();
-      size_t frame_grp_slot = frame_grp_id % kFrameWnd;
+      size_t frame_grp_slot = cfg_->FrameSlot(frame_grp_id);
       size_t cal_dl_symbol_id = symbol_id - cfg_->Frame().GetDLCalSymbol(0);
       size_t cur_ant = ((frame_id - TX_FRAME_DELTA) % cfg_->AntGroupNum()) *
                            cfg_->AntPerGroup() +
@@ -214,7 +223,11 @@ EventData DoFFT::Launch(size_t tag) {
 
   fft_req_tag_t(tag).rx_packet_->Free();
   duration_stat->task_count_++;
-  duration_stat->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
+  duration_stat->task_duration_[0] += duration;
+  if (duration_hist != nullptr) {
+    duration_hist->Record(duration);
+  }
   return EventData(EventType::kFFT,
                    gen_tag_t::FrmSym(pkt->frame_id_, pkt->symbol_id_).tag_);
 }
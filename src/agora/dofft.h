@@ -22,7 +22,7 @@
 class DoFFT : public Doer {
  public:
   DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
-        PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+        PtrGrid<kMaxUEs, complex_float>& csi_buffers,
         Table<complex_float>& calib_dl_buffer,
         Table<complex_float>& calib_ul_buffer, PhyStats* in_phy_stats,
         Stats* stats_manager);
@@ -59,6 +59,10 @@ class DoFFT : public Doer {
    * from fft_buffer_.FFT_outputs to data_buffer_ and do block transpose
    *     4. add an event to the message queue to infrom main thread the
    * completion of this task
+   *
+   * If the master erased the packet's antenna from the symbol, the packet
+   * is a placeholder that only carries the header, marked with
+   * Packet::kErasedMagic, and zeros are written in place of its FFT.
    */
   EventData Launch(size_t tag) override;
 
@@ -97,7 +101,7 @@ class DoFFT : public Doer {
 
  private:
   Table<complex_float>& data_buffer_;
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers_;
+  PtrGrid<kMaxUEs, complex_float>& csi_buffers_;
   Table<complex_float>& calib_dl_buffer_;
   Table<complex_float>& calib_ul_buffer_;
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
@@ -109,6 +113,8 @@ class DoFFT : public Doer {
 
   DurationStat* duration_stat_fft_;
   DurationStat* duration_stat_csi_;
+  LatencyHistogram* duration_hist_fft_;
+  LatencyHistogram* duration_hist_csi_;
   PhyStats* phy_stats_;
 };
 
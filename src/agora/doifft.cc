@@ -19,6 +19,8 @@ DoIFFT::DoIFFT(Config* in_config, int in_tid,
       dl_ifft_buffer_(in_dl_ifft_buffer),
       dl_socket_buffer_(in_dl_socket_buffer) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kIFFT, in_tid);
+  duration_hist_ =
+      in_stats_manager->GetDurationHistogram(DoerType::kIFFT, in_tid);
   DftiCreateDescriptor(&mkl_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
                        cfg_->OfdmCaNum());
   if (kUseOutOfPlaceIFFT) {
@@ -122,6 +124,8 @@ EventData DoIFFT::Launch(size_t tag) {
   }
 
   duration_stat_->task_count_++;
-  duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
+  duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
   return EventData(EventType::kIFFT, tag);
 }
@@ -54,6 +54,7 @@ class DoIFFT : public Doer {
   Table<complex_float>& dl_ifft_buffer_;
   char* dl_socket_buffer_;
   DurationStat* duration_stat_;
+  LatencyHistogram* duration_hist_;
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
   float* ifft_out_;  // Buffer for IFFT output
   float ifft_scale_factor_;
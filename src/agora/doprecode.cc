@@ -10,7 +10,7 @@ static constexpr bool kUseSpatialLocality = true;
 
 DoPrecode::DoPrecode(
     Config* in_config, int in_tid,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices,
+    PtrGrid<kMaxDataSCs, complex_float>& dl_zf_matrices,
     Table<complex_float>& in_dl_ifft_buffer,
     Table<int8_t>& dl_encoded_or_raw_data /* Encoded if LDPC is enabled */,
     Stats* in_stats_manager)
@@ -20,6 +20,8 @@ DoPrecode::DoPrecode(
       dl_raw_data_(dl_encoded_or_raw_data) {
   duration_stat_ =
       in_stats_manager->GetDurationStat(DoerType::kPrecode, in_tid);
+  duration_hist_ =
+      in_stats_manager->GetDurationHistogram(DoerType::kPrecode, in_tid);
 
   AllocBuffer1d(&modulated_buffer_temp_, kSCsPerCacheline * cfg_->UeNum(),
                 Agora_memory::Alignment_t::kAlign64, 0);
@@ -69,7 +71,7 @@ EventData DoPrecode::Launch(size_t tag) {
   const size_t symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
   const size_t total_data_symbol_idx =
       cfg_->GetTotalDataSymbolIdxDl(frame_id, symbol_idx_dl);
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
 
   // Mark pilot subcarriers in this block
   // In downlink pilot symbols, all subcarriers are used as pilots
@@ -153,7 +155,9 @@ EventData DoPrecode::Launch(size_t tag) {
     }
   }
   duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
-  duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
+  duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
   if (kDebugPrintInTask) {
     std::printf(
         "In doPrecode thread %d: finished frame: %zu, symbol: %zu, "
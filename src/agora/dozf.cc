@@ -14,19 +14,21 @@ static constexpr bool kUseSIMDGather = true;
 static constexpr size_t kUseInverseForZF = 1u;
 
 DoZF::DoZF(Config* config, int tid,
-           PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+           PtrGrid<kMaxUEs, complex_float>& csi_buffers,
            Table<complex_float>& calib_dl_buffer,
            Table<complex_float>& calib_ul_buffer,
-           PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
-           PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices,
-           Stats* stats_manager)
+           PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices,
+           PtrGrid<kMaxDataSCs, complex_float>& dl_zf_matrices,
+           Stats* stats_manager, const AntennaErasures* antenna_erasures)
     : Doer(config, tid),
       csi_buffers_(csi_buffers),
       calib_dl_buffer_(calib_dl_buffer),
       calib_ul_buffer_(calib_ul_buffer),
       ul_zf_matrices_(ul_zf_matrices),
-      dl_zf_matrices_(dl_zf_matrices) {
+      dl_zf_matrices_(dl_zf_matrices),
+      antenna_erasures_(antenna_erasures) {
   duration_stat_ = stats_manager->GetDurationStat(DoerType::kZF, tid);
+  duration_hist_ = stats_manager->GetDurationHistogram(DoerType::kZF, tid);
   pred_csi_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
@@ -56,21 +58,63 @@ EventData DoZF::Launch(size_t tag) {
   return EventData(EventType::kZF, tag);
 }
 
+arma::uvec DoZF::KeptCsiRows(size_t frame_id, size_t num_rows) const {
+  if (antenna_erasures_ == nullptr) {
+    return arma::uvec();
+  }
+  std::bitset<kMaxAntennas> erased;
+  for (size_t i = 0; i < cfg_->Frame().NumPilotSyms(); i++) {
+    erased |=
+        antenna_erasures_->Erased(frame_id, cfg_->Frame().GetPilotSymbol(i));
+  }
+  if (erased.none() == true) {
+    return arma::uvec();
+  }
+
+  const bool ref_rows_shed = num_rows < cfg_->BsAntNum();
+  std::vector<arma::uword> kept_rows;
+  size_t row = 0;
+  for (size_t ant_id = 0; ant_id < cfg_->BsAntNum(); ant_id++) {
+    if ((ref_rows_shed == true) && (ant_id >= cfg_->RefAnt()) &&
+        (ant_id < cfg_->RefAnt() + cfg_->NumChannels())) {
+      continue;
+    }
+    if (erased.test(ant_id) == false) {
+      kept_rows.push_back(row);
+    }
+    row++;
+  }
+  return arma::uvec(kept_rows);
+}
+
 void DoZF::ComputePrecoder(const arma::cx_fmat& mat_csi,
                            complex_float* calib_ptr, complex_float* _mat_ul_zf,
-                           complex_float* _mat_dl_zf) {
+                           complex_float* _mat_dl_zf,
+                           const arma::uvec& kept_rows) {
   arma::cx_fmat mat_ul_zf(reinterpret_cast<arma::cx_float*>(_mat_ul_zf),
                           cfg_->UeNum(), cfg_->BsAntNum(), false);
+  // Reduced-dimension zeroforcing over the received antennas
+  arma::cx_fmat mat_csi_kept;
+  if (kept_rows.is_empty() == false) {
+    mat_csi_kept = mat_csi.rows(kept_rows);
+  }
+  const arma::cx_fmat& csi = kept_rows.is_empty() ? mat_csi : mat_csi_kept;
   arma::cx_fmat mat_ul_zf_tmp;
   if (kUseInverseForZF != 0u) {
     try {
-      mat_ul_zf_tmp = arma::inv_sympd(mat_csi.t() * mat_csi) * mat_csi.t();
+      mat_ul_zf_tmp = arma::inv_sympd(csi.t() * csi) * csi.t();
     } catch (std::runtime_error&) {
       MLPD_WARN("Failed to invert channel matrix, falling back to pinv()\n");
-      arma::pinv(mat_ul_zf_tmp, mat_csi, 1e-2, "dc");
+      arma::pinv(mat_ul_zf_tmp, csi, 1e-2, "dc");
     }
   } else {
-    arma::pinv(mat_ul_zf_tmp, mat_csi, 1e-2, "dc");
+    arma::pinv(mat_ul_zf_tmp, csi, 1e-2, "dc");
+  }
+  if (kept_rows.is_empty() == false) {
+    arma::cx_fmat mat_ul_zf_full(cfg_->UeNum(), mat_csi.n_rows,
+                                 arma::fill::zeros);
+    mat_ul_zf_full.cols(kept_rows) = mat_ul_zf_tmp;
+    mat_ul_zf_tmp = mat_ul_zf_full;
   }
 
   if (cfg_->Frame().NumDLSyms() > 0) {
@@ -184,13 +228,15 @@ static inline void TransposeGather(size_t cur_sc_id, float* src, float*& dst,
 void DoZF::ZfTimeOrthogonal(size_t tag) {
   const size_t frame_id = gen_tag_t(tag).frame_id_;
   const size_t base_sc_id = gen_tag_t(tag).sc_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   if (kDebugPrintInTask) {
     std::printf("In doZF thread %d: frame: %zu, base subcarrier: %zu\n", tid_,
                 frame_id, base_sc_id);
   }
   size_t num_subcarriers =
       std::min(cfg_->ZfBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+  // The erased antennas are the same for all subcarriers of the frame
+  arma::uvec kept_rows;
 
   // Handle each subcarrier one by one
   for (size_t i = 0; i < num_subcarriers; i++) {
@@ -221,15 +267,16 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
       arma::cx_fvec calib_vec(
           reinterpret_cast<arma::cx_float*>(calib_gather_buffer_),
           cfg_->BfAntNum(), false);
-      size_t frame_cal_slot = kFrameWnd - 1;
-      size_t frame_cal_slot_prev = kFrameWnd - 1;
+      size_t frame_cal_slot = cfg_->FrameWnd() - 1;
+      size_t frame_cal_slot_prev = cfg_->FrameWnd() - 1;
       if (cfg_->Frame().IsRecCalEnabled() && frame_id >= TX_FRAME_DELTA) {
         size_t frame_grp_id = (frame_id - TX_FRAME_DELTA) / cfg_->AntGroupNum();
 
         // use the previous window which has a full set of calibration results
-        frame_cal_slot = (frame_grp_id + kFrameWnd - 1) % kFrameWnd;
+        frame_cal_slot = cfg_->FrameSlot(frame_grp_id + cfg_->FrameWnd() - 1);
         if (frame_id >= TX_FRAME_DELTA + cfg_->AntGroupNum()) {
-          frame_cal_slot_prev = (frame_grp_id + kFrameWnd - 2) % kFrameWnd;
+          frame_cal_slot_prev =
+              cfg_->FrameSlot(frame_grp_id + cfg_->FrameWnd() - 2);
         }
       }
       arma::cx_fmat calib_dl_mat(
@@ -258,16 +305,22 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
       }
     }
 
+    if (i == 0) {
+      kept_rows = KeptCsiRows(frame_id, mat_csi.n_rows);
+    }
+
     double start_tsc3 = GetTime::WorkerRdtsc();
     duration_stat_->task_duration_[2] += start_tsc3 - start_tsc2;
 
     ComputePrecoder(mat_csi, calib_gather_buffer_,
                     ul_zf_matrices_[frame_slot][cur_sc_id],
-                    dl_zf_matrices_[frame_slot][cur_sc_id]);
+                    dl_zf_matrices_[frame_slot][cur_sc_id], kept_rows);
 
     duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
     duration_stat_->task_count_++;
-    duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc1;
+    const size_t duration = GetTime::WorkerRdtsc() - start_tsc1;
+    duration_stat_->task_duration_[0] += duration;
+    duration_hist_->Record(duration);
     // if (duration > 500) {
     //     std::printf("Thread %d ZF takes %.2f\n", tid, duration);
     // }
@@ -277,7 +330,7 @@ void DoZF::ZfTimeOrthogonal(size_t tag) {
 void DoZF::ZfFreqOrthogonal(size_t tag) {
   const size_t frame_id = gen_tag_t(tag).frame_id_;
   const size_t base_sc_id = gen_tag_t(tag).sc_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   if (kDebugPrintInTask) {
     std::printf(
         "In doZF thread %d: frame: %zu, subcarrier: %zu, block: %zu, "
@@ -304,15 +357,16 @@ void DoZF::ZfFreqOrthogonal(size_t tag) {
     arma::cx_fvec calib_vec(
         reinterpret_cast<arma::cx_float*>(calib_gather_buffer_),
         cfg_->BfAntNum(), false);
-    size_t frame_cal_slot = kFrameWnd - 1;
-    size_t frame_cal_slot_prev = kFrameWnd - 1;
+    size_t frame_cal_slot = cfg_->FrameWnd() - 1;
+    size_t frame_cal_slot_prev = cfg_->FrameWnd() - 1;
     if (cfg_->Frame().IsRecCalEnabled() && (frame_id >= TX_FRAME_DELTA)) {
       size_t frame_grp_id = (frame_id - TX_FRAME_DELTA) / cfg_->AntGroupNum();
 
       // use the previous window which has a full set of calibration results
-      frame_cal_slot = (frame_grp_id + kFrameWnd - 1) % kFrameWnd;
+      frame_cal_slot = cfg_->FrameSlot(frame_grp_id + cfg_->FrameWnd() - 1);
       if (frame_id >= TX_FRAME_DELTA + cfg_->AntGroupNum()) {
-        frame_cal_slot_prev = (frame_grp_id + kFrameWnd - 2) % kFrameWnd;
+        frame_cal_slot_prev =
+            cfg_->FrameSlot(frame_grp_id + cfg_->FrameWnd() - 2);
       }
     }
     arma::cx_fmat calib_dl_mat(
@@ -344,11 +398,14 @@ void DoZF::ZfFreqOrthogonal(size_t tag) {
 
   ComputePrecoder(mat_csi, calib_gather_buffer_,
                   ul_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)],
-                  dl_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)]);
+                  dl_zf_matrices_[frame_slot][cfg_->GetZfScId(base_sc_id)],
+                  KeptCsiRows(frame_id, mat_csi.n_rows));
 
   duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
   duration_stat_->task_count_++;
-  duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc1;
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc1;
+  duration_stat_->task_duration_[0] += duration;
+  duration_hist_->Record(duration);
 
   // if (duration > 500) {
   //     std::printf("Thread %d ZF takes %.2f\n", tid, duration);
@@ -365,7 +422,7 @@ void DoZF::Predict(size_t tag)
     // Use stale CSI as predicted CSI
     // TODO: add prediction algorithm
     const size_t offset_in_buffer
-        = ((frame_id % kFrameWnd) * cfg_->OfdmDataNum())
+        = (cfg_->FrameSlot(frame_id) * cfg_->OfdmDataNum())
         + base_sc_id;
     auto* ptr_in = (arma::cx_float*)pred_csi_buffer;
     std::memcpy(ptr_in, (arma::cx_float*)csi_buffer_[offset_in_buffer],
@@ -20,12 +20,13 @@
 class DoZF : public Doer {
  public:
   DoZF(Config* in_config, int tid,
-       PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+       PtrGrid<kMaxUEs, complex_float>& csi_buffers,
        Table<complex_float>& calib_dl_buffer,
        Table<complex_float>& calib_ul_buffer,
-       PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices_,
-       PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices_,
-       Stats* stats_manager);
+       PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices_,
+       PtrGrid<kMaxDataSCs, complex_float>& dl_zf_matrices_,
+       Stats* stats_manager,
+       const AntennaErasures* antenna_erasures = nullptr);
   ~DoZF() override;
 
   /**
@@ -50,9 +51,19 @@ class DoZF : public Doer {
   void ZfTimeOrthogonal(size_t tag);
 
   /// Compute the uplink zeroforcing detector matrix and/or the downlink
-  /// zeroforcing precoder using this CSI matrix and calibration buffer
+  /// zeroforcing precoder using this CSI matrix and calibration buffer.
+  /// Rows of [mat_csi] in [kept_rows], if not empty, are the antennas whose
+  /// pilots were received. The zeroforcing then uses only those rows, and
+  /// the columns of the erased antennas are zero.
   void ComputePrecoder(const arma::cx_fmat& mat_csi, complex_float* calib_ptr,
-                       complex_float* mat_ul_zf, complex_float* mat_dl_zf);
+                       complex_float* mat_ul_zf, complex_float* mat_dl_zf,
+                       const arma::uvec& kept_rows);
+
+  /// Rows of a CSI matrix of [frame_id] with [num_rows] rows whose
+  /// antennas were not erased from any pilot symbol. Empty if no antenna
+  /// was erased. With an external reference node, the rows of the reference
+  /// antennas may already be shed from the matrix.
+  arma::uvec KeptCsiRows(size_t frame_id, size_t num_rows) const;
 
   void ZfFreqOrthogonal(size_t tag);
 
@@ -80,17 +91,20 @@ class DoZF : public Doer {
    */
   void Predict(size_t offset);
 
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers_;
+  PtrGrid<kMaxUEs, complex_float>& csi_buffers_;
   complex_float* pred_csi_buffer_;
   Table<complex_float> calib_dl_buffer_;
   Table<complex_float> calib_ul_buffer_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices_;
+  PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices_;
+  PtrGrid<kMaxDataSCs, complex_float>& dl_zf_matrices_;
   DurationStat* duration_stat_;
+  LatencyHistogram* duration_hist_;
 
   complex_float* csi_gather_buffer_;  // Intermediate buffer to gather CSI
   // Intermediate buffer to gather reciprical calibration data vector
   complex_float* calib_gather_buffer_;
+  // Antennas erased by the master, or nullptr if erasures are disabled
+  const AntennaErasures* antenna_erasures_;
 };
 
 #endif  // DOZF_H_
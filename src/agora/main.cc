@@ -3,6 +3,7 @@
  * @brief Main file for the agora server
  */
 #include "agora.h"
+#include "async_logger.h"
 #include "gflags/gflags.h"
 #include "version_config.h"
 
@@ -28,6 +29,8 @@ int main(int argc, char* argv[]) {
   std::unique_ptr<Config> cfg = std::make_unique<Config>(conf_file.c_str());
   cfg->GenData();
 
+  // Move log formatting and writing off the Agora threads
+  AsyncLogger::Start();
   int ret;
   try {
     SignalHandler signal_handler;
@@ -41,6 +44,7 @@ int main(int argc, char* argv[]) {
     std::cerr << "SignalException: " << e.what() << std::endl;
     ret = EXIT_FAILURE;
   }
+  AsyncLogger::Stop();
 
   gflags::ShutDownCommandLineFlags();
   return ret;
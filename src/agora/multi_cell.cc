@@ -0,0 +1,106 @@
+/**
+ * @file multi_cell.cc
+ * @brief Implementation file for running several Agora cells in one process
+ * with a shared pool of worker threads
+ */
+#include "multi_cell.h"
+
+MultiCell::MultiCell(const std::vector<Config*>& cfgs)
+    : base_worker_core_offset_(0) {
+  RtAssert(cfgs.empty() == false, "MultiCell: no cells");
+  const size_t num_workers = cfgs.at(0)->WorkerThreadNum();
+  for (const auto* cfg : cfgs) {
+    RtAssert(cfg->BigstationMode() == false,
+             "MultiCell: Bigstation mode is not supported");
+    // The worker producer tokens of each cell are made for its workers
+    RtAssert(cfg->WorkerThreadNum() == num_workers,
+             "MultiCell: all cells must have the same number of workers");
+    base_worker_core_offset_ =
+        std::max(base_worker_core_offset_,
+                 cfg->CoreOffset() + 1 + cfg->SocketThreadNum());
+  }
+
+  for (auto* cfg : cfgs) {
+    cells_.push_back(std::make_unique<Agora>(cfg, false));
+    cells_.back()->SetWorkerParking(&worker_parking_);
+  }
+
+  MLPD_INFO("MultiCell: %zu cells, worker thread cores %zu--%zu\n",
+            cells_.size(), base_worker_core_offset_,
+            base_worker_core_offset_ + num_workers - 1);
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back(&MultiCell::Worker, this, i);
+  }
+}
+
+MultiCell::~MultiCell() {
+  Stop();
+  // The workers use the buffers of the cells
+  for (auto& worker_thread : workers_) {
+    MLPD_SYMBOL("MultiCell: Joining worker thread\n");
+    worker_thread.join();
+  }
+  cells_.clear();
+}
+
+void MultiCell::Start() {
+  std::vector<std::thread> masters;
+  for (auto& cell : cells_) {
+    masters.emplace_back(&Agora::Start, cell.get());
+  }
+  for (auto& master : masters) {
+    master.join();
+  }
+}
+
+void MultiCell::Stop() {
+  for (auto& cell : cells_) {
+    cell->GetConfig()->Running(false);
+  }
+  worker_parking_.Wake();
+}
+
+bool MultiCell::AnyCellRunning() const {
+  for (const auto& cell : cells_) {
+    if (cell->GetConfig()->Running() == true) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MultiCell::Worker(int tid) {
+  // The shared workers follow the placement of the first cell
+  PinToCoreWithOffset(ThreadType::kWorker, base_worker_core_offset_, tid,
+                      cells_.at(0)->GetConfig()->Placement());
+
+  std::vector<std::unique_ptr<Agora::WorkerContext>> contexts;
+  for (auto& cell : cells_) {
+    contexts.push_back(cell->CreateWorkerContext(tid));
+  }
+
+  const Config* cfg = cells_.at(0)->GetConfig();
+  WorkerIdler idler(&worker_parking_, cfg->WorkerIdleSpinPolls(),
+                    cfg->WorkerIdlePausePolls(), cfg->WorkerParkTimeoutUs());
+  // Start the workers from different cells
+  size_t first_cell = tid % cells_.size();
+  while (AnyCellRunning() == true) {
+    bool launched = false;
+    for (size_t i = 0; i < cells_.size(); i++) {
+      const size_t cell_id = (first_cell + i) % cells_.size();
+      Agora& cell = *cells_.at(cell_id);
+      if ((cell.GetConfig()->Running() == true) &&
+          (cell.WorkerPoll(*contexts.at(cell_id)) == true)) {
+        launched = true;
+      }
+    }
+    if (launched == true) {
+      idler.Busy();
+    } else {
+      idler.Idle();
+    }
+    // Round-robin: the next pass starts from the next cell
+    first_cell = (first_cell + 1) % cells_.size();
+  }
+  MLPD_SYMBOL("MultiCell worker %d exit\n", tid);
+}
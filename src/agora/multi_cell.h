@@ -0,0 +1,56 @@
+/**
+ * @file multi_cell.h
+ * @brief Declaration file for running several Agora cells in one process
+ * with a shared pool of worker threads
+ */
+
+#ifndef MULTI_CELL_H_
+#define MULTI_CELL_H_
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "agora.h"
+#include "config.h"
+
+/**
+ * @brief Several Agora cells in one process. Each cell has its own Config,
+ * master thread, TXRX threads, buffers, and queues, and the worker threads
+ * are shared between the cells.
+ *
+ * A worker keeps the doers of every cell, since the doers are bound to the
+ * buffers of their cell. The tasks of a cell are in its own queues, so the
+ * task tags need no cell id. The workers poll the running cells round-robin,
+ * starting from a different cell in each pass so that a busy cell does not
+ * starve the others.
+ */
+class MultiCell {
+ public:
+  /// Create the cells and start the shared worker threads. All cells must
+  /// use the same number of worker threads.
+  explicit MultiCell(const std::vector<Config*>& cfgs);
+  ~MultiCell();
+
+  /// Run the master loops of all cells until they finish
+  void Start();
+  void Stop();
+
+  inline size_t NumCells() const { return this->cells_.size(); }
+  inline Agora& Cell(size_t cell_id) { return *this->cells_.at(cell_id); }
+
+ private:
+  void Worker(int tid);
+  bool AnyCellRunning() const;
+
+  std::vector<std::unique_ptr<Agora>> cells_;
+  std::vector<std::thread> workers_;
+  // Idle workers park here until any cell schedules tasks
+  WorkerParking worker_parking_;
+
+  // Worker thread i runs on core base_worker_core_offset + i, after the
+  // master and TXRX cores of all cells
+  size_t base_worker_core_offset_;
+};
+
+#endif  // MULTI_CELL_H_
@@ -12,7 +12,25 @@ PhyStats::PhyStats(Config* const cfg) : config_(cfg) {
   } else {
     num_rx_symbols_ = cfg->Frame().NumULSyms();
   }
-  const size_t task_buffer_symbol_num = num_rx_symbols_ * kFrameWnd;
+  const size_t task_buffer_symbol_num = num_rx_symbols_ * config_->FrameWnd();
+
+  shards_.resize(cfg->WorkerThreadNum());
+  for (Shard& shard : shards_) {
+    shard.decoded_bits_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                     Agora_memory::Alignment_t::kAlign64);
+    shard.bit_error_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                  Agora_memory::Alignment_t::kAlign64);
+    shard.decoded_blocks_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                       Agora_memory::Alignment_t::kAlign64);
+    shard.block_error_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                    Agora_memory::Alignment_t::kAlign64);
+    shard.uncoded_bits_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                     Agora_memory::Alignment_t::kAlign64);
+    shard.uncoded_bit_error_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
+                                          Agora_memory::Alignment_t::kAlign64);
+    shard.evm_buffer_.Calloc(config_->FrameWnd(), cfg->UeAntNum(),
+                             Agora_memory::Alignment_t::kAlign64);
+  }
 
   decoded_bits_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
                              Agora_memory::Alignment_t::kAlign64);
@@ -29,7 +47,7 @@ PhyStats::PhyStats(Config* const cfg) : config_(cfg) {
   uncoded_bit_error_count_.Calloc(cfg->UeNum(), task_buffer_symbol_num,
                                   Agora_memory::Alignment_t::kAlign64);
 
-  evm_buffer_.Calloc(kFrameWnd, cfg->UeAntNum(),
+  evm_buffer_.Calloc(config_->FrameWnd(), cfg->UeAntNum(),
                      Agora_memory::Alignment_t::kAlign64);
 
   if (num_rx_symbols_ > 0) {
@@ -48,11 +66,22 @@ PhyStats::PhyStats(Config* const cfg) : config_(cfg) {
     }
     gt_mat_ = gt_mat_.cols(cfg->OfdmDataStart(), (cfg->OfdmDataStop() - 1));
   }
-  pilot_snr_.Calloc(kFrameWnd, cfg->UeAntNum(),
+  pilot_snr_.Calloc(config_->FrameWnd(), cfg->UeAntNum(),
                     Agora_memory::Alignment_t::kAlign64);
+  antenna_erasures_.resize(cfg->BsAntNum(), 0);
 }
 
 PhyStats::~PhyStats() {
+  for (Shard& shard : shards_) {
+    shard.decoded_bits_count_.Free();
+    shard.bit_error_count_.Free();
+    shard.decoded_blocks_count_.Free();
+    shard.block_error_count_.Free();
+    shard.uncoded_bits_count_.Free();
+    shard.uncoded_bit_error_count_.Free();
+    shard.evm_buffer_.Free();
+  }
+
   decoded_bits_count_.Free();
   bit_error_count_.Free();
 
@@ -66,8 +95,62 @@ PhyStats::~PhyStats() {
   pilot_snr_.Free();
 }
 
+void PhyStats::ReduceFrame(size_t frame_id) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  for (size_t i = 0; i < num_rx_symbols_; i++) {
+    ReduceSymbol((frame_slot * num_rx_symbols_) + i);
+  }
+  ReduceEvm(frame_slot);
+}
+
+void PhyStats::ReduceAll() {
+  for (size_t i = 0; i < num_rx_symbols_ * config_->FrameWnd(); i++) {
+    ReduceSymbol(i);
+  }
+  for (size_t frame_slot = 0; frame_slot < config_->FrameWnd(); frame_slot++) {
+    ReduceEvm(frame_slot);
+  }
+}
+
+void PhyStats::ReduceSymbol(size_t offset) {
+  for (size_t ue_id = 0; ue_id < config_->UeNum(); ue_id++) {
+    size_t decoded_bits = 0;
+    size_t bit_errors = 0;
+    size_t decoded_blocks = 0;
+    size_t block_errors = 0;
+    size_t uncoded_bits = 0;
+    size_t uncoded_bit_errors = 0;
+    for (Shard& shard : shards_) {
+      decoded_bits += shard.decoded_bits_count_[ue_id][offset];
+      bit_errors += shard.bit_error_count_[ue_id][offset];
+      decoded_blocks += shard.decoded_blocks_count_[ue_id][offset];
+      block_errors += shard.block_error_count_[ue_id][offset];
+      uncoded_bits += shard.uncoded_bits_count_[ue_id][offset];
+      uncoded_bit_errors += shard.uncoded_bit_error_count_[ue_id][offset];
+    }
+    decoded_bits_count_[ue_id][offset] = decoded_bits;
+    bit_error_count_[ue_id][offset] = bit_errors;
+    decoded_blocks_count_[ue_id][offset] = decoded_blocks;
+    block_error_count_[ue_id][offset] = block_errors;
+    uncoded_bits_count_[ue_id][offset] = uncoded_bits;
+    uncoded_bit_error_count_[ue_id][offset] = uncoded_bit_errors;
+  }
+}
+
+void PhyStats::ReduceEvm(size_t frame_slot) {
+  for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
+    float evm = 0;
+    for (Shard& shard : shards_) {
+      evm += shard.evm_buffer_[frame_slot][ue_id];
+    }
+    evm_buffer_[frame_slot][ue_id] = evm;
+  }
+}
+
 void PhyStats::PrintPhyStats() {
-  const size_t task_buffer_symbol_num = num_rx_symbols_ * kFrameWnd;
+  const size_t task_buffer_symbol_num = num_rx_symbols_ * config_->FrameWnd();
+  // Include the frames that did not complete
+  ReduceAll();
   std::string tx_type;
   if (config_->IsUe()) {
     tx_type = "Downlink";
@@ -97,11 +180,39 @@ void PhyStats::PrintPhyStats() {
                 << std::endl;
     }
   }
+
+  if (TotalAntennaErasures() > 0) {
+    std::stringstream ss;
+    ss << "Antenna erasures: " << TotalAntennaErasures() << " (";
+    for (size_t ant_id = 0; ant_id < antenna_erasures_.size(); ant_id++) {
+      if (antenna_erasures_.at(ant_id) > 0) {
+        ss << "ant " << ant_id << ": " << antenna_erasures_.at(ant_id) << " ";
+      }
+    }
+    ss << ")" << std::endl;
+    std::cout << ss.str();
+  }
+}
+
+void PhyStats::UpdateAntennaErasures(const std::bitset<kMaxAntennas>& erased) {
+  for (size_t ant_id = 0; ant_id < antenna_erasures_.size(); ant_id++) {
+    if (erased.test(ant_id) == true) {
+      antenna_erasures_.at(ant_id)++;
+    }
+  }
+}
+
+size_t PhyStats::TotalAntennaErasures() const {
+  size_t total = 0;
+  for (size_t count : antenna_erasures_) {
+    total += count;
+  }
+  return total;
 }
 
 void PhyStats::PrintEvmStats(size_t frame_id) {
-  arma::fmat evm_mat(evm_buffer_[frame_id % kFrameWnd], config_->UeNum(), 1,
-                     false);
+  arma::fmat evm_mat(evm_buffer_[config_->FrameSlot(frame_id)],
+                     config_->UeNum(), 1, false);
   evm_mat = sqrt(evm_mat) / config_->OfdmDataNum();
   std::stringstream ss;
   ss << "Frame " << frame_id << " Constellation:\n"
@@ -110,16 +221,50 @@ void PhyStats::PrintEvmStats(size_t frame_id) {
 }
 
 float PhyStats::GetEvmSnr(size_t frame_id, size_t ue_id) {
-  float evm = evm_buffer_[frame_id % kFrameWnd][ue_id];
+  float evm = evm_buffer_[config_->FrameSlot(frame_id)][ue_id];
   evm = std::sqrt(evm) / config_->OfdmDataNum();
   return -10 * std::log10(evm);
 }
 
+float PhyStats::GetBlockErrorRate(size_t ue_id) {
+  const size_t task_buffer_symbol_num = num_rx_symbols_ * config_->FrameWnd();
+  size_t total_decoded_blocks = 0;
+  size_t total_block_errors = 0;
+  for (size_t i = 0; i < task_buffer_symbol_num; i++) {
+    total_decoded_blocks += decoded_blocks_count_[ue_id][i];
+    total_block_errors += block_error_count_[ue_id][i];
+  }
+  if (total_decoded_blocks == 0) {
+    return 0;
+  }
+  return static_cast<float>(total_block_errors) / total_decoded_blocks;
+}
+
+size_t PhyStats::GetBitErrors(size_t ue_id) {
+  size_t total = 0;
+  for (size_t i = 0; i < num_rx_symbols_ * config_->FrameWnd(); i++) {
+    total += bit_error_count_[ue_id][i];
+  }
+  return total;
+}
+
+size_t PhyStats::GetDecodedBits(size_t ue_id) {
+  size_t total = 0;
+  for (size_t i = 0; i < num_rx_symbols_ * config_->FrameWnd(); i++) {
+    total += decoded_bits_count_[ue_id][i];
+  }
+  return total;
+}
+
+float PhyStats::GetPilotSnr(size_t frame_id, size_t ue_id) {
+  return pilot_snr_[config_->FrameSlot(frame_id)][ue_id];
+}
+
 void PhyStats::PrintSnrStats(size_t frame_id) {
   std::stringstream ss;
   ss << "Frame " << frame_id << " Pilot Signal SNR: ";
   for (size_t i = 0; i < config_->UeNum(); i++) {
-    ss << pilot_snr_[frame_id % kFrameWnd][i] << " ";
+    ss << pilot_snr_[config_->FrameSlot(frame_id)][i] << " ";
   }
   ss << std::endl;
   std::cout << ss.str();
@@ -138,21 +283,22 @@ void PhyStats::UpdatePilotSnr(size_t frame_id, size_t ue_id,
       fft_abs_mag.rows(config_->OfdmDataStop(), config_->OfdmCaNum() - 1)));
   float noise = config_->OfdmCaNum() * (noise_per_sc1 + noise_per_sc2) / 2;
   float snr = (rssi - noise) / noise;
-  pilot_snr_[frame_id % kFrameWnd][ue_id] = 10 * std::log10(snr);
+  pilot_snr_[config_->FrameSlot(frame_id)][ue_id] = 10 * std::log10(snr);
 }
 
-void PhyStats::UpdateEvmStats(size_t frame_id, size_t sc_id,
+void PhyStats::UpdateEvmStats(size_t tid, size_t frame_id, size_t sc_id,
                               const arma::cx_fmat& eq) {
   if (num_rx_symbols_ > 0) {
     arma::fmat evm = abs(eq - gt_mat_.col(sc_id));
-    arma::fmat cur_evm_mat(evm_buffer_[frame_id % kFrameWnd], config_->UeNum(),
-                           1, false);
+    arma::fmat cur_evm_mat(
+        shards_.at(tid).evm_buffer_[config_->FrameSlot(frame_id)],
+        config_->UeNum(), 1, false);
     cur_evm_mat += evm % evm;
   }
 }
 
-void PhyStats::UpdateBitErrors(size_t ue_id, size_t offset, uint8_t tx_byte,
-                               uint8_t rx_byte) {
+void PhyStats::UpdateBitErrors(size_t tid, size_t ue_id, size_t offset,
+                               uint8_t tx_byte, uint8_t rx_byte) {
   static constexpr size_t kBitsInByte = 8;
   // std::printf("Updating bit errors: %zu %zu %d %d\n", ue_id, offset, tx_byte,
   // rx_byte);
@@ -162,37 +308,38 @@ void PhyStats::UpdateBitErrors(size_t ue_id, size_t offset, uint8_t tx_byte,
     bit_errors += (xor_byte & 1);
     xor_byte >>= 1;
   }
-  bit_error_count_[ue_id][offset] += bit_errors;
+  shards_.at(tid).bit_error_count_[ue_id][offset] += bit_errors;
 }
 
-void PhyStats::UpdateDecodedBits(size_t ue_id, size_t offset,
+void PhyStats::UpdateDecodedBits(size_t tid, size_t ue_id, size_t offset,
                                  size_t new_bits_num) {
-  decoded_bits_count_[ue_id][offset] += new_bits_num;
+  shards_.at(tid).decoded_bits_count_[ue_id][offset] += new_bits_num;
 }
 
-void PhyStats::UpdateBlockErrors(size_t ue_id, size_t offset,
+void PhyStats::UpdateBlockErrors(size_t tid, size_t ue_id, size_t offset,
                                  size_t block_error_count) {
-  block_error_count_[ue_id][offset] +=
+  shards_.at(tid).block_error_count_[ue_id][offset] +=
       static_cast<unsigned long>(block_error_count > 0);
 }
 
-void PhyStats::IncrementDecodedBlocks(size_t ue_id, size_t offset) {
-  decoded_blocks_count_[ue_id][offset]++;
+void PhyStats::IncrementDecodedBlocks(size_t tid, size_t ue_id,
+                                      size_t offset) {
+  shards_.at(tid).decoded_blocks_count_[ue_id][offset]++;
 }
 
-void PhyStats::UpdateUncodedBitErrors(size_t ue_id, size_t offset,
-                                      size_t mod_bit_size, uint8_t tx_byte,
-                                      uint8_t rx_byte) {
+void PhyStats::UpdateUncodedBitErrors(size_t tid, size_t ue_id,
+                                      size_t offset, size_t mod_bit_size,
+                                      uint8_t tx_byte, uint8_t rx_byte) {
   uint8_t xor_byte(tx_byte ^ rx_byte);
   size_t bit_errors = 0;
   for (size_t j = 0; j < mod_bit_size; j++) {
     bit_errors += xor_byte & 1;
     xor_byte >>= 1;
   }
-  uncoded_bit_error_count_[ue_id][offset] += bit_errors;
+  shards_.at(tid).uncoded_bit_error_count_[ue_id][offset] += bit_errors;
 }
 
-void PhyStats::UpdateUncodedBits(size_t ue_id, size_t offset,
+void PhyStats::UpdateUncodedBits(size_t tid, size_t ue_id, size_t offset,
                                  size_t new_bits_num) {
-  uncoded_bits_count_[ue_id][offset] += new_bits_num;
+  shards_.at(tid).uncoded_bits_count_[ue_id][offset] += new_bits_num;
 }
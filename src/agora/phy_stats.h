@@ -6,38 +6,86 @@
 #define PHY_STATS_H_
 
 #include <armadillo>
+#include <bitset>
+#include <vector>
 
 #include "config.h"
 #include "memory_manage.h"
 #include "symbols.h"
 
+/**
+ * @brief Bit, block and EVM statistics of the received data.
+ *
+ * Each worker thread updates its own shard of the counters, so workers never
+ * write to the same cache line. When a frame completes, the master sums the
+ * frame's counters over the shards into a snapshot with ReduceFrame(), and
+ * the Get and Print functions read the snapshot.
+ */
 class PhyStats {
  public:
   explicit PhyStats(Config* const cfg);
   ~PhyStats();
   void PrintPhyStats();
-  void UpdateBitErrors(size_t /*ue_id*/, size_t /*offset*/, uint8_t /*tx_byte*/,
-                       uint8_t /*rx_byte*/);
-  void UpdateDecodedBits(size_t /*ue_id*/, size_t /*offset*/,
+  void UpdateBitErrors(size_t /*tid*/, size_t /*ue_id*/, size_t /*offset*/,
+                       uint8_t /*tx_byte*/, uint8_t /*rx_byte*/);
+  void UpdateDecodedBits(size_t /*tid*/, size_t /*ue_id*/, size_t /*offset*/,
                          size_t /*new_bits_num*/);
-  void UpdateBlockErrors(size_t /*ue_id*/, size_t /*offset*/,
+  void UpdateBlockErrors(size_t /*tid*/, size_t /*ue_id*/, size_t /*offset*/,
                          size_t /*block_error_count*/);
-  void IncrementDecodedBlocks(size_t /*ue_id*/, size_t /*offset*/);
-  void UpdateUncodedBitErrors(size_t /*ue_id*/, size_t /*offset*/,
-                              size_t /*mod_bit_size*/, uint8_t /*tx_byte*/,
-                              uint8_t /*rx_byte*/);
-  void UpdateUncodedBits(size_t /*ue_id*/, size_t /*offset*/,
+  void IncrementDecodedBlocks(size_t /*tid*/, size_t /*ue_id*/,
+                              size_t /*offset*/);
+  void UpdateUncodedBitErrors(size_t /*tid*/, size_t /*ue_id*/,
+                              size_t /*offset*/, size_t /*mod_bit_size*/,
+                              uint8_t /*tx_byte*/, uint8_t /*rx_byte*/);
+  void UpdateUncodedBits(size_t /*tid*/, size_t /*ue_id*/, size_t /*offset*/,
                          size_t /*new_bits_num*/);
-  void UpdateEvmStats(size_t /*frame_id*/, size_t /*sc_id*/,
+  void UpdateEvmStats(size_t /*tid*/, size_t /*frame_id*/, size_t /*sc_id*/,
                       const arma::cx_fmat& /*eq*/);
+  /// Sum the counters of [frame_id] over the worker shards into the
+  /// snapshot. Called by the master when the frame is complete.
+  void ReduceFrame(size_t frame_id);
   void PrintEvmStats(size_t /*frame_id*/);
   void UpdatePilotSnr(size_t /*frame_id*/, size_t /*ue_id*/,
                       complex_float* /*fft_data*/);
   float GetEvmSnr(size_t frame_id, size_t ue_id);
+  /// The block error rate of UE [ue_id] over the blocks decoded in the
+  /// frame window, or zero if none were decoded
+  float GetBlockErrorRate(size_t ue_id);
+  /// The bit errors and decoded bits of UE [ue_id] over the frame window
+  size_t GetBitErrors(size_t ue_id);
+  size_t GetDecodedBits(size_t ue_id);
+  float GetPilotSnr(size_t frame_id, size_t ue_id);
   void PrintSnrStats(size_t /*frame_id*/);
+  /// Count the antennas erased from a symbol by the master thread, which is
+  /// the only caller
+  void UpdateAntennaErasures(const std::bitset<kMaxAntennas>& erased);
+  size_t TotalAntennaErasures() const;
 
  private:
+  /// The counters of one worker thread. Each table is a separate cache-line
+  /// aligned allocation.
+  struct Shard {
+    Table<size_t> decoded_bits_count_;
+    Table<size_t> bit_error_count_;
+    Table<size_t> decoded_blocks_count_;
+    Table<size_t> block_error_count_;
+    Table<size_t> uncoded_bits_count_;
+    Table<size_t> uncoded_bit_error_count_;
+    Table<float> evm_buffer_;
+  };
+
+  /// Sum the counters of the whole frame window into the snapshot
+  void ReduceAll();
+  /// Sum the counters of each UE at symbol [offset] into the snapshot
+  void ReduceSymbol(size_t offset);
+  /// Sum the EVM of each UE at [frame_slot] into the snapshot
+  void ReduceEvm(size_t frame_slot);
+
   Config const* const config_;
+  // shards_[i] is written by worker thread i only
+  std::vector<Shard> shards_;
+
+  // The sums over the shards as of the last ReduceFrame()
   Table<size_t> decoded_bits_count_;
   Table<size_t> bit_error_count_;
   Table<size_t> decoded_blocks_count_;
@@ -46,6 +94,8 @@ class PhyStats {
   Table<size_t> uncoded_bit_error_count_;
   Table<float> evm_buffer_;
   Table<float> pilot_snr_;
+  // antenna_erasures_[i] is the number of symbols erased for antenna i
+  std::vector<size_t> antenna_erasures_;
 
   arma::cx_fmat gt_mat_;
   size_t num_rx_symbols_;
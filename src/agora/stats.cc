@@ -4,6 +4,8 @@
  */
 #include "stats.h"
 
+#include <algorithm>
+#include <cmath>
 #include <typeinfo>
 
 Stats::Stats(const Config* const cfg)
@@ -17,9 +19,222 @@ Stats::Stats(const Config* const cfg)
       creation_tsc_(GetTime::Rdtsc()) {
   frame_start_.Calloc(config_->SocketThreadNum(), kNumStatsFrames,
                       Agora_memory::Alignment_t::kAlign64);
+  rx_packet_drops_.Calloc(config_->SocketThreadNum(), kNumRxDropReasons,
+                          Agora_memory::Alignment_t::kAlign64);
+  dropped_frames_.fill(0);
+  fronthaul_.resize(config_->BsAntNum());
+  worker_histograms_.resize(task_thread_num_);
+  worker_perf_stats_.resize(task_thread_num_);
+  for (auto& timestamps : master_timestamps_) {
+    timestamps.fill(0);
+  }
+}
+
+Stats::~Stats() {
+  frame_start_.Free();
+  rx_packet_drops_.Free();
+}
+
+size_t Stats::NumDroppedFrames() const {
+  size_t total = 0;
+  for (size_t count : this->dropped_frames_) {
+    total += count;
+  }
+  return total;
 }
 
-Stats::~Stats() { frame_start_.Free(); }
+size_t Stats::NumDroppedRxPackets(RxDropReason reason) {
+  size_t total = 0;
+  for (size_t i = 0; i < config_->SocketThreadNum(); i++) {
+    total += this->rx_packet_drops_[i][static_cast<size_t>(reason)];
+  }
+  return total;
+}
+
+size_t Stats::NumDroppedRxPackets() {
+  size_t total = 0;
+  for (size_t i = 0; i < kNumRxDropReasons; i++) {
+    total += NumDroppedRxPackets(static_cast<RxDropReason>(i));
+  }
+  return total;
+}
+
+void Stats::MasterUpdateFronthaul(size_t ant_id, uint64_t tx_time_ns,
+                                  uint64_t rx_time_ns) {
+  if (ant_id >= this->fronthaul_.size()) {
+    return;
+  }
+  FronthaulStat& stat = this->fronthaul_.at(ant_id);
+  double latency_us = 0;
+  if (rx_time_ns < tx_time_ns) {
+    stat.num_early_++;
+  } else {
+    latency_us = (rx_time_ns - tx_time_ns) / 1000.0;
+  }
+  auto bin = [](double us) {
+    return std::min(kNumFronthaulBins - 1,
+                    static_cast<size_t>(us / kFronthaulBinUs));
+  };
+  stat.latency_bins_.at(bin(latency_us))++;
+  if (stat.num_packets_ > 0) {
+    stat.jitter_bins_.at(bin(std::fabs(latency_us - stat.last_latency_us_)))++;
+  }
+  stat.last_latency_us_ = latency_us;
+  stat.num_packets_++;
+}
+
+double Stats::BinPercentileUs(const std::array<size_t, kNumFronthaulBins>& bins,
+                              double percentile) {
+  size_t total = 0;
+  for (size_t count : bins) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>(percentile / 100.0 * (total - 1));
+  size_t seen = 0;
+  for (size_t i = 0; i < kNumFronthaulBins; i++) {
+    seen += bins.at(i);
+    if (seen > rank) {
+      return (i + 1) * kFronthaulBinUs;
+    }
+  }
+  return kNumFronthaulBins * kFronthaulBinUs;
+}
+
+void Stats::PrintFronthaulSummary() const {
+  for (size_t ant = 0; ant < this->fronthaul_.size(); ant++) {
+    const FronthaulStat& stat = this->fronthaul_.at(ant);
+    if (stat.num_packets_ == 0) {
+      continue;
+    }
+    std::printf(
+        "Stats: fronthaul antenna %zu: %zu packets, latency p50 %.0f us, "
+        "p99 %.0f us, jitter p50 %.0f us, p99 %.0f us\n",
+        ant, stat.num_packets_, FronthaulLatencyPercentileUs(ant, 50),
+        FronthaulLatencyPercentileUs(ant, 99),
+        FronthaulJitterPercentileUs(ant, 50),
+        FronthaulJitterPercentileUs(ant, 99));
+    if (stat.num_early_ > 0) {
+      std::printf(
+          "Stats: fronthaul antenna %zu: %zu packets received before they "
+          "were sent. Are the sender and server clocks synchronized?\n",
+          ant, stat.num_early_);
+    }
+  }
+}
+
+LatencyHistogram Stats::MergedDurationHistogram(DoerType doer_type) const {
+  LatencyHistogram merged;
+  for (const auto& histograms : this->worker_histograms_) {
+    merged.Merge(histograms.at(static_cast<size_t>(doer_type)));
+  }
+  return merged;
+}
+
+double Stats::TaskDurationPercentileUs(DoerType doer_type,
+                                       double percentile) const {
+  return GetTime::CyclesToUs(
+      MergedDurationHistogram(doer_type).Percentile(percentile),
+      this->freq_ghz_);
+}
+
+void Stats::PrintLatencySummary() const {
+  auto print = [this](const char* kind, const std::string& name,
+                      const LatencyHistogram& histogram) {
+    if (histogram.Count() == 0) {
+      return;
+    }
+    std::printf(
+        "Stats: %s %s: %zu samples, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, "
+        "max %.1f us\n",
+        kind, name.c_str(), histogram.Count(),
+        GetTime::CyclesToUs(histogram.Percentile(50), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Percentile(99), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Percentile(99.9), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Max(), this->freq_ghz_));
+  };
+  for (size_t i = 0; i < kFrameStages.size(); i++) {
+    print("frame stage", kFrameStages.at(i).name_,
+          this->frame_stage_histograms_.at(i));
+  }
+  for (DoerType doer_type : kAllDoerTypes) {
+    print("task", kDoerNames.at(doer_type), MergedDurationHistogram(doer_type));
+  }
+}
+
+void Stats::PrintPerfSummary() const {
+  for (DoerType doer_type : kAllDoerTypes) {
+    PerfStat total;
+    for (const auto& perf_stats : this->worker_perf_stats_) {
+      const PerfStat& stat = perf_stats.at(static_cast<size_t>(doer_type));
+      for (size_t i = 0; i < PerfCounters::kNumEvents; i++) {
+        total.counts_.at(i) += stat.counts_.at(i);
+      }
+      total.task_count_ += stat.task_count_;
+      total.counted_mask_ |= stat.counted_mask_;
+    }
+    if (total.task_count_ == 0) {
+      continue;
+    }
+
+    auto counted = [&total](size_t event) {
+      return (total.counted_mask_ & (1u << event)) != 0;
+    };
+    const auto cycles_index = static_cast<size_t>(PerfCounters::Event::kCycles);
+    const auto instructions_index =
+        static_cast<size_t>(PerfCounters::Event::kInstructions);
+    std::string ipc;
+    std::string per_task;
+    char buf[64];
+    if (counted(cycles_index) && counted(instructions_index) &&
+        (total.counts_.at(cycles_index) > 0)) {
+      std::snprintf(buf, sizeof(buf), ", IPC %.2f",
+                    static_cast<double>(total.counts_.at(instructions_index)) /
+                        total.counts_.at(cycles_index));
+      ipc = buf;
+    }
+    for (size_t i = 0; i < PerfCounters::kNumEvents; i++) {
+      if (counted(i) == true) {
+        std::snprintf(buf, sizeof(buf), "%s%.1f %s",
+                      per_task.empty() ? "" : ", ",
+                      static_cast<double>(total.counts_.at(i)) /
+                          total.task_count_,
+                      PerfCounters::kEventNames.at(i));
+        per_task += buf;
+      }
+    }
+    std::printf("Stats: perf %s: %zu tasks%s, per task %s\n",
+                kDoerNames.at(doer_type).c_str(), total.task_count_,
+                ipc.c_str(), per_task.c_str());
+  }
+}
+
+void Stats::SaveLatencySummary(const std::string& filename) const {
+  std::printf("Stats: Saving latency percentiles to %s\n", filename.c_str());
+  FILE* fp = std::fopen(filename.c_str(), "w");
+  RtAssert(fp != nullptr,
+           std::string("Open file failed ") + std::to_string(errno));
+  std::fprintf(fp, "Name, samples, p50 us, p99 us, p99.9 us, max us\n");
+  auto save = [this, fp](const std::string& name,
+                         const LatencyHistogram& histogram) {
+    std::fprintf(
+        fp, "%s, %zu, %.3f, %.3f, %.3f, %.3f\n", name.c_str(),
+        histogram.Count(),
+        GetTime::CyclesToUs(histogram.Percentile(50), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Percentile(99), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Percentile(99.9), this->freq_ghz_),
+        GetTime::CyclesToUs(histogram.Max(), this->freq_ghz_));
+  };
+  for (size_t i = 0; i < kFrameStages.size(); i++) {
+    save(kFrameStages.at(i).name_, this->frame_stage_histograms_.at(i));
+  }
+  for (DoerType doer_type : kAllDoerTypes) {
+    save(kDoerNames.at(doer_type), MergedDurationHistogram(doer_type));
+  }
+  std::fclose(fp);
+}
 
 void Stats::PopulateSummary(FrameSummary* frame_summary, size_t thread_id,
                             DoerType doer_type) {
@@ -84,6 +299,15 @@ void Stats::UpdateStats(size_t frame_id) {
   this->last_frame_id_ = frame_id;
   size_t frame_slot = (frame_id % kNumStatsFrames);
 
+  for (size_t i = 0; i < kFrameStages.size(); i++) {
+    const size_t from_tsc = MasterGetTsc(kFrameStages.at(i).from_, frame_id);
+    const size_t to_tsc = MasterGetTsc(kFrameStages.at(i).to_, frame_id);
+    // Stages that the frame skipped keep the timestamps of an older frame
+    if ((from_tsc > 0) && (to_tsc >= from_tsc)) {
+      this->frame_stage_histograms_.at(i).Record(to_tsc - from_tsc);
+    }
+  }
+
   if (kIsWorkerTimingEnabled == true) {
     std::vector<FrameSummary> work_summary(kAllDoerTypes.size());
     for (size_t i = 0u; i < task_thread_num_; i++) {
@@ -240,6 +464,38 @@ void Stats::SaveToFile() {
 
   std::fclose(fp_debug);
 
+  size_t fronthaul_packets = 0;
+  for (const FronthaulStat& stat : this->fronthaul_) {
+    fronthaul_packets += stat.num_packets_;
+  }
+  if (fronthaul_packets > 0) {
+    std::string filename_fronthaul =
+        cur_directory + "/data/fronthaul_latency.txt";
+    std::printf("Stats: Saving fronthaul latency histograms to %s\n",
+                filename_fronthaul.c_str());
+    FILE* fp_fronthaul = std::fopen(filename_fronthaul.c_str(), "w");
+    RtAssert(fp_fronthaul != nullptr,
+             std::string("Open file failed ") + std::to_string(errno));
+    std::fprintf(fp_fronthaul,
+                 "Antenna, 0 for latency or 1 for jitter, then the packet "
+                 "count of each %.0f us bin\n",
+                 kFronthaulBinUs);
+    for (size_t ant = 0; ant < this->fronthaul_.size(); ant++) {
+      const FronthaulStat& stat = this->fronthaul_.at(ant);
+      for (const auto* bins : {&stat.latency_bins_, &stat.jitter_bins_}) {
+        std::fprintf(fp_fronthaul, "%zu %d", ant,
+                     bins == &stat.latency_bins_ ? 0 : 1);
+        for (size_t count : *bins) {
+          std::fprintf(fp_fronthaul, " %zu", count);
+        }
+        std::fprintf(fp_fronthaul, "\n");
+      }
+    }
+    std::fclose(fp_fronthaul);
+  }
+
+  SaveLatencySummary(cur_directory + "/data/latency_percentiles.txt");
+
   if (kIsWorkerTimingEnabled == true) {
     std::string filename_detailed =
         cur_directory + "/data/timeresult_detail.txt";
@@ -317,8 +573,55 @@ size_t Stats::GetTotalTaskCount(DoerType doer_type, size_t thread_num) {
   return total_count;
 }
 
+double Stats::FrameLatencyPercentileUs(double percentile) const {
+  std::vector<double> latency_us;
+  const size_t first_frame_id =
+      (this->last_frame_id_ + 1 > kNumStatsFrames)
+          ? (this->last_frame_id_ + 1 - kNumStatsFrames)
+          : 0;
+  for (size_t i = first_frame_id; i <= this->last_frame_id_; i++) {
+    const size_t first_rx_tsc = MasterGetTsc(TsType::kFirstSymbolRX, i);
+    const size_t done_tsc = MasterGetTsc(TsType::kFrameDone, i);
+    // Dropped frames keep the completion timestamp of an older frame
+    if (done_tsc > first_rx_tsc) {
+      latency_us.push_back(
+          GetTime::CyclesToUs(done_tsc - first_rx_tsc, this->freq_ghz_));
+    }
+  }
+  if (latency_us.empty() == true) {
+    return 0;
+  }
+
+  const size_t rank = std::min(
+      latency_us.size() - 1,
+      static_cast<size_t>(percentile / 100.0 * latency_us.size()));
+  std::nth_element(latency_us.begin(), latency_us.begin() + rank,
+                   latency_us.end());
+  return latency_us.at(rank);
+}
+
 void Stats::PrintSummary() {
   std::printf("Stats: total processed frames %zu\n", this->last_frame_id_ + 1);
+  if (NumDroppedFrames() > 0) {
+    std::printf(
+        "Stats: dropped frames %zu (deadline missed %zu, window full %zu)\n",
+        NumDroppedFrames(), NumDroppedFrames(FrameDropReason::kDeadline),
+        NumDroppedFrames(FrameDropReason::kWindowFull));
+  }
+  if (NumDroppedRxPackets() > 0) {
+    std::printf(
+        "Stats: dropped RX packets %zu (bad length %zu, bad magic %zu, out of "
+        "range %zu, bad checksum %zu, stale %zu, duplicate %zu)\n",
+        NumDroppedRxPackets(), NumDroppedRxPackets(RxDropReason::kBadLength),
+        NumDroppedRxPackets(RxDropReason::kBadMagic),
+        NumDroppedRxPackets(RxDropReason::kOutOfRange),
+        NumDroppedRxPackets(RxDropReason::kBadChecksum),
+        NumDroppedRxPackets(RxDropReason::kStale),
+        NumDroppedRxPackets(RxDropReason::kDuplicate));
+  }
+  PrintFronthaulSummary();
+  PrintLatencySummary();
+  PrintPerfSummary();
   if (kIsWorkerTimingEnabled == false) {
     std::printf("Stats: Worker timing is disabled. Not printing summary\n");
   } else {
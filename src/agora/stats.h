@@ -7,10 +7,14 @@
 #define STATS_H_
 
 #include <iostream>
+#include <vector>
 
 #include "config.h"
 #include "gettime.h"
+#include "latency_histogram.h"
 #include "memory_manage.h"
+#include "packet_validator.h"
+#include "perf_counters.h"
 #include "symbols.h"
 
 static constexpr size_t kMaxStatBreakdown = 4;
@@ -23,6 +27,28 @@ struct DurationStat {
   void Reset() { std::memset(this, 0, sizeof(DurationStat)); }
 };
 
+// Accumulated performance counter events of the tasks of one Doer in a
+// worker thread, in its own cache line
+struct alignas(64) PerfStat {
+  std::array<uint64_t, PerfCounters::kNumEvents> counts_;
+  size_t task_count_;
+  // The events counted, as in PerfCounters::CountedMask()
+  uint32_t counted_mask_;
+  PerfStat() { Reset(); }
+  void Reset() { std::memset(this, 0, sizeof(PerfStat)); }
+
+  /// Count the events of a task since [start], read from [counters]
+  inline void Add(const PerfCounters& counters,
+                  const PerfCounters::Values& start) {
+    PerfCounters::Values end{};
+    counters.Read(end);
+    for (size_t i = 0; i < PerfCounters::kNumEvents; i++) {
+      this->counts_[i] += end[i] - start[i];
+    }
+    this->task_count_++;
+  }
+};
+
 // Temporary summary statistics assembled from per-thread runtime stats
 struct FrameSummary {
   std::array<double, kMaxStatBreakdown> us_this_thread_;
@@ -52,11 +78,54 @@ enum class TsType : size_t {
   kTXDone,
   kModulDone,
   kFFTDone,
+  kFrameDone,  // All processing of the frame is complete
   kTsTypeEnd
 };
 static constexpr size_t kNumTimestampTypes =
     static_cast<size_t>(TsType::kTsTypeEnd);
 
+// Reasons for the master to drop a frame before it is fully processed
+enum class FrameDropReason : size_t {
+  kDeadline,    // Processing did not finish within the frame deadline
+  kWindowFull,  // A newer frame needed the slot of this frame
+  kFrameDropReasonEnd
+};
+static constexpr size_t kNumFrameDropReasons =
+    static_cast<size_t>(FrameDropReason::kFrameDropReasonEnd);
+
+// A stage of frame processing, from timestamp from_ to timestamp to_ of the
+// frame. The master keeps a latency histogram of each stage.
+struct FrameStage {
+  TsType from_;
+  TsType to_;
+  const char* name_;
+};
+static constexpr std::array<FrameStage, 7> kFrameStages = {
+    {{TsType::kFirstSymbolRX, TsType::kPilotAllRX, "Pilot RX"},
+     {TsType::kPilotAllRX, TsType::kZFDone, "Pilots to ZF"},
+     {TsType::kFirstSymbolRX, TsType::kRXDone, "RX"},
+     {TsType::kFirstSymbolRX, TsType::kDemulDone, "RX to demul"},
+     {TsType::kFirstSymbolRX, TsType::kDecodeDone, "RX to decode"},
+     {TsType::kFirstSymbolRX, TsType::kTXDone, "RX to TX"},
+     {TsType::kFirstSymbolRX, TsType::kFrameDone, "Frame"}}};
+
+// The fronthaul latency and jitter histograms have kNumFronthaulBins bins
+// of kFronthaulBinUs microseconds. The last bin also counts longer times.
+static constexpr size_t kNumFronthaulBins = 200;
+static constexpr double kFronthaulBinUs = 5.0;
+
+// One-way latency and jitter of the packets received from one antenna
+struct FronthaulStat {
+  std::array<size_t, kNumFronthaulBins> latency_bins_;
+  // Jitter is the latency difference between consecutive packets
+  std::array<size_t, kNumFronthaulBins> jitter_bins_;
+  size_t num_packets_;
+  // Packets received before they were sent, i.e., the clocks are not synced
+  size_t num_early_;
+  double last_latency_us_;
+  FronthaulStat() { std::memset(this, 0, sizeof(FronthaulStat)); }
+};
+
 class Stats {
  public:
   explicit Stats(const Config* const cfg);
@@ -66,8 +135,9 @@ class Stats {
   /// stats for all uplink and donwlink Doer types. Else return immediately.
   void UpdateStats(size_t frame_id);
 
-  /// Save master timestamps to a file. If worker stats collection is enabled,
-  /// also save detailed worker timing info to a file.
+  /// Save master timestamps, and the fronthaul latency histograms if any
+  /// packets were timestamped, to files. If worker stats collection is
+  /// enabled, also save detailed worker timing info to a file.
   void SaveToFile();
 
   /// If worker stats collection is enabled, prsize_t a summary of stats
@@ -163,11 +233,92 @@ class Stats {
                 .duration_stat_[static_cast<size_t>(doer_type)];
   }
 
+  /// Get the histogram of the task durations in TSC cycles of thread
+  /// thread_id for DoerType doer_type
+  LatencyHistogram* GetDurationHistogram(DoerType doer_type,
+                                         size_t thread_id) {
+    return &this->worker_histograms_.at(thread_id).at(
+        static_cast<size_t>(doer_type));
+  }
+
+  /// Get the PerfStat object used by thread thread_id for DoerType doer_type
+  PerfStat* GetPerfStat(DoerType doer_type, size_t thread_id) {
+    return &this->worker_perf_stats_.at(thread_id).at(
+        static_cast<size_t>(doer_type));
+  }
+
+  /// Return the [percentile] (0 -- 100) in microseconds of the durations of
+  /// the tasks of doer_type, over all worker threads
+  double TaskDurationPercentileUs(DoerType doer_type, double percentile) const;
+
+  /// Return the [percentile] (0 -- 100) in microseconds of the latency of
+  /// kFrameStages[stage] over the completed frames
+  double FrameStagePercentileUs(size_t stage, double percentile) const {
+    return GetTime::CyclesToUs(
+        this->frame_stage_histograms_.at(stage).Percentile(percentile),
+        this->freq_ghz_);
+  }
+
+  /// From the master, count a frame dropped for [reason]
+  void MasterCountDroppedFrame(FrameDropReason reason) {
+    this->dropped_frames_.at(static_cast<size_t>(reason))++;
+  }
+
+  /// Return the number of frames dropped for [reason]
+  size_t NumDroppedFrames(FrameDropReason reason) const {
+    return this->dropped_frames_.at(static_cast<size_t>(reason));
+  }
+
+  /// Return the number of frames dropped for any reason
+  size_t NumDroppedFrames() const;
+
+  /// Return the number of received packets that the TXRX threads dropped
+  /// for [reason]
+  size_t NumDroppedRxPackets(RxDropReason reason);
+
+  /// Return the number of received packets dropped for any reason
+  size_t NumDroppedRxPackets();
+
+  /// From the master, count the one-way latency of a packet from antenna
+  /// [ant_id] that the sender sent at [tx_time_ns] and the TXRX thread
+  /// received at [rx_time_ns], both in CLOCK_REALTIME nanoseconds
+  void MasterUpdateFronthaul(size_t ant_id, uint64_t tx_time_ns,
+                             uint64_t rx_time_ns);
+
+  /// Return the [percentile] (0 -- 100) of the one-way latency in
+  /// microseconds of the packets from antenna [ant_id], rounded up to a
+  /// histogram bin
+  double FronthaulLatencyPercentileUs(size_t ant_id, double percentile) const {
+    return BinPercentileUs(this->fronthaul_.at(ant_id).latency_bins_,
+                           percentile);
+  }
+
+  /// Return the [percentile] (0 -- 100) of the jitter in microseconds of the
+  /// packets from antenna [ant_id], rounded up to a histogram bin
+  double FronthaulJitterPercentileUs(size_t ant_id, double percentile) const {
+    return BinPercentileUs(this->fronthaul_.at(ant_id).jitter_bins_,
+                           percentile);
+  }
+
+  /// Return the latency and jitter stats of antenna [ant_id]
+  const FronthaulStat& Fronthaul(size_t ant_id) const {
+    return this->fronthaul_.at(ant_id);
+  }
+
+  /// Return the [percentile] (0 -- 100) of the latency in microseconds from
+  /// the first received packet to the completion of a frame, over the last
+  /// kNumStatsFrames frames. Frames that did not complete are excluded.
+  double FrameLatencyPercentileUs(double percentile) const;
+
   inline size_t LastFrameId() const { return this->last_frame_id_; }
   /// Dimensions = number of packet RX threads x kNumStatsFrames.
   /// frame_start[i][j] is the RDTSC timestamp taken by thread i when it
   /// starts receiving frame j.
   inline Table<size_t>& FrameStart() { return this->frame_start_; };
+  /// Dimensions = number of packet RX threads x kNumRxDropReasons.
+  /// rx_packet_drops[i][j] is the number of packets thread i dropped for
+  /// RxDropReason j.
+  inline Table<size_t>& RxPacketDrops() { return this->rx_packet_drops_; }
 
  private:
   // Fill in running time summary stats for the current frame for this
@@ -181,6 +332,20 @@ class Stats {
                                     FrameSummary const& s);
   static void PrintPerFrame(std::string const& doer_string,
                             FrameSummary const& frame_summary);
+  static double BinPercentileUs(
+      const std::array<size_t, kNumFronthaulBins>& bins, double percentile);
+  // Print the fronthaul latency and jitter of each antenna
+  void PrintFronthaulSummary() const;
+  // The task duration histogram of doer_type merged over the worker threads
+  LatencyHistogram MergedDurationHistogram(DoerType doer_type) const;
+  // Print the percentiles of the frame stage latencies and task durations
+  void PrintLatencySummary() const;
+  // Save the percentiles of the frame stage latencies and task durations to
+  // filename
+  void SaveLatencySummary(const std::string& filename) const;
+  // Print the IPC and events per task of each doer type, if the workers
+  // counted them
+  void PrintPerfSummary() const;
 
   size_t GetTotalTaskCount(DoerType doer_type, size_t thread_num);
 
@@ -211,6 +376,17 @@ class Stats {
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_;
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_old_;
 
+  /// Task duration histograms in TSC cycles. Each worker thread has one
+  /// histogram for every Doer type.
+  std::vector<std::array<LatencyHistogram, kNumDoerTypes>> worker_histograms_;
+
+  /// Performance counter events of the tasks. Each worker thread has one
+  /// PerfStat for every Doer type.
+  std::vector<std::array<PerfStat, kNumDoerTypes>> worker_perf_stats_;
+
+  /// Latency histograms in TSC cycles of kFrameStages, recorded by the master
+  std::array<LatencyHistogram, kFrameStages.size()> frame_stage_histograms_;
+
   std::array<std::array<double, kNumStatsFrames>, kNumDoerTypes> doer_us_;
   std::array<std::array<std::array<double, kNumStatsFrames>, kMaxStatBreakdown>,
              kNumDoerTypes>
@@ -218,10 +394,19 @@ class Stats {
 
   size_t last_frame_id_;
 
+  /// dropped_frames_[i] is the number of frames dropped for FrameDropReason i
+  std::array<size_t, kNumFrameDropReasons> dropped_frames_;
+
+  /// Fronthaul latency and jitter, indexed by antenna
+  std::vector<FronthaulStat> fronthaul_;
+
   /// Dimensions = number of packet RX threads x kNumStatsFrames.
   /// frame_start[i][j] is the RDTSC timestamp taken by thread i when it
   /// starts receiving frame j.
   Table<size_t> frame_start_;
+
+  /// Dimensions = number of packet RX threads x kNumRxDropReasons
+  Table<size_t> rx_packet_drops_;
 };
 
 #endif  // STATS_H_
@@ -12,6 +12,13 @@ static constexpr bool kEnableSlowStart = true;
 static constexpr bool kEnableSlowSending = true;
 static constexpr bool kDebugPrintBeacon = false;
 
+// DL TX scheduler mode. The wheel's ticks are one microsecond, so that it
+// turns once every few milliseconds.
+static constexpr size_t kTxWheelBuckets = 4096;
+static constexpr double kTxWheelTickSec = 1e-6;
+// TX packets moved into the wheel per loop iteration
+static constexpr size_t kTxScheduleBatch = 16;
+
 PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset)
     : cfg_(cfg),
       core_offset_(core_offset),
@@ -61,10 +68,10 @@ bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
 
     if (cfg_->Frame().NumDLSyms() > 0) {
       std::memcpy(
-          calib_dl_buffer[kFrameWnd - 1], radioconfig_->GetCalibDl(),
+          calib_dl_buffer[cfg_->FrameWnd() - 1], radioconfig_->GetCalibDl(),
           cfg_->OfdmDataNum() * cfg_->BfAntNum() * sizeof(arma::cx_float));
       std::memcpy(
-          calib_ul_buffer[kFrameWnd - 1], radioconfig_->GetCalibUl(),
+          calib_ul_buffer[cfg_->FrameWnd() - 1], radioconfig_->GetCalibUl(),
           cfg_->OfdmDataNum() * cfg_->BfAntNum() * sizeof(arma::cx_float));
     }
   }
@@ -76,17 +83,41 @@ bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
   /// Make sure we can fit each channel in the tread buffer without rollover
   assert(buffers_per_socket_ % cfg_->NumChannels() == 0);
 
+  const size_t rx_stride = RxPacketStride(cfg_);
+  const size_t rx_headroom = UseIoUring(cfg_) ? kUringRxHeadroom : 0;
   rx_packets_.resize(socket_thread_num_);
+  urings_.resize(socket_thread_num_);
+  uring_buf_rings_.resize(socket_thread_num_);
+  InitBeacons();
+  InitRxValidators();
+  if (UseReuseportRx(cfg_) == true) {
+    StartReuseportRx();
+  }
+  if (UseShmTransport(cfg_) == true) {
+    shm_transport_ = std::make_unique<ShmTransport>(
+        cfg_->ShmName(), true /* create */, cfg_->NumRadios(),
+        cfg_->ShmRingSlots(),
+        std::max(cfg_->PacketLength(), cfg_->DlPacketLength()));
+    shm_tx_drops_.resize(socket_thread_num_, 0);
+  }
   for (size_t i = 0; i < socket_thread_num_; i++) {
     rx_packets_.at(i).reserve(buffers_per_socket_);
     for (size_t number_packets = 0; number_packets < buffers_per_socket_;
          number_packets++) {
       auto* pkt_loc = reinterpret_cast<Packet*>(
-          buffer[i] + (number_packets * cfg_->PacketLength()));
+          buffer[i] + (number_packets * rx_stride) + rx_headroom);
       rx_packets_.at(i).emplace_back(pkt_loc);
     }
 
-    if (kUseArgos == true) {
+    if (UseIoUring(cfg_) == true) {
+      MLPD_SYMBOL("LoopTXRX: Starting io_uring thread %zu\n", i);
+      socket_std_threads_.at(i) =
+          std::thread(&PacketTXRX::LoopTxRxUring, this, i);
+    } else if (UseShmTransport(cfg_) == true) {
+      MLPD_SYMBOL("LoopTXRX: Starting shared memory thread %zu\n", i);
+      socket_std_threads_.at(i) =
+          std::thread(&PacketTXRX::LoopTxRxShm, this, i);
+    } else if (kUseArgos == true) {
       socket_std_threads_.at(i) =
           std::thread(&PacketTXRX::LoopTxRxArgos, this, i);
     } else if (kUseUHD == true) {
@@ -104,6 +135,48 @@ bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
   return true;
 }
 
+void PacketTXRX::InitBeacons() {
+  beacon_pkt_stride_ = Roundup<64>(cfg_->PacketLength());
+  beacon_pkts_.assign(
+      cfg_->Frame().NumBeaconSyms() * cfg_->NumRadios() * beacon_pkt_stride_,
+      0);
+
+  // The beacon samples follow the zero prefix. Simulators only read the
+  // header, and have no beacon samples.
+  const size_t data_len = cfg_->PacketLength() - Packet::kOffsetOfData;
+  const size_t prefix_len =
+      std::min(cfg_->OfdmTxZeroPrefix() * sizeof(uint32_t), data_len);
+  const size_t beacon_len =
+      std::min(cfg_->Beacon().size() * sizeof(uint32_t), data_len - prefix_len);
+  for (size_t beacon_sym = 0; beacon_sym < cfg_->Frame().NumBeaconSyms();
+       beacon_sym++) {
+    for (size_t radio_id = 0; radio_id < cfg_->NumRadios(); radio_id++) {
+      Packet* pkt = BeaconPacket(beacon_sym, radio_id);
+      new (pkt) Packet(0, cfg_->Frame().GetBeaconSymbol(beacon_sym),
+                       0 /* cell_id */, radio_id);
+      std::memcpy(reinterpret_cast<uint8_t*>(pkt->data_) + prefix_len,
+                  cfg_->Beacon().data(), beacon_len);
+    }
+  }
+}
+
+void PacketTXRX::InitRxValidators() {
+  std::vector<bool> is_rx_symbol(cfg_->Frame().NumTotalSyms());
+  for (size_t symbol_id = 0; symbol_id < is_rx_symbol.size(); symbol_id++) {
+    const SymbolType type = cfg_->GetSymbolType(symbol_id);
+    is_rx_symbol.at(symbol_id) =
+        (type == SymbolType::kPilot) || (type == SymbolType::kUL) ||
+        (type == SymbolType::kCalDL) || (type == SymbolType::kCalUL);
+  }
+  rx_validators_.resize(socket_thread_num_);
+  for (size_t tid = 0; tid < socket_thread_num_; tid++) {
+    rx_validators_.at(tid).Init(
+        cfg_->FrameWnd(), cfg_->NumCells(), ant_per_cell_, is_rx_symbol,
+        cfg_->PacketLength(), cfg_->PacketChecksum(),
+        (rx_packet_drops_ != nullptr) ? (*rx_packet_drops_)[tid] : nullptr);
+  }
+}
+
 void PacketTXRX::SendBeacon(int tid, size_t frame_id) {
   static double send_time = 0;
   double time_now = GetTime::GetTimeUs() / 1000;
@@ -111,9 +184,6 @@ void PacketTXRX::SendBeacon(int tid, size_t frame_id) {
   size_t radio_hi = (tid + 1) * cfg_->NumRadios() / socket_thread_num_;
 
   // Send a beacon packet in the downlink to trigger user pilot
-  std::vector<uint8_t> udp_pkt_buf(cfg_->PacketLength(), 0);
-  auto* pkt = reinterpret_cast<Packet*>(&udp_pkt_buf[0]);
-
   if (kDebugPrintBeacon) {
     std::printf("TXRX [%d]: Sending beacon for frame %zu tx delta %f ms\n", tid,
                 frame_id, time_now - send_time);
@@ -123,18 +193,19 @@ void PacketTXRX::SendBeacon(int tid, size_t frame_id) {
   for (size_t beacon_sym = 0; beacon_sym < cfg_->Frame().NumBeaconSyms();
        beacon_sym++) {
     for (size_t ant_id = radio_lo; ant_id < radio_hi; ant_id++) {
-      new (pkt) Packet(frame_id, cfg_->Frame().GetBeaconSymbol(beacon_sym),
-                       0 /* cell_id */, ant_id);
+      Packet* pkt = BeaconPacket(beacon_sym, ant_id);
+      pkt->frame_id_ = frame_id;
 
-      udp_clients_.at(ant_id)->Send(cfg_->BsRruAddr(),
-                                    cfg_->BsRruPort() + ant_id,
-                                    udp_pkt_buf.data(), cfg_->PacketLength());
+      udp_clients_.at(ant_id)->Send(
+          cfg_->BsRruAddr(), cfg_->BsRruPort() + ant_id,
+          reinterpret_cast<uint8_t*>(pkt), cfg_->PacketLength());
     }
   }
 }
 
 void PacketTXRX::LoopTxRx(size_t tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid);
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid,
+                      cfg_->Placement());
 
   const double rdtsc_freq = GetTime::MeasureRdtscFreq();
   const size_t frame_tsc_delta =
@@ -144,13 +215,18 @@ void PacketTXRX::LoopTxRx(size_t tid) {
   // Slow start variables (Start with no less than 200 ms)
   const size_t slow_start_tsc1 =
       std::max(40 * frame_tsc_delta, two_hundred_ms_ticks);
-  const size_t slow_start_thresh1 = kFrameWnd;
+  const size_t slow_start_thresh1 = cfg_->FrameWnd();
   const size_t slow_start_tsc2 = 15 * frame_tsc_delta;
-  const size_t slow_start_thresh2 = kFrameWnd * 4;
-  size_t delay_tsc = frame_tsc_delta;
+  const size_t slow_start_thresh2 = cfg_->FrameWnd() * 4;
+  size_t first_delay_tsc = frame_tsc_delta;
+  size_t steady_delay_tsc = frame_tsc_delta;
 
   if (kEnableSlowStart) {
-    delay_tsc = slow_start_tsc1;
+    first_delay_tsc = slow_start_tsc1;
+    if (kEnableSlowSending) {
+      // Temp for historic reasons
+      steady_delay_tsc = frame_tsc_delta * 4;
+    }
   }
 
   size_t* rx_frame_start = (*frame_start_)[tid];
@@ -162,8 +238,11 @@ void PacketTXRX::LoopTxRx(size_t tid) {
   for (size_t radio_id = radio_lo; radio_id < radio_hi; ++radio_id) {
     size_t local_port_id = cfg_->BsServerPort() + radio_id;
 
-    udp_servers_.at(radio_id) =
-        std::make_unique<UDPServer>(local_port_id, sock_buf_size);
+    // In reuseport mode the sockets are bound before the threads start
+    if (UseReuseportRx(cfg_) == false) {
+      udp_servers_.at(radio_id) =
+          std::make_unique<UDPServer>(local_port_id, sock_buf_size);
+    }
     udp_clients_.at(radio_id) = std::make_unique<UDPClient>();
     MLPD_FRAME(
         "TXRX thread %d: set up UDP socket server listening to port %d"
@@ -172,11 +251,57 @@ void PacketTXRX::LoopTxRx(size_t tid) {
         cfg_->BsRruPort() + radio_id);
   }
 
+  // Threads transmit for their own radios, but in reuseport mode receive
+  // from every radio's port group
+  const bool reuseport_rx = UseReuseportRx(cfg_);
+  const size_t rx_radio_lo = reuseport_rx ? 0 : radio_lo;
+  const size_t rx_radio_hi = reuseport_rx ? cfg_->NumRadios() : radio_hi;
+
+  const bool use_gso = UseUdpGso(cfg_);
+  const bool use_gro = UseUdpGro(cfg_);
+  std::vector<uint8_t> gro_buf(use_gro ? kGroBufferSize : 0);
+  for (size_t rx_radio = rx_radio_lo; rx_radio < rx_radio_hi; rx_radio++) {
+    UDPServer& rx_server = reuseport_rx
+                               ? *reuseport_servers_.at(tid).at(rx_radio)
+                               : *udp_servers_.at(rx_radio);
+    if (use_gro == true) {
+      rx_server.EnableGro();
+    }
+    if (rx_server.EnableRxTimestamps(cfg_->RxHwTimestamps()) == false) {
+      MLPD_WARN(
+          "TXRX thread %zu: No kernel receive timestamps on port %zu, using "
+          "the time of receipt\n",
+          tid, cfg_->BsServerPort() + rx_radio);
+    }
+  }
+  const size_t rebalance_tsc =
+      cfg_->ReuseportRebalanceMs() * 1e6f * rdtsc_freq;
+  size_t rebalance_time = GetTime::Rdtsc() + rebalance_tsc;
+
+  // The beacons of every frame, and in DL TX scheduler mode the downlink
+  // symbols, go out on this schedule
+  const size_t tx_start_tsc = GetTime::Rdtsc();
+  FrameSchedule tx_schedule(tx_start_tsc + first_delay_tsc, steady_delay_tsc,
+                            frame_tsc_delta / cfg_->Frame().NumTotalSyms());
+  if (kEnableSlowStart) {
+    tx_schedule.SetSlowStart(slow_start_thresh1, slow_start_tsc1,
+                             slow_start_thresh2, slow_start_tsc2);
+  }
+
+  std::unique_ptr<TxTimingWheel> tx_wheel;
+  const size_t dl_advance_tsc = cfg_->DlTxAdvanceUs() * 1e3f * rdtsc_freq;
+  size_t num_dl_scheduled = 0;
+  size_t num_dl_late = 0;
+  if (UseDlTxScheduler(cfg_) == true) {
+    tx_wheel = std::make_unique<TxTimingWheel>(
+        kTxWheelBuckets, kTxWheelTickSec * 1e9 * rdtsc_freq, tx_start_tsc);
+  }
+  auto send_dl_packet = [this, tid](size_t tag) { SendDlPacket(tid, tag); };
+
   int prev_frame_id = -1;
-  size_t radio_id = radio_lo;
-  size_t tx_frame_start = GetTime::Rdtsc();
+  size_t radio_id = rx_radio_lo;
   size_t tx_frame_id = 0;
-  size_t send_time = delay_tsc + tx_frame_start;
+  size_t send_time = tx_schedule.FrameStart(tx_frame_id);
   // Send Beacons for the first time to kick off sim
   // SendBeacon(tid, tx_frame_id++);
   while (cfg_->Running() == true) {
@@ -184,29 +309,44 @@ void PacketTXRX::LoopTxRx(size_t tid) {
 
     if (rdtsc_now > send_time) {
       SendBeacon(tid, tx_frame_id++);
+      send_time = tx_schedule.FrameStart(tx_frame_id);
+    }
 
-      if (kEnableSlowStart) {
-        if (tx_frame_id == slow_start_thresh1) {
-          delay_tsc = slow_start_tsc2;
-        } else if (tx_frame_id == slow_start_thresh2) {
-          delay_tsc = frame_tsc_delta;
-          if (kEnableSlowSending) {
-            // Temp for historic reasons
-            delay_tsc = frame_tsc_delta * 4;
-          }
-        }
-      }
-      tx_frame_start = send_time;
-      send_time += delay_tsc;
+    // One thread rebalances the steering of all port groups
+    if ((reuseport_rx == true) && (tid == 0) && (rebalance_tsc > 0) &&
+        (rdtsc_now > rebalance_time)) {
+      RebalanceReuseportRx();
+      rebalance_time = rdtsc_now + rebalance_tsc;
     }
 
-    int send_result = DequeueSend(tid);
+    int send_result = -1;
+    if (tx_wheel != nullptr) {
+      num_dl_scheduled += ScheduleDl(tid, *tx_wheel, tx_schedule,
+                                     dl_advance_tsc, num_dl_late);
+      if (tx_wheel->Expire(GetTime::Rdtsc(), send_dl_packet) > 0) {
+        send_result = 0;
+      }
+    } else {
+      send_result = use_gso ? DequeueSendGso(tid) : DequeueSend(tid);
+    }
     if (-1 == send_result) {
       // receive data
-
-      struct Packet* pkt = RecvEnqueue(tid, radio_id, rx_slot);
+      UDPServer& udp_server = reuseport_rx
+                                  ? *reuseport_servers_.at(tid).at(radio_id)
+                                  : *udp_servers_.at(radio_id);
+      struct Packet* pkt = nullptr;
+      size_t num_rx = 0;
+      if (use_gro == true) {
+        num_rx = RecvEnqueueGro(tid, udp_server, rx_slot, gro_buf.data());
+        if (num_rx > 0) {
+          pkt = rx_packets_.at(tid).at(rx_slot).RawPacket();
+        }
+      } else {
+        pkt = RecvEnqueue(tid, udp_server, rx_slot);
+        num_rx = (pkt != nullptr) ? 1 : 0;
+      }
       if (pkt != nullptr) {
-        rx_slot = (rx_slot + 1) % buffers_per_socket_;
+        rx_slot = (rx_slot + num_rx) % buffers_per_socket_;
 
         if (kIsWorkerTimingEnabled) {
           int frame_id = pkt->frame_id_;
@@ -216,17 +356,88 @@ void PacketTXRX::LoopTxRx(size_t tid) {
           }
         }
 
-        if (++radio_id == radio_hi) {
-          radio_id = radio_lo;
+        if (++radio_id == rx_radio_hi) {
+          radio_id = rx_radio_lo;
+        }
+      } else if (reuseport_rx == true) {
+        // Any of the groups may hold this thread's packets
+        if (++radio_id == rx_radio_hi) {
+          radio_id = rx_radio_lo;
         }
       }
     }  // end if -1 == send_result
   }    // end while
+
+  if (tx_wheel != nullptr) {
+    MLPD_INFO(
+        "TXRX thread %zu: %zu of %zu downlink packets were encoded after "
+        "their release time\n",
+        tid, num_dl_late, num_dl_scheduled);
+  }
+}
+
+void PacketTXRX::StartReuseportRx() {
+  const size_t sock_buf_size = (1024 * 1024 * 64 * 8) - 1;
+  reuseport_servers_.resize(socket_thread_num_);
+  for (size_t tid = 0; tid < socket_thread_num_; tid++) {
+    reuseport_servers_.at(tid).resize(cfg_->NumRadios());
+  }
+  ant_balancer_ =
+      std::make_unique<AntennaBalancer>(cfg_->BsAntNum(), socket_thread_num_);
+  ant_rx_packets_ = std::make_unique<std::atomic<size_t>[]>(cfg_->BsAntNum());
+  for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+    ant_rx_packets_[ant] = 0;
+  }
+
+  const std::vector<sock_filter> program = BuildAntennaSteeringProgram(
+      ant_balancer_->AntToThread(), ant_per_cell_, socket_thread_num_);
+  for (size_t radio_id = 0; radio_id < cfg_->NumRadios(); radio_id++) {
+    const size_t local_port_id = cfg_->BsServerPort() + radio_id;
+    // A socket's index in the group is the order it was bound in
+    for (size_t tid = 0; tid < socket_thread_num_; tid++) {
+      reuseport_servers_.at(tid).at(radio_id) =
+          std::make_unique<UDPServer>(local_port_id, sock_buf_size, true);
+    }
+    AttachReuseportProgram(reuseport_servers_.at(0).at(radio_id)->Fd(),
+                           program);
+  }
+  MLPD_INFO("PacketTXRX: %zu threads share %zu SO_REUSEPORT port groups\n",
+            socket_thread_num_, cfg_->NumRadios());
 }
 
-struct Packet* PacketTXRX::RecvEnqueue(size_t tid, size_t radio_id,
+void PacketTXRX::RebalanceReuseportRx() {
+  // Only move antennas off a thread with a backlog of this many packets
+  static constexpr size_t kMinQueuedPackets = 64;
+
+  std::vector<size_t> thread_depths(socket_thread_num_, 0);
+  for (size_t tid = 0; tid < socket_thread_num_; tid++) {
+    for (const auto& udp_server : reuseport_servers_.at(tid)) {
+      thread_depths.at(tid) += SocketQueuedBytes(udp_server->Fd());
+    }
+  }
+  std::vector<size_t> ant_packets(cfg_->BsAntNum());
+  for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+    ant_packets.at(ant) = ant_rx_packets_[ant].exchange(0);
+  }
+
+  if (ant_balancer_->Rebalance(thread_depths, ant_packets,
+                               kMinQueuedPackets * cfg_->PacketLength())) {
+    const std::vector<sock_filter> program = BuildAntennaSteeringProgram(
+        ant_balancer_->AntToThread(), ant_per_cell_, socket_thread_num_);
+    for (const auto& udp_server : reuseport_servers_.at(0)) {
+      AttachReuseportProgram(udp_server->Fd(), program);
+    }
+    std::string depths;
+    for (size_t depth : thread_depths) {
+      depths += " " + std::to_string(depth);
+    }
+    MLPD_INFO("PacketTXRX: Rebalanced reuseport steering, queued bytes:%s\n",
+              depths.c_str());
+  }
+}
+
+struct Packet* PacketTXRX::RecvEnqueue(size_t tid, UDPServer& udp_server,
                                        size_t rx_slot) {
-  moodycamel::ProducerToken* local_ptok = rx_ptoks_[tid];
   size_t packet_length = cfg_->PacketLength();
   RxPacket& rx = rx_packets_.at(tid).at(rx_slot);
 
@@ -238,50 +449,110 @@ struct Packet* PacketTXRX::RecvEnqueue(size_t tid, size_t radio_id,
   }
   Packet* pkt = rx.RawPacket();
 
-  ssize_t rx_bytes = udp_servers_.at(radio_id)->Recv(
-      reinterpret_cast<uint8_t*>(pkt), packet_length);
+  uint64_t rx_time_ns = 0;
+  ssize_t rx_bytes = udp_server.Recv(reinterpret_cast<uint8_t*>(pkt),
+                                     packet_length, rx_time_ns);
   if (0 > rx_bytes) {
     MLPD_ERROR("RecvEnqueue: Udp Recv failed with error\n");
     throw std::runtime_error("PacketTXRX: recv failed");
   } else if (rx_bytes == 0) {
     pkt = nullptr;
   } else if (static_cast<size_t>(rx_bytes) == packet_length) {
-    if (kDebugPrintInTask) {
-      std::printf("In TXRX thread %zu: Received frame %d, symbol %d, ant %d\n",
-                  tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+    rx.SetRxTimeNs(rx_time_ns != 0 ? rx_time_ns : GetTime::RealtimeNs());
+    if (EnqueueRxPacket(tid, rx) == false) {
+      pkt = nullptr;
     }
-    if (kDebugMulticell) {
-      std::printf(
-          "Before packet combining: receiving data stream from the "
-          "antenna %d in cell %d,\n",
-          pkt->ant_id_, pkt->cell_id_);
+  } else {
+    // A stray or truncated datagram
+    rx_validators_.at(tid).CountDrop(RxDropReason::kBadLength);
+    pkt = nullptr;
+  }
+  return pkt;
+}
+
+size_t PacketTXRX::RecvEnqueueGro(size_t tid, UDPServer& udp_server,
+                                  size_t rx_slot, uint8_t* gro_buf) {
+  const size_t packet_length = cfg_->PacketLength();
+  size_t segment_size = 0;
+  uint64_t rx_time_ns = 0;
+  ssize_t rx_bytes = udp_server.RecvSegments(gro_buf, kGroBufferSize,
+                                             segment_size, &rx_time_ns);
+  if (0 > rx_bytes) {
+    MLPD_ERROR("RecvEnqueueGro: Udp Recv failed with error\n");
+    throw std::runtime_error("PacketTXRX: recv failed");
+  } else if (rx_bytes == 0) {
+    return 0;
+  } else if ((segment_size != packet_length) ||
+             (static_cast<size_t>(rx_bytes) % packet_length != 0)) {
+    // The kernel only coalesces datagrams of one size, so none of these is
+    // a packet
+    rx_validators_.at(tid).CountDrop(RxDropReason::kBadLength);
+    return 0;
+  }
+
+  // Split the coalesced buffer into one RX slot per packet. The packets
+  // share the timestamp of the first one.
+  if (rx_time_ns == 0) {
+    rx_time_ns = GetTime::RealtimeNs();
+  }
+  const size_t num_packets = static_cast<size_t>(rx_bytes) / packet_length;
+  size_t num_rx = 0;
+  for (size_t i = 0; i < num_packets; i++) {
+    const size_t slot = (rx_slot + num_rx) % buffers_per_socket_;
+    RxPacket& rx = rx_packets_.at(tid).at(slot);
+    if (rx.Empty() == false) {
+      MLPD_ERROR("TXRX thread %zu rx_buffer full, offset: %zu\n", tid, slot);
+      cfg_->Running(false);
+      return num_rx;
     }
-    pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
-    if (kDebugMulticell) {
-      std::printf(
-          "After packet combining: the combined antenna ID is %d, it "
-          "comes from the cell %d\n",
-          pkt->ant_id_, pkt->cell_id_);
+    std::memcpy(rx.RawPacket(), gro_buf + (i * packet_length), packet_length);
+    rx.SetRxTimeNs(rx_time_ns);
+    // Dropped packets leave their slot to the next one
+    if (EnqueueRxPacket(tid, rx) == true) {
+      num_rx++;
     }
+  }
+  return num_rx;
+}
 
-    // Push kPacketRX event into the queue.
-    rx.Use();
-    EventData rx_message(EventType::kPacketRX, rx_tag_t(rx).tag_);
-    if (message_queue_->enqueue(*local_ptok, rx_message) == false) {
-      MLPD_ERROR("socket message enqueue failed\n");
-      throw std::runtime_error("PacketTXRX: socket message enqueue failed");
-    }
-  } else {
-    MLPD_ERROR("RecvEnqueue: Udp Recv failed to receive all expected bytes");
-    throw std::runtime_error(
-        "PacketTXRX::RecvEnqueue: Udp Recv failed to receive all expected "
-        "bytes");
+bool PacketTXRX::EnqueueRxPacket(size_t tid, RxPacket& rx) {
+  moodycamel::ProducerToken* local_ptok = rx_ptoks_[tid];
+  Packet* pkt = rx.RawPacket();
+  if (rx_validators_.at(tid).Check(pkt) == false) {
+    return false;
   }
-  return pkt;
+  if (kDebugPrintInTask) {
+    std::printf("In TXRX thread %zu: Received frame %d, symbol %d, ant %d\n",
+                tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+  }
+  if (kDebugMulticell) {
+    std::printf(
+        "Before packet combining: receiving data stream from the "
+        "antenna %d in cell %d,\n",
+        pkt->ant_id_, pkt->cell_id_);
+  }
+  pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
+  if (kDebugMulticell) {
+    std::printf(
+        "After packet combining: the combined antenna ID is %d, it "
+        "comes from the cell %d\n",
+        pkt->ant_id_, pkt->cell_id_);
+  }
+  if ((ant_rx_packets_ != nullptr) && (pkt->ant_id_ < cfg_->BsAntNum())) {
+    ant_rx_packets_[pkt->ant_id_].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Push kPacketRX event into the queue.
+  rx.Use();
+  EventData rx_message(EventType::kPacketRX, rx_tag_t(rx).tag_);
+  if (message_queue_->enqueue(*local_ptok, rx_message) == false) {
+    MLPD_ERROR("socket message enqueue failed\n");
+    throw std::runtime_error("PacketTXRX: socket message enqueue failed");
+  }
+  return true;
 }
 
 int PacketTXRX::DequeueSend(int tid) {
-  auto& c = cfg_;
   EventData event;
   if (task_queue_->try_dequeue_from_producer(*tx_ptoks_[tid], event) == false) {
     return -1;
@@ -289,10 +560,15 @@ int PacketTXRX::DequeueSend(int tid) {
 
   // std::printf("tx queue length: %d\n", task_queue_->size_approx());
   assert(event.event_type_ == EventType::kPacketTX);
+  SendDlPacket(tid, event.tags_[0]);
+  return event.tags_[0];
+}
 
-  size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
-  size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
-  size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+void PacketTXRX::SendDlPacket(int tid, size_t tag) {
+  auto& c = cfg_;
+  size_t ant_id = gen_tag_t(tag).ant_id_;
+  size_t frame_id = gen_tag_t(tag).frame_id_;
+  size_t symbol_id = gen_tag_t(tag).symbol_id_;
 
   size_t data_symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
   size_t offset = (c->GetTotalDataSymbolIdxDl(frame_id, data_symbol_idx_dl) *
@@ -303,8 +579,8 @@ int PacketTXRX::DequeueSend(int tid) {
     std::printf(
         "In TXRX thread %d: Transmitted frame %zu, symbol %zu, "
         "ant %zu, tag %zu, offset: %zu, msg_queue_length: %zu\n",
-        tid, frame_id, symbol_id, ant_id, gen_tag_t(event.tags_[0]).tag_,
-        offset, message_queue_->size_approx());
+        tid, frame_id, symbol_id, ant_id, tag, offset,
+        message_queue_->size_approx());
   }
 
   char* cur_buffer_ptr = tx_buffer_ + offset * c->DlPacketLength();
@@ -316,9 +592,80 @@ int PacketTXRX::DequeueSend(int tid) {
                                 reinterpret_cast<uint8_t*>(cur_buffer_ptr),
                                 c->DlPacketLength());
 
-  RtAssert(
-      message_queue_->enqueue(*rx_ptoks_[tid],
-                              EventData(EventType::kPacketTX, event.tags_[0])),
-      "Socket message enqueue failed\n");
-  return event.tags_[0];
+  RtAssert(message_queue_->enqueue(*rx_ptoks_[tid],
+                                   EventData(EventType::kPacketTX, tag)),
+           "Socket message enqueue failed\n");
+}
+
+size_t PacketTXRX::ScheduleDl(int tid, TxTimingWheel& wheel,
+                              const FrameSchedule& schedule,
+                              uint64_t advance_tsc, size_t& num_late) {
+  std::array<EventData, kTxScheduleBatch> events;
+  const size_t num_events = task_queue_->try_dequeue_bulk_from_producer(
+      *tx_ptoks_[tid], events.data(), events.size());
+  const uint64_t now_tsc = GetTime::Rdtsc();
+  for (size_t i = 0; i < num_events; i++) {
+    assert(events.at(i).event_type_ == EventType::kPacketTX);
+    const gen_tag_t tag(events.at(i).tags_[0]);
+    const uint64_t air_tsc =
+        schedule.SymbolStart(tag.frame_id_, tag.symbol_id_);
+    const uint64_t release_tsc =
+        (air_tsc > advance_tsc) ? (air_tsc - advance_tsc) : 0;
+    if (release_tsc <= now_tsc) {
+      num_late++;
+    }
+    wheel.Insert(release_tsc, tag.tag_);
+  }
+  return num_events;
+}
+
+int PacketTXRX::DequeueSendGso(int tid) {
+  // ScheduleAntennasTX enqueues the channels of a radio together
+  std::array<EventData, kMaxChannels> events;
+  const size_t num_events = task_queue_->try_dequeue_bulk_from_producer(
+      *tx_ptoks_[tid], events.data(), cfg_->NumChannels());
+  if (num_events == 0) {
+    return -1;
+  }
+
+  std::array<struct iovec, kMaxChannels> datagrams;
+  size_t num_datagrams = 0;
+  for (size_t i = 0; i < num_events; i++) {
+    assert(events.at(i).event_type_ == EventType::kPacketTX);
+    const gen_tag_t tag(events.at(i).tags_[0]);
+    const size_t data_symbol_idx_dl =
+        cfg_->Frame().GetDLSymbolIdx(tag.symbol_id_);
+    const size_t offset =
+        (cfg_->GetTotalDataSymbolIdxDl(tag.frame_id_, data_symbol_idx_dl) *
+         cfg_->BsAntNum()) +
+        tag.ant_id_;
+
+    char* cur_buffer_ptr = tx_buffer_ + offset * cfg_->DlPacketLength();
+    new (cur_buffer_ptr)
+        Packet(tag.frame_id_, tag.symbol_id_, 0 /* cell_id */, tag.ant_id_);
+    datagrams.at(num_datagrams).iov_base = cur_buffer_ptr;
+    datagrams.at(num_datagrams).iov_len = cfg_->DlPacketLength();
+    num_datagrams++;
+
+    // Send once the run of one radio's antennas of a symbol ends
+    const size_t radio_id = tag.ant_id_ / cfg_->NumChannels();
+    bool run_ends = (i + 1 == num_events);
+    if (run_ends == false) {
+      const gen_tag_t next(events.at(i + 1).tags_[0]);
+      run_ends = (next.frame_id_ != tag.frame_id_) ||
+                 (next.symbol_id_ != tag.symbol_id_) ||
+                 (next.ant_id_ / cfg_->NumChannels() != radio_id);
+    }
+    if (run_ends == true) {
+      udp_clients_.at(radio_id)->SendSegmented(
+          cfg_->BsRruAddr(), cfg_->BsRruPort() + radio_id, datagrams.data(),
+          num_datagrams);
+      num_datagrams = 0;
+    }
+  }
+
+  RtAssert(message_queue_->enqueue_bulk(*rx_ptoks_[tid], events.data(),
+                                        num_events),
+           "Socket message enqueue failed\n");
+  return events.at(num_events - 1).tags_[0];
 }
@@ -14,53 +14,121 @@
 #include <iostream>
 #include <mutex>
 #include <numeric>
+#include <optional>
 #include <vector>
 
 #include "buffer.h"
 #include "concurrentqueue.h"
 #include "config.h"
 #include "gettime.h"
+#include "packet_validator.h"
 #include "radio_lib.h"
 #include "symbols.h"
+#include "tx_scheduler.h"
 #include "udp_client.h"
 #include "udp_server.h"
 
 #if defined(USE_DPDK)
 #include "dpdk_transport.h"
 
-//Removed support for copy free dpdk memory due to slowdown issue.
-//#define USE_DPDK_MEMORY
-
-#if defined(USE_DPDK_MEMORY)
+/// An RX packet that points into the mbuf it was received in. The mbuf goes
+/// back to the receiving thread's collector once the workers release the
+/// packet.
 class DPDKRxPacket : public RxPacket {
  public:
-  DPDKRxPacket() : RxPacket() { mem_ = nullptr; }
+  DPDKRxPacket() : RxPacket() {
+    collector_ = nullptr;
+    mem_ = nullptr;
+  }
   explicit DPDKRxPacket(const DPDKRxPacket& copy) : RxPacket(copy) {
+    collector_ = copy.collector_;
     mem_ = copy.mem_;
   }
   ~DPDKRxPacket() = default;
-  inline bool Set(rte_mbuf* mem, Packet* in_pkt) {
+  inline bool Set(DpdkMbufCollector* collector, rte_mbuf* mem,
+                  Packet* in_pkt) {
+    collector_ = collector;
     mem_ = mem;
     return RxPacket::Set(in_pkt);
   }
 
  private:
+  DpdkMbufCollector* collector_;
   rte_mbuf* mem_;
+  inline void GcPacket() override { collector_->Release(mem_); }
+};
+#endif  //  defined(USE_DPDK)
+
+#if defined(USE_AF_XDP)
+#include "xdp_transport.h"
+
+/// An RX packet received into an AF_XDP UMEM frame. The frame goes back to
+/// the socket's fill ring once the workers release the packet.
+class XdpRxPacket : public RxPacket {
+ public:
+  XdpRxPacket() : RxPacket() {
+    socket_ = nullptr;
+    addr_ = 0;
+  }
+  explicit XdpRxPacket(const XdpRxPacket& copy) : RxPacket(copy) {
+    socket_ = copy.socket_;
+    addr_ = copy.addr_;
+  }
+  ~XdpRxPacket() = default;
+  inline bool Set(XdpSocket* socket, uint64_t addr, Packet* in_pkt) {
+    socket_ = socket;
+    addr_ = addr;
+    return RxPacket::Set(in_pkt);
+  }
+
+ private:
+  XdpSocket* socket_;
+  uint64_t addr_;
+  inline void GcPacket() override { socket_->Recycle(addr_); }
+};
+#endif  // defined(USE_AF_XDP)
+
+#if !defined(USE_DPDK) && !defined(USE_AF_XDP)
+#include "reuseport_steering.h"
+#include "shm_transport.h"
+#include "uring_transport.h"
+
+/// An RX packet in a socket thread's RX buffer. In io_uring mode the packet's
+/// slot is a provided buffer, which goes back to the kernel once the workers
+/// release the packet; otherwise releasing the packet is a no-op.
+class UringRxPacket : public RxPacket {
+ public:
+  explicit UringRxPacket(Packet* in) : RxPacket(in) {
+    ring_ = nullptr;
+    bid_ = 0;
+  }
+  explicit UringRxPacket(const UringRxPacket& copy) : RxPacket(copy) {
+    ring_ = copy.ring_;
+    bid_ = copy.bid_;
+  }
+  ~UringRxPacket() = default;
+  inline void SetBuffer(UringBufRing* ring, uint16_t bid) {
+    ring_ = ring;
+    bid_ = bid;
+  }
+
+ private:
+  UringBufRing* ring_;
+  uint16_t bid_;
   inline void GcPacket() override {
-    //std::printf("Garbage collecting the memory for DPDKRxPacket\n");
-    rte_pktmbuf_free(mem_);
-    this->Set(nullptr, nullptr);
+    if (ring_ != nullptr) {
+      ring_->Recycle(bid_);
+    }
   }
 };
-#endif  // defined(USE_DPDK_MEMORY)
-#endif  //  defined(USE_DPDK)
+#endif  // !defined(USE_DPDK) && !defined(USE_AF_XDP)
 
 /**
  * @brief Implementations of this class provide packet I/O for Agora.
  *
- * In the vanilla mode, this class provides socket or DPDK-based packet I/O to
- * Agora (running on the base station server or client) for communicating
- * with simulated peers.
+ * In the vanilla mode, this class provides socket, DPDK, or AF_XDP-based
+ * packet I/O to Agora (running on the base station server or client) for
+ * communicating with simulated peers.
  *
  * In the "Argos" mode, this class provides SoapySDR-based communication for
  * Agora (running on the base station server or client) for communicating
@@ -71,6 +139,84 @@ class PacketTXRX {
  public:
   static const int kMaxSocketNum = 10;  // Max number of socket threads allowed
 
+#if defined(USE_AF_XDP)
+  // Each thread's RX buffer is registered as UMEM, one packet per frame
+  static constexpr Agora_memory::Alignment_t kRxBufferAlignment =
+      Agora_memory::Alignment_t::kAlign4096;
+#else
+  static constexpr Agora_memory::Alignment_t kRxBufferAlignment =
+      Agora_memory::Alignment_t::kAlign64;
+#endif
+
+#if !defined(USE_DPDK) && !defined(USE_AF_XDP)
+  /// Bytes in front of each packet of a thread's RX buffer in io_uring mode,
+  /// which hold the recvmsg header and keep packets 64-byte aligned
+  static constexpr size_t kUringRxHeadroom = 64;
+  static_assert(kUringRxHeadroom >= kUringRecvHeadroom);
+
+  /// True if the socket threads receive and transmit through io_uring
+  static inline bool UseIoUring(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (cfg->UseIoUring() == true);
+  }
+
+  /// True if the socket threads exchange packets with a simulator on the
+  /// same host through shared memory rings instead of sockets
+  static inline bool UseShmTransport(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (UseIoUring(cfg) == false) && (cfg->UseShmTransport() == true);
+  }
+
+  /// True if the socket threads hold downlink packets in a timing wheel
+  /// until shortly before the air time of their symbol
+  static inline bool UseDlTxScheduler(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (UseIoUring(cfg) == false) && (UseShmTransport(cfg) == false) &&
+           (cfg->DlTxScheduler() == true);
+  }
+
+  /// True if all socket threads receive from one SO_REUSEPORT group per
+  /// radio port, steered by antenna, instead of each owning a set of radios
+  static inline bool UseReuseportRx(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (UseIoUring(cfg) == false) && (UseShmTransport(cfg) == false) &&
+           (cfg->ReuseportRx() == true);
+  }
+
+  /// True if the socket threads send each radio's packets of a symbol with
+  /// one UDP GSO send
+  static inline bool UseUdpGso(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (UseIoUring(cfg) == false) && (UseDlTxScheduler(cfg) == false) &&
+           (cfg->UdpGso() == true);
+  }
+
+  /// True if the socket threads receive packets coalesced by UDP GRO
+  static inline bool UseUdpGro(const Config* cfg) {
+    return (kUseArgos == false) && (kUseUHD == false) &&
+           (UseIoUring(cfg) == false) && (cfg->UdpGro() == true);
+  }
+
+  /// Bytes of a socket thread's buffer for receiving GRO-coalesced packets,
+  /// which fits the largest buffer the kernel coalesces
+  static constexpr size_t kGroBufferSize = 65536;
+#endif
+
+  /// Bytes between consecutive packets of a thread's RX buffer
+  static inline size_t RxPacketStride(const Config* cfg) {
+#if defined(USE_AF_XDP)
+    unused(cfg);
+    return kXdpFrameSize;
+#elif defined(USE_DPDK)
+    return cfg->PacketLength();
+#else
+    if (UseIoUring(cfg) == true) {
+      return Roundup<64>(cfg->PacketLength()) + kUringRxHeadroom;
+    }
+    return cfg->PacketLength();
+#endif
+  }
+
   explicit PacketTXRX(Config* cfg, size_t in_core_offset = 1);
 
   PacketTXRX(Config* cfg, size_t core_offset,
@@ -87,6 +233,12 @@ class PacketTXRX {
                     size_t& prev_frame_id, size_t& rx_slot);
 #endif
 
+#if defined(USE_AF_XDP)
+  // At thread [tid], receive packets from the AF_XDP socket and enqueue them
+  // to the master thread
+  size_t XdpRecv(int tid, size_t& prev_frame_id);
+#endif
+
   /**
    * @brief Start the network I/O threads
    *
@@ -103,10 +255,90 @@ class PacketTXRX {
 
   void SendBeacon(int tid, size_t frame_id);
 
+  /// Count the packets each TXRX thread drops in row [tid] of
+  /// [rx_packet_drops], which has kNumRxDropReasons columns. Call before
+  /// StartTxRx.
+  inline void SetRxPacketDrops(Table<size_t>* rx_packet_drops) {
+    this->rx_packet_drops_ = rx_packet_drops;
+  }
+
  private:
   void LoopTxRx(size_t tid);  // The thread function for thread [tid]
   int DequeueSend(int tid);
-  struct Packet* RecvEnqueue(size_t tid, size_t radio_id, size_t rx_offset);
+  struct Packet* RecvEnqueue(size_t tid, UDPServer& udp_server,
+                             size_t rx_offset);
+  // Hand the packet received in [rx] to the master thread, unless it is
+  // malformed or a duplicate. Returns false if the packet was dropped, which
+  // leaves its slot free.
+  bool EnqueueRxPacket(size_t tid, RxPacket& rx);
+
+#if !defined(USE_DPDK) && !defined(USE_AF_XDP)
+  /// A socket thread's sends in io_uring mode
+  struct UringTxState {
+    int fd_;
+    std::vector<UringSendMsg> msgs_;
+    std::vector<size_t> free_msgs_;  // Indices of msgs_ not in flight
+    std::vector<sockaddr_in> rru_addrs_;  // Indexed by antenna
+  };
+
+  // The thread function for thread [tid] in io_uring mode
+  void LoopTxRxUring(size_t tid);
+  // Submit sends for a batch of queued TX packets, without waiting for them
+  size_t DequeueSendUring(size_t tid, Uring& uring, UringTxState& tx);
+  struct Packet* RecvEnqueueUring(size_t tid, const io_uring_cqe* cqe,
+                                  const UringBufRing& buf_ring);
+
+  // In GSO mode, send the queued TX packets of thread [tid] with one GSO
+  // send per radio and symbol
+  int DequeueSendGso(int tid);
+  // In GRO mode, receive a possibly coalesced buffer into [gro_buf] and copy
+  // its packets into the RX slots from [rx_slot] on. Returns the number of
+  // packets received.
+  size_t RecvEnqueueGro(size_t tid, UDPServer& udp_server, size_t rx_slot,
+                        uint8_t* gro_buf);
+
+  // The thread function for thread [tid] in shared memory mode
+  void LoopTxRxShm(size_t tid);
+  // Copy the packets waiting in the uplink ring of [radio_id] into the RX
+  // slots from [rx_slot] on, at most [max_packets]. Returns the number of
+  // packets received.
+  size_t RecvEnqueueShm(size_t tid, size_t radio_id, size_t rx_slot,
+                        size_t max_packets);
+  // Copy the queued TX packets of thread [tid] into the downlink rings
+  int DequeueSendShm(size_t tid);
+  // Push the beacons of frame [frame_id] into the downlink rings of the
+  // radios whose downlink thread [tid] produces for
+  void SendBeaconShm(size_t tid, size_t frame_id);
+
+  // Build the beacon packets of every radio, which only differ between
+  // frames in their frame ID
+  void InitBeacons();
+  // Set up each thread's checks of received packets
+  void InitRxValidators();
+  // The prebuilt packet of beacon symbol [beacon_sym] for [radio_id]
+  inline Packet* BeaconPacket(size_t beacon_sym, size_t radio_id) {
+    return reinterpret_cast<Packet*>(
+        &beacon_pkts_.at(((beacon_sym * cfg_->NumRadios()) + radio_id) *
+                         beacon_pkt_stride_));
+  }
+
+  // Send the downlink packet of [tag] and report it to the master thread
+  void SendDlPacket(int tid, size_t tag);
+  // In DL TX scheduler mode, move the queued TX packets of thread [tid] into
+  // [wheel], to be released [advance_tsc] before their air time in
+  // [schedule]. Counts the packets already due in [num_late], and returns
+  // the number of packets dequeued.
+  size_t ScheduleDl(int tid, TxTimingWheel& wheel,
+                    const FrameSchedule& schedule, uint64_t advance_tsc,
+                    size_t& num_late);
+
+  // Bind every thread's socket to each radio port's SO_REUSEPORT group, in
+  // thread order, and attach the initial steering program
+  void StartReuseportRx();
+  // Move an antenna off the socket thread with the deepest socket queues,
+  // and steer the groups by the new mapping
+  void RebalanceReuseportRx();
+#endif
 
   void LoopTxRxArgos(size_t tid);
   int DequeueSendArgos(int tid);
@@ -135,6 +367,7 @@ class PacketTXRX {
 
   char* tx_buffer_;
   Table<size_t>* frame_start_;
+  Table<size_t>* rx_packet_drops_ = nullptr;
   moodycamel::ConcurrentQueue<EventData>* message_queue_;
   moodycamel::ConcurrentQueue<EventData>* task_queue_;
   moodycamel::ProducerToken** rx_ptoks_;
@@ -147,18 +380,62 @@ class PacketTXRX {
   uint32_t bs_rru_addr_;     // IPv4 address of the simulator sender
   uint32_t bs_server_addr_;  // IPv4 address of the Agora server
   struct rte_mempool* mbuf_pool_;
+  // Pool for the headers of received packets if the NICs split them from
+  // the payload, otherwise nullptr
+  struct rte_mempool* hdr_pool_;
+  // Mbufs of received packets released by the workers, one per socket_thread
+  std::vector<std::unique_ptr<DpdkMbufCollector>> mbuf_collectors_;
 
   // Dimension 1: socket_thread
-  // Dimension 2: rx_packet
-#if defined(USE_DPDK_MEMORY)
+  // Dimension 2: rx_packet, each pointing into the mbuf it was received in
   std::vector<std::vector<DPDKRxPacket>> rx_packets_;
+#elif defined(USE_AF_XDP)
+  uint32_t bs_rru_addr_;     // IPv4 address of the simulator sender
+  uint32_t bs_server_addr_;  // IPv4 address of the Agora server
+  std::unique_ptr<XdpTransport> xdp_transport_;
+  // One socket per socket_thread, with its UMEM in the thread's RX buffer
+  std::vector<std::unique_ptr<XdpSocket>> xdp_sockets_;
+  // Flow back to the sender, learned by each socket_thread from its first
+  // received packet since AF_XDP transmits below ARP
+  std::vector<std::optional<XdpFlow>> tx_flows_;
+
+  // Dimension 1: socket_thread
+  // Dimension 2: rx_packet, indexed by UMEM frame
+  std::vector<std::vector<XdpRxPacket>> rx_packets_;
 #else
-  std::vector<std::vector<RxPacket>> rx_packets_;
-#endif  // defined(USE_DPDK_MEMORY)
-#else
+  // io_uring mode only. Each socket_thread creates its own ring, which stays
+  // alive after the thread exits so that workers can still release packets.
+  std::vector<std::unique_ptr<Uring>> urings_;
+  // The provided buffers of each socket_thread, over its RX buffer
+  std::vector<std::unique_ptr<UringBufRing>> uring_buf_rings_;
+
   // Dimension 1: socket_thread
-  // Dimension 2: rx_packet
-  std::vector<std::vector<RxPacket>> rx_packets_;
+  // Dimension 2: rx_packet, indexed by provided buffer id in io_uring mode
+  std::vector<std::vector<UringRxPacket>> rx_packets_;
+
+  // Shared memory mode only. Radio i's uplink ring is consumed by the thread
+  // that owns the radio, and its downlink ring is produced by thread
+  // i % socket_thread_num, which ScheduleAntennasTX hands its packets to.
+  std::unique_ptr<ShmTransport> shm_transport_;
+  // Downlink packets dropped because no simulator drained the ring, per
+  // socket_thread
+  std::vector<size_t> shm_tx_drops_;
+
+  // Beacon packets, one per beacon symbol and radio, beacon_pkt_stride_
+  // bytes apart
+  std::vector<uint8_t> beacon_pkts_;
+  size_t beacon_pkt_stride_;
+
+  // Reuseport mode only. Dimension 1: socket_thread, dimension 2: radio.
+  // Each thread's socket sits at the thread's index in every port group.
+  std::vector<std::vector<std::unique_ptr<UDPServer>>> reuseport_servers_;
+  std::unique_ptr<AntennaBalancer> ant_balancer_;
+  // Packets received per antenna since the last rebalance
+  std::unique_ptr<std::atomic<size_t>[]> ant_rx_packets_;
+
+  // Checks the packets each socket_thread receives before they go to the
+  // master
+  std::vector<PacketValidator> rx_validators_;
 #endif  // defined(USE_DPDK)
 
   std::unique_ptr<RadioConfig> radioconfig_;  // Used only in Argos mode
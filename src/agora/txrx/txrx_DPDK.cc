@@ -20,7 +20,29 @@ PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset)
       rte_socket_id());
   RtAssert(cfg_->DpdkNumPorts() <= rte_eth_dev_count_avail(),
            "Invalid number of DPDK ports");
-  mbuf_pool_ = DpdkTransport::CreateMempool(cfg->DpdkNumPorts());
+
+  // Received packets stay in their mbufs until the workers release them, so
+  // the pool holds a window of RX packets on top of the NIC rings
+  const size_t frame_len =
+      kPayloadOffset +
+      Roundup<64>(std::max(cfg_->PacketLength(), cfg_->DlPacketLength()));
+  const size_t num_rx_packets =
+      cfg_->BsAntNum() * cfg_->FrameWnd() * cfg_->Frame().NumTotalSyms();
+  const size_t num_mbufs = kNumMBufs * cfg_->DpdkNumPorts() + num_rx_packets;
+  mbuf_pool_ = DpdkTransport::CreateMempool("MBUF_POOL", num_mbufs, frame_len);
+
+  hdr_pool_ = nullptr;
+  bool buffer_split = true;
+  for (uint16_t port_id = 0; port_id < cfg_->DpdkNumPorts(); port_id++) {
+    buffer_split = buffer_split && DpdkTransport::SupportsBufferSplit(
+                                       port_id + cfg_->DpdkPortOffset());
+  }
+  if (buffer_split == true) {
+    hdr_pool_ =
+        DpdkTransport::CreateMempool("HDR_POOL", num_mbufs, kPayloadOffset);
+  }
+  std::printf("DPDK: %zu mbufs, header split %s\n", num_mbufs,
+              buffer_split ? "on" : "off");
 
   int ret = inet_pton(AF_INET, cfg_->BsRruAddr().c_str(), &bs_rru_addr_);
   RtAssert(ret == 1, "Invalid sender IP address");
@@ -29,7 +51,8 @@ PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset)
 
   for (uint16_t port_id = 0; port_id < cfg_->DpdkNumPorts(); port_id++) {
     if (DpdkTransport::NicInit(port_id + cfg->DpdkPortOffset(), mbuf_pool_,
-                               socket_thread_num_) != 0) {
+                               socket_thread_num_, frame_len,
+                               hdr_pool_) != 0) {
       rte_exit(EXIT_FAILURE, "Cannot init port %u\n",
                port_id + cfg->DpdkPortOffset());
     }
@@ -67,7 +90,12 @@ PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset,
   tx_ptoks_ = tx_ptoks;
 }
 
-PacketTXRX::~PacketTXRX() { rte_mempool_free(mbuf_pool_); }
+PacketTXRX::~PacketTXRX() {
+  rte_mempool_free(mbuf_pool_);
+  if (hdr_pool_ != nullptr) {
+    rte_mempool_free(hdr_pool_);
+  }
+}
 
 bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
                            Table<size_t>& frame_start, char* tx_buffer,
@@ -80,20 +108,13 @@ bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
   buffers_per_socket_ = packet_num_in_buffer / socket_thread_num_;
   tx_buffer_ = tx_buffer;
 
+  // Packets are received into mbufs, so the RX buffers are unused
+  unused(buffer);
   rx_packets_.resize(socket_thread_num_);
+  mbuf_collectors_.resize(socket_thread_num_);
   for (size_t i = 0; i < socket_thread_num_; i++) {
-    rx_packets_.at(i).reserve(buffers_per_socket_);
-#if defined(USE_DPDK_MEMORY)
-    unused(buffer);
     rx_packets_.at(i).resize(buffers_per_socket_);
-#else
-    for (size_t number_packets = 0; number_packets < buffers_per_socket_;
-         number_packets++) {
-      auto* pkt_loc = reinterpret_cast<Packet*>(
-          buffer[i] + (number_packets * cfg_->PacketLength()));
-      rx_packets_.at(i).emplace_back(pkt_loc);
-    }
-#endif  // defined(USE_DPDK_MEMORY)
+    mbuf_collectors_.at(i) = std::make_unique<DpdkMbufCollector>();
   }
 
   unsigned int lcore_id;
@@ -131,6 +152,7 @@ void PacketTXRX::LoopTxRx(size_t tid) {
   const uint16_t queue_id = tid / cfg_->DpdkNumPorts();
 
   while (this->cfg_->Running()) {
+    mbuf_collectors_.at(tid)->FreeReleased();
     if (-1 != DequeueSend(tid)) {
       continue;
     }
@@ -191,14 +213,24 @@ uint16_t PacketTXRX::DpdkRecv(int tid, uint16_t port_id, uint16_t queue_id,
       continue;
     }
 
-    auto* payload = reinterpret_cast<uint8_t*>(eth_hdr) + kPayloadOffset;
-#if defined(USE_DPDK_MEMORY)
-    rx.Set(dpdk_pkt, reinterpret_cast<Packet*>(payload));
-#else
-    DpdkTransport::FastMemcpy(reinterpret_cast<uint8_t*>(rx.RawPacket()),
-                              payload, cfg_->PacketLength());
-    rte_pktmbuf_free(dpdk_pkt);
-#endif
+    uint8_t* payload;
+    if (dpdk_pkt->nb_segs > 1) {
+      // Header split: the payload starts the second segment, aligned by the
+      // mbuf headroom
+      payload = rte_pktmbuf_mtod(dpdk_pkt->next, uint8_t*);
+    } else {
+      payload = reinterpret_cast<uint8_t*>(eth_hdr) + kPayloadOffset;
+      // Move the payload back to a 64-byte boundary if the driver left it
+      // unaligned. The move overwrites the headers already checked above.
+      if (reinterpret_cast<uintptr_t>(payload) % 64 != 0) {
+        auto* aligned = RTE_PTR_ALIGN_FLOOR(payload, 64);
+        std::memmove(aligned, payload, cfg_->PacketLength());
+        payload = aligned;
+      }
+    }
+    rx.Set(mbuf_collectors_.at(tid).get(), dpdk_pkt,
+           reinterpret_cast<Packet*>(payload));
+    rx.SetRxTimeNs(GetTime::RealtimeNs());
 
     if (kIsWorkerTimingEnabled) {
       if (prev_frame_id == SIZE_MAX or
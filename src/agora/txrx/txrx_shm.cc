@@ -0,0 +1,193 @@
+/**
+ * @file txrx_shm.cc
+ * @brief Implementation of PacketTXRX datapath functions for communicating
+ * with simulators on the same host through shared memory rings
+ */
+
+#include "logger.h"
+#include "txrx.h"
+
+static constexpr bool kEnableSlowStart = true;
+static constexpr bool kEnableSlowSending = true;
+
+// Packets moved through the rings per loop iteration, in each direction and
+// per radio for receiving
+static constexpr size_t kShmBatch = 16;
+
+void PacketTXRX::LoopTxRxShm(size_t tid) {
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid,
+                      cfg_->Placement());
+
+  const double rdtsc_freq = GetTime::MeasureRdtscFreq();
+  const size_t frame_tsc_delta =
+      cfg_->GetFrameDurationSec() * 1e9f * rdtsc_freq;
+  const size_t two_hundred_ms_ticks = (0.2f /* 200 ms */ * 1e9f * rdtsc_freq);
+
+  // Slow start variables (Start with no less than 200 ms)
+  const size_t slow_start_tsc1 =
+      std::max(40 * frame_tsc_delta, two_hundred_ms_ticks);
+  const size_t slow_start_thresh1 = cfg_->FrameWnd();
+  const size_t slow_start_tsc2 = 15 * frame_tsc_delta;
+  const size_t slow_start_thresh2 = cfg_->FrameWnd() * 4;
+  size_t delay_tsc = frame_tsc_delta;
+
+  if (kEnableSlowStart) {
+    delay_tsc = slow_start_tsc1;
+  }
+
+  const size_t radio_lo = tid * cfg_->NumRadios() / socket_thread_num_;
+  const size_t radio_hi = (tid + 1) * cfg_->NumRadios() / socket_thread_num_;
+  MLPD_FRAME("TXRX thread %zu: receiving from the rings of radios %zu-%zu\n",
+             tid, radio_lo, radio_hi);
+
+  size_t* rx_frame_start = (*frame_start_)[tid];
+  size_t rx_slot = 0;
+  size_t prev_frame_id = SIZE_MAX;
+  size_t tx_frame_start = GetTime::Rdtsc();
+  size_t tx_frame_id = 0;
+  size_t send_time = delay_tsc + tx_frame_start;
+  while (cfg_->Running() == true) {
+    size_t rdtsc_now = GetTime::Rdtsc();
+
+    if (rdtsc_now > send_time) {
+      SendBeaconShm(tid, tx_frame_id++);
+
+      if (kEnableSlowStart) {
+        if (tx_frame_id == slow_start_thresh1) {
+          delay_tsc = slow_start_tsc2;
+        } else if (tx_frame_id == slow_start_thresh2) {
+          delay_tsc = frame_tsc_delta;
+          if (kEnableSlowSending) {
+            // Temp for historic reasons
+            delay_tsc = frame_tsc_delta * 4;
+          }
+        }
+      }
+      tx_frame_start = send_time;
+      send_time += delay_tsc;
+    }
+
+    for (size_t i = 0; i < kShmBatch; i++) {
+      if (DequeueSendShm(tid) == -1) {
+        break;
+      }
+    }
+
+    for (size_t radio_id = radio_lo; radio_id < radio_hi; radio_id++) {
+      const size_t num_rx = RecvEnqueueShm(tid, radio_id, rx_slot, kShmBatch);
+      if (num_rx == 0) {
+        continue;
+      }
+      if (kIsWorkerTimingEnabled) {
+        const Packet* pkt = rx_packets_.at(tid).at(rx_slot).RawPacket();
+        if ((prev_frame_id == SIZE_MAX) || (pkt->frame_id_ > prev_frame_id)) {
+          rx_frame_start[pkt->frame_id_ % kNumStatsFrames] = GetTime::Rdtsc();
+          prev_frame_id = pkt->frame_id_;
+        }
+      }
+      rx_slot = (rx_slot + num_rx) % buffers_per_socket_;
+    }
+  }
+
+  if (shm_tx_drops_.at(tid) > 0) {
+    MLPD_WARN(
+        "TXRX thread %zu: %zu downlink packets dropped on full shared memory "
+        "rings\n",
+        tid, shm_tx_drops_.at(tid));
+  }
+}
+
+size_t PacketTXRX::RecvEnqueueShm(size_t tid, size_t radio_id, size_t rx_slot,
+                                  size_t max_packets) {
+  const size_t packet_length = cfg_->PacketLength();
+  ShmRing& ring = shm_transport_->Uplink(radio_id);
+  size_t num_rx = 0;
+  for (size_t i = 0; i < max_packets; i++) {
+    RxPacket& rx = rx_packets_.at(tid).at((rx_slot + num_rx) %
+                                          buffers_per_socket_);
+    // Unlike a socket, the ring holds packets until there is room for them
+    if (rx.Empty() == false) {
+      break;
+    }
+    const uint8_t* slot = ring.Front();
+    if (slot == nullptr) {
+      break;
+    }
+    std::memcpy(rx.RawPacket(), slot, packet_length);
+    ring.Pop();
+    rx.SetRxTimeNs(GetTime::RealtimeNs());
+    // Dropped packets leave their slot to the next one
+    if (EnqueueRxPacket(tid, rx) == true) {
+      num_rx++;
+    }
+  }
+  return num_rx;
+}
+
+int PacketTXRX::DequeueSendShm(size_t tid) {
+  auto& c = cfg_;
+  EventData event;
+  if (task_queue_->try_dequeue_from_producer(*tx_ptoks_[tid], event) == false) {
+    return -1;
+  }
+  assert(event.event_type_ == EventType::kPacketTX);
+
+  size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
+  size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+  size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+
+  size_t data_symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
+  size_t offset = (c->GetTotalDataSymbolIdxDl(frame_id, data_symbol_idx_dl) *
+                   c->BsAntNum()) +
+                  ant_id;
+
+  if (kDebugPrintInTask) {
+    std::printf(
+        "In TXRX thread %zu: Transmitted frame %zu, symbol %zu, "
+        "ant %zu, tag %zu, offset: %zu, msg_queue_length: %zu\n",
+        tid, frame_id, symbol_id, ant_id, gen_tag_t(event.tags_[0]).tag_,
+        offset, message_queue_->size_approx());
+  }
+
+  char* cur_buffer_ptr = tx_buffer_ + offset * c->DlPacketLength();
+  auto* pkt = reinterpret_cast<Packet*>(cur_buffer_ptr);
+  new (pkt) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
+
+  // A socket drops packets that nobody receives, and so does a full ring,
+  // so that Agora runs without a downlink consumer
+  ShmRing& ring = shm_transport_->Downlink(ant_id / c->NumChannels());
+  uint8_t* slot = ring.Reserve();
+  if (slot != nullptr) {
+    std::memcpy(slot, cur_buffer_ptr, c->DlPacketLength());
+    ring.Commit();
+  } else {
+    shm_tx_drops_.at(tid)++;
+  }
+
+  RtAssert(
+      message_queue_->enqueue(*rx_ptoks_[tid],
+                              EventData(EventType::kPacketTX, event.tags_[0])),
+      "Socket message enqueue failed\n");
+  return event.tags_[0];
+}
+
+void PacketTXRX::SendBeaconShm(size_t tid, size_t frame_id) {
+  // Beacons go through the downlink rings, whose producer for radio i is
+  // thread i % socket_thread_num
+  for (size_t beacon_sym = 0; beacon_sym < cfg_->Frame().NumBeaconSyms();
+       beacon_sym++) {
+    for (size_t radio_id = tid; radio_id < cfg_->NumRadios();
+         radio_id += socket_thread_num_) {
+      ShmRing& ring = shm_transport_->Downlink(radio_id);
+      uint8_t* slot = ring.Reserve();
+      if (slot == nullptr) {
+        shm_tx_drops_.at(tid)++;
+        continue;
+      }
+      std::memcpy(slot, BeaconPacket(beacon_sym, radio_id),
+                  cfg_->PacketLength());
+      reinterpret_cast<Packet*>(slot)->frame_id_ = frame_id;
+      ring.Commit();
+    }
+  }
+}
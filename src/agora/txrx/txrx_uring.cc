@@ -0,0 +1,300 @@
+/**
+ * @file txrx_uring.cc
+ * @brief Implementation of PacketTXRX datapath functions for communicating
+ * with simulators through io_uring
+ */
+
+#include <arpa/inet.h>
+
+#include "logger.h"
+#include "txrx.h"
+
+static constexpr bool kEnableSlowStart = true;
+static constexpr bool kEnableSlowSending = true;
+
+// Sends in flight per thread. Each one holds a message header until its
+// completion, and the rest of the submission queue is left for receives.
+static constexpr size_t kUringTxSlots = kUringEntries / 2;
+// Completions handled per loop iteration
+static constexpr size_t kUringCqeBatch = 64;
+// Marks the user data of sends. Receives carry their radio id.
+static constexpr uint64_t kUringTxFlag = 1ull << 63;
+
+void PacketTXRX::LoopTxRxUring(size_t tid) {
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid,
+                      cfg_->Placement());
+
+  const double rdtsc_freq = GetTime::MeasureRdtscFreq();
+  const size_t frame_tsc_delta =
+      cfg_->GetFrameDurationSec() * 1e9f * rdtsc_freq;
+  const size_t two_hundred_ms_ticks = (0.2f /* 200 ms */ * 1e9f * rdtsc_freq);
+
+  // Slow start variables (Start with no less than 200 ms)
+  const size_t slow_start_tsc1 =
+      std::max(40 * frame_tsc_delta, two_hundred_ms_ticks);
+  const size_t slow_start_thresh1 = cfg_->FrameWnd();
+  const size_t slow_start_tsc2 = 15 * frame_tsc_delta;
+  const size_t slow_start_thresh2 = cfg_->FrameWnd() * 4;
+  size_t delay_tsc = frame_tsc_delta;
+
+  if (kEnableSlowStart) {
+    delay_tsc = slow_start_tsc1;
+  }
+
+  const size_t radio_lo = tid * cfg_->NumRadios() / socket_thread_num_;
+  const size_t radio_hi = (tid + 1) * cfg_->NumRadios() / socket_thread_num_;
+
+  const size_t sock_buf_size = (1024 * 1024 * 64 * 8) - 1;
+  for (size_t radio_id = radio_lo; radio_id < radio_hi; ++radio_id) {
+    size_t local_port_id = cfg_->BsServerPort() + radio_id;
+
+    udp_servers_.at(radio_id) =
+        std::make_unique<UDPServer>(local_port_id, sock_buf_size);
+    udp_clients_.at(radio_id) = std::make_unique<UDPClient>();
+    MLPD_FRAME(
+        "TXRX thread %zu: set up UDP socket server listening to port %zu"
+        " with remote address %s:%zu \n",
+        tid, local_port_id, cfg_->BsRruAddr().c_str(),
+        cfg_->BsRruPort() + radio_id);
+  }
+
+  // The ring is created here because only its creator may submit to it
+  urings_.at(tid) =
+      std::make_unique<Uring>(kUringEntries, cfg_->IoUringSqPoll());
+  Uring& uring = *urings_.at(tid);
+  std::vector<UringRxPacket>& rx_packets = rx_packets_.at(tid);
+  const size_t num_bufs = std::min(rx_packets.size(), kUringMaxBufs);
+  auto* rx_base = reinterpret_cast<uint8_t*>(rx_packets.at(0).RawPacket()) -
+                  kUringRxHeadroom;
+  uring_buf_rings_.at(tid) = std::make_unique<UringBufRing>(
+      &uring, 0 /* bgid */, rx_base, RxPacketStride(cfg_), kUringRxHeadroom,
+      cfg_->PacketLength(), num_bufs);
+  UringBufRing& buf_ring = *uring_buf_rings_.at(tid);
+  for (size_t bid = 0; bid < num_bufs; bid++) {
+    rx_packets.at(bid).SetBuffer(&buf_ring, static_cast<uint16_t>(bid));
+  }
+
+  UringTxState tx;
+  tx.fd_ = udp_clients_.at(radio_lo)->Fd();
+  tx.msgs_.resize(kUringTxSlots);
+  for (size_t i = 0; i < kUringTxSlots; i++) {
+    tx.free_msgs_.push_back(kUringTxSlots - 1 - i);
+  }
+  sockaddr_in rru_addr;
+  std::memset(&rru_addr, 0, sizeof(rru_addr));
+  rru_addr.sin_family = AF_INET;
+  RtAssert(inet_pton(AF_INET, cfg_->BsRruAddr().c_str(),
+                     &rru_addr.sin_addr) == 1,
+           "Invalid sender IP address");
+  tx.rru_addrs_.resize(cfg_->BsAntNum(), rru_addr);
+  for (size_t ant_id = 0; ant_id < cfg_->BsAntNum(); ant_id++) {
+    tx.rru_addrs_.at(ant_id).sin_port = htons(cfg_->BsRruPort() + ant_id);
+  }
+
+  // Receive on every radio of this thread with one request each. The kernel
+  // copies the header in at submission, and no address or control data is
+  // requested, so one header serves all radios.
+  msghdr rx_msg;
+  std::memset(&rx_msg, 0, sizeof(rx_msg));
+  std::vector<size_t> rearm_radios;
+  for (size_t radio_id = radio_lo; radio_id < radio_hi; ++radio_id) {
+    rearm_radios.push_back(radio_id);
+  }
+
+  size_t prev_frame_id = SIZE_MAX;
+  size_t tx_frame_start = GetTime::Rdtsc();
+  size_t tx_frame_id = 0;
+  size_t send_time = delay_tsc + tx_frame_start;
+  while (cfg_->Running() == true) {
+    size_t rdtsc_now = GetTime::Rdtsc();
+
+    if (rdtsc_now > send_time) {
+      SendBeacon(tid, tx_frame_id++);
+
+      if (kEnableSlowStart) {
+        if (tx_frame_id == slow_start_thresh1) {
+          delay_tsc = slow_start_tsc2;
+        } else if (tx_frame_id == slow_start_thresh2) {
+          delay_tsc = frame_tsc_delta;
+          if (kEnableSlowSending) {
+            // Temp for historic reasons
+            delay_tsc = frame_tsc_delta * 4;
+          }
+        }
+      }
+      tx_frame_start = send_time;
+      send_time += delay_tsc;
+    }
+
+    for (size_t i = 0; i < kUringCqeBatch; i++) {
+      io_uring_cqe* cqe = uring.PeekCqe();
+      if (cqe == nullptr) {
+        break;
+      }
+      if (cqe->user_data == kUringInternalUserData) {
+        MLPD_ERROR("TXRX thread %zu: Failed to provide buffers: %s\n", tid,
+                   std::strerror(-cqe->res));
+        throw std::runtime_error("PacketTXRX: io_uring provide failed");
+      } else if ((cqe->user_data & kUringTxFlag) != 0) {
+        const size_t slot = cqe->user_data & ~kUringTxFlag;
+        if (cqe->res != static_cast<int>(cfg_->DlPacketLength())) {
+          MLPD_ERROR("TXRX thread %zu: io_uring send failed: %d\n", tid,
+                     cqe->res);
+          throw std::runtime_error("PacketTXRX: io_uring send failed");
+        }
+        RtAssert(message_queue_->enqueue(
+                     *rx_ptoks_[tid],
+                     EventData(EventType::kPacketTX, tx.msgs_.at(slot).tag_)),
+                 "Socket message enqueue failed\n");
+        tx.free_msgs_.push_back(slot);
+      } else {
+        Packet* pkt = RecvEnqueueUring(tid, cqe, buf_ring);
+        if ((pkt != nullptr) && (kIsWorkerTimingEnabled == true)) {
+          if ((prev_frame_id == SIZE_MAX) ||
+              (pkt->frame_id_ > prev_frame_id)) {
+            (*frame_start_)[tid][pkt->frame_id_ % kNumStatsFrames] =
+                GetTime::Rdtsc();
+            prev_frame_id = pkt->frame_id_;
+          }
+        }
+        // The kernel ends a receive request when it runs out of buffers
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+          rearm_radios.push_back(cqe->user_data);
+        }
+      }
+      uring.SeenCqe();
+    }
+
+    DequeueSendUring(tid, uring, tx);
+    // Hand buffers back before re-arming, so that the new requests find them
+    buf_ring.Refill();
+    while ((rearm_radios.empty() == false) && (uring.SqSpace() > 0)) {
+      const size_t radio_id = rearm_radios.back();
+      UringPrepRecvMultishot(uring.GetSqe(), udp_servers_.at(radio_id)->Fd(),
+                             &rx_msg, buf_ring, radio_id);
+      rearm_radios.pop_back();
+    }
+    // Without SQPOLL this is the only syscall per iteration, and only if
+    // there is anything to submit
+    uring.Submit();
+  }
+
+  // Sends still point into the thread's slots, so wait for them to finish
+  while (tx.free_msgs_.size() < kUringTxSlots) {
+    io_uring_cqe* cqe = uring.PeekCqe();
+    if (cqe == nullptr) {
+      uring.SubmitAndWait(1);
+      continue;
+    }
+    if ((cqe->user_data != kUringInternalUserData) &&
+        ((cqe->user_data & kUringTxFlag) != 0)) {
+      tx.free_msgs_.push_back(cqe->user_data & ~kUringTxFlag);
+    }
+    uring.SeenCqe();
+  }
+}
+
+struct Packet* PacketTXRX::RecvEnqueueUring(size_t tid,
+                                            const io_uring_cqe* cqe,
+                                            const UringBufRing& buf_ring) {
+  if (cqe->res == -ENOBUFS) {
+    MLPD_WARN("TXRX thread %zu: Out of io_uring RX buffers\n", tid);
+    return nullptr;
+  } else if (cqe->res < 0) {
+    MLPD_ERROR("RecvEnqueueUring: io_uring recv failed: %s\n",
+               std::strerror(-cqe->res));
+    throw std::runtime_error("PacketTXRX: io_uring recv failed");
+  }
+
+  const auto bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+  UringRxPacket& rx = rx_packets_.at(tid).at(bid);
+  // The kernel only picks buffers that were handed back, so the slot is free
+  RtAssert(rx.Empty() == true, "io_uring: Received into a busy RX slot");
+  Packet* pkt = rx.RawPacket();
+  RtAssert(reinterpret_cast<uint8_t*>(pkt) == buf_ring.Payload(bid),
+           "io_uring: RX slot does not match the buffer");
+
+  const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(
+      reinterpret_cast<uint8_t*>(pkt) - kUringRecvHeadroom);
+  PacketValidator& validator = rx_validators_.at(tid);
+  bool valid = true;
+  if ((out->payloadlen != cfg_->PacketLength()) ||
+      ((out->flags & MSG_TRUNC) != 0)) {
+    validator.CountDrop(RxDropReason::kBadLength);
+    valid = false;
+  } else {
+    valid = validator.Check(pkt);
+  }
+  if (valid == false) {
+    // Hand the buffer straight back to the kernel
+    rx.Use();
+    rx.Free();
+    return nullptr;
+  }
+
+  if (kDebugPrintInTask) {
+    std::printf("In TXRX thread %zu: Received frame %d, symbol %d, ant %d\n",
+                tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+  }
+  pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
+
+  // Push kPacketRX event into the queue.
+  rx.SetRxTimeNs(GetTime::RealtimeNs());
+  rx.Use();
+  EventData rx_message(EventType::kPacketRX, rx_tag_t(rx).tag_);
+  if (message_queue_->enqueue(*rx_ptoks_[tid], rx_message) == false) {
+    MLPD_ERROR("socket message enqueue failed\n");
+    throw std::runtime_error("PacketTXRX: socket message enqueue failed");
+  }
+  return pkt;
+}
+
+size_t PacketTXRX::DequeueSendUring(size_t tid, Uring& uring,
+                                    UringTxState& tx) {
+  auto& c = cfg_;
+  const size_t max_events =
+      std::min(tx.free_msgs_.size(), static_cast<size_t>(uring.SqSpace()));
+  if (max_events == 0) {
+    return 0;
+  }
+
+  EventData events[kUringTxSlots];
+  const size_t num_events = task_queue_->try_dequeue_bulk_from_producer(
+      *tx_ptoks_[tid], events, max_events);
+
+  for (size_t i = 0; i < num_events; i++) {
+    const EventData& event = events[i];
+    assert(event.event_type_ == EventType::kPacketTX);
+
+    size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
+    size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+    size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+
+    size_t data_symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
+    size_t offset = (c->GetTotalDataSymbolIdxDl(frame_id, data_symbol_idx_dl) *
+                     c->BsAntNum()) +
+                    ant_id;
+
+    if (kDebugPrintInTask) {
+      std::printf(
+          "In TXRX thread %zu: Transmitted frame %zu, symbol %zu, "
+          "ant %zu, tag %zu, offset: %zu, msg_queue_length: %zu\n",
+          tid, frame_id, symbol_id, ant_id, gen_tag_t(event.tags_[0]).tag_,
+          offset, message_queue_->size_approx());
+    }
+
+    char* cur_buffer_ptr = tx_buffer_ + offset * c->DlPacketLength();
+    auto* pkt = reinterpret_cast<Packet*>(cur_buffer_ptr);
+    new (pkt) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
+
+    // Send straight from the downlink buffer, which is not reused before the
+    // kPacketTX event that the completion triggers
+    const size_t slot = tx.free_msgs_.back();
+    tx.free_msgs_.pop_back();
+    UringSendMsg& msg = tx.msgs_.at(slot);
+    msg.tag_ = event.tags_[0];
+    msg.Set(tx.rru_addrs_.at(ant_id), cur_buffer_ptr, c->DlPacketLength());
+    UringPrepSendMsg(uring.GetSqe(), tx.fd_, &msg.msg_, kUringTxFlag | slot);
+  }
+  return num_events;
+}
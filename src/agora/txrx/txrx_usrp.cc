@@ -9,7 +9,8 @@
 static constexpr bool kDebugDownlink = false;
 
 void PacketTXRX::LoopTxRxUsrp(size_t tid) {
-  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid);
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid,
+                      cfg_->Placement());
   size_t* rx_frame_start = (*frame_start_)[tid];
   size_t rx_slot = 0;
   size_t radio_lo = tid * cfg_->NumRadios() / socket_thread_num_;
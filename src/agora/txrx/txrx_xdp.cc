@@ -0,0 +1,267 @@
+/**
+ * @file txrx_xdp.cc
+ * @brief Implementation of PacketTXRX datapath functions for communicating
+ * with simulators over AF_XDP sockets
+ */
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <netinet/ip.h>
+
+#include "logger.h"
+#include "txrx.h"
+
+PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset)
+    : cfg_(cfg),
+      core_offset_(core_offset),
+      ant_per_cell_(cfg->BsAntNum() / cfg->NumCells()),
+      socket_thread_num_(cfg->SocketThreadNum()) {
+  RtAssert(socket_thread_num_ <= kMaxSocketNum, "Too many socket threads");
+  RtAssert(cfg_->XdpInterface().empty() == false,
+           "AF_XDP: xdp_interface must be set");
+  RtAssert(kXdpKernelHeadroom + kXdpFrameHeadroom + kXdpPayloadOffset +
+                   cfg_->PacketLength() <=
+               kXdpFrameSize,
+           "AF_XDP: Packet does not fit in a UMEM frame");
+  RtAssert(kXdpPayloadOffset + cfg_->DlPacketLength() <= kXdpFrameSize,
+           "AF_XDP: Downlink packet does not fit in a UMEM frame");
+
+  int ret = inet_pton(AF_INET, cfg_->BsRruAddr().c_str(), &bs_rru_addr_);
+  RtAssert(ret == 1, "Invalid sender IP address");
+  ret = inet_pton(AF_INET, cfg_->BsServerAddr().c_str(), &bs_server_addr_);
+  RtAssert(ret == 1, "Invalid server IP address");
+
+  xdp_transport_ = std::make_unique<XdpTransport>(
+      cfg_->XdpInterface(), cfg_->BsServerPort(),
+      cfg_->BsServerPort() + cfg_->NumRadios() - 1,
+      cfg_->XdpQueueStart() + socket_thread_num_, cfg_->XdpNativeMode());
+  xdp_sockets_.resize(socket_thread_num_);
+  tx_flows_.resize(socket_thread_num_);
+}
+
+PacketTXRX::PacketTXRX(Config* cfg, size_t core_offset,
+                       moodycamel::ConcurrentQueue<EventData>* queue_message,
+                       moodycamel::ConcurrentQueue<EventData>* queue_task,
+                       moodycamel::ProducerToken** rx_ptoks,
+                       moodycamel::ProducerToken** tx_ptoks)
+    : PacketTXRX(cfg, core_offset) {
+  message_queue_ = queue_message;
+  task_queue_ = queue_task;
+  rx_ptoks_ = rx_ptoks;
+  tx_ptoks_ = tx_ptoks;
+}
+
+PacketTXRX::~PacketTXRX() {
+  for (size_t i = 0; i < socket_thread_num_; i++) {
+    if (socket_std_threads_.at(i).joinable() == true) {
+      socket_std_threads_.at(i).join();
+    }
+  }
+  // Close the sockets before detaching the program
+  xdp_sockets_.clear();
+  xdp_transport_.reset();
+}
+
+bool PacketTXRX::StartTxRx(Table<char>& buffer, size_t packet_num_in_buffer,
+                           Table<size_t>& frame_start, char* tx_buffer,
+                           Table<complex_float>& calib_dl_buffer,
+                           Table<complex_float>& calib_ul_buffer) {
+  unused(calib_dl_buffer);
+  unused(calib_ul_buffer);
+
+  frame_start_ = &frame_start;
+  tx_buffer_ = tx_buffer;
+  buffers_per_socket_ = packet_num_in_buffer / socket_thread_num_;
+  MLPD_INFO("PacketTXRX: AF_XDP rx threads %zu, UMEM frames %zu\n",
+            socket_thread_num_, buffers_per_socket_);
+
+  rx_packets_.resize(socket_thread_num_);
+  for (size_t i = 0; i < socket_thread_num_; i++) {
+    // The first buffers_per_socket_ frames of the thread's RX buffer are its
+    // UMEM, so each received packet stays where the kernel wrote it
+    xdp_sockets_.at(i) = std::make_unique<XdpSocket>(
+        xdp_transport_.get(), cfg_->XdpQueueStart() + i,
+        reinterpret_cast<uint8_t*>(buffer[i]), buffers_per_socket_);
+    MLPD_INFO("TXRX thread %zu: AF_XDP socket on %s queue %zu (%s)\n", i,
+              cfg_->XdpInterface().c_str(), cfg_->XdpQueueStart() + i,
+              xdp_sockets_.at(i)->ZeroCopy() ? "zero-copy" : "copy mode");
+    rx_packets_.at(i).resize(xdp_sockets_.at(i)->NumRxFrames());
+
+    socket_std_threads_.at(i) = std::thread(&PacketTXRX::LoopTxRx, this, i);
+  }
+  return true;
+}
+
+void PacketTXRX::SendBeacon(int tid, size_t frame_id) {
+  if (tx_flows_.at(tid).has_value() == false) {
+    // The sender's address is not known yet
+    return;
+  }
+  XdpSocket* socket = xdp_sockets_.at(tid).get();
+  size_t radio_lo = tid * cfg_->NumRadios() / socket_thread_num_;
+  size_t radio_hi = (tid + 1) * cfg_->NumRadios() / socket_thread_num_;
+
+  for (size_t beacon_sym = 0; beacon_sym < cfg_->Frame().NumBeaconSyms();
+       beacon_sym++) {
+    for (size_t ant_id = radio_lo; ant_id < radio_hi; ant_id++) {
+      uint8_t* frame = socket->AllocTx();
+      if (frame == nullptr) {
+        MLPD_WARN("TXRX thread %d: no AF_XDP TX frame for beacon\n", tid);
+        return;
+      }
+      uint8_t* payload = frame + kXdpPayloadOffset;
+      std::memset(payload, 0, cfg_->PacketLength());
+      new (payload) Packet(frame_id, cfg_->Frame().GetBeaconSymbol(beacon_sym),
+                           0 /* cell_id */, ant_id);
+      size_t len = XdpTransport::WriteHeaders(
+          frame, tx_flows_.at(tid).value(), cfg_->BsServerPort() + ant_id,
+          cfg_->BsRruPort() + ant_id, cfg_->PacketLength());
+      socket->Send(frame, len);
+    }
+  }
+}
+
+void PacketTXRX::LoopTxRx(size_t tid) {
+  PinToCoreWithOffset(ThreadType::kWorkerTXRX, core_offset_, tid,
+                      cfg_->Placement());
+  size_t prev_frame_id = SIZE_MAX;
+  XdpSocket* socket = xdp_sockets_.at(tid).get();
+
+  while (cfg_->Running() == true) {
+    socket->Refill();
+    if (-1 != DequeueSend(tid)) {
+      continue;
+    }
+    XdpRecv(tid, prev_frame_id);
+  }
+}
+
+size_t PacketTXRX::XdpRecv(int tid, size_t& prev_frame_id) {
+  XdpSocket* socket = xdp_sockets_.at(tid).get();
+  uint64_t addrs[kXdpRxBatchSize];
+  uint32_t lens[kXdpRxBatchSize];
+  size_t nb_rx = socket->Recv(addrs, lens, kXdpRxBatchSize);
+
+  for (size_t i = 0; i < nb_rx; i++) {
+    const uint64_t frame_addr = addrs[i] & ~(kXdpFrameSize - 1);
+    uint8_t* eth_frame = socket->Umem() + addrs[i];
+    const auto* ip_hdr = reinterpret_cast<const iphdr*>(eth_frame + ETH_HLEN);
+
+    if (lens[i] != kXdpPayloadOffset + cfg_->PacketLength()) {
+      MLPD_ERROR("AF_XDP: Received %u bytes, expected %zu\n", lens[i],
+                 kXdpPayloadOffset + cfg_->PacketLength());
+      socket->Recycle(frame_addr);
+      continue;
+    }
+    if (ip_hdr->saddr != bs_rru_addr_) {
+      MLPD_ERROR("AF_XDP: Source addr does not match\n");
+      socket->Recycle(frame_addr);
+      continue;
+    }
+    if (ip_hdr->daddr != bs_server_addr_) {
+      MLPD_ERROR("AF_XDP: Destination addr does not match\n");
+      socket->Recycle(frame_addr);
+      continue;
+    }
+    if (tx_flows_.at(tid).has_value() == false) {
+      tx_flows_.at(tid) = XdpTransport::ReplyFlow(eth_frame);
+    }
+
+    // Move the payload back to a 64-byte boundary if the driver's headroom
+    // left it unaligned. The move stays inside the frame's headroom.
+    auto* payload = eth_frame + kXdpPayloadOffset;
+    if (reinterpret_cast<uintptr_t>(payload) % 64 != 0) {
+      auto* aligned = reinterpret_cast<uint8_t*>(
+          reinterpret_cast<uintptr_t>(payload) & ~uintptr_t{63});
+      std::memmove(aligned, payload, cfg_->PacketLength());
+      payload = aligned;
+    }
+
+    // Frames are only received after their packet was released, so the slot
+    // of the frame is always free
+    XdpRxPacket& rx = rx_packets_.at(tid).at(frame_addr / kXdpFrameSize);
+    RtAssert(rx.Set(socket, frame_addr, reinterpret_cast<Packet*>(payload)),
+             "AF_XDP: Received into a frame that is still in use");
+    rx.SetRxTimeNs(GetTime::RealtimeNs());
+    Packet* pkt = rx.RawPacket();
+    if (kDebugPrintInTask) {
+      std::printf("In TXRX thread %d: Received frame %d, symbol %d, ant %d\n",
+                  tid, pkt->frame_id_, pkt->symbol_id_, pkt->ant_id_);
+    }
+    pkt->ant_id_ += pkt->cell_id_ * ant_per_cell_;
+
+    if (kIsWorkerTimingEnabled) {
+      if (prev_frame_id == SIZE_MAX or pkt->frame_id_ > prev_frame_id) {
+        (*frame_start_)[tid][pkt->frame_id_ % kNumStatsFrames] =
+            GetTime::Rdtsc();
+        prev_frame_id = pkt->frame_id_;
+      }
+    }
+
+    rx.Use();
+    if (message_queue_->enqueue(
+            *rx_ptoks_[tid],
+            EventData(EventType::kPacketRX, rx_tag_t(rx).tag_)) == false) {
+      MLPD_ERROR("socket message enqueue failed\n");
+      throw std::runtime_error("PacketTXRX: socket message enqueue failed");
+    }
+  }
+  return nb_rx;
+}
+
+int PacketTXRX::DequeueSend(int tid) {
+  auto& c = cfg_;
+  EventData event;
+  if (task_queue_->try_dequeue_from_producer(*tx_ptoks_[tid], event) == false) {
+    return -1;
+  }
+  assert(event.event_type_ == EventType::kPacketTX);
+
+  size_t ant_id = gen_tag_t(event.tags_[0]).ant_id_;
+  size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+  size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+
+  size_t data_symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
+  size_t offset = (c->GetTotalDataSymbolIdxDl(frame_id, data_symbol_idx_dl) *
+                   c->BsAntNum()) +
+                  ant_id;
+
+  if (kDebugPrintInTask) {
+    std::printf(
+        "In TXRX thread %d: Transmitted frame %zu, symbol %zu, "
+        "ant %zu, tag %zu, offset: %zu, msg_queue_length: %zu\n",
+        tid, frame_id, symbol_id, ant_id, gen_tag_t(event.tags_[0]).tag_,
+        offset, message_queue_->size_approx());
+  }
+
+  char* cur_buffer_ptr = tx_buffer_ + offset * c->DlPacketLength();
+  auto* pkt = reinterpret_cast<Packet*>(cur_buffer_ptr);
+  new (pkt) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
+
+  if (tx_flows_.at(tid).has_value() == true) {
+    XdpSocket* socket = xdp_sockets_.at(tid).get();
+    uint8_t* frame = socket->AllocTx();
+    // TX frames come back once the kernel completes earlier sends
+    while (frame == nullptr && cfg_->Running() == true) {
+      frame = socket->AllocTx();
+    }
+    if (frame != nullptr) {
+      std::memcpy(frame + kXdpPayloadOffset, cur_buffer_ptr,
+                  c->DlPacketLength());
+      size_t len = XdpTransport::WriteHeaders(
+          frame, tx_flows_.at(tid).value(), c->BsServerPort() + ant_id,
+          c->BsRruPort() + ant_id, c->DlPacketLength());
+      socket->Send(frame, len);
+    }
+  } else {
+    MLPD_ERROR("TXRX thread %d: dropping frame %zu symbol %zu ant %zu, no "
+               "packet received from the sender yet\n",
+               tid, frame_id, symbol_id, ant_id);
+  }
+
+  RtAssert(
+      message_queue_->enqueue(*rx_ptoks_[tid],
+                              EventData(EventType::kPacketTX, event.tags_[0])),
+      "Socket message enqueue failed\n");
+  return event.tags_[0];
+}
@@ -14,8 +14,8 @@ static constexpr size_t kVarNodesSize = 1024 * 1024 * sizeof(int16_t);
 
 DoDecodeClient::DoDecodeClient(
     Config* in_config, int in_tid,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
     PhyStats* in_phy_stats, Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       demod_buffers_(demod_buffers),
@@ -40,7 +40,7 @@ EventData DoDecodeClient::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxDl(frame_id, symbol_idx_dl);
   const size_t cur_cb_id = (cb_id % cfg_->LdpcConfig().NumBlocksInSymbol());
   const size_t ue_id = (cb_id / cfg_->LdpcConfig().NumBlocksInSymbol());
-  const size_t frame_slot = (frame_id % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
 
   if (kDebugPrintInTask == true) {
     std::printf(
@@ -113,20 +113,21 @@ EventData DoDecodeClient::Launch(size_t tag) {
 
   if ((kEnableMac == false) && (kPrintPhyStats == true) &&
       (symbol_idx_dl >= cfg_->Frame().ClientDlPilotSymbols())) {
-    phy_stats_->UpdateDecodedBits(ue_id, symbol_offset,
+    phy_stats_->UpdateDecodedBits(tid_, ue_id, symbol_offset,
                                   cfg_->NumBytesPerCb() * 8);
-    phy_stats_->IncrementDecodedBlocks(ue_id, symbol_offset);
+    phy_stats_->IncrementDecodedBlocks(tid_, ue_id, symbol_offset);
     size_t block_error(0);
     for (size_t i = 0; i < cfg_->NumBytesPerCb(); i++) {
       uint8_t rx_byte = decoded_buffer_ptr[i];
       auto tx_byte = static_cast<uint8_t>(cfg_->GetInfoBits(
           cfg_->DlBits(), symbol_idx_dl, ue_id, cur_cb_id)[i]);
-      phy_stats_->UpdateBitErrors(ue_id, symbol_offset, tx_byte, rx_byte);
+      phy_stats_->UpdateBitErrors(tid_, ue_id, symbol_offset, tx_byte,
+                                  rx_byte);
       if (rx_byte != tx_byte) {
         block_error++;
       }
     }
-    phy_stats_->UpdateBlockErrors(ue_id, symbol_offset, block_error);
+    phy_stats_->UpdateBlockErrors(tid_, ue_id, symbol_offset, block_error);
   }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
@@ -21,9 +21,9 @@ static const size_t kDefaultQueueSize = 36;
 PhyUe::PhyUe(Config* config)
     : stats_(std::make_unique<Stats>(config)),
       phy_stats_(std::make_unique<PhyStats>(config)),
-      demod_buffer_(kFrameWnd, config->Frame().NumDLSyms(), config->UeAntNum(),
-                    kMaxModType * config->OfdmDataNum()),
-      decoded_buffer_(kFrameWnd, config->Frame().NumDLSyms(),
+      demod_buffer_(config->FrameWnd(), config->Frame().NumDLSyms(),
+                    config->UeAntNum(), kMaxModType * config->OfdmDataNum()),
+      decoded_buffer_(config->FrameWnd(), config->Frame().NumDLSyms(),
                       config->UeAntNum(),
                       config->LdpcConfig().NumBlocksInSymbol() *
                           Roundup<64>(config->NumBytesPerCb())) {
@@ -55,15 +55,15 @@ PhyUe::PhyUe(Config* config)
   }
 
   complete_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->Frame().NumTotalSyms() * config_->UeAntNum() *
-      kDefaultQueueSize);
+      config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+      config_->UeAntNum() * kDefaultQueueSize);
   work_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->Frame().NumTotalSyms() * config_->UeAntNum() *
-      kDefaultQueueSize);
+      config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+      config_->UeAntNum() * kDefaultQueueSize);
   tx_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->UeNum() * kDefaultQueueSize);
+      config_->FrameWnd() * config_->UeNum() * kDefaultQueueSize);
   to_mac_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->UeNum() * kDefaultQueueSize);
+      config_->FrameWnd() * config_->UeNum() * kDefaultQueueSize);
 
   for (size_t i = 0; i < rx_thread_num_; i++) {
     rx_ptoks_ptr_[i] = new moodycamel::ProducerToken(complete_queue_);
@@ -98,10 +98,10 @@ PhyUe::PhyUe(Config* config)
   for (size_t i = 0; i < config_->WorkerThreadNum(); i++) {
     auto new_worker = std::make_unique<UeWorker>(
         i, *config_, *stats_, *phy_stats_, complete_queue_, work_queue_,
-        *work_producer_token_.get(), ul_bits_buffer_, ul_syms_buffer_,
-        modul_buffer_, ifft_buffer_, tx_buffer_, rx_buffer_, csi_buffer_,
-        equal_buffer_, non_null_sc_ind_, fft_buffer_, demod_buffer_,
-        decoded_buffer_, ue_pilot_vec_);
+        *work_producer_token_.get(), work_parking_, ul_bits_buffer_,
+        ul_syms_buffer_, modul_buffer_, ifft_buffer_, tx_buffer_, rx_buffer_,
+        csi_buffer_, equal_buffer_, non_null_sc_ind_, fft_buffer_,
+        demod_buffer_, decoded_buffer_, ue_pilot_vec_);
 
     new_worker->Start(core_offset_worker);
     workers_.push_back(std::move(new_worker));
@@ -109,40 +109,48 @@ PhyUe::PhyUe(Config* config)
 
   // initilize all kinds of checkers
   // Init the frame work tracking structure
+  frame_tasks_.resize(config_->FrameWnd());
   for (size_t frame = 0; frame < this->frame_tasks_.size(); frame++) {
     FrameInit(frame);
   }
-  decode_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
-  demul_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
-  fft_dlpilot_counters_.Init(config->Frame().ClientDlPilotSymbols(),
+  const size_t frame_wnd = config_->FrameWnd();
+  decode_counters_.Init(frame_wnd, dl_data_symbol_perframe_,
+                        config_->UeAntNum());
+  demul_counters_.Init(frame_wnd, dl_data_symbol_perframe_,
+                       config_->UeAntNum());
+  fft_dlpilot_counters_.Init(frame_wnd, config->Frame().ClientDlPilotSymbols(),
                              config_->UeAntNum());
-  fft_dldata_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
+  fft_dldata_counters_.Init(frame_wnd, dl_data_symbol_perframe_,
+                            config_->UeAntNum());
 
-  tx_counters_.Init(config_->UeNum());
-  encode_counter_.Init(ul_data_symbol_perframe_, config_->UeNum());
-  modulation_counters_.Init(ul_data_symbol_perframe_, config_->UeNum());
+  tx_counters_.Init(frame_wnd, config_->UeNum());
+  encode_counter_.Init(frame_wnd, ul_data_symbol_perframe_, config_->UeNum());
+  modulation_counters_.Init(frame_wnd, ul_data_symbol_perframe_,
+                            config_->UeNum());
 
   const size_t num_ue = config_->UeNum();
   ue_tracker_.reserve(num_ue);
   ue_tracker_.resize(num_ue);
   for (auto& ue : ue_tracker_) {
     //Might want to change the 1 to NumChannels or channels per ue
-    ue.ifft_counters_.Init(ul_symbol_perframe_, 1);
+    ue.ifft_counters_.Init(frame_wnd, ul_symbol_perframe_, 1);
     ue.tx_pending_frame_ = 0;
     ue.tx_ready_frames_.clear();
   }
 
   // This usage doesn't effect the user num_reciprocity_pkts_per_frame_;
+  rx_counters_.Init(frame_wnd);
   rx_counters_.num_pkts_per_frame_ =
       config_->UeAntNum() *
       (config_->Frame().NumDLSyms() + config_->Frame().NumBeaconSyms());
   rx_counters_.num_pilot_pkts_per_frame_ =
       config_->UeAntNum() * config_->Frame().ClientDlPilotSymbols();
 
-  rx_downlink_deferral_.resize(kFrameWnd);
+  rx_downlink_deferral_.resize(frame_wnd);
 
   //Mac counters for downlink data
-  tomac_counters_.Init(config_->Frame().NumDlDataSyms(), config_->UeAntNum());
+  tomac_counters_.Init(frame_wnd, config_->Frame().NumDlDataSyms(),
+                       config_->UeAntNum());
 }
 
 PhyUe::~PhyUe() {
@@ -189,10 +197,11 @@ void PhyUe::ScheduleWork(EventData do_task) {
       throw std::runtime_error("PhyUe: work task enqueue failed");
     }
   }
+  work_parking_.Wake();
 }
 
 void PhyUe::ReceiveDownlinkSymbol(struct Packet* rx_packet, size_t tag) {
-  const size_t frame_slot = rx_packet->frame_id_ % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(rx_packet->frame_id_);
   const size_t dl_symbol_idx =
       config_->Frame().GetDLSymbolIdx(rx_packet->symbol_id_);
 
@@ -211,7 +220,7 @@ void PhyUe::ReceiveDownlinkSymbol(struct Packet* rx_packet, size_t tag) {
 }
 
 void PhyUe::ScheduleDefferedDownlinkSymbols(size_t frame_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   // Complete the csi offset
   size_t csi_offset = frame_slot * config_->UeAntNum();
 
@@ -234,7 +243,7 @@ void PhyUe::ScheduleDefferedDownlinkSymbols(size_t frame_id) {
 }
 
 void PhyUe::ClearCsi(size_t frame_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
 
   if (config_->Frame().ClientDlPilotSymbols() > 0) {
     size_t csi_offset = frame_slot * config_->UeAntNum();
@@ -256,6 +265,7 @@ void PhyUe::ClearCsi(size_t frame_id) {
 void PhyUe::Stop() {
   std::cout << "PhyUe: Stopping threads " << std::endl;
   config_->Running(false);
+  work_parking_.Wake();
   usleep(1000);
   ru_.reset();
 }
@@ -314,8 +324,8 @@ void PhyUe::Start() {
           size_t symbol_id = pkt->symbol_id_;
           size_t ant_id = pkt->ant_id_;
           size_t ue_id = ant_id / config_->NumChannels();
-          size_t frame_slot = frame_id % kFrameWnd;
-          RtAssert(pkt->frame_id_ < (cur_frame_id + kFrameWnd),
+          size_t frame_slot = config_->FrameSlot(frame_id);
+          RtAssert(pkt->frame_id_ < (cur_frame_id + config_->FrameWnd()),
                    "Error: Received packet for future frame beyond frame "
                    "window. This can happen if PHY is running "
                    "slowly, e.g., in debug mode");
@@ -326,7 +336,7 @@ void PhyUe::Start() {
             this->stats_->MasterSetTsc(TsType::kFirstSymbolRX, frame_id);
             if (kDebugPrintPerFrameStart) {
               const size_t prev_frame_slot =
-                  (frame_slot + kFrameWnd - 1) % kFrameWnd;
+                  config_->FrameSlot(frame_id - 1);
               std::printf(
                   "PhyUe [frame %zu + %.2f ms since last frame]: Received "
                   "first packet. Remaining packets in prev frame: %zu\n",
@@ -558,7 +568,8 @@ void PhyUe::Start() {
           // This is an entrie frame (multiple mac packets)
           size_t ue_id = rx_mac_tag_t(event.tags_[0]).tid_;
           size_t radio_buf_id = rx_mac_tag_t(event.tags_[0]).offset_;
-          RtAssert(radio_buf_id == expected_frame_id_from_mac_ % kFrameWnd);
+          RtAssert(radio_buf_id ==
+                   config_->FrameSlot(expected_frame_id_from_mac_));
 
           auto* pkt = reinterpret_cast<MacPacket*>(
               &ul_bits_buffer_[ue_id][radio_buf_id *
@@ -734,8 +745,8 @@ void PhyUe::Start() {
           RtAssert(frame_id == next_frame_processed_[ue_id],
                    "PhyUe: Unexpected frame was transmitted!");
 
-          ul_bits_buffer_status_[ue_id]
-                                [next_frame_processed_[ue_id] % kFrameWnd] = 0;
+          ul_bits_buffer_status_[ue_id][config_->FrameSlot(
+              next_frame_processed_[ue_id])] = 0;
           next_frame_processed_[ue_id]++;
 
           PrintPerTaskDone(PrintType::kPacketTX, frame_id, 0, ue_id);
@@ -785,29 +796,29 @@ void PhyUe::InitializeVarsFromCfg() {
                        : std::min(config_->UeNum(), config_->SocketThreadNum());
 
   tx_buffer_status_size_ =
-      (ul_symbol_perframe_ * config_->UeAntNum() * kFrameWnd);
+      (ul_symbol_perframe_ * config_->UeAntNum() * config_->FrameWnd());
   tx_buffer_size_ = config_->PacketLength() * tx_buffer_status_size_;
 
   rx_buffer_size_ = config_->PacketLength() *
                     (dl_symbol_perframe_ + config_->Frame().NumBeaconSyms()) *
-                    config_->UeAntNum() * kFrameWnd;
+                    config_->UeAntNum() * config_->FrameWnd();
 }
 
 void PhyUe::InitializeUplinkBuffers() {
   // initialize ul data buffer
-  ul_bits_buffer_size_ = kFrameWnd * config_->UlMacBytesNumPerframe();
+  ul_bits_buffer_size_ = config_->FrameWnd() * config_->UlMacBytesNumPerframe();
   ul_bits_buffer_.Malloc(config_->UeAntNum(), ul_bits_buffer_size_,
                          Agora_memory::Alignment_t::kAlign64);
-  ul_bits_buffer_status_.Calloc(config_->UeAntNum(), kFrameWnd,
+  ul_bits_buffer_status_.Calloc(config_->UeAntNum(), config_->FrameWnd(),
                                 Agora_memory::Alignment_t::kAlign64);
 
   // Temp -- Using more memory than necessary to comply with the DoEncode
   // function which uses the total number of ul symbols offset (instead of
   // just the data specific ones) ul_syms_buffer_size_ =
-  //    kFrameWnd * ul_symbol_perframe_ * config_->OfdmDataNum();
+  //    config_->FrameWnd() * ul_symbol_perframe_ * config_->OfdmDataNum();
   // ul_syms_buffer_.Calloc(config_->UeAntNum(), ul_syms_buffer_size_,
   //                       Agora_memory::Alignment_t::kAlign64);
-  const size_t ul_syms_buffer_dim1 = ul_symbol_perframe_ * kFrameWnd;
+  const size_t ul_syms_buffer_dim1 = ul_symbol_perframe_ * config_->FrameWnd();
   const size_t ul_syms_buffer_dim2 =
       Roundup<64>(config_->OfdmDataNum()) * config_->UeAntNum();
 
@@ -821,7 +832,7 @@ void PhyUe::InitializeUplinkBuffers() {
 
   // initialize IFFT buffer
   size_t ifft_buffer_block_num =
-      config_->UeAntNum() * ul_symbol_perframe_ * kFrameWnd;
+      config_->UeAntNum() * ul_symbol_perframe_ * config_->FrameWnd();
   ifft_buffer_.Calloc(ifft_buffer_block_num, config_->OfdmCaNum(),
                       Agora_memory::Alignment_t::kAlign64);
 
@@ -849,12 +860,12 @@ void PhyUe::InitializeDownlinkBuffers() {
 
   // initialize FFT buffer
   size_t fft_buffer_block_num =
-      config_->UeAntNum() * dl_symbol_perframe_ * kFrameWnd;
+      config_->UeAntNum() * dl_symbol_perframe_ * config_->FrameWnd();
   fft_buffer_.Calloc(fft_buffer_block_num, config_->OfdmCaNum(),
                      Agora_memory::Alignment_t::kAlign64);
 
   // initialize CSI buffer
-  csi_buffer_.resize(config_->UeAntNum() * kFrameWnd);
+  csi_buffer_.resize(config_->UeAntNum() * config_->FrameWnd());
   for (auto& i : csi_buffer_) {
     i.resize(config_->OfdmDataNum());
 
@@ -872,7 +883,7 @@ void PhyUe::InitializeDownlinkBuffers() {
   if (dl_data_symbol_perframe_ > 0) {
     // initialize equalized data buffer
     const size_t task_buffer_symbol_num_dl =
-        dl_data_symbol_perframe_ * kFrameWnd;
+        dl_data_symbol_perframe_ * config_->FrameWnd();
     size_t buffer_size = config_->UeAntNum() * task_buffer_symbol_num_dl;
     equal_buffer_.resize(buffer_size);
     for (auto& i : equal_buffer_) {
@@ -1145,13 +1156,14 @@ void PhyUe::FrameInit(size_t frame) {
   if ((kEnableMac == false) || (config_->Frame().NumDLSyms() == 0)) {
     initial |= static_cast<std::uint8_t>(FrameTasksFlags::kMacTxComplete);
   }
-  frame_tasks_.at(frame % kFrameWnd) = initial;
+  frame_tasks_.at(config_->FrameSlot(frame)) = initial;
 }
 
 bool PhyUe::FrameComplete(size_t frame, FrameTasksFlags complete) {
-  frame_tasks_.at(frame % kFrameWnd) |= static_cast<std::uint8_t>(complete);
+  frame_tasks_.at(config_->FrameSlot(frame)) |=
+      static_cast<std::uint8_t>(complete);
   bool is_complete =
-      (frame_tasks_.at(frame % kFrameWnd) ==
+      (frame_tasks_.at(config_->FrameSlot(frame)) ==
        static_cast<std::uint8_t>(FrameTasksFlags::kFrameComplete));
   return is_complete;
 }
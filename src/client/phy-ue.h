@@ -99,7 +99,7 @@ class PhyUe {
   size_t dl_symbol_perframe_;
   size_t rx_thread_num_;
 
-  std::array<std::uint8_t, kFrameWnd> frame_tasks_;
+  std::vector<std::uint8_t> frame_tasks_;
 
   // The thread running MAC layer functions
   std::unique_ptr<MacThreadClient> mac_thread_;
@@ -133,14 +133,14 @@ class PhyUe {
   /**
    * Data for IFFT, (prefix added)
    * First dimension: IFFT_buffer_block_num = BS_ANT_NUM *
-   *   dl_data_symbol_perframe * kFrameWnd
+   *   dl_data_symbol_perframe * frame window
    * Second dimension: OFDM_CA_NUM
    */
   Table<complex_float> ifft_buffer_;
 
   /**
    * Data before modulation
-   * First dimension: data_symbol_num_perframe * kFrameWnd
+   * First dimension: data_symbol_num_perframe * frame window
    * Second dimension: OFDM_CA_NUM * UE_NUM
    */
   Table<int8_t> ul_bits_buffer_;
@@ -151,7 +151,7 @@ class PhyUe {
   size_t ul_syms_buffer_size_;
   /**
    * Data after modulation
-   * First dimension: data_symbol_num_perframe * kFrameWnd
+   * First dimension: data_symbol_num_perframe * frame window
    * Second dimension: OFDM_CA_NUM * UE_NUM
    */
   Table<complex_float> modul_buffer_;
@@ -172,31 +172,31 @@ class PhyUe {
   /**
    * Data for FFT, after time sync (prefix removed)
    * First dimension: FFT_buffer_block_num = BS_ANT_NUM *
-   * symbol_num_perframe * kFrameWnd Second dimension:
+   * symbol_num_perframe * frame window Second dimension:
    * OFDM_CA_NUM
    */
   Table<complex_float> fft_buffer_;
 
   /**
    * Estimated CSI data
-   * First dimension: OFDM_CA_NUM * kFrameWnd
+   * First dimension: OFDM_CA_NUM * frame window
    * Second dimension: BS_ANT_NUM * UE_NUM
    */
   std::vector<myVec> csi_buffer_;
 
   /**
    * Data after equalization
-   * First dimension: data_symbol_num_perframe * kFrameWnd
+   * First dimension: data_symbol_num_perframe * frame window
    * Second dimension: OFDM_CA_NUM * UE_NUM
    */
   std::vector<myVec> equal_buffer_;
 
   // Data after demodulation. Each buffer has kMaxModType * number of OFDM
   // data subcarriers
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> demod_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t> demod_buffer_;
 
   // Data after LDPC decoding. Each buffer [decoded bytes per UE] bytes.
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> decoded_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t> decoded_buffer_;
 
   std::vector<size_t> non_null_sc_ind_;
   std::vector<std::vector<std::complex<float>>> ue_pilot_vec_;
@@ -204,6 +204,7 @@ class PhyUe {
   // Communication queues
   moodycamel::ConcurrentQueue<EventData> complete_queue_;
   moodycamel::ConcurrentQueue<EventData> work_queue_;
+  WorkerParking work_parking_;
 
   moodycamel::ConcurrentQueue<EventData> tx_queue_;
   moodycamel::ConcurrentQueue<EventData> to_mac_queue_;
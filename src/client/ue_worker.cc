@@ -28,20 +28,21 @@ UeWorker::UeWorker(
     size_t tid, Config& config, Stats& shared_stats, PhyStats& shared_phy_stats,
     moodycamel::ConcurrentQueue<EventData>& notify_queue,
     moodycamel::ConcurrentQueue<EventData>& work_queue,
-    moodycamel::ProducerToken& work_producer, Table<int8_t>& ul_bits_buffer,
-    Table<int8_t>& encoded_buffer, Table<complex_float>& modul_buffer,
-    Table<complex_float>& ifft_buffer, char* const tx_buffer,
-    Table<char>& rx_buffer, std::vector<myVec>& csi_buffer,
-    std::vector<myVec>& equal_buffer, std::vector<size_t>& non_null_sc_ind,
-    Table<complex_float>& fft_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    moodycamel::ProducerToken& work_producer, WorkerParking& work_parking,
+    Table<int8_t>& ul_bits_buffer, Table<int8_t>& encoded_buffer,
+    Table<complex_float>& modul_buffer, Table<complex_float>& ifft_buffer,
+    char* const tx_buffer, Table<char>& rx_buffer,
+    std::vector<myVec>& csi_buffer, std::vector<myVec>& equal_buffer,
+    std::vector<size_t>& non_null_sc_ind, Table<complex_float>& fft_buffer,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
     std::vector<std::vector<std::complex<float>>>& ue_pilot_vec)
     : tid_(tid),
       thread_(),
       notify_queue_(notify_queue),
       work_queue_(work_queue),
       work_producer_token_(work_producer),
+      work_parking_(work_parking),
       config_(config),
       stats_(shared_stats),
       phy_stats_(shared_phy_stats),
@@ -95,7 +96,7 @@ void UeWorker::TaskThread(size_t core_offset) {
   auto encoder = std::make_unique<DoEncode>(
       &config_, (int)tid_,
       (kEnableMac == true) ? ul_bits_buffer_ : config_.UlBits(),
-      (kEnableMac == true) ? kFrameWnd : 1, encoded_buffer_, &stats_);
+      (kEnableMac == true) ? config_.FrameWnd() : 1, encoded_buffer_, &stats_);
 
   auto iffter = std::make_unique<DoIFFTClient>(
       &config_, (int)tid_, ifft_buffer_, tx_buffer_, &stats_);
@@ -104,10 +105,16 @@ void UeWorker::TaskThread(size_t core_offset) {
       std::make_unique<DoDecodeClient>(&config_, (int)tid_, demod_buffer_,
                                        decoded_buffer_, &phy_stats_, &stats_);
 
+  WorkerIdler idler(&work_parking_, config_.WorkerIdleSpinPolls(),
+                    config_.WorkerIdlePausePolls(),
+                    config_.WorkerParkTimeoutUs());
   EventData event;
   while (config_.Running() == true) {
     if (work_queue_.try_dequeue_from_producer(work_producer_token_, event) ==
-        true) {
+        false) {
+      idler.Idle();
+    } else {
+      idler.Busy();
       switch (event.event_type_) {
         case EventType::kDecode: {
           DoDecodeUe(decoder.get(), event.tags_[0]);
@@ -152,7 +159,7 @@ void UeWorker::DoFftData(size_t tag) {
   size_t frame_id = pkt->frame_id_;
   size_t symbol_id = pkt->symbol_id_;
   size_t ant_id = pkt->ant_id_;
-  size_t frame_slot = frame_id % kFrameWnd;
+  size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask || kDebugPrintFft) {
     std::printf("UeWorker[%zu]: Fft Data(frame %zu, symbol %zu, ant %zu)\n",
@@ -284,7 +291,7 @@ void UeWorker::DoFftPilot(size_t tag) {
   size_t frame_id = pkt->frame_id_;
   size_t symbol_id = pkt->symbol_id_;
   size_t ant_id = pkt->ant_id_;
-  size_t frame_slot = frame_id % kFrameWnd;
+  size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask || kDebugPrintFft) {
     std::printf("UeWorker[%zu]: Fft Pilot(frame %zu, symbol %zu, ant %zu)\n",
@@ -391,7 +398,7 @@ void UeWorker::DoDemul(size_t tag) {
   }
   size_t start_tsc = GetTime::Rdtsc();
 
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_.FrameSlot(frame_id);
   size_t dl_symbol_id = config_.Frame().GetDLSymbolIdx(symbol_id);
   size_t dl_data_symbol_perframe = config_.Frame().NumDlDataSyms();
   size_t total_dl_symbol_id = frame_slot * dl_data_symbol_perframe +
@@ -598,7 +605,7 @@ void UeWorker::DoIfft(size_t tag) {
   const size_t symbol_id = gen_tag_t(tag).symbol_id_;
   const size_t user_id = gen_tag_t(tag).ue_id_;
 
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask) {
     std::printf("User Task[%zu]: iFFT   (frame %zu, symbol %zu, user %zu)\n",
@@ -18,6 +18,7 @@
 #include "doifft_client.h"
 #include "mkl_dfti.h"
 #include "stats.h"
+#include "worker_parking.h"
 
 static const size_t kVectorAlignment = 64;
 using myVec = std::vector<complex_float, boost::alignment::aligned_allocator<
@@ -30,14 +31,14 @@ class UeWorker {
       PhyStats& shared_phy_stats,
       moodycamel::ConcurrentQueue<EventData>& notify_queue,
       moodycamel::ConcurrentQueue<EventData>& work_queue,
-      moodycamel::ProducerToken& work_producer, Table<int8_t>& ul_bits_buffer,
-      Table<int8_t>& encoded_buffer, Table<complex_float>& modul_buffer,
-      Table<complex_float>& ifft_buffer, char* const tx_buffer,
-      Table<char>& rx_buffer, std::vector<myVec>& csi_buffer,
-      std::vector<myVec>& equal_buffer, std::vector<size_t>& non_null_sc_ind,
-      Table<complex_float>& fft_buffer,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+      moodycamel::ProducerToken& work_producer, WorkerParking& work_parking,
+      Table<int8_t>& ul_bits_buffer, Table<int8_t>& encoded_buffer,
+      Table<complex_float>& modul_buffer, Table<complex_float>& ifft_buffer,
+      char* const tx_buffer, Table<char>& rx_buffer,
+      std::vector<myVec>& csi_buffer, std::vector<myVec>& equal_buffer,
+      std::vector<size_t>& non_null_sc_ind, Table<complex_float>& fft_buffer,
+      PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
+      PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
       std::vector<std::vector<std::complex<float>>>& ue_pilot_vec);
   ~UeWorker();
 
@@ -129,6 +130,8 @@ class UeWorker {
   moodycamel::ConcurrentQueue<EventData>& notify_queue_;
   moodycamel::ConcurrentQueue<EventData>& work_queue_;
   moodycamel::ProducerToken& work_producer_token_;
+  // Idle workers park here until work is scheduled
+  WorkerParking& work_parking_;
 
   // Shared Objects
   Config& config_;
@@ -149,8 +152,8 @@ class UeWorker {
   std::vector<myVec>& equal_buffer_;
   std::vector<size_t>& non_null_sc_ind_;
   Table<complex_float>& fft_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
 
   std::vector<std::vector<std::complex<float>>>& ue_pilot_vec_;
 };
@@ -0,0 +1,374 @@
+/**
+ * @file async_logger.cc
+ * @brief Implementation file for the AsyncLogger class.
+ */
+#include "async_logger.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "logger.h"
+
+// How long the background thread sleeps when no messages are queued
+static constexpr auto kIdleSleep = std::chrono::milliseconds(1);
+// Messages longer than this are truncated
+static constexpr size_t kMaxMessageLen = 1024;
+
+static std::thread logger_thread;
+// Dropped messages that the background thread has reported
+static size_t reported_drops = 0;
+
+// Conversion from TSC to CLOCK_REALTIME, measured by Start()
+static uint64_t base_tsc;
+static uint64_t base_realtime_ns;
+static double tsc_per_ns = 1.0;
+
+static uint64_t RealtimeNs() {
+  timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  return (static_cast<uint64_t>(t.tv_sec) * 1000000000) + t.tv_nsec;
+}
+
+void AsyncLogger::Start() {
+  if (Running() == true) {
+    return;
+  }
+  // Measure the TSC frequency to timestamp the messages
+  const uint64_t start_tsc = __rdtsc();
+  const uint64_t start_ns = RealtimeNs();
+  usleep(10000);
+  base_tsc = __rdtsc();
+  base_realtime_ns = RealtimeNs();
+  tsc_per_ns = static_cast<double>(base_tsc - start_tsc) /
+               static_cast<double>(base_realtime_ns - start_ns);
+
+  running_.store(true);
+  logger_thread = std::thread(&AsyncLogger::Loop);
+  // Write the queued messages if the process exits while the logger runs
+  static std::once_flag stop_at_exit;
+  std::call_once(stop_at_exit, []() { std::atexit(&AsyncLogger::Stop); });
+}
+
+void AsyncLogger::Stop() {
+  if (Running() == false) {
+    return;
+  }
+  running_.store(false);
+  logger_thread.join();
+}
+
+size_t AsyncLogger::NumDropped() {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  size_t total = 0;
+  for (const auto& ring : rings_) {
+    total += ring->dropped_.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+AsyncLogger::Ring* AsyncLogger::NewRing() {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  rings_.push_back(std::make_unique<Ring>());
+  return rings_.back().get();
+}
+
+void AsyncLogger::AddString(LogRecord& record, size_t i, const char* str) {
+  record.arg_types_[i] = LogRecord::ArgType::kString;
+  record.args_[i] = record.strings_len_;
+  const size_t space = sizeof(record.strings_) - record.strings_len_;
+  if (space == 0) {
+    // No room for even the terminator: point at the last one written
+    record.args_[i] = sizeof(record.strings_) - 1;
+    return;
+  }
+  const char* src = (str != nullptr) ? str : "(null)";
+  const size_t len = std::min(std::strlen(src), space - 1);
+  std::memcpy(record.strings_ + record.strings_len_, src, len);
+  record.strings_[record.strings_len_ + len] = '\0';
+  record.strings_len_ += len + 1;
+}
+
+void AsyncLogger::Loop() {
+  while (Running() == true) {
+    if (Drain() == 0) {
+      std::this_thread::sleep_for(kIdleSleep);
+    }
+    const size_t drops = NumDropped();
+    if (drops > reported_drops) {
+      std::fprintf(MLPD_LOG_DEFAULT_STREAM,
+                   "AsyncLogger: dropped %zu messages, since a logging "
+                   "thread's ring was full\n",
+                   drops - reported_drops);
+      reported_drops = drops;
+    }
+  }
+  // Write the messages queued before Stop()
+  while (Drain() > 0) {
+  }
+}
+
+size_t AsyncLogger::Drain() {
+  std::vector<Ring*> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (const auto& ring : rings_) {
+      snapshot.push_back(ring.get());
+    }
+  }
+  // The queued messages of each ring, which are written oldest first across
+  // the rings
+  std::vector<size_t> heads(snapshot.size());
+  std::vector<size_t> tails(snapshot.size());
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    heads.at(i) = snapshot.at(i)->head_.load(std::memory_order_relaxed);
+    tails.at(i) = snapshot.at(i)->tail_.load(std::memory_order_acquire);
+  }
+
+  size_t num_written = 0;
+  char message[kMaxMessageLen];
+  while (true) {
+    size_t oldest = SIZE_MAX;
+    for (size_t i = 0; i < snapshot.size(); i++) {
+      if ((heads.at(i) < tails.at(i)) &&
+          ((oldest == SIZE_MAX) ||
+           (snapshot.at(i)->records_[heads.at(i) % kRingSlots].tsc_ <
+            snapshot.at(oldest)->records_[heads.at(oldest) % kRingSlots]
+                .tsc_))) {
+        oldest = i;
+      }
+    }
+    if (oldest == SIZE_MAX) {
+      break;
+    }
+
+    Ring* ring = snapshot.at(oldest);
+    const LogRecord& record = ring->records_[heads.at(oldest) % kRingSlots];
+    const size_t len = Format(record, message, sizeof(message));
+    const auto ns_since_base = static_cast<int64_t>(
+        static_cast<double>(static_cast<int64_t>(record.tsc_ - base_tsc)) /
+        tsc_per_ns);
+    const uint64_t realtime_ns = base_realtime_ns + ns_since_base;
+    // Same header as MlpdOutputLogHeader()
+    std::fprintf(record.stream_, "%u:%06u %s: ",
+                 static_cast<unsigned>((realtime_ns / 1000000000) % 100),
+                 static_cast<unsigned>((realtime_ns / 1000) % 1000000),
+                 MlpdLogLevelName(record.level_));
+    std::fwrite(message, 1, len, record.stream_);
+
+    heads.at(oldest)++;
+    ring->head_.store(heads.at(oldest), std::memory_order_release);
+    num_written++;
+  }
+  if (num_written > 0) {
+    std::fflush(nullptr);
+  }
+  return num_written;
+}
+
+/// Sign-extend or zero-extend integer argument i of record to 64 bits, as
+/// printf would convert it for a signed or unsigned conversion
+static int64_t SignedArg(const LogRecord& record, size_t i) {
+  const uint64_t bits = record.args_[i];
+  switch (record.arg_types_[i]) {
+    case LogRecord::ArgType::kDouble: {
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return static_cast<int64_t>(value);
+    }
+    case LogRecord::ArgType::kSigned:
+    case LogRecord::ArgType::kUnsigned:
+      switch (record.arg_sizes_[i]) {
+        case 1:
+          return static_cast<int8_t>(bits);
+        case 2:
+          return static_cast<int16_t>(bits);
+        case 4:
+          return static_cast<int32_t>(bits);
+        default:
+          return static_cast<int64_t>(bits);
+      }
+    default:
+      return static_cast<int64_t>(bits);
+  }
+}
+
+static uint64_t UnsignedArg(const LogRecord& record, size_t i) {
+  const uint64_t bits = record.args_[i];
+  switch (record.arg_types_[i]) {
+    case LogRecord::ArgType::kDouble:
+      return static_cast<uint64_t>(SignedArg(record, i));
+    case LogRecord::ArgType::kSigned:
+    case LogRecord::ArgType::kUnsigned:
+      switch (record.arg_sizes_[i]) {
+        case 1:
+          return static_cast<uint8_t>(bits);
+        case 2:
+          return static_cast<uint16_t>(bits);
+        case 4:
+          return static_cast<uint32_t>(bits);
+        default:
+          return bits;
+      }
+    default:
+      return bits;
+  }
+}
+
+static double DoubleArg(const LogRecord& record, size_t i) {
+  switch (record.arg_types_[i]) {
+    case LogRecord::ArgType::kDouble: {
+      double value;
+      std::memcpy(&value, &record.args_[i], sizeof(value));
+      return value;
+    }
+    case LogRecord::ArgType::kSigned:
+      return static_cast<double>(SignedArg(record, i));
+    default:
+      return static_cast<double>(UnsignedArg(record, i));
+  }
+}
+
+size_t AsyncLogger::Format(const LogRecord& record, char* buf, size_t size) {
+  size_t len = 0;
+  // Append the output of snprintf, which may be truncated
+  auto append = [&](int ret) {
+    if (ret > 0) {
+      len = std::min(size - 1, len + static_cast<size_t>(ret));
+    }
+  };
+  size_t arg = 0;
+  const char* p = record.format_;
+  while ((*p != '\0') && (len + 1 < size)) {
+    if (*p != '%') {
+      buf[len++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      buf[len++] = '%';
+      p += 2;
+      continue;
+    }
+
+    // Rebuild the conversion %[flags][width][.precision][length]type with
+    // the length that matches the stored argument. Repeated flags are
+    // dropped and the width and precision are clamped to the message length,
+    // so the longest conversion, e.g., "%-+ #0'-1024.1024llx", fits in spec.
+    char spec[32];
+    size_t spec_len = 0;
+    const char* spec_begin = p;
+    spec[spec_len++] = *p++;
+    // Parse a whole number or '*' argument, clamped to the message length
+    auto parse_number = [&]() {
+      long value = 0;
+      if (*p == '*') {
+        value = (arg < record.num_args_) ? SignedArg(record, arg) : 0;
+        arg++;
+        p++;
+      }
+      while ((*p >= '0') && (*p <= '9')) {
+        value = std::min(static_cast<long>(kMaxMessageLen),
+                         (value * 10) + (*p - '0'));
+        p++;
+      }
+      return std::max(-static_cast<long>(kMaxMessageLen),
+                      std::min(static_cast<long>(kMaxMessageLen), value));
+    };
+    while ((*p != '\0') && (std::strchr("-+ #0'", *p) != nullptr)) {
+      if (std::memchr(spec, *p, spec_len) == nullptr) {
+        spec[spec_len++] = *p;
+      }
+      p++;
+    }
+    if ((*p == '*') || ((*p >= '0') && (*p <= '9'))) {
+      spec_len += std::snprintf(spec + spec_len, sizeof(spec) - spec_len,
+                                "%ld", parse_number());
+    }
+    if (*p == '.') {
+      p++;
+      const long precision = parse_number();
+      // A negative precision argument is taken as if it were omitted
+      if (precision >= 0) {
+        spec_len += std::snprintf(spec + spec_len, sizeof(spec) - spec_len,
+                                  ".%ld", precision);
+      }
+    }
+    while ((*p != '\0') && (std::strchr("hlLqjzt", *p) != nullptr)) {
+      p++;
+    }
+    const char conversion = *p;
+    if (conversion == '\0') {
+      break;
+    }
+    p++;
+
+    if (arg >= record.num_args_) {
+      // Print the conversion as is, like a missing argument in a log line
+      append(std::snprintf(buf + len, size - len, "%.*s",
+                           static_cast<int>(p - spec_begin), spec_begin));
+      continue;
+    }
+    const size_t i = arg++;
+    char* out = buf + len;
+    const size_t out_size = size - len;
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        std::strcpy(spec + spec_len, "lld");
+        append(std::snprintf(out, out_size, spec,
+                             static_cast<long long>(SignedArg(record, i))));
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        spec[spec_len++] = 'l';
+        spec[spec_len++] = 'l';
+        spec[spec_len++] = conversion;
+        spec[spec_len] = '\0';
+        append(std::snprintf(
+            out, out_size, spec,
+            static_cast<unsigned long long>(UnsignedArg(record, i))));
+        break;
+      case 'c':
+        std::strcpy(spec + spec_len, "c");
+        append(std::snprintf(out, out_size, spec,
+                             static_cast<int>(UnsignedArg(record, i))));
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        spec[spec_len++] = conversion;
+        spec[spec_len] = '\0';
+        append(std::snprintf(out, out_size, spec, DoubleArg(record, i)));
+        break;
+      case 's':
+        std::strcpy(spec + spec_len, "s");
+        append(std::snprintf(
+            out, out_size, spec,
+            (record.arg_types_[i] == LogRecord::ArgType::kString)
+                ? record.strings_ + record.args_[i]
+                : "(invalid)"));
+        break;
+      case 'p':
+        std::strcpy(spec + spec_len, "p");
+        append(std::snprintf(out, out_size, spec,
+                             reinterpret_cast<void*>(record.args_[i])));
+        break;
+      default:
+        // %n and unknown conversions print nothing, but take an argument
+        break;
+    }
+  }
+  buf[len] = '\0';
+  return len;
+}
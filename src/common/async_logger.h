@@ -0,0 +1,174 @@
+/**
+ * @file async_logger.h
+ * @brief Declaration file for the AsyncLogger class, which moves formatting
+ * and writing log messages off the logging threads.
+ */
+#ifndef ASYNC_LOGGER_H_
+#define ASYNC_LOGGER_H_
+
+#include <x86intrin.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief One log message: the format string, the TSC at which it was
+ * logged, and the raw arguments. String arguments are copied into
+ * strings_, since they may not outlive the call.
+ */
+struct LogRecord {
+  static constexpr size_t kMaxArgs = 12;
+  static constexpr size_t kSize = 256;
+
+  enum class ArgType : uint8_t {
+    kSigned,
+    kUnsigned,
+    kDouble,
+    kString,
+    kPointer
+  };
+
+  const char* format_;
+  uint64_t tsc_;
+  FILE* stream_;
+  // Integer and pointer bits, doubles, or offsets into strings_
+  std::array<uint64_t, kMaxArgs> args_;
+  uint8_t level_;
+  uint8_t num_args_;
+  // Number of bytes used in strings_
+  uint16_t strings_len_;
+  std::array<ArgType, kMaxArgs> arg_types_;
+  // The size in bytes of each integer argument, so that it is converted
+  // like printf would convert it
+  std::array<uint8_t, kMaxArgs> arg_sizes_;
+  // The rest of the record holds the string arguments. Longer strings are
+  // truncated.
+  char strings_[108];
+};
+static_assert(sizeof(LogRecord) == LogRecord::kSize, "Unexpected LogRecord");
+
+/**
+ * @brief An asynchronous logger. Each logging thread writes binary
+ * LogRecords to its own single-producer single-consumer ring, and a
+ * background thread formats them in TSC order and writes them out.
+ *
+ * A thread whose ring is full drops the message and counts it, instead of
+ * blocking. While the logger is not running, messages are written
+ * synchronously by the logging thread.
+ */
+class AsyncLogger {
+ public:
+  // Messages each thread can have in flight
+  static constexpr size_t kRingSlots = 1024;
+
+  /// Start the background thread. Messages logged from now on are written
+  /// asynchronously.
+  static void Start();
+  /// Write all the queued messages and stop the background thread. Messages
+  /// logged from now on are written synchronously.
+  static void Stop();
+  static inline bool Running() {
+    return running_.load(std::memory_order_relaxed);
+  }
+  /// Return the number of messages dropped because a ring was full
+  static size_t NumDropped();
+
+  /// Queue a message of [level] for [stream], formatted as by
+  /// printf(format, args...). Returns false if the message was dropped.
+  template <typename... Args>
+  static bool Log(FILE* stream, int level, const char* format,
+                  const Args&... args) {
+    Ring* ring = ThisThreadRing();
+    const size_t tail = ring->tail_.load(std::memory_order_relaxed);
+    if (tail - ring->head_.load(std::memory_order_acquire) == kRingSlots) {
+      ring->dropped_.store(ring->dropped_.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+      return false;
+    }
+    LogRecord& record = ring->records_[tail % kRingSlots];
+    record.format_ = format;
+    record.tsc_ = __rdtsc();
+    record.stream_ = stream;
+    record.level_ = static_cast<uint8_t>(level);
+    record.num_args_ = 0;
+    record.strings_len_ = 0;
+    // Arguments beyond kMaxArgs are printed as missing
+    (AddArg(record, args), ...);
+    ring->tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Format [record] as printf would, into [buf] of [size] bytes, and
+  /// return the length of the message. Exposed for testing.
+  static size_t Format(const LogRecord& record, char* buf, size_t size);
+
+ private:
+  struct Ring {
+    alignas(64) std::atomic<size_t> head_{0};  // Written by the consumer
+    alignas(64) std::atomic<size_t> tail_{0};  // Written by the producer
+    std::atomic<size_t> dropped_{0};           // Written by the producer
+    alignas(64) std::array<LogRecord, kRingSlots> records_;
+  };
+
+  /// Return the ring of the calling thread, creating it on first use
+  static inline Ring* ThisThreadRing() {
+    thread_local Ring* ring = nullptr;
+    if (ring == nullptr) {
+      ring = NewRing();
+    }
+    return ring;
+  }
+  static Ring* NewRing();
+
+  template <typename T>
+  static inline void AddArg(LogRecord& record, const T& arg) {
+    if (record.num_args_ == LogRecord::kMaxArgs) {
+      return;
+    }
+    const size_t i = record.num_args_++;
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, char*> || std::is_same_v<U, const char*>) {
+      AddString(record, i, arg);
+    } else if constexpr (std::is_null_pointer_v<U>) {
+      record.arg_types_[i] = LogRecord::ArgType::kPointer;
+      record.args_[i] = 0;
+    } else if constexpr (std::is_pointer_v<U>) {
+      record.arg_types_[i] = LogRecord::ArgType::kPointer;
+      record.args_[i] = reinterpret_cast<uintptr_t>(arg);
+    } else if constexpr (std::is_floating_point_v<U>) {
+      record.arg_types_[i] = LogRecord::ArgType::kDouble;
+      const auto value = static_cast<double>(arg);
+      std::memcpy(&record.args_[i], &value, sizeof(value));
+    } else {
+      static_assert(std::is_integral_v<U> || std::is_enum_v<U>,
+                    "AsyncLogger: Unsupported argument type");
+      record.arg_types_[i] = std::is_signed_v<U>
+                                 ? LogRecord::ArgType::kSigned
+                                 : LogRecord::ArgType::kUnsigned;
+      record.arg_sizes_[i] = sizeof(U);
+      record.args_[i] = static_cast<uint64_t>(arg);
+    }
+  }
+  static void AddString(LogRecord& record, size_t i, const char* str);
+
+  static void Loop();
+  /// Write the queued messages of all rings in TSC order. Returns the
+  /// number of messages written.
+  static size_t Drain();
+
+  static inline std::atomic<bool> running_{false};
+  // All the rings ever created. Rings are never freed, since their threads
+  // may log again after Stop().
+  static inline std::mutex rings_mutex_;
+  static inline std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+#endif  // ASYNC_LOGGER_H_
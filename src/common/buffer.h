@@ -6,6 +6,8 @@
 #define BUFFER_H_
 
 #include <atomic>
+#include <bitset>
+#include <cstddef>
 #include <sstream>
 #include <vector>
 
@@ -165,15 +167,34 @@ static_assert(sizeof(EventData) == 64);
 struct Packet {
   // The packet's data starts at kOffsetOfData bytes from the start
   static constexpr size_t kOffsetOfData = 64;
+  // Set in every packet, so that receivers can tell Agora packets from stray
+  // traffic on their ports
+  static constexpr uint32_t kMagic = 0x41475241;
+  // Set instead of kMagic in the placeholder packets that the master hands to
+  // FFT for erased antennas
+  static constexpr uint32_t kErasedMagic = 0x45524153;
 
   uint32_t frame_id_;
   uint32_t symbol_id_;
   uint32_t cell_id_;
   uint32_t ant_id_;
-  uint32_t fill_[12];  // Padding for 64-byte alignment needed for SIMD
-  short data_[];       // Elements sent by antennae are two bytes (I/Q samples)
+  // Time the sender sent the packet, in nanoseconds of CLOCK_REALTIME, or
+  // zero if the sender did not timestamp it
+  uint64_t tx_time_ns_;
+  uint32_t magic_;  // kMagic
+  // CRC32C of the packet with this field zeroed, if the configuration
+  // enables packet checksums
+  uint32_t checksum_;
+  uint32_t fill_[8];  // Padding for 64-byte alignment needed for SIMD
+  short data_[];      // Elements sent by antennae are two bytes (I/Q samples)
   Packet(int f, int s, int c, int a)  // TODO: Should be unsigned integers
-      : frame_id_(f), symbol_id_(s), cell_id_(c), ant_id_(a) {}
+      : frame_id_(f),
+        symbol_id_(s),
+        cell_id_(c),
+        ant_id_(a),
+        tx_time_ns_(0),
+        magic_(kMagic),
+        checksum_(0) {}
 
   std::string ToString() const {
     std::ostringstream ret;
@@ -183,18 +204,21 @@ struct Packet {
     return ret.str();
   }
 };
+static_assert(offsetof(Packet, data_) == Packet::kOffsetOfData);
 
 class RxPacket {
  private:
   std::atomic<unsigned> references_;
   Packet *packet_;
+  uint64_t rx_time_ns_;
 
   inline virtual void GcPacket(void) {}
 
  public:
-  RxPacket() : references_(0) { packet_ = nullptr; }
-  explicit RxPacket(Packet *in) : references_(0) { Set(in); }
-  explicit RxPacket(const RxPacket &copy) : packet_(copy.packet_) {
+  RxPacket() : references_(0), rx_time_ns_(0) { packet_ = nullptr; }
+  explicit RxPacket(Packet *in) : references_(0), rx_time_ns_(0) { Set(in); }
+  explicit RxPacket(const RxPacket &copy)
+      : packet_(copy.packet_), rx_time_ns_(copy.rx_time_ns_) {
     references_.store(copy.references_.load());
   }
   virtual ~RxPacket() = default;
@@ -212,6 +236,10 @@ class RxPacket {
   }
 
   inline Packet *RawPacket() { return packet_; }
+  /// Time the packet arrived, in nanoseconds of CLOCK_REALTIME, or zero if
+  /// the receiver did not timestamp it
+  inline uint64_t RxTimeNs() const { return rx_time_ns_; }
+  inline void SetRxTimeNs(uint64_t rx_time_ns) { rx_time_ns_ = rx_time_ns; }
   inline bool Empty() const { return references_.load() == 0; }
   inline void Use() { references_.fetch_add(1); }
   inline void Free() {
@@ -281,15 +309,15 @@ static_assert(sizeof(rx_mac_tag_t) == sizeof(size_t));
 class RxCounters {
  public:
   // num_pkt[i] is the total number of packets we've received for frame i
-  std::array<size_t, kFrameWnd> num_pkts_;
+  std::vector<size_t> num_pkts_;
 
   // num_pilot_pkts[i] is the total number of pilot packets we've received
   // for frame i
-  std::array<size_t, kFrameWnd> num_pilot_pkts_;
+  std::vector<size_t> num_pilot_pkts_;
 
   // num_rc_pkts[i] is the total number of reciprocity pilot packets we've
   // received for frame i
-  std::array<size_t, kFrameWnd> num_reciprocity_pkts_;
+  std::vector<size_t> num_reciprocity_pkts_;
 
   // Number of packets we'll receive per frame on the uplink
   size_t num_pkts_per_frame_;
@@ -300,10 +328,17 @@ class RxCounters {
   // Number of reciprocity pilot packets we'll receive per frame
   size_t num_reciprocity_pkts_per_frame_;
 
-  RxCounters() {
-    num_pkts_.fill(0);
-    num_pilot_pkts_.fill(0);
-    num_reciprocity_pkts_.fill(0);
+  RxCounters() = default;
+
+  /**
+   * @brief Allocate and zero the per-frame counters
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   */
+  void Init(size_t frame_wnd) {
+    assert(IsPowerOfTwo(frame_wnd));
+    num_pkts_.assign(frame_wnd, 0);
+    num_pilot_pkts_.assign(frame_wnd, 0);
+    num_reciprocity_pkts_.assign(frame_wnd, 0);
   }
 };
 
@@ -314,19 +349,30 @@ class RxCounters {
  */
 class FrameCounters {
  public:
-  FrameCounters() : task_count_(), symbol_count_() {}
+  FrameCounters()
+      : frame_wnd_mask_(0), max_symbol_count_(0), max_task_count_(0) {}
 
-  void Init(size_t max_symbol_count, size_t max_task_count = 0) {
+  /**
+   * @brief Allocate and zero the counters
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   * @param max_symbol_count The number of symbols per frame
+   * @param max_task_count The number of tasks per symbol
+   */
+  void Init(size_t frame_wnd, size_t max_symbol_count,
+            size_t max_task_count = 0) {
+    assert(IsPowerOfTwo(frame_wnd));
+    this->frame_wnd_mask_ = frame_wnd - 1;
     this->max_symbol_count_ = max_symbol_count;
     this->max_task_count_ = max_task_count;
-    this->symbol_count_.fill(0);
+    this->symbol_count_.assign(frame_wnd, 0);
+    this->task_count_.resize(frame_wnd);
     for (auto &frame : task_count_) {
       frame.fill(0);
     }
   }
 
   void Reset(size_t frame_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     this->symbol_count_.at(frame_slot) = 0;
     this->task_count_.at(frame_slot).fill(0);
   }
@@ -336,7 +382,7 @@ class FrameCounters {
    * @param frame_id The frame id of the symbol to increment
    */
   bool CompleteSymbol(size_t frame_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     this->symbol_count_.at(frame_slot)++;
     return this->IsLastSymbol(frame_slot);
   }
@@ -347,7 +393,7 @@ class FrameCounters {
    * @param symbol_id The symbol id of the task to increment
    */
   bool CompleteTask(size_t frame_id, size_t symbol_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     this->task_count_.at(frame_slot).at(symbol_id)++;
     return this->IsLastTask(frame_id, symbol_id);
   }
@@ -363,7 +409,7 @@ class FrameCounters {
    * @param frame id The frame id of the symbol to check
    */
   bool IsLastSymbol(size_t frame_id) const {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     bool is_last;
     size_t symbol_count = this->symbol_count_.at(frame_slot);
     if (symbol_count == this->max_symbol_count_) {
@@ -392,7 +438,7 @@ class FrameCounters {
    * @param symbol_id The symbol id to check
    */
   bool IsLastTask(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_slot = frame_id % kFrameWnd;
+    const size_t frame_slot = frame_id & this->frame_wnd_mask_;
     bool is_last;
     size_t task_count = this->task_count_.at(frame_slot).at(symbol_id);
     if (task_count == this->max_task_count_) {
@@ -411,7 +457,7 @@ class FrameCounters {
   }
 
   size_t GetSymbolCount(size_t frame_id) const {
-    return this->symbol_count_.at(frame_id % kFrameWnd);
+    return this->symbol_count_.at(frame_id & this->frame_wnd_mask_);
   }
 
   size_t GetTaskCount(size_t frame_id) const {
@@ -419,7 +465,8 @@ class FrameCounters {
   }
 
   size_t GetTaskCount(size_t frame_id, size_t symbol_id) const {
-    return this->task_count_.at(frame_id % kFrameWnd).at(symbol_id);
+    return this->task_count_.at(frame_id & this->frame_wnd_mask_)
+        .at(symbol_id);
   }
 
   inline size_t MaxSymbolCount() const { return this->max_symbol_count_; }
@@ -427,16 +474,378 @@ class FrameCounters {
 
  private:
   // task_count[i][j] is the number of tasks completed for
-  // frame (i % kFrameWnd) and symbol j
-  std::array<std::array<size_t, kMaxSymbols>, kFrameWnd> task_count_;
+  // frame slot i and symbol j
+  std::vector<std::array<size_t, kMaxSymbols>> task_count_;
   // symbol_count[i] is the number of symbols completed for
-  // frame (i % kFrameWnd)
-  std::array<size_t, kFrameWnd> symbol_count_;
+  // frame slot i
+  std::vector<size_t> symbol_count_;
 
+  // The slot of a frame is (frame_id & frame_wnd_mask_)
+  size_t frame_wnd_mask_;
   // Maximum number of symbols in a frame
   size_t max_symbol_count_;
   // Maximum number of tasks in a symbol
   size_t max_task_count_;
 };
 
+/**
+ * @brief Thread-safe variant of FrameCounters that worker threads update
+ * directly. Every counter lives on its own cache line so that workers
+ * completing tasks of different symbols do not share cache lines. The
+ * Complete functions return true to exactly one caller: the one that completes
+ * the symbol (or frame). That caller also resets the counter, so the frame
+ * slot can be reused one frame window later without help from the master.
+ */
+class AtomicFrameCounters {
+ public:
+  AtomicFrameCounters()
+      : frame_wnd_mask_(0), max_symbol_count_(0), max_task_count_(0) {}
+
+  /**
+   * @brief Allocate and zero the counters
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   * @param max_symbol_count The number of symbols per frame
+   * @param max_task_count The number of tasks per symbol
+   */
+  void Init(size_t frame_wnd, size_t max_symbol_count,
+            size_t max_task_count = 0) {
+    assert(IsPowerOfTwo(frame_wnd));
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->max_symbol_count_ = max_symbol_count;
+    this->max_task_count_ = max_task_count;
+    this->task_count_ =
+        std::vector<std::array<PaddedCount, kMaxSymbols>>(frame_wnd);
+    this->symbol_count_ = std::vector<PaddedCount>(frame_wnd);
+    for (size_t i = 0; i < frame_wnd; i++) {
+      this->Reset(i);
+    }
+  }
+
+  void Reset(size_t frame_id) {
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
+    this->symbol_count_.at(frame_slot).count_.store(0,
+                                                    std::memory_order_relaxed);
+    for (auto &symbol : this->task_count_.at(frame_slot)) {
+      symbol.count_.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Increments the symbol count for input frame
+   * @param frame_id The frame id of the symbol to increment
+   * @return True for the single caller that completes the frame
+   */
+  bool CompleteSymbol(size_t frame_id) {
+    return Complete(
+        this->symbol_count_.at(frame_id & this->frame_wnd_mask_).count_,
+        this->max_symbol_count_);
+  }
+
+  /**
+   * @brief Increments the task count for input frame and symbol. acq_rel
+   * ordering makes the results of all tasks of the symbol visible to the
+   * caller that completes it.
+   * @param frame_id The frame id of the task to increment
+   * @param symbol_id The symbol id of the task to increment
+   * @return True for the single caller that completes the symbol
+   */
+  bool CompleteTask(size_t frame_id, size_t symbol_id) {
+    return Complete(this->task_count_.at(frame_id & this->frame_wnd_mask_)
+                        .at(symbol_id)
+                        .count_,
+                    this->max_task_count_);
+  }
+
+  size_t GetSymbolCount(size_t frame_id) const {
+    return this->symbol_count_.at(frame_id & this->frame_wnd_mask_)
+        .count_.load(std::memory_order_relaxed);
+  }
+
+  size_t GetTaskCount(size_t frame_id, size_t symbol_id) const {
+    return this->task_count_.at(frame_id & this->frame_wnd_mask_)
+        .at(symbol_id)
+        .count_.load(std::memory_order_relaxed);
+  }
+
+  inline size_t MaxSymbolCount() const { return this->max_symbol_count_; }
+  inline size_t MaxTaskCount() const { return this->max_task_count_; }
+
+ private:
+  struct alignas(64) PaddedCount {
+    std::atomic<size_t> count_;
+  };
+  static_assert(sizeof(PaddedCount) == 64);
+
+  static bool Complete(std::atomic<size_t> &count, size_t max_count) {
+    const size_t new_count = count.fetch_add(1, std::memory_order_acq_rel) + 1;
+    // This should never happen
+    assert(new_count <= max_count);
+    if (new_count == max_count) {
+      count.store(0, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  // task_count[i][j] is the number of tasks completed for
+  // frame slot i and symbol j
+  std::vector<std::array<PaddedCount, kMaxSymbols>> task_count_;
+  // symbol_count[i] is the number of symbols completed for
+  // frame slot i
+  std::vector<PaddedCount> symbol_count_;
+
+  // The slot of a frame is (frame_id & frame_wnd_mask_)
+  size_t frame_wnd_mask_;
+  // Maximum number of symbols in a frame
+  size_t max_symbol_count_;
+  // Maximum number of tasks in a symbol
+  size_t max_task_count_;
+};
+
+/**
+ * @brief Frames aborted by the master thread. Each frame slot stores the
+ * generation of the last frame dropped in it, where the generation of a frame
+ * is the number of times its slot has been reused (frame_id / frame window).
+ * The master writes it when it drops a frame, and workers read it to discard
+ * queued tasks of the dropped frame. A later frame that reuses the slot has a
+ * different generation, so it needs no reset.
+ */
+class DroppedFrames {
+ public:
+  DroppedFrames() : frame_wnd_mask_(0), frame_wnd_shift_(0) {}
+
+  /**
+   * @brief Allocate the per-slot generations with no frame dropped
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   */
+  void Init(size_t frame_wnd) {
+    assert(IsPowerOfTwo(frame_wnd));
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->frame_wnd_shift_ = __builtin_ctzl(frame_wnd);
+    this->generation_ = std::vector<std::atomic<size_t>>(frame_wnd);
+    for (auto &generation : this->generation_) {
+      generation.store(kNoneDropped, std::memory_order_relaxed);
+    }
+  }
+
+  /// Mark [frame_id] as dropped. Only the master thread calls this.
+  void Drop(size_t frame_id) {
+    this->generation_.at(frame_id & this->frame_wnd_mask_)
+        .store(Generation(frame_id), std::memory_order_release);
+  }
+
+  /// Return true if [frame_id] has been dropped
+  bool IsDropped(size_t frame_id) const {
+    return this->generation_.at(frame_id & this->frame_wnd_mask_)
+               .load(std::memory_order_acquire) == Generation(frame_id);
+  }
+
+ private:
+  static constexpr size_t kNoneDropped = SIZE_MAX;
+
+  inline size_t Generation(size_t frame_id) const {
+    return frame_id >> this->frame_wnd_shift_;
+  }
+
+  // generation_[i] is the generation of the last frame dropped in slot i,
+  // or kNoneDropped
+  std::vector<std::atomic<size_t>> generation_;
+
+  // The slot of a frame is (frame_id & frame_wnd_mask_)
+  size_t frame_wnd_mask_;
+  // The generation of a frame is (frame_id >> frame_wnd_shift_)
+  size_t frame_wnd_shift_;
+};
+
+/**
+ * @brief The antennas received and erased for each symbol of the frames in
+ * the frame window. The master thread marks each antenna of a pilot or
+ * uplink symbol as received when its packet arrives, and erases the antennas
+ * still missing when the symbol times out. The first packet of a frame
+ * resets the symbols of its slot, so that symbols whose packets are all lost
+ * time out too. Only the master thread reads and writes this state, except
+ * for the erased antennas of the pilot symbols, which zeroforcing reads once
+ * the FFT of all the pilots is done.
+ */
+class AntennaErasures {
+ public:
+  AntennaErasures() : frame_wnd_mask_(0), symbol_num_(0), ant_num_(0) {}
+
+  /**
+   * @brief Allocate the per-symbol state with no symbol received
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   */
+  void Init(size_t frame_wnd, size_t symbol_num, size_t ant_num) {
+    assert(IsPowerOfTwo(frame_wnd));
+    assert(ant_num <= kMaxAntennas);
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->symbol_num_ = symbol_num;
+    this->ant_num_ = ant_num;
+    this->symbols_ = std::vector<SymbolAntennas>(frame_wnd * symbol_num);
+    this->slots_ = std::vector<FrameSlot>(frame_wnd);
+  }
+
+  /// Mark the packet of [ant_id] for [symbol_id] of [frame_id] as received
+  /// at time [now], in any unit. Returns true if it is the first packet of
+  /// the frame, whose pilot and uplink symbols should then all be checked
+  /// for timeouts.
+  bool MarkReceived(size_t frame_id, size_t symbol_id, size_t ant_id,
+                    size_t now = 0) {
+    FrameSlot &slot = this->slots_.at(frame_id & this->frame_wnd_mask_);
+    const bool first_packet = (slot.frame_id_ != frame_id);
+    if (first_packet == true) {
+      slot.frame_id_ = frame_id;
+      for (size_t i = 0; i < this->symbol_num_; i++) {
+        SymbolAntennas &symbol = this->At(frame_id, i);
+        symbol.frame_id_ = frame_id;
+        symbol.received_.reset();
+        symbol.erased_.reset();
+      }
+    }
+    slot.last_rx_time_ = now;
+    SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    if (symbol.received_.none() == true) {
+      symbol.first_rx_time_ = now;
+    }
+    symbol.received_.set(ant_id);
+    return first_packet;
+  }
+
+  /// Return true if [symbol_id] of [frame_id] has waited longer than
+  /// [timeout] for its missing antennas at time [now]: since its first
+  /// packet, or since the latest packet of the frame if it has none
+  bool TimedOut(size_t frame_id, size_t symbol_id, size_t now,
+                size_t timeout) const {
+    const SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    const size_t since = (symbol.received_.any() == true)
+                             ? symbol.first_rx_time_
+                             : this->slots_.at(frame_id & this->frame_wnd_mask_)
+                                   .last_rx_time_;
+    return (now - since) > timeout;
+  }
+
+  /// Erase the antennas of [symbol_id] of [frame_id] that have not been
+  /// received, and return them
+  std::bitset<kMaxAntennas> EraseMissing(size_t frame_id, size_t symbol_id) {
+    SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    assert(symbol.frame_id_ == frame_id);
+    std::bitset<kMaxAntennas> missing;
+    for (size_t ant_id = 0; ant_id < this->ant_num_; ant_id++) {
+      missing.set(ant_id, (symbol.received_.test(ant_id) == false) &&
+                              (symbol.erased_.test(ant_id) == false));
+    }
+    symbol.erased_ |= missing;
+    return missing;
+  }
+
+  /// Return true if every antenna of [symbol_id] of [frame_id] has been
+  /// either received or erased, or if another frame has taken over the slot
+  bool IsComplete(size_t frame_id, size_t symbol_id) const {
+    const SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    return (symbol.frame_id_ != frame_id) ||
+           ((symbol.received_ | symbol.erased_).count() == this->ant_num_);
+  }
+
+  /// Return true if [ant_id] has been erased from [symbol_id] of [frame_id]
+  bool IsErased(size_t frame_id, size_t symbol_id, size_t ant_id) const {
+    const SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    return (symbol.frame_id_ == frame_id) && symbol.erased_.test(ant_id);
+  }
+
+  /// The antennas erased from [symbol_id] of [frame_id]
+  std::bitset<kMaxAntennas> Erased(size_t frame_id, size_t symbol_id) const {
+    const SymbolAntennas &symbol = this->At(frame_id, symbol_id);
+    return (symbol.frame_id_ == frame_id) ? symbol.erased_
+                                          : std::bitset<kMaxAntennas>();
+  }
+
+ private:
+  struct SymbolAntennas {
+    size_t frame_id_ = SIZE_MAX;
+    std::bitset<kMaxAntennas> received_;
+    std::bitset<kMaxAntennas> erased_;
+    // Time of the symbol's first packet
+    size_t first_rx_time_ = 0;
+  };
+  struct FrameSlot {
+    size_t frame_id_ = SIZE_MAX;
+    // Time of the frame's latest packet
+    size_t last_rx_time_ = 0;
+  };
+
+  inline SymbolAntennas &At(size_t frame_id, size_t symbol_id) {
+    return this->symbols_.at(
+        ((frame_id & this->frame_wnd_mask_) * this->symbol_num_) + symbol_id);
+  }
+  inline const SymbolAntennas &At(size_t frame_id, size_t symbol_id) const {
+    return this->symbols_.at(
+        ((frame_id & this->frame_wnd_mask_) * this->symbol_num_) + symbol_id);
+  }
+
+  // symbols_[i * symbol_num_ + j] is symbol j of the frame in slot i
+  std::vector<SymbolAntennas> symbols_;
+  // slots_[i] is the frame in slot i
+  std::vector<FrameSlot> slots_;
+
+  // The slot of a frame is (frame_id & frame_wnd_mask_)
+  size_t frame_wnd_mask_;
+  size_t symbol_num_;
+  size_t ant_num_;
+};
+
+/**
+ * @brief The last frame that finished a stage in each frame slot, shared
+ * between the uplink and downlink master threads. The thread that runs the
+ * stage marks each frame when the stage is done, and the other thread polls
+ * for it. A later frame that reuses the slot overwrites the mark, so it
+ * needs no reset.
+ */
+class FrameProgress {
+ public:
+  FrameProgress() : frame_wnd_mask_(0) {}
+
+  /**
+   * @brief Allocate the per-slot marks with no frame done
+   * @param frame_wnd The number of frames tracked. Must be a power of two.
+   */
+  void Init(size_t frame_wnd) {
+    assert(IsPowerOfTwo(frame_wnd));
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->done_frame_ = std::vector<PaddedFrame>(frame_wnd);
+    for (auto &done_frame : this->done_frame_) {
+      done_frame.frame_id_.store(kNoFrame, std::memory_order_relaxed);
+    }
+  }
+
+  /// Mark the stage of [frame_id] as done. Only one thread calls this.
+  /// Memory writes before the call are visible to the thread that sees the
+  /// mark with Done().
+  void MarkDone(size_t frame_id) {
+    this->done_frame_.at(frame_id & this->frame_wnd_mask_)
+        .frame_id_.store(frame_id, std::memory_order_release);
+  }
+
+  /// Return true if the stage of [frame_id] is done
+  bool Done(size_t frame_id) const {
+    return this->done_frame_.at(frame_id & this->frame_wnd_mask_)
+               .frame_id_.load(std::memory_order_acquire) == frame_id;
+  }
+
+ private:
+  static constexpr size_t kNoFrame = SIZE_MAX;
+
+  // Each slot is polled by one thread and written by the other
+  struct alignas(64) PaddedFrame {
+    std::atomic<size_t> frame_id_;
+  };
+  static_assert(sizeof(PaddedFrame) == 64);
+
+  // done_frame_[i] is the last frame in slot i whose stage is done, or
+  // kNoFrame
+  std::vector<PaddedFrame> done_frame_;
+
+  // The slot of a frame is (frame_id & frame_wnd_mask_)
+  size_t frame_wnd_mask_;
+};
+
 #endif  // BUFFER_H_
@@ -19,6 +19,39 @@
 using json = nlohmann::json;
 
 static const size_t kMacAlignmentBytes = 64u;
+static const std::string kSysfsCpuDir = "/sys/devices/system/cpu";
+static const std::string kSysfsNetDir = "/sys/class/net";
+
+// Worker stages by name, in the default priority order. Stages later in the
+// pipeline come first so that frames closer to completion are served first.
+static const std::vector<std::pair<std::string, EventType>>
+    kDefaultWorkerStagePriority = {
+        {"decode", EventType::kDecode}, {"ifft", EventType::kIFFT},
+        {"demul", EventType::kDemul},   {"precode", EventType::kPrecode},
+        {"encode", EventType::kEncode}, {"zf", EventType::kZF},
+        {"fft", EventType::kFFT}};
+
+/// Plan the cores of all threads from the "thread_placement" object of the
+/// config and the CPU topology in sysfs
+static std::unique_ptr<ThreadPlacement> PlanThreadPlacement(
+    const json& placement_conf, const PlacementRoles& roles) {
+  PlacementConstraints constraints;
+  constraints.avoid_smt_siblings_ =
+      placement_conf.value("avoid_smt_siblings", true);
+  constraints.colocate_fft_demul_ =
+      placement_conf.value("colocate_fft_demul", true);
+  constraints.nic_numa_node_ = placement_conf.value("nic_numa_node", -1);
+  const std::string nic = placement_conf.value("nic", "");
+  if ((constraints.nic_numa_node_ < 0) && (nic.empty() == false)) {
+    constraints.nic_numa_node_ = CpuTopology::NicNumaNode(kSysfsNetDir, nic);
+  }
+  for (const auto& role :
+       placement_conf.value("cores", json::object()).items()) {
+    constraints.cores_[role.key()] = role.value().get<std::vector<size_t>>();
+  }
+  return std::make_unique<ThreadPlacement>(
+      CpuTopology::FromSysfs(kSysfsCpuDir), roles, constraints);
+}
 
 Config::Config(const std::string& jsonfile)
     : freq_ghz_(GetTime::MeasureRdtscFreq()),
@@ -138,6 +171,26 @@ Config::Config(const std::string& jsonfile)
   dpdk_num_ports_ = tdd_conf.value("dpdk_num_ports", 1);
   dpdk_port_offset_ = tdd_conf.value("dpdk_port_offset", 0);
 
+  xdp_interface_ = tdd_conf.value("xdp_interface", "");
+  xdp_queue_start_ = tdd_conf.value("xdp_queue_start", 0);
+  xdp_native_mode_ = tdd_conf.value("xdp_native_mode", false);
+
+  use_io_uring_ = tdd_conf.value("io_uring", false);
+  io_uring_sqpoll_ = tdd_conf.value("io_uring_sqpoll", false);
+  reuseport_rx_ = tdd_conf.value("reuseport_rx", false);
+  reuseport_rebalance_ms_ = tdd_conf.value("reuseport_rebalance_ms", 10);
+  udp_gso_ = tdd_conf.value("udp_gso", false);
+  udp_gro_ = tdd_conf.value("udp_gro", false);
+  rx_hw_timestamps_ = tdd_conf.value("rx_hw_timestamps", false);
+  use_shm_transport_ = tdd_conf.value("shm_transport", false);
+  shm_name_ = tdd_conf.value("shm_name", "/agora_fronthaul");
+  shm_ring_slots_ = tdd_conf.value("shm_ring_slots", 256);
+  dl_tx_scheduler_ = tdd_conf.value("dl_tx_scheduler", false);
+  dl_tx_advance_us_ = tdd_conf.value("dl_tx_advance_us", 100);
+  packet_checksum_ = tdd_conf.value("packet_checksum", false);
+  metrics_socket_ = tdd_conf.value("metrics_socket", "");
+  use_perf_counters_ = tdd_conf.value("perf_counters", false);
+
   ue_mac_tx_port_ = tdd_conf.value("ue_mac_tx_port", kMacUserRemotePort);
   ue_mac_rx_port_ = tdd_conf.value("ue_mac_rx_port", kMacUserLocalPort);
   bs_mac_tx_port_ = tdd_conf.value("bs_mac_tx_port", kMacBaseRemotePort);
@@ -166,6 +219,7 @@ Config::Config(const std::string& jsonfile)
   ofdm_data_stop_ = ofdm_data_start_ + ofdm_data_num_;
 
   bigstation_mode_ = tdd_conf.value("bigstation_mode", false);
+  split_master_ = tdd_conf.value("split_master", false);
   freq_orthogonal_pilot_ = tdd_conf.value("freq_orthogonal_pilot", false);
   correct_phase_shift_ = tdd_conf.value("correct_phase_shift", false);
 
@@ -357,14 +411,74 @@ Config::Config(const std::string& jsonfile)
 
   // Agora configurations
   frames_to_test_ = tdd_conf.value("frames_to_test", 9600);
+  // Round the frame window up to a power of two so that the slot of a frame
+  // in per-frame buffers is a mask of the frame ID
+  const size_t frame_wnd = tdd_conf.value("frame_window", kDefaultFrameWnd);
+  RtAssert(frame_wnd >= 2, "Frame window must hold at least two frames");
+  frame_wnd_ = 1;
+  while (frame_wnd_ < frame_wnd) {
+    frame_wnd_ <<= 1;
+  }
+  frame_deadline_us_ = tdd_conf.value("frame_deadline_us", 0);
+  antenna_erasure_timeout_us_ =
+      tdd_conf.value("antenna_erasure_timeout_us", 0);
+  // Stages missing from "worker_stage_priority" keep their default order
+  // after the listed ones
+  auto stage_priority = tdd_conf.value("worker_stage_priority", json::array());
+  for (const auto& stage_name : stage_priority) {
+    auto stage = std::find_if(
+        kDefaultWorkerStagePriority.begin(), kDefaultWorkerStagePriority.end(),
+        [&stage_name](const std::pair<std::string, EventType>& s) {
+          return s.first == stage_name.get<std::string>();
+        });
+    RtAssert(stage != kDefaultWorkerStagePriority.end(),
+             "Unknown stage in worker_stage_priority: " +
+                 stage_name.get<std::string>());
+    RtAssert(std::count(worker_stage_priority_.begin(),
+                        worker_stage_priority_.end(), stage->second) == 0,
+             "Duplicate stage in worker_stage_priority: " + stage->first);
+    worker_stage_priority_.push_back(stage->second);
+  }
+  for (const auto& stage : kDefaultWorkerStagePriority) {
+    if (std::count(worker_stage_priority_.begin(),
+                   worker_stage_priority_.end(), stage.second) == 0) {
+      worker_stage_priority_.push_back(stage.second);
+    }
+  }
+  worker_idle_spin_polls_ = tdd_conf.value("worker_idle_spin_polls", 2048);
+  worker_idle_pause_polls_ = tdd_conf.value("worker_idle_pause_polls", 16384);
+  worker_park_timeout_us_ = tdd_conf.value("worker_park_timeout_us", 500);
   core_offset_ = tdd_conf.value("core_offset", 0);
   worker_thread_num_ = tdd_conf.value("worker_thread_num", 25);
   socket_thread_num_ = tdd_conf.value("socket_thread_num", 4);
   fft_thread_num_ = tdd_conf.value("fft_thread_num", 5);
   demul_thread_num_ = tdd_conf.value("demul_thread_num", 5);
   decode_thread_num_ = tdd_conf.value("decode_thread_num", 10);
+  if (bigstation_mode_ == true) {
+    // Each pool must have a thread, and the ZF pool takes the rest
+    RtAssert((fft_thread_num_ > 0) && (demul_thread_num_ > 0) &&
+                 (decode_thread_num_ > 0) &&
+                 (fft_thread_num_ + demul_thread_num_ + decode_thread_num_ <
+                  worker_thread_num_),
+             "Bigstation mode needs at least one FFT, ZF, demul, and decode "
+             "thread");
+  }
   zf_thread_num_ = worker_thread_num_ - fft_thread_num_ - demul_thread_num_ -
                    decode_thread_num_;
+  if (tdd_conf.contains("thread_placement") == true) {
+    PlacementRoles roles;
+    roles.num_masters_ = split_master_ ? 2 : 1;
+    roles.num_txrx_ = socket_thread_num_;
+    roles.num_mac_ = kEnableMac ? 1 : 0;
+    roles.num_workers_ = worker_thread_num_;
+    roles.bigstation_ = bigstation_mode_;
+    roles.num_fft_ = fft_thread_num_;
+    roles.num_zf_ = zf_thread_num_;
+    roles.num_demul_ = demul_thread_num_;
+    thread_placement_ =
+        PlanThreadPlacement(tdd_conf.at("thread_placement"), roles);
+    std::printf("%s", thread_placement_->ToString().c_str());
+  }
 
   demul_block_size_ = tdd_conf.value("demul_block_size", 48);
   RtAssert(demul_block_size_ % kSCsPerCacheline == 0,
@@ -467,13 +581,13 @@ Config::Config(const std::string& jsonfile)
       "%s,\n\t%zu codeblocks per symbol, %zu bytes per code block,"
       "\n\t%zu UL MAC data bytes per frame, %zu UL MAC bytes per frame, "
       "\n\t%zu DL MAC data bytes per frame, %zu DL MAC bytes per frame, "
-      "frame time %.3f usec\n",
+      "frame time %.3f usec, frame window %zu frames\n",
       bs_ant_num_, ue_ant_num_, frame_.NumPilotSyms(), frame_.NumULSyms(),
       frame_.NumDLSyms(), ofdm_ca_num_, ofdm_data_num_, modulation_.c_str(),
       ldpc_config_.NumBlocksInSymbol(), num_bytes_per_cb_,
       ul_mac_data_bytes_num_perframe_, ul_mac_bytes_num_perframe_,
       dl_mac_data_bytes_num_perframe_, dl_mac_bytes_num_perframe_,
-      this->GetFrameDurationSec() * 1e6);
+      this->GetFrameDurationSec() * 1e6, frame_wnd_);
 }
 
 void Config::GenData() {
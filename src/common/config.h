@@ -27,6 +27,7 @@
 #include "memory_manage.h"
 #include "modulation.h"
 #include "symbols.h"
+#include "thread_placement.h"
 #include "utils.h"
 #include "utils_ldpc.h"
 
@@ -104,6 +105,41 @@ class Config {
   inline size_t RadioPerGroup() const {
     return this->ant_per_group_ / this->num_channels_;
   }
+  /// Number of frames tracked concurrently. This is always a power of two.
+  inline size_t FrameWnd() const { return this->frame_wnd_; }
+  /// Return the slot of [frame_id] in buffers that hold FrameWnd() frames
+  inline size_t FrameSlot(size_t frame_id) const {
+    return (frame_id & (this->frame_wnd_ - 1));
+  }
+  /// Processing budget of a frame in microseconds, measured from its first
+  /// received packet. Zero disables dropping late frames.
+  inline size_t FrameDeadlineUs() const { return this->frame_deadline_us_; }
+  /// Microseconds after the first packet of a pilot or uplink symbol after
+  /// which the antennas still missing are erased. Zero disables erasures.
+  inline size_t AntennaErasureTimeoutUs() const {
+    return this->antenna_erasure_timeout_us_;
+  }
+  /// Pipeline stages in the order in which workers serve them, highest
+  /// priority first
+  inline const std::vector<EventType>& WorkerStagePriority() const {
+    return this->worker_stage_priority_;
+  }
+  /// Empty polls that an idle worker spins, then pauses, before it parks
+  inline size_t WorkerIdleSpinPolls() const {
+    return this->worker_idle_spin_polls_;
+  }
+  inline size_t WorkerIdlePausePolls() const {
+    return this->worker_idle_pause_polls_;
+  }
+  /// Longest time in microseconds that an idle worker parks before it polls
+  /// again. Zero disables parking.
+  inline size_t WorkerParkTimeoutUs() const {
+    return this->worker_park_timeout_us_;
+  }
+  /// The core of each thread, or nullptr if threads are pinned by offset
+  inline const ThreadPlacement* Placement() const {
+    return this->thread_placement_.get();
+  }
   inline size_t CoreOffset() const { return this->core_offset_; }
   inline size_t WorkerThreadNum() const { return this->worker_thread_num_; }
   inline size_t SocketThreadNum() const { return this->socket_thread_num_; }
@@ -150,6 +186,7 @@ class Config {
 
   inline float Scale() const { return this->scale_; }
   inline bool BigstationMode() const { return this->bigstation_mode_; }
+  inline bool SplitMaster() const { return this->split_master_; }
   inline size_t UlMacDataBytesNumPerframe() const {
     return this->ul_mac_data_bytes_num_perframe_;
   }
@@ -188,6 +225,32 @@ class Config {
   inline uint16_t DpdkNumPorts() const { return this->dpdk_num_ports_; }
   inline uint16_t DpdkPortOffset() const { return this->dpdk_port_offset_; }
 
+  inline std::string XdpInterface() const { return this->xdp_interface_; }
+  inline uint16_t XdpQueueStart() const { return this->xdp_queue_start_; }
+  inline bool XdpNativeMode() const { return this->xdp_native_mode_; }
+
+  inline bool UseIoUring() const { return this->use_io_uring_; }
+  inline bool IoUringSqPoll() const { return this->io_uring_sqpoll_; }
+
+  inline bool ReuseportRx() const { return this->reuseport_rx_; }
+  inline size_t ReuseportRebalanceMs() const {
+    return this->reuseport_rebalance_ms_;
+  }
+
+  inline bool UdpGso() const { return this->udp_gso_; }
+  inline bool UdpGro() const { return this->udp_gro_; }
+  inline bool RxHwTimestamps() const { return this->rx_hw_timestamps_; }
+
+  inline bool UseShmTransport() const { return this->use_shm_transport_; }
+  inline std::string ShmName() const { return this->shm_name_; }
+  inline size_t ShmRingSlots() const { return this->shm_ring_slots_; }
+
+  inline bool DlTxScheduler() const { return this->dl_tx_scheduler_; }
+  inline size_t DlTxAdvanceUs() const { return this->dl_tx_advance_us_; }
+  inline bool PacketChecksum() const { return this->packet_checksum_; }
+  inline std::string MetricsSocket() const { return this->metrics_socket_; }
+  inline bool UsePerfCounters() const { return this->use_perf_counters_; }
+
   inline size_t BsMacRxPort() const { return this->bs_mac_rx_port_; }
   inline size_t BsMacTxPort() const { return this->bs_mac_tx_port_; }
 
@@ -282,23 +345,23 @@ class Config {
   }
 
   /// Return total number of data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdx(size_t frame_id, size_t symbol_id) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumDataSyms() + symbol_id);
+    return (FrameSlot(frame_id) * this->frame_.NumDataSyms() + symbol_id);
   }
 
   /// Return total number of uplink data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdxUl(size_t frame_id,
                                         size_t symbol_idx_ul) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumULSyms() + symbol_idx_ul);
+    return (FrameSlot(frame_id) * this->frame_.NumULSyms() + symbol_idx_ul);
   }
 
   /// Return total number of downlink data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdxDl(size_t frame_id,
                                         size_t symbol_idx_dl) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumDLSyms() + symbol_idx_dl);
+    return (FrameSlot(frame_id) * this->frame_.NumDLSyms() + symbol_idx_dl);
   }
 
   /// Return the frame duration in seconds
@@ -311,7 +374,7 @@ class Config {
   /// be an uplink symbol.
   inline complex_float* GetDataBuf(Table<complex_float>& data_buffers,
                                    size_t frame_id, size_t symbol_id) const {
-    size_t frame_slot = frame_id % kFrameWnd;
+    size_t frame_slot = FrameSlot(frame_id);
     size_t symbol_offset = (frame_slot * this->frame_.NumULSyms()) +
                            this->frame_.GetULSymbolIdx(symbol_id);
     return data_buffers[symbol_offset];
@@ -326,7 +389,7 @@ class Config {
   /// Get the calibration buffer for this frame and subcarrier ID
   inline complex_float* GetCalibBuffer(Table<complex_float>& calib_buffer,
                                        size_t frame_id, size_t sc_id) const {
-    size_t frame_slot = frame_id % kFrameWnd;
+    size_t frame_slot = FrameSlot(frame_id);
     return &calib_buffer[frame_slot][sc_id * bs_ant_num_];
   }
 
@@ -340,7 +403,7 @@ class Config {
     } else {
       mac_bytes_perframe = ul_mac_bytes_num_perframe_;
     }
-    return &info_bits[ue_id][(frame_id % kFrameWnd) * mac_bytes_perframe +
+    return &info_bits[ue_id][FrameSlot(frame_id) * mac_bytes_perframe +
                              symbol_id * mac_packet_length_ +
                              cb_id * this->num_bytes_per_cb_];
   }
@@ -509,6 +572,24 @@ class Config {
   size_t ant_group_num_;
   size_t ant_per_group_;
 
+  // Number of frames tracked concurrently, rounded up to a power of two
+  size_t frame_wnd_;
+  // Frames not processed within this many microseconds of their first packet
+  // are dropped. Zero disables the deadline.
+  size_t frame_deadline_us_;
+  // Antennas whose packets for a symbol are missing this many microseconds
+  // after its first packet are erased. Zero disables erasures.
+  size_t antenna_erasure_timeout_us_;
+  // Worker task types in decreasing priority
+  std::vector<EventType> worker_stage_priority_;
+  // Idle workers spin, then pause, then park on a futex until new tasks are
+  // scheduled or the park timeout expires. A zero timeout disables parking.
+  size_t worker_idle_spin_polls_;
+  size_t worker_idle_pause_polls_;
+  size_t worker_park_timeout_us_;
+
+  // Set if the config has a "thread_placement" object
+  std::unique_ptr<ThreadPlacement> thread_placement_;
   size_t core_offset_;
   size_t worker_thread_num_;
   size_t socket_thread_num_;
@@ -575,6 +656,9 @@ class Config {
   float scale_;  // Scaling factor for all transmit symbols
 
   bool bigstation_mode_;      // If true, use pipeline-parallel scheduling
+  // If true, uplink and downlink processing are coordinated by two master
+  // threads
+  bool split_master_;
   bool correct_phase_shift_;  // If true, do phase shift correction
 
   // The total number of uncoded data bytes in each OFDM symbol
@@ -633,6 +717,72 @@ class Config {
   // Offset of the first NIC port used by Agora's DPDK mode
   uint16_t dpdk_port_offset_;
 
+  // Interface that Agora's AF_XDP mode attaches to
+  std::string xdp_interface_;
+
+  // RX queue of the first AF_XDP socket. TXRX thread i uses queue
+  // xdp_queue_start_ + i, so the NIC must steer each thread's ports there.
+  uint16_t xdp_queue_start_;
+
+  // Attach the XDP program in driver mode and try zero-copy sockets, instead
+  // of generic (SKB) mode with copies, which works on any interface
+  bool xdp_native_mode_;
+
+  // Batch socket I/O through io_uring instead of one syscall per packet. Used
+  // by the socket TXRX threads and the sender.
+  bool use_io_uring_;
+
+  // Poll io_uring submissions from a kernel thread, so the I/O threads do
+  // not enter the kernel while traffic is flowing
+  bool io_uring_sqpoll_;
+
+  // Share every radio's UDP port among all socket threads through an
+  // SO_REUSEPORT group, with packets steered to threads by antenna
+  bool reuseport_rx_;
+
+  // How often the antenna-to-thread steering is rebalanced in reuseport
+  // mode. Zero keeps the initial mapping.
+  size_t reuseport_rebalance_ms_;
+
+  // Send the packets of a batch with one UDP GSO send per destination
+  // instead of one send per packet. Used by the socket TXRX threads and the
+  // sender.
+  bool udp_gso_;
+
+  // Let the kernel coalesce received packets with UDP GRO, so the socket
+  // TXRX threads receive several packets per call
+  bool udp_gro_;
+
+  // Prefer the NIC's receive timestamps to the kernel's software ones for
+  // the fronthaul latency stats. The NIC's PTP clock must be synchronized
+  // with the sender's CLOCK_REALTIME.
+  bool rx_hw_timestamps_;
+
+  // Exchange packets with a simulator on the same host through rings in a
+  // POSIX shared memory region named shm_name_ instead of UDP sockets. Each
+  // radio has an uplink and a downlink ring of shm_ring_slots_ packets.
+  bool use_shm_transport_;
+  std::string shm_name_;
+  size_t shm_ring_slots_;
+
+  // Hold downlink packets until dl_tx_advance_us_ before the air time of
+  // their symbol in the beacon schedule, instead of sending them as soon as
+  // they are encoded
+  bool dl_tx_scheduler_;
+  size_t dl_tx_advance_us_;
+
+  // Senders fill in the checksum of each uplink packet, and the TXRX threads
+  // drop packets whose checksum does not match
+  bool packet_checksum_;
+
+  // Path of the Unix domain socket on which Agora serves its metrics in the
+  // Prometheus text format. Empty disables the metrics exporter.
+  std::string metrics_socket_;
+
+  // Count hardware events, e.g., cycles and cache misses, of each worker task
+  // with perf_event_open()
+  bool use_perf_counters_;
+
   // Port ID at BaseStation MAC layer side
   size_t bs_mac_rx_port_;
   size_t bs_mac_tx_port_;
@@ -19,7 +19,8 @@ inline const struct rte_eth_conf port_conf_default() {
 }
 
 int DpdkTransport::NicInit(uint16_t port, struct rte_mempool* mbuf_pool,
-                           int thread_num, size_t pkt_len) {
+                           int thread_num, size_t pkt_len,
+                           struct rte_mempool* hdr_pool) {
   struct rte_eth_conf port_conf = port_conf_default();
   const uint16_t rxRings = thread_num, txRings = 2 * thread_num;
   int retval;
@@ -55,6 +56,11 @@ int DpdkTransport::NicInit(uint16_t port, struct rte_mempool* mbuf_pool,
       RTE_MIN(RTE_MIN(dev_info.max_rx_pktlen, port_conf.rxmode.max_rx_pkt_len),
               pkt_len);
   // port_conf.rxmode.offloads |= DEV_RX_OFFLOAD_JUMBO_FRAME;
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 11, 0, 0)
+  if (hdr_pool != nullptr) {
+    port_conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_BUFFER_SPLIT;
+  }
+#endif
 
   retval = rte_eth_dev_configure(port, rxRings, txRings, &port_conf);
   if (retval != 0) return retval;
@@ -64,6 +70,22 @@ int DpdkTransport::NicInit(uint16_t port, struct rte_mempool* mbuf_pool,
   rxconf = dev_info.default_rxconf;
   rxconf.offloads = port_conf.rxmode.offloads;
 
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 11, 0, 0)
+  union rte_eth_rxseg rx_seg[2];
+  if (hdr_pool != nullptr) {
+    // Headers go to the first segment and the payload to the second
+    std::memset(rx_seg, 0, sizeof(rx_seg));
+    rx_seg[0].split.mp = hdr_pool;
+    rx_seg[0].split.length = kPayloadOffset;
+    rx_seg[1].split.mp = mbuf_pool;
+    rxconf.rx_seg = rx_seg;
+    rxconf.rx_nseg = 2;
+    mbuf_pool = nullptr;
+  }
+#else
+  RtAssert(hdr_pool == nullptr, "DPDK: Buffer split needs DPDK 20.11");
+#endif
+
   for (q = 0; q < rxRings; q++) {
     retval = rte_eth_rx_queue_setup(
         port, q, nb_rxd, rte_eth_dev_socket_id(port), &rxconf, mbuf_pool);
@@ -105,6 +127,34 @@ int DpdkTransport::NicInit(uint16_t port, struct rte_mempool* mbuf_pool,
   return 0;
 }
 
+bool DpdkTransport::SupportsBufferSplit(uint16_t port) {
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 11, 0, 0)
+  struct rte_eth_dev_info dev_info;
+  if (rte_eth_dev_info_get(port, &dev_info) != 0) {
+    return false;
+  }
+  return (dev_info.rx_offload_capa & RTE_ETH_RX_OFFLOAD_BUFFER_SPLIT) != 0;
+#else
+  unused(port);
+  return false;
+#endif
+}
+
+size_t DpdkMbufCollector::FreeReleased() {
+  rte_mbuf* mbufs[kMbufFreeBulkSize];
+  const size_t num = released_.try_dequeue_bulk(mbufs, kMbufFreeBulkSize);
+  if (num > 0) {
+#if RTE_VERSION >= RTE_VERSION_NUM(20, 5, 0, 0)
+    rte_pktmbuf_free_bulk(mbufs, num);
+#else
+    for (size_t i = 0; i < num; i++) {
+      rte_pktmbuf_free(mbufs[i]);
+    }
+#endif
+  }
+  return num;
+}
+
 // Reference: https://stackoverflow.com/a/44948720
 void DpdkTransport::FastMemcpy(void* pvDest, void* pvSrc, size_t nBytes) {
   // std::printf("pvDest: 0x%lx, pvSrc: 0x%lx, Dest: %lx, Src,
@@ -298,10 +348,16 @@ void DpdkTransport::DpdkInit(uint16_t core_offset, size_t thread_num) {
 
 rte_mempool* DpdkTransport::CreateMempool(size_t num_ports,
                                           size_t packet_length) {
-  size_t mbuf_size = packet_length + kMBufCacheSize;
+  return CreateMempool("MBUF_POOL", kNumMBufs * num_ports, packet_length);
+}
+
+rte_mempool* DpdkTransport::CreateMempool(const std::string& name,
+                                          size_t num_mbufs,
+                                          size_t packet_length) {
+  size_t mbuf_size = packet_length + RTE_PKTMBUF_HEADROOM;
   rte_mempool* mbuf_pool =
-      rte_pktmbuf_pool_create("MBUF_POOL", kNumMBufs * num_ports,
-                              kMBufCacheSize, 0, mbuf_size, rte_socket_id());
+      rte_pktmbuf_pool_create(name.c_str(), num_mbufs, kMBufCacheSize, 0,
+                              mbuf_size, rte_socket_id());
 
   RtAssert(mbuf_pool != NULL, "Cannot create mbuf pool");
 
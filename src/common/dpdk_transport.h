@@ -24,6 +24,7 @@
 
 #include <string>
 
+#include "concurrentqueue.h"
 #include "utils.h"
 
 static constexpr size_t kRxRingSize = 2048;
@@ -36,6 +37,8 @@ static constexpr size_t kJumboFrameMaxSize = 0x2600;
 /// Maximum number of packets received in rx_burst
 static constexpr size_t kRxBatchSize = 16;
 static constexpr size_t kTxBatchSize = 1;
+/// Maximum number of released mbufs freed in one rte_pktmbuf_free_bulk()
+static constexpr size_t kMbufFreeBulkSize = 64;
 
 /// Offset to the payload starting from the beginning of the UDP frame
 static constexpr size_t kPayloadOffset = sizeof(struct rte_ether_hdr) +
@@ -43,13 +46,43 @@ static constexpr size_t kPayloadOffset = sizeof(struct rte_ether_hdr) +
                                          sizeof(struct rte_udp_hdr) + 22;
 static_assert(kPayloadOffset == 64, "");
 
+/**
+ * @brief Frees received mbufs in bulk on the thread that received them.
+ *
+ * Agora workers are not EAL lcores, so an mbuf freed by a worker bypasses
+ * the mempool caches and goes straight to the shared ring. Instead, workers
+ * hand mbufs back with Release(), and the receiving thread frees them in
+ * batches with FreeReleased(), through its own lcore's cache.
+ */
+class DpdkMbufCollector {
+ public:
+  /// Queue [mbuf] to be freed by the owning thread. Thread-safe.
+  inline void Release(rte_mbuf* mbuf) { released_.enqueue(mbuf); }
+
+  /// Free up to kMbufFreeBulkSize released mbufs. Called by the owner only.
+  /// @return The number of mbufs freed
+  size_t FreeReleased();
+
+ private:
+  moodycamel::ConcurrentQueue<rte_mbuf*> released_;
+};
+
 class DpdkTransport {
  public:
   DpdkTransport();
   ~DpdkTransport();
 
+  /// Configure and start [port] with [thread_num] RX queues filled from
+  /// [mbuf_pool]. If [hdr_pool] is given, each packet's first kPayloadOffset
+  /// bytes are split into an mbuf from [hdr_pool], so that the payload starts
+  /// at the data offset of an mbuf from [mbuf_pool].
   static int NicInit(uint16_t port, struct rte_mempool* mbuf_pool,
-                     int thread_num, size_t pkt_len = kJumboFrameMaxSize);
+                     int thread_num, size_t pkt_len = kJumboFrameMaxSize,
+                     struct rte_mempool* hdr_pool = nullptr);
+
+  /// True if [port] can split the headers and payload of received packets
+  /// into separate mbufs (DPDK 20.11 or later)
+  static bool SupportsBufferSplit(uint16_t port);
 
   // Steer the flow [src_ip, dest_ip, src_port, dst_port] arriving on
   // [port_id] to RX queue [rx_q]
@@ -75,6 +108,10 @@ class DpdkTransport {
   static void DpdkInit(uint16_t core_offset, size_t thread_num);
   static rte_mempool* CreateMempool(size_t num_ports,
                                     size_t packet_length = kJumboFrameMaxSize);
+  /// Create a pool of [num_mbufs] mbufs, each with room for [packet_length]
+  /// bytes after the default headroom
+  static rte_mempool* CreateMempool(const std::string& name, size_t num_mbufs,
+                                    size_t packet_length);
 };
 
 #endif  // DPDK_TRANSPORT_H_
\ No newline at end of file
@@ -17,6 +17,14 @@ static inline double GetTimeUs() {
   return tv.tv_sec * 1000000 + tv.tv_nsec / 1000.0;
 }
 
+/// Get current CLOCK_REALTIME time in nanoseconds, which can be compared
+/// with timestamps taken on other hosts whose clocks are synchronized
+static inline uint64_t RealtimeNs() {
+  struct timespec tv;
+  clock_gettime(CLOCK_REALTIME, &tv);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000000 + tv.tv_nsec;
+}
+
 // Get current time in microseconds. This can be deleted after we replace
 // all occurences of get_time() with get_time_us()
 static inline double GetTime() { return GetTimeUs(); }
@@ -0,0 +1,52 @@
+/**
+ * @file latency_histogram.cc
+ * @brief Implementation file for the LatencyHistogram class.
+ */
+#include "latency_histogram.h"
+
+#include <cmath>
+
+void LatencyHistogram::Reset() {
+  this->counts_.fill(0);
+  this->count_ = 0;
+  this->max_ = 0;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    this->counts_[i] += other.counts_[i];
+  }
+  this->count_ += other.count_;
+  this->max_ = std::max(this->max_, other.max_);
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+  if (this->count_ == 0) {
+    return 0;
+  }
+  // The rank of the value at the percentile, counting from 1
+  const auto rank = std::max(
+      size_t{1}, static_cast<size_t>(std::ceil(percentile / 100.0 *
+                                               static_cast<double>(count_))));
+  size_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    seen += this->counts_[i];
+    if (seen >= rank) {
+      return std::min(BucketMax(i), this->max_);
+    }
+  }
+  return this->max_;
+}
+
+uint64_t LatencyHistogram::BucketMax(size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  if (bucket == kNumBuckets - 1) {
+    return UINT64_MAX;
+  }
+  const size_t shift = ((bucket - kSubBuckets) / (kSubBuckets / 2)) + 1;
+  const uint64_t sub_bucket =
+      ((bucket - kSubBuckets) % (kSubBuckets / 2)) + (kSubBuckets / 2);
+  return ((sub_bucket + 1) << shift) - 1;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file latency_histogram.h
+ * @brief Declaration file for the LatencyHistogram class, a log-linear
+ * histogram of durations with fixed memory.
+ */
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A histogram of durations, e.g., in TSC cycles, with a bounded
+ * relative error, in the style of HdrHistogram.
+ *
+ * Values below kSubBuckets have a bucket each. Above that, each power of two
+ * is split into kSubBuckets / 2 linear buckets, so a bucket is never wider
+ * than 1 / (kSubBuckets / 2) of its values. Values of kMaxValueBits bits or
+ * more are counted in the last bucket. Recording a value is a few
+ * instructions and never allocates.
+ *
+ * A histogram has one writer. Histograms are merged to summarize them.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 7;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  // Largest tracked value: about 6 minutes of TSC cycles at 3 GHz
+  static constexpr size_t kMaxValueBits = 40;
+  // The exact buckets, the linear buckets of each power of two, and one for
+  // larger values
+  static constexpr size_t kNumBuckets =
+      kSubBuckets + ((kMaxValueBits - kSubBucketBits) * (kSubBuckets / 2)) +
+      1;
+
+  LatencyHistogram() { Reset(); }
+
+  void Reset();
+
+  inline void Record(uint64_t value) {
+    this->counts_[BucketOf(value)]++;
+    this->count_++;
+    this->max_ = std::max(this->max_, value);
+  }
+
+  /// Add the counts of [other] to this histogram
+  void Merge(const LatencyHistogram& other);
+
+  /// Return the value at [percentile] (0 -- 100) of the recorded values,
+  /// i.e., the largest value of its bucket, but at most the largest recorded
+  /// value. Zero if the histogram is empty.
+  uint64_t Percentile(double percentile) const;
+
+  inline size_t Count() const { return this->count_; }
+  inline uint64_t Max() const { return this->max_; }
+
+  /// Return the bucket that counts [value]
+  static inline size_t BucketOf(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    // The position of the highest set bit is at least kSubBucketBits
+    const size_t msb = 63 - __builtin_clzll(value);
+    if (msb >= kMaxValueBits) {
+      return kNumBuckets - 1;
+    }
+    const size_t shift = msb - kSubBucketBits + 1;
+    // The kSubBucketBits leading bits of value, in [kSubBuckets / 2,
+    // kSubBuckets)
+    const size_t sub_bucket = value >> shift;
+    return kSubBuckets + ((shift - 1) * (kSubBuckets / 2)) +
+           (sub_bucket - (kSubBuckets / 2));
+  }
+
+  /// Return the largest value counted in [bucket]
+  static uint64_t BucketMax(size_t bucket);
+
+ private:
+  std::array<size_t, kNumBuckets> counts_;
+  size_t count_;
+  uint64_t max_;
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
@@ -20,9 +20,12 @@
 #ifndef LOGGER_H_
 #define LOGGER_H_
 
+#include <cstdarg>
 #include <ctime>
 #include <string>
 
+#include "async_logger.h"
+
 // Log levels: higher means more verbose
 #define MLPD_LOG_LEVEL_OFF 0
 #define MLPD_LOG_LEVEL_ERROR 1  // Only fatal conditions
@@ -56,50 +59,57 @@
 #define MLPD_ERROR(...) ((void)0)
 #endif
 
+// Errors are written synchronously, so that they are not lost if the process
+// exits. Less severe messages are queued to the AsyncLogger while it runs.
 #if MLPD_LOG_LEVEL >= MLPD_LOG_LEVEL_WARN
-#define MLPD_WARN(...)                                               \
-  MlpdOutputLogHeader(MLPD_LOG_DEFAULT_STREAM, MLPD_LOG_LEVEL_WARN); \
-  std::fprintf(MLPD_LOG_DEFAULT_STREAM, __VA_ARGS__);                \
-  std::fflush(MLPD_LOG_DEFAULT_STREAM)
+#define MLPD_WARN(...)                                                  \
+  do {                                                                  \
+    if (false) MlpdCheckFormat(__VA_ARGS__);                            \
+    MlpdLog(MLPD_LOG_DEFAULT_STREAM, MLPD_LOG_LEVEL_WARN, __VA_ARGS__); \
+  } while (0)
 #else
 #define MLPD_WARN(...) ((void)0)
 #endif
 
 #if MLPD_LOG_LEVEL >= MLPD_LOG_LEVEL_INFO
-#define MLPD_INFO(...)                                               \
-  MlpdOutputLogHeader(MLPD_LOG_DEFAULT_STREAM, MLPD_LOG_LEVEL_INFO); \
-  std::fprintf(MLPD_LOG_DEFAULT_STREAM, __VA_ARGS__);                \
-  std::fflush(MLPD_LOG_DEFAULT_STREAM)
+#define MLPD_INFO(...)                                                  \
+  do {                                                                  \
+    if (false) MlpdCheckFormat(__VA_ARGS__);                            \
+    MlpdLog(MLPD_LOG_DEFAULT_STREAM, MLPD_LOG_LEVEL_INFO, __VA_ARGS__); \
+  } while (0)
 #else
 #define MLPD_INFO(...) ((void)0)
 #endif
 
 #if MLPD_LOG_LEVEL >= MLPD_LOG_LEVEL_FRAME
-#define MLPD_FRAME(...)                                         \
-  MlpdOutputLogHeader(mlpd_trace_file_or_default_stream,        \
-                      MLPD_LOG_LEVEL_FRAME);                    \
-  std::fprintf(mlpd_trace_file_or_default_stream, __VA_ARGS__); \
-  std::fflush(mlpd_trace_file_or_default_stream)
+#define MLPD_FRAME(...)                         \
+  do {                                          \
+    if (false) MlpdCheckFormat(__VA_ARGS__);    \
+    MlpdLog(mlpd_trace_file_or_default_stream,  \
+            MLPD_LOG_LEVEL_FRAME, __VA_ARGS__); \
+  } while (0)
 #else
 #define MLPD_FRAME(...) ((void)0)
 #endif
 
 #if MLPD_LOG_LEVEL >= MLPD_LOG_LEVEL_SYMBOL
-#define MLPD_SYMBOL(...)                                        \
-  MlpdOutputLogHeader(mlpd_trace_file_or_default_stream,        \
-                      MLPD_LOG_LEVEL_SYMBOL);                   \
-  std::fprintf(mlpd_trace_file_or_default_stream, __VA_ARGS__); \
-  std::fflush(mlpd_trace_file_or_default_stream)
+#define MLPD_SYMBOL(...)                         \
+  do {                                           \
+    if (false) MlpdCheckFormat(__VA_ARGS__);     \
+    MlpdLog(mlpd_trace_file_or_default_stream,   \
+            MLPD_LOG_LEVEL_SYMBOL, __VA_ARGS__); \
+  } while (0)
 #else
 #define MLPD_SYMBOL(...) ((void)0)
 #endif
 
 #if MLPD_LOG_LEVEL >= MLPD_LOG_LEVEL_TRACE
-#define MLPD_TRACE(...)                                         \
-  MlpdOutputLogHeader(mlpd_trace_file_or_default_stream,        \
-                      MLPD_LOG_LEVEL_TRACE);                    \
-  std::fprintf(mlpd_trace_file_or_default_stream, __VA_ARGS__); \
-  std::fflush(mlpd_trace_file_or_default_stream)
+#define MLPD_TRACE(...)                         \
+  do {                                          \
+    if (false) MlpdCheckFormat(__VA_ARGS__);    \
+    MlpdLog(mlpd_trace_file_or_default_stream,  \
+            MLPD_LOG_LEVEL_TRACE, __VA_ARGS__); \
+  } while (0)
 #else
 #define MLPD_TRACE(...) ((void)0)
 #endif
@@ -116,35 +126,56 @@ static std::string MlpdGetFormattedTime() {
   return std::string(buf);
 }
 
-// Output log message header
-static inline void MlpdOutputLogHeader(FILE* stream, int level) {
-  std::string formatted_time = MlpdGetFormattedTime();
-
-  const char* type;
+/// Return the name of a log level in the log message header
+static inline const char* MlpdLogLevelName(int level) {
   switch (level) {
     case MLPD_LOG_LEVEL_ERROR:
-      type = "ERROR";
-      break;
+      return "ERROR";
     case MLPD_LOG_LEVEL_WARN:
-      type = "WARNG";
-      break;
+      return "WARNG";
     case MLPD_LOG_LEVEL_INFO:
-      type = "INFOR";
-      break;
+      return "INFOR";
     case MLPD_LOG_LEVEL_FRAME:
-      type = "FRAME";
-      break;
+      return "FRAME";
     case MLPD_LOG_LEVEL_SYMBOL:
-      type = "SBFRM";
-      break;
+      return "SBFRM";
     case MLPD_LOG_LEVEL_TRACE:
-      type = "TRACE";
-      break;
+      return "TRACE";
     default:
-      type = "UNKWN";
+      return "UNKWN";
   }
+}
 
-  std::fprintf(stream, "%s %s: ", formatted_time.c_str(), type);
+// Output log message header
+static inline void MlpdOutputLogHeader(FILE* stream, int level) {
+  std::string formatted_time = MlpdGetFormattedTime();
+  std::fprintf(stream, "%s %s: ", formatted_time.c_str(),
+               MlpdLogLevelName(level));
+}
+
+/// Never called: lets the compiler check the format arguments of the
+/// logging macros, as it did when they called fprintf
+static inline __attribute__((format(printf, 1, 2))) void MlpdCheckFormat(
+    const char* /*format*/, ...) {}
+
+static inline void MlpdPrint(FILE* stream, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stream, format, args);
+  va_end(args);
+}
+
+/// Queue a log message to the AsyncLogger if it runs, or write it now
+template <typename... Args>
+static inline void MlpdLog(FILE* stream, int level, const char* format,
+                           const Args&... args) {
+  if (AsyncLogger::Running() == true) {
+    AsyncLogger::Log(stream, level, format, args...);
+  } else {
+    MlpdOutputLogHeader(stream, level);
+    MlpdPrint(stream, format, args...);
+    std::fflush(stream);
+  }
 }
 
 /// Return true if the logging verbosity is reasonable for non-developer users
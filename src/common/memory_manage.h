@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <random>
+#include <vector>
 
 namespace Agora_memory {
 enum class Alignment_t : size_t {
@@ -113,23 +114,20 @@ static void FreeBuffer1d(T** buffer) {
   std::free(*buffer);
 };
 
-// PtrGrid is a 2D grid of pointers with [ROWS] rows and [COLS] columns. Each
-// entry of the grid is a pointer to an array of [T].
-template <size_t ROWS, size_t COLS, class T>
+// PtrGrid is a 2D grid of pointers with a runtime number of rows and [COLS]
+// columns. Each entry of the grid is a pointer to an array of [T].
+template <size_t COLS, class T>
 class PtrGrid {
  public:
   PtrGrid() : backing_buf_(nullptr) {}
 
-  /// Create a grid of pointers where each grid cell points to an array of
-  /// [n_entries]
-  explicit PtrGrid(size_t num_entries) { this->Alloc(ROWS, COLS, num_entries); }
-
-  /// Create a grid of pointers with dimensions [ROWS, COLS], where
+  /// Create a grid of pointers with dimensions [n_rows, COLS], where
   /// only the grid with dimensions [n_rows, n_cols] has cells pointing to an
   /// array of [n_entries]. This can use less memory than a fully-allocated
   /// grid.
-  PtrGrid(size_t n_rows, size_t n_cols, size_t n_entries) {
-    assert(n_rows <= ROWS && n_cols <= COLS);
+  PtrGrid(size_t n_rows, size_t n_cols, size_t n_entries)
+      : backing_buf_(nullptr) {
+    assert(n_cols <= COLS);
     this->Alloc(n_rows, n_cols, n_entries);
   }
 
@@ -148,8 +146,10 @@ class PtrGrid {
     std::memset(static_cast<void*>(this->backing_buf_), 0, alloc_sz);
 
     // Fill-in the grid with pointers into backing_buf
+    this->mat_.assign(n_rows, std::array<T*, COLS>());
     size_t offset = 0;
     for (size_t i = 0; i < n_rows; i++) {
+      this->mat_[i].fill(nullptr);
       for (size_t j = 0; j < n_cols; j++) {
         mat_[i][j] = &this->backing_buf_[offset];
         offset += n_entries;
@@ -157,11 +157,11 @@ class PtrGrid {
     }
   }
 
-  /// Allocate [n_entries] entries per pointer cell.
+  /// Allocate [n_rows, COLS] pointer cells with [n_entries] entries each.
   /// Each entry is a random float between -1.0 and 1.0.
-  void RandAllocCxFloat(size_t n_entries) {
+  void RandAllocCxFloat(size_t n_rows, size_t n_entries) {
     static_assert(sizeof(T) == 2 * sizeof(float), "T must be complex_float");
-    Alloc(ROWS, COLS, n_entries);
+    Alloc(n_rows, COLS, n_entries);
 
     std::default_random_engine generator;
     std::uniform_real_distribution<float> distribution(-1.0, 1.0);
@@ -180,37 +180,35 @@ class PtrGrid {
     return this->mat_[row_idx];
   }
 
+  /// Return the number of rows in the grid
+  inline size_t Rows() const { return this->mat_.size(); }
+
   // Delete copy constructor and copy assignment
   PtrGrid(PtrGrid const&) = delete;
   PtrGrid& operator=(PtrGrid const&) = delete;
 
  private:
-  std::array<std::array<T*, COLS>, ROWS> mat_;  /// The pointer cells
+  std::vector<std::array<T*, COLS>> mat_;  /// The pointer cells
 
   /// The backing buffer for the per-cell arrays. Having a common buffer
   /// reduces the number of memory allocations.
   T* backing_buf_;
 };
 
-// PtrCube is a 3D cube of pointers. Each entry of the cube is a pointer to an
-// array of [T].
-template <size_t DIM1, size_t DIM2, size_t DIM3, class T>
+// PtrCube is a 3D cube of pointers with a runtime first dimension. Each entry
+// of the cube is a pointer to an array of [T].
+template <size_t DIM2, size_t DIM3, class T>
 class PtrCube {
  public:
   PtrCube() : backing_buf_(nullptr) {}
 
-  /// Create a cube of pointers with dimensions [DIM1, DIM2, DIM3], where each
-  /// cube cell points to an array of [n_entries]
-  explicit PtrCube(size_t num_entries) {
-    this->Alloc(DIM1, DIM2, DIM3, num_entries);
-  }
-
-  /// Create a cube of pointers with dimensions [DIM1, DIM2, DIM3], where
+  /// Create a cube of pointers with dimensions [dim_1, DIM2, DIM3], where
   /// only the cube with dimensions [dim_1, dim_2, dim_3] has cells
   /// pointing to an array of [n_entries]. This can use less memory than a
   /// fully-allocated cube.
-  PtrCube(size_t dim_1, size_t dim_2, size_t dim_3, size_t n_entries) {
-    assert(dim_1 <= DIM1 && dim_2 <= DIM2 && dim_3 <= DIM3);
+  PtrCube(size_t dim_1, size_t dim_2, size_t dim_3, size_t n_entries)
+      : backing_buf_(nullptr) {
+    assert(dim_2 <= DIM2 && dim_3 <= DIM3);
     this->Alloc(dim_1, dim_2, dim_3, n_entries);
   }
 
@@ -229,6 +227,7 @@ class PtrCube {
     std::memset(static_cast<void*>(this->backing_buf_), 0, alloc_sz);
 
     // Fill-in the grid with pointers into backing_buf
+    this->cube_.assign(dim_1, std::array<std::array<T*, DIM3>, DIM2>());
     for (auto& mat : this->cube_) {
       for (auto& row : mat) {
         for (auto& entry : row) {
@@ -252,13 +251,16 @@ class PtrCube {
     return this->cube_[row_idx];
   }
 
+  /// Return the size of the first dimension of the cube
+  inline size_t Dim1() const { return this->cube_.size(); }
+
   // Delete copy constructor and copy assignment
   PtrCube(PtrCube const&) = delete;
   PtrCube& operator=(PtrCube const&) = delete;
 
  private:
   /// The pointer cells
-  std::array<std::array<std::array<T*, DIM3>, DIM2>, DIM1> cube_;
+  std::vector<std::array<std::array<T*, DIM3>, DIM2>> cube_;
 
   /// The backing buffer for the per-cell arrays. Having a common buffer
   /// reduces the number of memory allocations.
@@ -0,0 +1,178 @@
+/**
+ * @file metrics.cc
+ * @brief Implementation file for the Metrics registry and the
+ * MetricsExporter.
+ */
+
+#include "metrics.h"
+
+#include <poll.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "logger.h"
+
+// How often the exporter checks whether it should stop
+static constexpr int kExporterPollMs = 100;
+// How long the exporter waits for a client's request before answering in
+// plain text
+static constexpr int kRequestWaitMs = 50;
+
+MetricValue* Metrics::AddCounter(const std::string& name,
+                                 const std::string& help,
+                                 const std::string& labels) {
+  return Add(name, help, labels, MetricType::kCounter);
+}
+
+MetricValue* Metrics::AddGauge(const std::string& name,
+                               const std::string& help,
+                               const std::string& labels) {
+  return Add(name, help, labels, MetricType::kGauge);
+}
+
+MetricValue* Metrics::Add(const std::string& name, const std::string& help,
+                          const std::string& labels, MetricType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  values_.emplace_back();
+  metrics_.push_back({name, help, labels, type, &values_.back(), nullptr});
+  return &values_.back();
+}
+
+void Metrics::AddSampledGauge(const std::string& name,
+                              const std::string& help,
+                              const std::string& labels,
+                              std::function<double()> sample) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  metrics_.push_back(
+      {name, help, labels, MetricType::kGauge, nullptr, std::move(sample)});
+}
+
+std::string Metrics::Render() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream out;
+  // Enough digits for counters to stay exact
+  out.precision(15);
+  std::vector<bool> rendered(metrics_.size(), false);
+  // The samples of a name go together, under one HELP and TYPE line
+  for (size_t i = 0; i < metrics_.size(); i++) {
+    if (rendered.at(i) == true) {
+      continue;
+    }
+    const Metric& first = metrics_.at(i);
+    out << "# HELP " << first.name_ << " " << first.help_ << "\n";
+    out << "# TYPE " << first.name_ << " "
+        << ((first.type_ == MetricType::kCounter) ? "counter" : "gauge")
+        << "\n";
+    for (size_t j = i; j < metrics_.size(); j++) {
+      const Metric& metric = metrics_.at(j);
+      if (metric.name_ != first.name_) {
+        continue;
+      }
+      rendered.at(j) = true;
+      out << metric.name_;
+      if (metric.labels_.empty() == false) {
+        out << "{" << metric.labels_ << "}";
+      }
+      const double value = (metric.value_ != nullptr) ? metric.value_->Get()
+                                                      : metric.sample_();
+      out << " " << value << "\n";
+    }
+  }
+  return out.str();
+}
+
+MetricsExporter::MetricsExporter(const std::string& socket_path,
+                                 const Metrics* metrics)
+    : socket_path_(socket_path), metrics_(metrics), running_(true) {
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("MetricsExporter: Socket path too long: " +
+                             socket_path);
+  }
+  std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error("MetricsExporter: Failed to create socket");
+  }
+  // A socket file left behind by an earlier run would fail the bind
+  unlink(socket_path.c_str());
+  if ((bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+       0) ||
+      (listen(listen_fd_, 4) != 0)) {
+    const std::string error = std::strerror(errno);
+    close(listen_fd_);
+    throw std::runtime_error("MetricsExporter: Failed to listen on " +
+                             socket_path + ": " + error);
+  }
+  thread_ = std::thread(&MetricsExporter::Loop, this);
+  MLPD_INFO("MetricsExporter: Serving metrics on %s\n", socket_path.c_str());
+}
+
+MetricsExporter::~MetricsExporter() {
+  running_ = false;
+  thread_.join();
+  close(listen_fd_);
+  unlink(socket_path_.c_str());
+}
+
+void MetricsExporter::Loop() {
+  // Only run when the cores have nothing else to do
+  sched_param param;
+  param.sched_priority = 0;
+  if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+    MLPD_WARN("MetricsExporter: Failed to lower the thread's priority\n");
+  }
+
+  while (running_ == true) {
+    pollfd pfd = {listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kExporterPollMs) <= 0) {
+      continue;
+    }
+    const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    Serve(fd);
+    close(fd);
+  }
+}
+
+void MetricsExporter::Serve(int fd) {
+  bool is_http = false;
+  pollfd pfd = {fd, POLLIN, 0};
+  if (poll(&pfd, 1, kRequestWaitMs) > 0) {
+    char request[1024];
+    const ssize_t len = recv(fd, request, sizeof(request), MSG_DONTWAIT);
+    is_http = (len >= 4) && (std::memcmp(request, "GET ", 4) == 0);
+  }
+
+  const std::string body = metrics_->Render();
+  std::string response;
+  if (is_http == true) {
+    response =
+        "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " +
+        std::to_string(body.size()) + "\r\n\r\n";
+  }
+  response += body;
+
+  size_t sent = 0;
+  while (sent < response.size()) {
+    const ssize_t ret = send(fd, response.data() + sent,
+                             response.size() - sent, MSG_NOSIGNAL);
+    if (ret <= 0) {
+      return;
+    }
+    sent += ret;
+  }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file metrics.h
+ * @brief Declaration file for the Metrics registry and the MetricsExporter,
+ * which serves the metrics in the Prometheus text format on a Unix domain
+ * socket.
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// A counter or gauge value. Each value has one writer thread, so updates
+/// are plain relaxed loads and stores, and the exporter reads them without
+/// blocking the writer.
+class alignas(64) MetricValue {
+ public:
+  inline void Add(double delta) {
+    value_.store(value_.load(std::memory_order_relaxed) + delta,
+                 std::memory_order_relaxed);
+  }
+  inline void Set(double value) {
+    value_.store(value, std::memory_order_relaxed);
+  }
+  inline double Get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+/**
+ * @brief The registry of metrics that Agora exports.
+ *
+ * Metrics can be registered at any time, including while the exporter
+ * renders them. Registered values stay at the same address until the
+ * registry is destroyed.
+ */
+class Metrics {
+ public:
+  /// Register a counter. [labels] are Prometheus labels without braces, e.g.
+  /// "thread=\"0\"". Metrics of the same [name] differ in their labels.
+  MetricValue* AddCounter(const std::string& name, const std::string& help,
+                          const std::string& labels = "");
+
+  /// Register a gauge
+  MetricValue* AddGauge(const std::string& name, const std::string& help,
+                        const std::string& labels = "");
+
+  /// Register a gauge whose value [sample] returns when the metrics are
+  /// rendered, e.g., a queue depth. [sample] runs in the exporter thread.
+  void AddSampledGauge(const std::string& name, const std::string& help,
+                       const std::string& labels,
+                       std::function<double()> sample);
+
+  /// The current metrics in the Prometheus text exposition format
+  std::string Render() const;
+
+ private:
+  enum class MetricType { kCounter, kGauge };
+  struct Metric {
+    std::string name_;
+    std::string help_;
+    std::string labels_;
+    MetricType type_;
+    const MetricValue* value_;
+    std::function<double()> sample_;
+  };
+
+  MetricValue* Add(const std::string& name, const std::string& help,
+                   const std::string& labels, MetricType type);
+
+  mutable std::mutex mutex_;  // Guards registration against rendering
+  std::deque<MetricValue> values_;
+  std::vector<Metric> metrics_;
+};
+
+/**
+ * @brief A low-priority thread that serves [metrics] on the Unix domain
+ * socket at [socket_path].
+ *
+ * Clients that send an HTTP request, e.g.,
+ * "curl --unix-socket <path> http://localhost/metrics", get an HTTP
+ * response; other clients get the plain text.
+ */
+class MetricsExporter {
+ public:
+  MetricsExporter(const std::string& socket_path, const Metrics* metrics);
+  ~MetricsExporter();
+
+ private:
+  void Loop();
+  void Serve(int fd);
+
+  const std::string socket_path_;
+  const Metrics* metrics_;
+  int listen_fd_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+#endif  // METRICS_H_
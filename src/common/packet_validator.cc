@@ -0,0 +1,145 @@
+/**
+ * @file packet_validator.cc
+ * @brief Implementation file for the PacketValidator class.
+ */
+
+#include "packet_validator.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "utils.h"
+
+static_assert(offsetof(Packet, frame_id_) == 0 &&
+                  offsetof(Packet, symbol_id_) == 4 &&
+                  offsetof(Packet, cell_id_) == 8 &&
+                  offsetof(Packet, ant_id_) == 12,
+              "PacketValidator loads the packet IDs as one vector");
+
+PacketValidator::PacketValidator(const PacketValidator& other) {
+  *this = other;
+}
+
+PacketValidator& PacketValidator::operator=(const PacketValidator& other) {
+  biased_limits_ = other.biased_limits_;
+  is_rx_symbol_ = other.is_rx_symbol_;
+  frame_wnd_ = other.frame_wnd_;
+  ant_per_cell_ = other.ant_per_cell_;
+  num_ants_ = other.num_ants_;
+  packet_length_ = other.packet_length_;
+  check_checksum_ = other.check_checksum_;
+  slot_frame_ = other.slot_frame_;
+  received_ = other.received_;
+  own_drops_ = other.own_drops_;
+  drops_ = (other.drops_ == other.own_drops_.data()) ? own_drops_.data()
+                                                     : other.drops_;
+  return *this;
+}
+
+void PacketValidator::Init(size_t frame_wnd, size_t num_cells,
+                           size_t ant_per_cell,
+                           const std::vector<bool>& is_rx_symbol,
+                           size_t packet_length, bool check_checksum,
+                           size_t* drops) {
+  RtAssert(frame_wnd > 0, "PacketValidator: Empty frame window");
+  RtAssert(packet_length >= Packet::kOffsetOfData,
+           "PacketValidator: Packets are shorter than their header");
+  const __m128i limits = _mm_set_epi32(
+      static_cast<int>(ant_per_cell), static_cast<int>(num_cells),
+      static_cast<int>(is_rx_symbol.size()), static_cast<int>(UINT32_MAX));
+  biased_limits_ = _mm_xor_si128(limits, _mm_set1_epi32(INT_MIN));
+  is_rx_symbol_ = is_rx_symbol;
+  frame_wnd_ = frame_wnd;
+  ant_per_cell_ = ant_per_cell;
+  num_ants_ = num_cells * ant_per_cell;
+  packet_length_ = packet_length;
+  check_checksum_ = check_checksum;
+
+  // Slot i starts out tracking frame i, which has received nothing yet
+  slot_frame_.resize(frame_wnd);
+  received_.resize(frame_wnd);
+  const size_t num_words = ((is_rx_symbol.size() * num_ants_) + 63) / 64;
+  for (size_t slot = 0; slot < frame_wnd; slot++) {
+    slot_frame_.at(slot) = slot;
+    received_.at(slot).assign(num_words, 0);
+  }
+
+  own_drops_.fill(0);
+  drops_ = (drops != nullptr) ? drops : own_drops_.data();
+}
+
+bool PacketValidator::Check(const Packet* pkt) {
+  if (pkt->magic_ != Packet::kMagic) {
+    CountDrop(RxDropReason::kBadMagic);
+    return false;
+  }
+
+  // Compare the four IDs against their limits at once. SSE only compares
+  // signed integers, so both sides are offset by 2^31.
+  const __m128i ids = _mm_xor_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(pkt)),
+      _mm_set1_epi32(INT_MIN));
+  if (_mm_movemask_epi8(_mm_cmplt_epi32(ids, biased_limits_)) != 0xffff) {
+    CountDrop(RxDropReason::kOutOfRange);
+    return false;
+  }
+  if (is_rx_symbol_[pkt->symbol_id_] == false) {
+    CountDrop(RxDropReason::kOutOfRange);
+    return false;
+  }
+
+  if ((check_checksum_ == true) &&
+      (Checksum(pkt, packet_length_) != pkt->checksum_)) {
+    CountDrop(RxDropReason::kBadChecksum);
+    return false;
+  }
+
+  const size_t frame_id = pkt->frame_id_;
+  const size_t slot = frame_id % frame_wnd_;
+  std::vector<uint64_t>& received = received_[slot];
+  if (frame_id != slot_frame_[slot]) {
+    if (frame_id < slot_frame_[slot]) {
+      CountDrop(RxDropReason::kStale);
+      return false;
+    }
+    slot_frame_[slot] = frame_id;
+    std::fill(received.begin(), received.end(), 0);
+  }
+
+  const size_t bit = (pkt->symbol_id_ * num_ants_) +
+                     (pkt->cell_id_ * ant_per_cell_) + pkt->ant_id_;
+  const uint64_t mask = uint64_t{1} << (bit % 64);
+  if ((received[bit / 64] & mask) != 0) {
+    CountDrop(RxDropReason::kDuplicate);
+    return false;
+  }
+  received[bit / 64] |= mask;
+  return true;
+}
+
+uint32_t PacketValidator::Checksum(const Packet* pkt, size_t packet_length) {
+  // The header with a zero checksum, then the data
+  std::array<uint64_t, Packet::kOffsetOfData / sizeof(uint64_t)> header;
+  std::memcpy(header.data(), pkt, Packet::kOffsetOfData);
+  std::memset(reinterpret_cast<uint8_t*>(header.data()) +
+                  offsetof(Packet, checksum_),
+              0, sizeof(pkt->checksum_));
+
+  uint64_t crc = UINT32_MAX;
+  for (uint64_t word : header) {
+    crc = _mm_crc32_u64(crc, word);
+  }
+  const auto* data = reinterpret_cast<const uint8_t*>(pkt->data_);
+  const size_t data_len = packet_length - Packet::kOffsetOfData;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= data_len; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  for (; i < data_len; i++) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), data[i]);
+  }
+  return static_cast<uint32_t>(crc) ^ UINT32_MAX;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file packet_validator.h
+ * @brief Declaration file for the PacketValidator class, which rejects
+ * malformed, stale and duplicate fronthaul packets before they reach the
+ * master thread.
+ */
+
+#ifndef PACKET_VALIDATOR_H_
+#define PACKET_VALIDATOR_H_
+
+#include <immintrin.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+
+// Reasons for a receiving thread to drop a packet
+enum class RxDropReason : size_t {
+  kBadLength,    // The datagram is not one packet long
+  kBadMagic,     // The header does not carry Packet::kMagic
+  kOutOfRange,   // An ID is out of range, or the symbol is not received
+  kBadChecksum,  // The packet checksum does not match
+  kStale,        // The frame's slot already holds a newer frame
+  kDuplicate,    // The antenna's packet for the symbol already arrived
+  kRxDropReasonEnd
+};
+static constexpr size_t kNumRxDropReasons =
+    static_cast<size_t>(RxDropReason::kRxDropReasonEnd);
+
+/**
+ * @brief Checks the header of each received packet against the
+ * configuration, and tracks the packets received for each frame slot to drop
+ * duplicates.
+ *
+ * Used by one receiving thread only, so duplicates are only caught among the
+ * packets that thread receives.
+ */
+class PacketValidator {
+ public:
+  PacketValidator() = default;
+  /// Copies count drops into their own counters, unless the copied validator
+  /// counts into an external array
+  PacketValidator(const PacketValidator& other);
+  PacketValidator& operator=(const PacketValidator& other);
+
+  /**
+   * @brief Set up the checks for a window of [frame_wnd] frames with
+   * [num_cells] cells of [ant_per_cell] antennas.
+   *
+   * @param is_rx_symbol Whether each symbol of a frame is received
+   * @param packet_length The bytes in a packet, for checksums
+   * @param check_checksum Whether to verify packet checksums
+   * @param drops kNumRxDropReasons drop counters to update, or nullptr to
+   * count internally
+   */
+  void Init(size_t frame_wnd, size_t num_cells, size_t ant_per_cell,
+            const std::vector<bool>& is_rx_symbol, size_t packet_length,
+            bool check_checksum, size_t* drops = nullptr);
+
+  /// Return true if [pkt] should go to the master, or count the reason for
+  /// dropping it and return false. Accepting a packet marks it as received.
+  bool Check(const Packet* pkt);
+
+  inline void CountDrop(RxDropReason reason) {
+    drops_[static_cast<size_t>(reason)]++;
+  }
+
+  inline size_t NumDrops(RxDropReason reason) const {
+    return drops_[static_cast<size_t>(reason)];
+  }
+
+  /// The CRC32C of the [packet_length] bytes of [pkt], with its checksum
+  /// field taken as zero
+  static uint32_t Checksum(const Packet* pkt, size_t packet_length);
+
+  /// Fill in the checksum field of [pkt], once its contents are final
+  static inline void StampChecksum(Packet* pkt, size_t packet_length) {
+    pkt->checksum_ = Checksum(pkt, packet_length);
+  }
+
+ private:
+  /// The limits of the frame, symbol, cell and antenna IDs, in that order,
+  /// offset by 2^31 for unsigned comparisons
+  __m128i biased_limits_;
+  std::vector<bool> is_rx_symbol_;
+  size_t frame_wnd_ = 0;
+  size_t ant_per_cell_ = 0;
+  size_t num_ants_ = 0;
+  size_t packet_length_ = 0;
+  bool check_checksum_ = false;
+
+  /// The frame whose packets each frame slot tracks
+  std::vector<size_t> slot_frame_;
+  /// Bits of the packets received per frame slot, by symbol and antenna
+  std::vector<std::vector<uint64_t>> received_;
+
+  std::array<size_t, kNumRxDropReasons> own_drops_{};
+  size_t* drops_ = own_drops_.data();
+};
+
+#endif  // PACKET_VALIDATOR_H_
@@ -0,0 +1,106 @@
+/**
+ * @file perf_counters.cc
+ * @brief Implementation file for the PerfCounters class.
+ */
+#include "perf_counters.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger.h"
+
+PerfCounters::PerfCounters() {
+  this->fds_.fill(-1);
+  this->pages_.fill(nullptr);
+
+  if (Open(Event::kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES) ==
+      true) {
+    this->hardware_ = true;
+    // Counters that the CPU lacks are left out
+    Open(Event::kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    Open(Event::kLlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    Open(Event::kL1dMisses, PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    return;
+  }
+  const int hardware_errno = errno;
+  if (Open(Event::kTaskClockNs, PERF_TYPE_SOFTWARE,
+           PERF_COUNT_SW_TASK_CLOCK) == true) {
+    Open(Event::kPageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    MLPD_INFO(
+        "PerfCounters: no hardware counters (%s), counting software events\n",
+        std::strerror(hardware_errno));
+  } else {
+    MLPD_WARN(
+        "PerfCounters: perf_event_open() failed (%s). Check "
+        "kernel.perf_event_paranoid\n",
+        std::strerror(errno));
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  const long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < kNumEvents; i++) {
+    if (this->pages_[i] != nullptr) {
+      munmap(this->pages_[i], page_size);
+    }
+    if (this->fds_[i] >= 0) {
+      close(this->fds_[i]);
+    }
+  }
+}
+
+bool PerfCounters::Open(Event event, uint32_t type, uint64_t config) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  // Counting user space only needs kernel.perf_event_paranoid <= 2
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                          this->leader_fd_, 0));
+  if (fd < 0) {
+    return false;
+  }
+  if (this->leader_fd_ < 0) {
+    this->leader_fd_ = fd;
+  }
+  const auto index = static_cast<size_t>(event);
+  this->fds_[index] = fd;
+  this->group_order_[this->num_open_] = event;
+  this->num_open_++;
+  this->counted_mask_ |= (1u << index);
+
+  // The user page of a hardware counter lets rdpmc read it
+  if (type != PERF_TYPE_SOFTWARE) {
+    void* page = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED,
+                      fd, 0);
+    if (page != MAP_FAILED) {
+      this->pages_[index] = static_cast<perf_event_mmap_page*>(page);
+    }
+  }
+  return true;
+}
+
+void PerfCounters::ReadGroup(Values& values) const {
+  if (this->leader_fd_ < 0) {
+    return;
+  }
+  // The number of counters, followed by their counts in group_order_
+  std::array<uint64_t, kNumEvents + 1> group;
+  const ssize_t ret = read(this->leader_fd_, group.data(), sizeof(group));
+  if (ret < static_cast<ssize_t>(sizeof(uint64_t))) {
+    return;
+  }
+  for (size_t i = 0; (i < group[0]) && (i < this->num_open_); i++) {
+    values[static_cast<size_t>(this->group_order_[i])] = group[i + 1];
+  }
+}
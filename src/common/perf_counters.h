@@ -0,0 +1,111 @@
+/**
+ * @file perf_counters.h
+ * @brief Declaration file for the PerfCounters class, which counts hardware
+ * events of the calling thread with perf_event_open().
+ */
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <linux/perf_event.h>
+#include <x86intrin.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The performance counters of one thread, e.g., a worker.
+ *
+ * The hardware counters are opened as one group and read in user space with
+ * rdpmc. If the kernel does not permit hardware counters (see
+ * kernel.perf_event_paranoid), or the CPU has none, e.g., in a VM, software
+ * counters are used instead, and are read with a system call. If no counter
+ * can be opened, IsOpen() returns false.
+ */
+class PerfCounters {
+ public:
+  enum class Event : size_t {
+    kCycles,
+    kInstructions,
+    kLlcMisses,
+    kL1dMisses,
+    // Software fallback
+    kTaskClockNs,
+    kPageFaults
+  };
+  static constexpr size_t kNumEvents = 6;
+  static constexpr std::array<const char*, kNumEvents> kEventNames = {
+      "cycles",     "instructions",  "LLC misses",
+      "L1D misses", "task clock ns", "page faults"};
+  using Values = std::array<uint64_t, kNumEvents>;
+
+  /// Open the counters of the calling thread
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  inline bool IsOpen() const { return this->num_open_ > 0; }
+  /// Return a bitmask of the counted events, by their Event value
+  inline uint32_t CountedMask() const { return this->counted_mask_; }
+
+  /// Read the counts of the counted events into [values]. Only the thread
+  /// that opened the counters may read them.
+  inline void Read(Values& values) const {
+    if (this->hardware_ == true) {
+      bool read_all = true;
+      for (size_t i = 0; (i < this->num_open_) && (read_all == true); i++) {
+        const auto event = static_cast<size_t>(this->group_order_[i]);
+        read_all = ReadUserPage(this->pages_[event], values[event]);
+      }
+      if (read_all == true) {
+        return;
+      }
+    }
+    ReadGroup(values);
+  }
+
+ private:
+  /// Open [event] of [type] and [config] in the group. Returns false on
+  /// failure.
+  bool Open(Event event, uint32_t type, uint64_t config);
+  /// Read the counts of the group with a system call
+  void ReadGroup(Values& values) const;
+
+  /// Read a counter with rdpmc through its user page. Returns false if the
+  /// counter is not active on the CPU or rdpmc is not permitted.
+  static inline bool ReadUserPage(const perf_event_mmap_page* page,
+                                  uint64_t& value) {
+    if (page == nullptr) {
+      return false;
+    }
+    uint32_t seq;
+    do {
+      seq = page->lock;
+      asm volatile("" ::: "memory");
+      const uint32_t index = page->index;
+      if ((page->cap_user_rdpmc == 0) || (index == 0)) {
+        return false;
+      }
+      // Sign-extend the pmc_width bits of the counter
+      const uint16_t shift = 64 - page->pmc_width;
+      const uint64_t raw = __rdpmc(static_cast<int>(index - 1));
+      const int64_t pmc = static_cast<int64_t>(raw << shift) >> shift;
+      value = page->offset + pmc;
+      asm volatile("" ::: "memory");
+    } while (page->lock != seq);
+    return true;
+  }
+
+  bool hardware_ = false;
+  size_t num_open_ = 0;
+  uint32_t counted_mask_ = 0;
+  int leader_fd_ = -1;
+  // The events in the order they were opened, which is the order of their
+  // counts in a group read
+  std::array<Event, kNumEvents> group_order_;
+  std::array<int, kNumEvents> fds_;
+  std::array<perf_event_mmap_page*, kNumEvents> pages_;
+};
+
+#endif  // PERF_COUNTERS_H_
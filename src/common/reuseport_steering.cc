@@ -0,0 +1,145 @@
+/**
+ * @file reuseport_steering.cc
+ * @brief Implementation file for SO_REUSEPORT antenna steering and the
+ * AntennaBalancer class.
+ */
+
+#include "reuseport_steering.h"
+
+#include <linux/sock_diag.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "buffer.h"
+#include "utils.h"
+
+/// Load the little-endian 16-bit field at [offset] of the UDP payload into
+/// the accumulator. Absolute loads are big-endian, so load byte by byte.
+static void LoadLe16(std::vector<sock_filter>& prog, uint32_t offset) {
+  prog.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset + 1));
+  prog.push_back(BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8));
+  prog.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+  prog.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset));
+  prog.push_back(BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0));
+}
+
+std::vector<sock_filter> BuildAntennaSteeringProgram(
+    const std::vector<size_t>& ant_to_socket, size_t ant_per_cell,
+    size_t num_sockets) {
+  RtAssert(num_sockets > 0, "Reuseport: No sockets to steer to");
+  std::vector<sock_filter> prog;
+
+  // Packet IDs fit in 16 bits, and the program sees the UDP payload
+  LoadLe16(prog, offsetof(Packet, cell_id_));
+  prog.push_back(
+      BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, static_cast<uint32_t>(ant_per_cell)));
+  prog.push_back(BPF_STMT(BPF_ST, 0));
+  LoadLe16(prog, offsetof(Packet, ant_id_));
+  prog.push_back(BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, 0));
+  prog.push_back(BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0));
+
+  // One range check per run of antennas on the same socket, in order
+  for (size_t ant = 0; ant < ant_to_socket.size();) {
+    size_t last = ant;
+    while ((last + 1 < ant_to_socket.size()) &&
+           (ant_to_socket.at(last + 1) == ant_to_socket.at(ant))) {
+      last++;
+    }
+    RtAssert(ant_to_socket.at(ant) < num_sockets,
+             "Reuseport: Antenna steered to a missing socket");
+    // If A > last, skip the return
+    prog.push_back(BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K,
+                            static_cast<uint32_t>(last), 1, 0));
+    prog.push_back(BPF_STMT(BPF_RET | BPF_K,
+                            static_cast<uint32_t>(ant_to_socket.at(ant))));
+    ant = last + 1;
+  }
+  prog.push_back(
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(num_sockets)));
+  prog.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+  RtAssert(prog.size() <= BPF_MAXINSNS, "Reuseport: Program too long");
+  return prog;
+}
+
+void AttachReuseportProgram(int fd, const std::vector<sock_filter>& program) {
+  sock_fprog fprog;
+  fprog.len = static_cast<unsigned short>(program.size());
+  fprog.filter = const_cast<sock_filter*>(program.data());
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog,
+                 sizeof(fprog)) != 0) {
+    throw std::runtime_error(
+        std::string("Reuseport: Failed to attach steering program: ") +
+        std::strerror(errno));
+  }
+}
+
+size_t SocketQueuedBytes(int fd) {
+  uint32_t meminfo[SK_MEMINFO_VARS];
+  socklen_t len = sizeof(meminfo);
+  if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) != 0) {
+    return 0;
+  }
+  return meminfo[SK_MEMINFO_RMEM_ALLOC];
+}
+
+AntennaBalancer::AntennaBalancer(size_t num_antennas, size_t num_threads)
+    : num_threads_(num_threads), ant_to_thread_(num_antennas) {
+  RtAssert(num_threads > 0, "Reuseport: No receive threads");
+  for (size_t ant = 0; ant < num_antennas; ant++) {
+    ant_to_thread_.at(ant) = ant * num_threads / num_antennas;
+  }
+}
+
+bool AntennaBalancer::Rebalance(const std::vector<size_t>& thread_depths,
+                                const std::vector<size_t>& ant_packets,
+                                size_t min_depth) {
+  size_t deep = 0;
+  size_t shallow = 0;
+  for (size_t i = 1; i < num_threads_; i++) {
+    if (thread_depths.at(i) > thread_depths.at(deep)) {
+      deep = i;
+    }
+    if (thread_depths.at(i) < thread_depths.at(shallow)) {
+      shallow = i;
+    }
+  }
+  if ((thread_depths.at(deep) < min_depth) ||
+      (thread_depths.at(deep) < 2 * thread_depths.at(shallow))) {
+    return false;
+  }
+
+  std::vector<size_t> thread_packets(num_threads_, 0);
+  std::vector<size_t> thread_ants(num_threads_, 0);
+  for (size_t ant = 0; ant < ant_to_thread_.size(); ant++) {
+    thread_packets.at(ant_to_thread_.at(ant)) += ant_packets.at(ant);
+    thread_ants.at(ant_to_thread_.at(ant))++;
+  }
+  if (thread_ants.at(deep) < 2) {
+    return false;
+  }
+
+  // Moving an antenna with p packets narrows the gap as long as p < gap
+  const size_t gap = thread_packets.at(deep) > thread_packets.at(shallow)
+                         ? thread_packets.at(deep) - thread_packets.at(shallow)
+                         : 0;
+  size_t best_ant = SIZE_MAX;
+  for (size_t ant = 0; ant < ant_to_thread_.size(); ant++) {
+    if ((ant_to_thread_.at(ant) == deep) && (ant_packets.at(ant) > 0) &&
+        (ant_packets.at(ant) < gap) &&
+        ((best_ant == SIZE_MAX) ||
+         (ant_packets.at(ant) > ant_packets.at(best_ant)))) {
+      best_ant = ant;
+    }
+  }
+  if (best_ant == SIZE_MAX) {
+    return false;
+  }
+  ant_to_thread_.at(best_ant) = shallow;
+  return true;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file reuseport_steering.h
+ * @brief Declaration file for steering received packets across an
+ * SO_REUSEPORT socket group by antenna, and for the AntennaBalancer class,
+ * which moves antennas between the group's sockets as their load changes.
+ */
+
+#ifndef REUSEPORT_STEERING_H_
+#define REUSEPORT_STEERING_H_
+
+#include <linux/filter.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Build a classic BPF program that picks a socket of an SO_REUSEPORT
+ * group for each packet from its Packet header.
+ *
+ * The program computes the combined antenna id, cell_id_ * [ant_per_cell] +
+ * ant_id_, as PacketTXRX does after receiving, and returns
+ * [ant_to_socket][antenna]. A socket's index is its position in the group,
+ * i.e., the order in which the sockets were bound. Antennas beyond the end
+ * of [ant_to_socket] are spread by antenna id modulo [num_sockets].
+ */
+std::vector<sock_filter> BuildAntennaSteeringProgram(
+    const std::vector<size_t>& ant_to_socket, size_t ant_per_cell,
+    size_t num_sockets);
+
+/// Attach [program] to the SO_REUSEPORT group of socket [fd], replacing the
+/// group's previous program. Applies to every socket of the group.
+void AttachReuseportProgram(int fd, const std::vector<sock_filter>& program);
+
+/// Bytes queued in the receive buffer of socket [fd]
+size_t SocketQueuedBytes(int fd);
+
+/**
+ * @brief Maps antennas to the receive threads of a socket group, and moves
+ * antennas off threads whose socket queues back up.
+ *
+ * Antennas start in contiguous blocks, one per thread, as in the per-radio
+ * partitioning. Rebalance() is called periodically with each thread's queue
+ * depth and the packets received per antenna since the last call.
+ */
+class AntennaBalancer {
+ public:
+  AntennaBalancer(size_t num_antennas, size_t num_threads);
+
+  /**
+   * @brief Move one antenna from the thread with the deepest queue to the
+   * one with the shallowest, if the deepest queue holds at least
+   * [min_depth] and twice the shallowest.
+   *
+   * The antenna moved is the busiest one whose packets shrink the load gap
+   * between the two threads. A thread always keeps at least one antenna.
+   *
+   * @return True if the mapping changed
+   */
+  bool Rebalance(const std::vector<size_t>& thread_depths,
+                 const std::vector<size_t>& ant_packets, size_t min_depth);
+
+  inline const std::vector<size_t>& AntToThread() const {
+    return this->ant_to_thread_;
+  }
+  inline size_t NumThreads() const { return this->num_threads_; }
+
+ private:
+  size_t num_threads_;
+  std::vector<size_t> ant_to_thread_;
+};
+
+#endif  // REUSEPORT_STEERING_H_
@@ -0,0 +1,174 @@
+/**
+ * @file shm_transport.cc
+ * @brief Implementation file for the ShmRing and ShmTransport classes.
+ */
+
+#include "shm_transport.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "logger.h"
+#include "utils.h"
+
+/// Written last by the creator, once the rings are initialized
+static constexpr uint32_t kShmReadyMagic = 0x41474f52;
+
+/// The start of the region, which attaching processes check against their
+/// own geometry
+struct ShmRegionHeader {
+  std::atomic<uint32_t> ready_;
+  uint64_t num_radios_;
+  uint64_t num_slots_;
+  uint64_t slot_size_;
+};
+
+static std::string ErrnoString(const std::string& what) {
+  return what + ": " + std::strerror(errno);
+}
+
+ShmRing::ShmRing(ShmRingControl* control, uint8_t* slots, size_t num_slots,
+                 size_t slot_size)
+    : control_(control),
+      slots_(slots),
+      num_slots_(num_slots),
+      slot_size_(slot_size) {
+  prod_head_ = control->head_.load(std::memory_order_acquire);
+  cons_tail_ = control->tail_.load(std::memory_order_acquire);
+  prod_cached_tail_ = cons_tail_;
+  cons_cached_head_ = prod_head_;
+}
+
+ShmTransport::ShmTransport(const std::string& name, bool create,
+                           size_t num_radios, size_t num_slots,
+                           size_t packet_len)
+    : name_(name), owner_(create), map_(nullptr) {
+  if ((num_slots == 0) || ((num_slots & (num_slots - 1)) != 0)) {
+    throw std::runtime_error("ShmTransport: Ring size must be a power of two");
+  }
+  const size_t slot_size = Roundup<64>(packet_len);
+  const size_t controls_offset = Roundup<64>(sizeof(ShmRegionHeader));
+  const size_t slots_offset = Roundup<4096>(
+      controls_offset + (2 * num_radios * sizeof(ShmRingControl)));
+  const size_t ring_len = num_slots * slot_size;
+  map_len_ = slots_offset + (2 * num_radios * ring_len);
+
+  int fd = -1;
+  if (create == true) {
+    // A region left behind by a crashed run would hold stale indices
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      throw std::runtime_error(
+          ErrnoString("ShmTransport: Failed to create " + name));
+    }
+    if (ftruncate(fd, static_cast<off_t>(map_len_)) != 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error(
+          ErrnoString("ShmTransport: Failed to size " + name));
+    }
+  } else {
+    // Agora may still be starting up, and sizes the region after creating it
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(kShmAttachTimeoutMs);
+    struct stat st;
+    while (true) {
+      fd = shm_open(name.c_str(), O_RDWR, 0);
+      if ((fd >= 0) && (fstat(fd, &st) == 0) && (st.st_size > 0)) {
+        break;
+      }
+      if (fd >= 0) {
+        close(fd);
+      }
+      if (std::chrono::steady_clock::now() > deadline) {
+        throw std::runtime_error("ShmTransport: Timed out waiting for " +
+                                 name);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (static_cast<size_t>(st.st_size) != map_len_) {
+      close(fd);
+      throw std::runtime_error("ShmTransport: Size of " + name +
+                               " does not match the configuration");
+    }
+  }
+
+  // Populate the mapping up front, so that no page faults hit the datapath
+  map_ = mmap(nullptr, map_len_, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (map_ == MAP_FAILED) {
+    if (create == true) {
+      shm_unlink(name.c_str());
+    }
+    throw std::runtime_error(
+        ErrnoString("ShmTransport: Failed to map " + name));
+  }
+
+  auto* base = static_cast<uint8_t*>(map_);
+  auto* header = reinterpret_cast<ShmRegionHeader*>(base);
+  auto* controls = reinterpret_cast<ShmRingControl*>(base + controls_offset);
+  if (create == true) {
+    // The new region is zeroed, so only the geometry needs to be written
+    header->num_radios_ = num_radios;
+    header->num_slots_ = num_slots;
+    header->slot_size_ = slot_size;
+    header->ready_.store(kShmReadyMagic, std::memory_order_release);
+  } else {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(kShmAttachTimeoutMs);
+    while (header->ready_.load(std::memory_order_acquire) != kShmReadyMagic) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        munmap(map_, map_len_);
+        throw std::runtime_error("ShmTransport: Timed out waiting for " +
+                                 name + " to be initialized");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if ((header->num_radios_ != num_radios) ||
+        (header->num_slots_ != num_slots) ||
+        (header->slot_size_ != slot_size)) {
+      MLPD_ERROR(
+          "ShmTransport: %s has %zu radios, %zu slots of %zu bytes, expected "
+          "%zu radios, %zu slots of %zu bytes\n",
+          name.c_str(), static_cast<size_t>(header->num_radios_),
+          static_cast<size_t>(header->num_slots_),
+          static_cast<size_t>(header->slot_size_), num_radios, num_slots,
+          slot_size);
+      munmap(map_, map_len_);
+      throw std::runtime_error("ShmTransport: Geometry of " + name +
+                               " does not match the configuration");
+    }
+  }
+
+  uplink_.reserve(num_radios);
+  downlink_.reserve(num_radios);
+  for (size_t radio_id = 0; radio_id < num_radios; radio_id++) {
+    uplink_.emplace_back(&controls[radio_id],
+                         base + slots_offset + (radio_id * ring_len),
+                         num_slots, slot_size);
+    downlink_.emplace_back(
+        &controls[num_radios + radio_id],
+        base + slots_offset + ((num_radios + radio_id) * ring_len), num_slots,
+        slot_size);
+  }
+  MLPD_INFO("ShmTransport: %s %s, %zu radios, %zu slots of %zu bytes\n",
+            create ? "Created" : "Attached to", name.c_str(), num_radios,
+            num_slots, slot_size);
+}
+
+ShmTransport::~ShmTransport() {
+  munmap(map_, map_len_);
+  if (owner_ == true) {
+    shm_unlink(name_.c_str());
+  }
+}
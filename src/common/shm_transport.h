@@ -0,0 +1,140 @@
+/**
+ * @file shm_transport.h
+ * @brief Declaration file for the ShmRing and ShmTransport classes, which
+ * carry packets between Agora and a simulator on the same host through
+ * single-producer/single-consumer rings in POSIX shared memory.
+ */
+
+#ifndef SHM_TRANSPORT_H_
+#define SHM_TRANSPORT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// How long a simulator waits for Agora to create the region
+static constexpr size_t kShmAttachTimeoutMs = 60000;
+
+/// The indices of a ring, shared by its producer and its consumer. Each one
+/// counts the slots pushed or popped so far and is written by one side only.
+struct ShmRingControl {
+  alignas(64) std::atomic<uint64_t> head_;  // Written by the producer
+  alignas(64) std::atomic<uint64_t> tail_;  // Written by the consumer
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory rings need address-free atomics");
+
+/**
+ * @brief A process-local view of a ring of fixed-size packet slots in shared
+ * memory.
+ *
+ * One thread produces and one thread consumes, possibly in different
+ * processes. The producer builds a packet in place in the slot returned by
+ * Reserve() and publishes it with Commit(); the consumer reads the slot
+ * returned by Front() and frees it with Pop(). Each side caches the other
+ * side's index, so the shared indices are only read when the ring looks full
+ * or empty. There is no wakeup: consumers poll, as the TXRX threads already
+ * poll their sockets.
+ */
+class ShmRing {
+ public:
+  ShmRing(ShmRingControl* control, uint8_t* slots, size_t num_slots,
+          size_t slot_size);
+
+  /// The slot for the next packet, or nullptr if the ring is full. Called by
+  /// the producer only.
+  inline uint8_t* Reserve() {
+    if (prod_head_ - prod_cached_tail_ == num_slots_) {
+      prod_cached_tail_ = control_->tail_.load(std::memory_order_acquire);
+      if (prod_head_ - prod_cached_tail_ == num_slots_) {
+        return nullptr;
+      }
+    }
+    return Slot(prod_head_);
+  }
+
+  /// Publish the packet built in the slot from Reserve()
+  inline void Commit() {
+    prod_head_++;
+    control_->head_.store(prod_head_, std::memory_order_release);
+  }
+
+  /// The oldest packet, or nullptr if the ring is empty. Called by the
+  /// consumer only.
+  inline const uint8_t* Front() {
+    if (cons_tail_ == cons_cached_head_) {
+      cons_cached_head_ = control_->head_.load(std::memory_order_acquire);
+      if (cons_tail_ == cons_cached_head_) {
+        return nullptr;
+      }
+    }
+    return Slot(cons_tail_);
+  }
+
+  /// Free the slot of the packet from Front()
+  inline void Pop() {
+    cons_tail_++;
+    control_->tail_.store(cons_tail_, std::memory_order_release);
+  }
+
+  inline size_t NumSlots() const { return this->num_slots_; }
+  inline size_t SlotSize() const { return this->slot_size_; }
+
+ private:
+  inline uint8_t* Slot(uint64_t index) const {
+    return slots_ + ((index & (num_slots_ - 1)) * slot_size_);
+  }
+
+  ShmRingControl* control_;
+  uint8_t* slots_;
+  size_t num_slots_;
+  size_t slot_size_;
+
+  // Producer and consumer state sit on separate cache lines, since the two
+  // sides may be threads of the same process
+  alignas(64) uint64_t prod_head_;
+  uint64_t prod_cached_tail_;
+  alignas(64) uint64_t cons_tail_;
+  uint64_t cons_cached_head_;
+};
+
+/**
+ * @brief A POSIX shared memory region with an uplink and a downlink ring per
+ * radio, in place of the radios' UDP ports.
+ *
+ * Agora creates the region, replacing any stale one of the same name, and
+ * removes it when destroyed. Simulators attach to it, waiting until Agora
+ * has created it, and must use the same geometry. The simulator produces
+ * into the uplink rings and Agora into the downlink rings; each ring must
+ * have a single producer and a single consumer thread.
+ */
+class ShmTransport {
+ public:
+  /**
+   * @param name The region's name, starting with '/'
+   * @param create True to create the region (Agora), false to attach to it
+   * @param num_radios One uplink and one downlink ring per radio
+   * @param num_slots Packets per ring, a power of two
+   * @param packet_len The largest packet carried in either direction
+   */
+  ShmTransport(const std::string& name, bool create, size_t num_radios,
+               size_t num_slots, size_t packet_len);
+  ~ShmTransport();
+
+  inline ShmRing& Uplink(size_t radio_id) { return uplink_.at(radio_id); }
+  inline ShmRing& Downlink(size_t radio_id) { return downlink_.at(radio_id); }
+  inline size_t NumRadios() const { return this->uplink_.size(); }
+
+ private:
+  std::string name_;
+  bool owner_;
+  void* map_;
+  size_t map_len_;
+
+  std::vector<ShmRing> uplink_;
+  std::vector<ShmRing> downlink_;
+};
+
+#endif  // SHM_TRANSPORT_H_
@@ -3,6 +3,7 @@
 
 #include <mkl.h>
 
+#include <array>
 #include <map>
 #include <string>
 
@@ -13,9 +14,10 @@
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
 
-// Number of frames received that we allocate space for in worker threads. This
-// is the frame window that we track in Agora.
-static constexpr size_t kFrameWnd = 40;
+// Default number of frames received that we allocate space for in worker
+// threads. This is the frame window that we track in Agora. The window is set
+// at runtime by the "frame_window" config key (see Config::FrameWnd()).
+static constexpr size_t kDefaultFrameWnd = 32;
 
 #define TX_FRAME_DELTA 8
 #define SETTLE_TIME_MS 1
@@ -50,9 +52,11 @@ enum class EventType : int {
   kPacketFromMac,
   kPacketToMac,
   kFFTPilot,
-  kSNRReport,   // Signal new SNR measurement from PHY to MAC
-  kRANUpdate,   // Signal new RAN config to Agora
-  kRBIndicator  // Signal RB schedule to UEs
+  kSNRReport,      // Signal new SNR measurement from PHY to MAC
+  kRANUpdate,      // Signal new RAN config to Agora
+  kRBIndicator,    // Signal RB schedule to UEs
+  kFrameDropped,   // Signal an aborted frame from PHY to MAC
+  kDownlinkFrame   // Signal a frame's downlink to the downlink master
 };
 static constexpr size_t kNumEventTypes =
     static_cast<size_t>(EventType::kPacketToMac) + 1;
@@ -253,6 +257,11 @@ static constexpr size_t kNumStatsFrames = 10000;
 // If true, enable timing measurements in workers
 static constexpr bool kIsWorkerTimingEnabled = true;
 
+// If true, workers count completed ZF, demodulation, decode, and precode tasks
+// in shared atomic counters. Only the worker that completes a symbol notifies
+// the master thread, instead of one completion event per task.
+static constexpr bool kUseAtomicFrameCounters = true;
+
 // Maximum breakdown of a statistic (e.g., timing)
 static constexpr size_t kMaxStatsBreakdown = 4;
 
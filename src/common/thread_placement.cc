@@ -0,0 +1,346 @@
+/**
+ * @file thread_placement.cc
+ * @brief Implementation file for the CPU topology reader and the thread
+ * placement planner
+ */
+#include "thread_placement.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+#include "logger.h"
+#include "utils.h"
+
+// The highest cache index read from sysfs
+static constexpr size_t kMaxCacheIndex = 8;
+
+/// Return the first line of a sysfs file, or an empty string if the file
+/// does not exist
+static std::string ReadSysfsLine(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  if (file.is_open() == true) {
+    std::getline(file, line);
+  }
+  return line;
+}
+
+CpuTopology::CpuTopology(std::vector<CpuInfo> cpus) : cpus_(std::move(cpus)) {
+  RtAssert(cpus_.empty() == false, "CpuTopology: no CPUs");
+  std::sort(cpus_.begin(), cpus_.end(),
+            [](const CpuInfo& a, const CpuInfo& b) {
+              return a.cpu_id_ < b.cpu_id_;
+            });
+}
+
+std::vector<size_t> CpuTopology::ParseCpuList(const std::string& cpu_list) {
+  std::vector<size_t> cpus;
+  std::stringstream list_stream(cpu_list);
+  std::string range;
+  while (std::getline(list_stream, range, ',')) {
+    if (range.find_first_of("0123456789") == std::string::npos) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const size_t first = std::stoul(range.substr(0, dash));
+    const size_t last = (dash == std::string::npos)
+                            ? first
+                            : std::stoul(range.substr(dash + 1));
+    for (size_t cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+CpuTopology CpuTopology::FromSysfs(const std::string& cpu_dir) {
+  const std::vector<size_t> online =
+      ParseCpuList(ReadSysfsLine(cpu_dir + "/online"));
+  RtAssert(online.empty() == false,
+           "CpuTopology: no online CPUs in " + cpu_dir);
+
+  std::vector<CpuInfo> cpus;
+  for (size_t cpu_id : online) {
+    const std::string cpu_path = cpu_dir + "/cpu" + std::to_string(cpu_id);
+    CpuInfo cpu;
+    cpu.cpu_id_ = cpu_id;
+
+    const std::vector<size_t> siblings = ParseCpuList(
+        ReadSysfsLine(cpu_path + "/topology/thread_siblings_list"));
+    cpu.core_id_ = siblings.empty()
+                       ? cpu_id
+                       : *std::min_element(siblings.begin(), siblings.end());
+
+    // The last-level cache is the highest cache level. Without cache
+    // information, the package is the last-level cache group.
+    const std::string package =
+        ReadSysfsLine(cpu_path + "/topology/physical_package_id");
+    cpu.llc_id_ = package.empty() ? 0 : std::stoul(package);
+    size_t llc_level = 0;
+    for (size_t index = 0; index < kMaxCacheIndex; index++) {
+      const std::string cache_path =
+          cpu_path + "/cache/index" + std::to_string(index);
+      const std::string level = ReadSysfsLine(cache_path + "/level");
+      if (level.empty() == true) {
+        continue;
+      }
+      const std::vector<size_t> shared =
+          ParseCpuList(ReadSysfsLine(cache_path + "/shared_cpu_list"));
+      if ((std::stoul(level) > llc_level) && (shared.empty() == false)) {
+        llc_level = std::stoul(level);
+        cpu.llc_id_ = *std::min_element(shared.begin(), shared.end());
+      }
+    }
+
+    // The NUMA node appears as a nodeN entry in the CPU directory
+    cpu.numa_node_ = 0;
+    DIR* dir = opendir(cpu_path.c_str());
+    if (dir != nullptr) {
+      struct dirent* entry;
+      while ((entry = readdir(dir)) != nullptr) {
+        const std::string name(entry->d_name);
+        if ((name.rfind("node", 0) == 0) && (name.size() > 4) &&
+            (std::isdigit(name.at(4)) != 0)) {
+          cpu.numa_node_ = std::stoul(name.substr(4));
+        }
+      }
+      closedir(dir);
+    }
+    cpus.push_back(cpu);
+  }
+  return CpuTopology(cpus);
+}
+
+int CpuTopology::NicNumaNode(const std::string& net_dir,
+                             const std::string& nic) {
+  const std::string node =
+      ReadSysfsLine(net_dir + "/" + nic + "/device/numa_node");
+  return node.empty() ? -1 : std::stoi(node);
+}
+
+const CpuInfo& CpuTopology::Cpu(size_t cpu_id) const {
+  auto cpu = std::lower_bound(
+      cpus_.begin(), cpus_.end(), cpu_id,
+      [](const CpuInfo& a, size_t id) { return a.cpu_id_ < id; });
+  RtAssert((cpu != cpus_.end()) && (cpu->cpu_id_ == cpu_id),
+           "CpuTopology: CPU " + std::to_string(cpu_id) + " is not online");
+  return *cpu;
+}
+
+ThreadPlacement::ThreadPlacement(const CpuTopology& topology,
+                                 const PlacementRoles& roles,
+                                 const PlacementConstraints& constraints)
+    : topology_(topology) {
+  std::set<size_t> used_cpus;
+  std::set<size_t> used_cores;
+  auto take = [&](size_t cpu_id, std::vector<size_t>& role_cores) {
+    role_cores.push_back(cpu_id);
+    used_cpus.insert(cpu_id);
+    used_cores.insert(topology_.Cpu(cpu_id).core_id_);
+  };
+
+  // Explicit cores from the config
+  auto take_explicit = [&](const std::string& role, size_t num_threads,
+                           std::vector<size_t>& role_cores) {
+    auto explicit_cores = constraints.cores_.find(role);
+    if (explicit_cores == constraints.cores_.end()) {
+      return false;
+    }
+    RtAssert(explicit_cores->second.size() >= num_threads,
+             "thread_placement: fewer " + role + " cores than threads");
+    for (size_t i = 0; i < num_threads; i++) {
+      take(explicit_cores->second.at(i), role_cores);
+    }
+    return true;
+  };
+  const bool explicit_master =
+      take_explicit("master", roles.num_masters_, master_cores_);
+  const bool explicit_txrx =
+      take_explicit("txrx", roles.num_txrx_, txrx_cores_);
+  const bool explicit_mac = take_explicit("mac", roles.num_mac_, mac_cores_);
+  const bool explicit_workers =
+      take_explicit("worker", roles.num_workers_, worker_cores_);
+
+  // Core 0 is reserved for kernel threads
+  std::vector<const CpuInfo*> usable;
+  for (const auto& cpu : topology_.Cpus()) {
+    if ((cpu.cpu_id_ != 0) || (topology_.Cpus().size() == 1)) {
+      usable.push_back(&cpu);
+    }
+  }
+  const size_t io_node = (constraints.nic_numa_node_ >= 0)
+                             ? constraints.nic_numa_node_
+                             : usable.at(0)->numa_node_;
+
+  // Take the first CPU in order that is unused, and on an unused physical
+  // core if whole_core is set. If all CPUs are used, CPUs are shared.
+  auto pick = [&](const std::vector<const CpuInfo*>& order, size_t num_threads,
+                  std::vector<size_t>& role_cores) {
+    for (size_t i = 0; i < num_threads; i++) {
+      const CpuInfo* picked = nullptr;
+      for (bool whole_core : {constraints.avoid_smt_siblings_, false}) {
+        for (const CpuInfo* cpu : order) {
+          if ((picked == nullptr) && (used_cpus.count(cpu->cpu_id_) == 0) &&
+              ((whole_core == false) ||
+               (used_cores.count(cpu->core_id_) == 0))) {
+            picked = cpu;
+          }
+        }
+      }
+      if (picked == nullptr) {
+        picked = order.at(i % order.size());
+        MLPD_WARN("ThreadPlacement: too few cores, CPU %zu is shared\n",
+                  picked->cpu_id_);
+      }
+      take(picked->cpu_id_, role_cores);
+    }
+  };
+
+  // The master, TXRX, and MAC threads are packed on the NIC's NUMA node
+  std::vector<const CpuInfo*> io_order = usable;
+  std::stable_sort(io_order.begin(), io_order.end(),
+                   [io_node](const CpuInfo* a, const CpuInfo* b) {
+                     return std::make_tuple(a->numa_node_ != io_node,
+                                            a->llc_id_, a->cpu_id_) <
+                            std::make_tuple(b->numa_node_ != io_node,
+                                            b->llc_id_, b->cpu_id_);
+                   });
+  if (explicit_master == false) {
+    pick(io_order, roles.num_masters_, master_cores_);
+  }
+  if (explicit_txrx == false) {
+    pick(io_order, roles.num_txrx_, txrx_cores_);
+  }
+  if (explicit_mac == false) {
+    pick(io_order, roles.num_mac_, mac_cores_);
+  }
+
+  // Workers prefer last-level cache groups without I/O threads
+  std::set<size_t> io_llcs;
+  for (const auto* io_cores : {&master_cores_, &txrx_cores_, &mac_cores_}) {
+    for (size_t cpu_id : *io_cores) {
+      io_llcs.insert(topology_.Cpu(cpu_id).llc_id_);
+    }
+  }
+  if (explicit_workers == false) {
+    std::vector<const CpuInfo*> worker_order = usable;
+    std::stable_sort(
+        worker_order.begin(), worker_order.end(),
+        [&io_llcs, io_node](const CpuInfo* a, const CpuInfo* b) {
+          return std::make_tuple(io_llcs.count(a->llc_id_) > 0,
+                                 a->numa_node_ != io_node, a->llc_id_,
+                                 a->cpu_id_) <
+                 std::make_tuple(io_llcs.count(b->llc_id_) > 0,
+                                 b->numa_node_ != io_node, b->llc_id_,
+                                 b->cpu_id_);
+        });
+    pick(worker_order, roles.num_workers_, worker_cores_);
+  }
+
+  if (roles.bigstation_ == false) {
+    worker_types_.assign(roles.num_workers_, ThreadType::kWorker);
+    return;
+  }
+
+  // Bigstation workers are numbered by role, but the CPUs in worker_cores_
+  // are grouped by last-level cache. With colocate_fft_demul_, FFT and demul
+  // workers alternate in proportion to their counts along the CPUs, so each
+  // cache group holds both.
+  const size_t num_fft = roles.num_fft_;
+  const size_t num_demul = roles.num_demul_;
+  RtAssert(num_fft + roles.num_zf_ + num_demul <= roles.num_workers_,
+           "ThreadPlacement: more Bigstation workers than worker threads");
+  const size_t first_zf = num_fft;
+  const size_t first_demul = first_zf + roles.num_zf_;
+  const size_t first_decode = first_demul + num_demul;
+  std::vector<size_t> planned_cores(roles.num_workers_);
+  worker_types_.resize(roles.num_workers_);
+  size_t fft_id = 0;
+  size_t zf_id = first_zf;
+  size_t demul_id = first_demul;
+  size_t decode_id = first_decode;
+  for (size_t cpu_id : worker_cores_) {
+    size_t tid;
+    const bool fft_next =
+        (constraints.colocate_fft_demul_ == true)
+            ? ((fft_id < num_fft) &&
+               ((demul_id == first_decode) ||
+                (fft_id * num_demul <= (demul_id - first_demul) * num_fft)))
+            : (fft_id < num_fft);
+    const bool demul_next =
+        (constraints.colocate_fft_demul_ == true) && (demul_id < first_decode);
+    if (fft_next == true) {
+      tid = fft_id++;
+      worker_types_.at(tid) = ThreadType::kWorkerFFT;
+    } else if (demul_next == true) {
+      tid = demul_id++;
+      worker_types_.at(tid) = ThreadType::kWorkerDemul;
+    } else if (zf_id < first_demul) {
+      tid = zf_id++;
+      worker_types_.at(tid) = ThreadType::kWorkerZF;
+    } else if (demul_id < first_decode) {
+      tid = demul_id++;
+      worker_types_.at(tid) = ThreadType::kWorkerDemul;
+    } else {
+      tid = decode_id++;
+      worker_types_.at(tid) = ThreadType::kWorkerDecode;
+    }
+    planned_cores.at(tid) = cpu_id;
+  }
+  worker_cores_ = planned_cores;
+}
+
+const std::vector<size_t>* ThreadPlacement::RoleCores(
+    ThreadType thread_type) const {
+  switch (thread_type) {
+    case ThreadType::kMaster:
+      return &master_cores_;
+    case ThreadType::kWorkerTXRX:
+      return &txrx_cores_;
+    case ThreadType::kWorkerMacTXRX:
+      return &mac_cores_;
+    case ThreadType::kWorker:
+    case ThreadType::kWorkerFFT:
+    case ThreadType::kWorkerZF:
+    case ThreadType::kWorkerDemul:
+    case ThreadType::kWorkerDecode:
+      return &worker_cores_;
+    default:
+      return nullptr;
+  }
+}
+
+int ThreadPlacement::Core(ThreadType thread_type, size_t thread_id) const {
+  const std::vector<size_t>* cores = RoleCores(thread_type);
+  if ((cores == nullptr) || (thread_id >= cores->size())) {
+    return -1;
+  }
+  return static_cast<int>(cores->at(thread_id));
+}
+
+std::string ThreadPlacement::RoleToString(
+    const std::string& role_name, const std::vector<size_t>& cores) const {
+  std::stringstream ss;
+  for (size_t i = 0; i < cores.size(); i++) {
+    const CpuInfo& cpu = topology_.Cpu(cores.at(i));
+    const std::string name =
+        (&cores == &worker_cores_) ? ThreadTypeStr(worker_types_.at(i))
+                                   : role_name;
+    ss << "  " << name << " thread " << i << ": CPU " << cpu.cpu_id_
+       << " (core " << cpu.core_id_ << ", LLC " << cpu.llc_id_ << ", node "
+       << cpu.numa_node_ << ")\n";
+  }
+  return ss.str();
+}
+
+std::string ThreadPlacement::ToString() const {
+  return "Thread placement:\n" + RoleToString("Master", master_cores_) +
+         RoleToString("TXRX", txrx_cores_) + RoleToString("MAC", mac_cores_) +
+         RoleToString("Worker", worker_cores_);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file thread_placement.h
+ * @brief Declaration file for the CPU topology reader and the planner that
+ * assigns the cores of the master, TXRX, MAC, and worker threads
+ */
+#ifndef THREAD_PLACEMENT_H_
+#define THREAD_PLACEMENT_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+
+/// One logical CPU and the resources it shares with other CPUs
+struct CpuInfo {
+  size_t cpu_id_;
+  // CPUs with the same core_id_ are SMT siblings
+  size_t core_id_;
+  // CPUs with the same llc_id_ share the last-level cache (L3, or a CCX on
+  // AMD processors)
+  size_t llc_id_;
+  size_t numa_node_;
+};
+
+class CpuTopology {
+ public:
+  explicit CpuTopology(std::vector<CpuInfo> cpus);
+
+  /// Read the online CPUs from a sysfs CPU directory such as
+  /// /sys/devices/system/cpu
+  static CpuTopology FromSysfs(const std::string& cpu_dir);
+
+  /// Return the NUMA node of network interface [nic] from a sysfs network
+  /// directory such as /sys/class/net, or -1 if it is unknown
+  static int NicNumaNode(const std::string& net_dir, const std::string& nic);
+
+  /// Parse a sysfs CPU list such as "0-3,8,10-11"
+  static std::vector<size_t> ParseCpuList(const std::string& cpu_list);
+
+  inline const std::vector<CpuInfo>& Cpus() const { return this->cpus_; }
+  /// Return the CPU with id cpu_id. The CPU must be online.
+  const CpuInfo& Cpu(size_t cpu_id) const;
+
+ private:
+  // Sorted by cpu_id_
+  std::vector<CpuInfo> cpus_;
+};
+
+/// Constraints on the placement of threads, from the "thread_placement"
+/// object of the config
+struct PlacementConstraints {
+  // Give each worker a physical core of its own
+  bool avoid_smt_siblings_ = true;
+  // Put each FFT worker in a last-level cache group with demul workers
+  // (Bigstation mode)
+  bool colocate_fft_demul_ = true;
+  // NUMA node for the master, TXRX, and MAC threads. -1 uses the node of the
+  // first usable CPU.
+  int nic_numa_node_ = -1;
+  // Explicit cores by role: "master", "txrx", "mac", and "worker"
+  std::map<std::string, std::vector<size_t>> cores_;
+};
+
+/// The number of threads of each role
+struct PlacementRoles {
+  // Two masters when the uplink and downlink master loops are split
+  size_t num_masters_ = 1;
+  size_t num_txrx_ = 0;
+  size_t num_mac_ = 0;
+  size_t num_workers_ = 0;
+  // In Bigstation mode, worker threads [0, num_fft_) run FFT, the next
+  // num_zf_ ZF, the next num_demul_ demodulation, and the rest decoding
+  bool bigstation_ = false;
+  size_t num_fft_ = 0;
+  size_t num_zf_ = 0;
+  size_t num_demul_ = 0;
+};
+
+/**
+ * @brief Assigns one CPU to each thread of a process.
+ *
+ * Explicit per-role cores come first. The master, TXRX, and MAC threads are
+ * then packed onto the NIC's NUMA node, and the workers get the remaining
+ * physical cores, preferring last-level cache groups without I/O threads.
+ * If there are too few cores, workers fall back to SMT siblings and then
+ * share cores.
+ */
+class ThreadPlacement {
+ public:
+  ThreadPlacement(const CpuTopology& topology, const PlacementRoles& roles,
+                  const PlacementConstraints& constraints);
+
+  /// Return the CPU for thread [thread_id] of type [thread_type], or -1 if
+  /// the plan has no CPU for it. Worker thread IDs index all worker threads,
+  /// including the Bigstation ones.
+  int Core(ThreadType thread_type, size_t thread_id) const;
+
+  /// The plan, one thread per line
+  std::string ToString() const;
+
+ private:
+  const std::vector<size_t>* RoleCores(ThreadType thread_type) const;
+  std::string RoleToString(const std::string& role_name,
+                           const std::vector<size_t>& cores) const;
+
+  const CpuTopology topology_;
+  std::vector<size_t> master_cores_;
+  std::vector<size_t> txrx_cores_;
+  std::vector<size_t> mac_cores_;
+  std::vector<size_t> worker_cores_;
+  std::vector<ThreadType> worker_types_;
+};
+
+#endif  // THREAD_PLACEMENT_H_
@@ -0,0 +1,68 @@
+/**
+ * @file tx_scheduler.cc
+ * @brief Implementation file for the FrameSchedule and TxTimingWheel classes.
+ */
+
+#include "tx_scheduler.h"
+
+#include <algorithm>
+
+#include "utils.h"
+
+// Entries per bucket allocated up front, enough for the channels of a radio
+static constexpr size_t kBucketReserve = 8;
+
+FrameSchedule::FrameSchedule(uint64_t first_frame_tsc, uint64_t frame_gap_tsc,
+                             uint64_t symbol_tsc)
+    : first_frame_tsc_(first_frame_tsc),
+      frame_gap_tsc_(frame_gap_tsc),
+      symbol_tsc_(symbol_tsc),
+      thresh1_(0),
+      gap1_tsc_(0),
+      thresh2_(0),
+      gap2_tsc_(0) {}
+
+void FrameSchedule::SetSlowStart(size_t thresh1, uint64_t gap1_tsc,
+                                 size_t thresh2, uint64_t gap2_tsc) {
+  RtAssert(thresh1 <= thresh2, "FrameSchedule: Slow start phases overlap");
+  thresh1_ = thresh1;
+  gap1_tsc_ = gap1_tsc;
+  thresh2_ = thresh2;
+  gap2_tsc_ = gap2_tsc;
+}
+
+uint64_t FrameSchedule::FrameStart(size_t frame_id) const {
+  // The number of gaps before [frame_id] that follow frames below [thresh]
+  auto gaps_below = [frame_id](size_t thresh) -> uint64_t {
+    return std::min(frame_id, thresh > 0 ? thresh - 1 : 0);
+  };
+  const uint64_t num_gap1 = gaps_below(thresh1_);
+  const uint64_t num_gap2 = gaps_below(thresh2_) - num_gap1;
+  const uint64_t num_steady = frame_id - num_gap1 - num_gap2;
+  return first_frame_tsc_ + (num_gap1 * gap1_tsc_) + (num_gap2 * gap2_tsc_) +
+         (num_steady * frame_gap_tsc_);
+}
+
+TxTimingWheel::TxTimingWheel(size_t num_buckets, uint64_t tick_tsc,
+                             uint64_t start_tsc)
+    : buckets_(num_buckets),
+      tick_tsc_(std::max<uint64_t>(tick_tsc, 1)),
+      start_tsc_(start_tsc),
+      cursor_tick_(0),
+      size_(0) {
+  RtAssert(num_buckets > 0, "TxTimingWheel: No buckets");
+  for (auto& bucket : buckets_) {
+    bucket.reserve(kBucketReserve);
+  }
+}
+
+void TxTimingWheel::Insert(uint64_t release_tsc, size_t tag) {
+  uint64_t tick = 0;
+  if (release_tsc > start_tsc_) {
+    tick = (release_tsc - start_tsc_) / tick_tsc_;
+  }
+  // Past release times are due at the next Expire()
+  tick = std::max(tick, cursor_tick_);
+  buckets_.at(tick % buckets_.size()).push_back({release_tsc, tag});
+  size_++;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file tx_scheduler.h
+ * @brief Declaration file for the FrameSchedule and TxTimingWheel classes,
+ * which time downlink transmissions to the air times of their symbols.
+ */
+
+#ifndef TX_SCHEDULER_H_
+#define TX_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The air times of frames and symbols in RDTSC ticks, following the
+ * beacon schedule of the TXRX threads.
+ *
+ * Frame 0 starts at a given time and frame j at a fixed gap after frame
+ * j - 1. With slow start, the gap is larger for the first frames. Symbols of
+ * a frame are one symbol duration apart, whatever the gap between frames.
+ */
+class FrameSchedule {
+ public:
+  FrameSchedule(uint64_t first_frame_tsc, uint64_t frame_gap_tsc,
+                uint64_t symbol_tsc);
+
+  /// Space frames 1 to [thresh1] - 1 by [gap1_tsc], and frames [thresh1] to
+  /// [thresh2] - 1 by [gap2_tsc], as the TXRX threads' slow start does
+  void SetSlowStart(size_t thresh1, uint64_t gap1_tsc, size_t thresh2,
+                    uint64_t gap2_tsc);
+
+  uint64_t FrameStart(size_t frame_id) const;
+
+  inline uint64_t SymbolStart(size_t frame_id, size_t symbol_id) const {
+    return FrameStart(frame_id) + (symbol_id * symbol_tsc_);
+  }
+
+ private:
+  uint64_t first_frame_tsc_;
+  uint64_t frame_gap_tsc_;
+  uint64_t symbol_tsc_;
+
+  size_t thresh1_;
+  uint64_t gap1_tsc_;
+  size_t thresh2_;
+  uint64_t gap2_tsc_;
+};
+
+/**
+ * @brief A hashed timing wheel of tags to release at given RDTSC times.
+ *
+ * Each bucket covers one tick of time, and a tag goes to the bucket of its
+ * release tick modulo the number of buckets, so release times beyond one
+ * turn of the wheel wait for later turns. Tags whose release time has
+ * passed when they are inserted are released at the next Expire(). Used by
+ * one thread only.
+ */
+class TxTimingWheel {
+ public:
+  TxTimingWheel(size_t num_buckets, uint64_t tick_tsc, uint64_t start_tsc);
+
+  /// Release [tag] at the first Expire() at or after [release_tsc]
+  void Insert(uint64_t release_tsc, size_t tag);
+
+  /**
+   * @brief Call [release] with every tag whose release time is at or before
+   * [now_tsc], in order of release tick.
+   *
+   * @return The number of tags released
+   */
+  template <typename F>
+  size_t Expire(uint64_t now_tsc, F&& release) {
+    if (now_tsc < start_tsc_) {
+      return 0;
+    }
+    const uint64_t now_tick = (now_tsc - start_tsc_) / tick_tsc_;
+    uint64_t first_tick = cursor_tick_;
+    // One turn of the wheel visits every bucket
+    if ((now_tick >= buckets_.size()) &&
+        (first_tick < now_tick - buckets_.size() + 1)) {
+      first_tick = now_tick - buckets_.size() + 1;
+    }
+
+    size_t num_released = 0;
+    for (uint64_t tick = first_tick; tick <= now_tick; tick++) {
+      std::vector<Entry>& bucket = buckets_.at(tick % buckets_.size());
+      // Keep the entries of later ticks and turns in order
+      size_t num_kept = 0;
+      for (size_t i = 0; i < bucket.size(); i++) {
+        if (bucket[i].release_tsc_ <= now_tsc) {
+          release(bucket[i].tag_);
+          num_released++;
+        } else {
+          bucket[num_kept++] = bucket[i];
+        }
+      }
+      bucket.resize(num_kept);
+    }
+    // The current tick may still hold entries due later within it
+    cursor_tick_ = now_tick;
+    size_ -= num_released;
+    return num_released;
+  }
+
+  inline size_t Size() const { return this->size_; }
+
+ private:
+  struct Entry {
+    uint64_t release_tsc_;
+    size_t tag_;
+  };
+
+  std::vector<std::vector<Entry>> buckets_;
+  uint64_t tick_tsc_;
+  uint64_t start_tsc_;
+  uint64_t cursor_tick_;  // The earliest tick that may hold due entries
+  size_t size_;
+};
+
+#endif  // TX_SCHEDULER_H_
@@ -15,9 +15,12 @@
 #define UDP_CLIENT_H_
 
 #include <netdb.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstring> /* std::strerror, std::memset, std::memcpy */
 #include <map>
 #include <mutex>
@@ -30,6 +33,10 @@ class UDPClient {
  public:
   static const bool kDebugPrintUdpClientInit = false;
   static const bool kDebugPrintUdpClientSend = false;
+  // Kernel limits on one UDP GSO send: UDP_MAX_SEGMENTS datagrams, and the
+  // payload of one IPv4 UDP datagram in total
+  static constexpr size_t kMaxGsoSegments = 64;
+  static constexpr size_t kMaxGsoBytes = 65507;
   UDPClient() {
     if (kDebugPrintUdpClientInit) {
       std::printf("Creating UDP Client socket\n");
@@ -70,13 +77,109 @@ class UDPClient {
    */
   void Send(const std::string& rem_hostname, uint16_t rem_port,
             const uint8_t* msg, size_t len) {
-    std::string remote_uri = rem_hostname + ":" + std::to_string(rem_port);
-    struct addrinfo* rem_addrinfo = nullptr;
-
     if (kDebugPrintUdpClientSend) {
       std::printf("UDPClient sending message to %s to port %d\n",
                   rem_hostname.c_str(), rem_port);
     }
+    const struct addrinfo* rem_addrinfo = Resolve(rem_hostname, rem_port);
+
+    ssize_t ret = sendto(sock_fd_, msg, len, 0, rem_addrinfo->ai_addr,
+                         rem_addrinfo->ai_addrlen);
+    if (ret != static_cast<ssize_t>(len)) {
+      throw std::runtime_error("sendto() failed. errno = " +
+                               std::string(std::strerror(errno)));
+    }
+
+    if (enable_recording_flag_) {
+      std::scoped_lock map_access(map_insert_access_);
+      sent_vec_.emplace_back(msg, msg + len);
+    }
+  }
+
+  /**
+   * @brief Send [num_datagrams] UDP packets to a remote server with UDP
+   * generic segmentation offload (GSO): the kernel builds the packets from
+   * one large send, so a batch takes a few sendmsg() calls instead of one
+   * sendto() per packet.
+   *
+   * All datagrams but the last must be as long as the first, which is the
+   * segment size. The segment size must fit the path MTU.
+   *
+   * @param datagrams One iovec per packet to send
+   * @param num_datagrams Number of packets to send
+   */
+  void SendSegmented(const std::string& rem_hostname, uint16_t rem_port,
+                     const struct iovec* datagrams, size_t num_datagrams) {
+    if (num_datagrams == 0) {
+      return;
+    }
+    const struct addrinfo* rem_addrinfo = Resolve(rem_hostname, rem_port);
+    const size_t segment_size = datagrams[0].iov_len;
+    const size_t max_segments =
+        std::min(kMaxGsoSegments, kMaxGsoBytes / segment_size);
+    if (max_segments == 0) {
+      throw std::runtime_error("UDPClient: GSO segment size too large");
+    }
+
+    // The segment size travels with each send as a control message
+    char control[CMSG_SPACE(sizeof(uint16_t))];
+    for (size_t first = 0; first < num_datagrams; first += max_segments) {
+      const size_t num = std::min(max_segments, num_datagrams - first);
+      size_t len = 0;
+      for (size_t i = first; i < first + num; i++) {
+        len += datagrams[i].iov_len;
+      }
+
+      struct msghdr msg;
+      std::memset(&msg, 0, sizeof(msg));
+      msg.msg_name = rem_addrinfo->ai_addr;
+      msg.msg_namelen = rem_addrinfo->ai_addrlen;
+      msg.msg_iov = const_cast<struct iovec*>(&datagrams[first]);
+      msg.msg_iovlen = num;
+      if (num > 1) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        const auto gso_size = static_cast<uint16_t>(segment_size);
+        std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+      }
+
+      ssize_t ret = sendmsg(sock_fd_, &msg, 0);
+      if (ret != static_cast<ssize_t>(len)) {
+        throw std::runtime_error("sendmsg() with UDP GSO failed. errno = " +
+                                 std::string(std::strerror(errno)));
+      }
+
+      if (enable_recording_flag_) {
+        std::scoped_lock map_access(map_insert_access_);
+        for (size_t i = first; i < first + num; i++) {
+          const auto* base = static_cast<const uint8_t*>(datagrams[i].iov_base);
+          sent_vec_.emplace_back(base, base + datagrams[i].iov_len);
+        }
+      }
+    }
+  }
+
+  /// The socket's file descriptor, for batched I/O outside this class. The
+  /// client keeps ownership.
+  inline int Fd() const { return sock_fd_; }
+
+  // Enable recording of all packets sent by this UDP client
+  void EnableRecording() { enable_recording_flag_ = true; }
+
+ private:
+  /**
+   * @brief Return the addrinfo of a remote server, resolving it and caching
+   * it on first use
+   */
+  const struct addrinfo* Resolve(const std::string& rem_hostname,
+                                 uint16_t rem_port) {
+    std::string remote_uri = rem_hostname + ":" + std::to_string(rem_port);
+    struct addrinfo* rem_addrinfo = nullptr;
 
     const auto remote_itr = addrinfo_map_.find(remote_uri);
     if (remote_itr == addrinfo_map_.end()) {
@@ -120,23 +223,9 @@ class UDPClient {
       rem_addrinfo = remote_itr->second;
     }
 
-    ssize_t ret = sendto(sock_fd_, msg, len, 0, rem_addrinfo->ai_addr,
-                         rem_addrinfo->ai_addrlen);
-    if (ret != static_cast<ssize_t>(len)) {
-      throw std::runtime_error("sendto() failed. errno = " +
-                               std::string(std::strerror(errno)));
-    }
-
-    if (enable_recording_flag_) {
-      std::scoped_lock map_access(map_insert_access_);
-      sent_vec_.emplace_back(msg, msg + len);
-    }
+    return rem_addrinfo;
   }
 
-  // Enable recording of all packets sent by this UDP client
-  void EnableRecording() { enable_recording_flag_ = true; }
-
- private:
   /**
    * @brief The raw socket file descriptor
    */
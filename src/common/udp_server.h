@@ -17,23 +17,78 @@
 
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <netdb.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cstdint>
 #include <cstring> /* std::strerror, std::memset, std::memcpy */
 #include <map>
 #include <mutex>
 #include <stdexcept>
 
+/**
+ * @brief Converts a NIC's hardware receive timestamps, in the time of its PTP
+ * hardware clock (PHC), to CLOCK_REALTIME.
+ *
+ * The PHC often runs in TAI or is not synchronized at all. The kernel's
+ * software timestamp of a packet is taken shortly after the NIC's, so the
+ * smallest software-minus-hardware difference over a window of packets
+ * measures the offset between the clocks, up to the shortest delivery delay
+ * from the NIC to the network stack. The offset is measured again every
+ * window to follow the drift between the clocks.
+ */
+class HwTimestampConverter {
+ public:
+  static constexpr size_t kWindowPackets = 1024;
+
+  /// Convert [hw_ns] to CLOCK_REALTIME with the help of the software
+  /// timestamp [sw_ns] of the same packet. Returns zero if [sw_ns] is zero
+  /// and no offset has been measured yet.
+  uint64_t ToRealtimeNs(uint64_t hw_ns, uint64_t sw_ns) {
+    if (sw_ns != 0) {
+      const auto diff = static_cast<int64_t>(sw_ns - hw_ns);
+      if ((window_count_ == 0) || (diff < window_min_)) {
+        window_min_ = diff;
+      }
+      window_count_++;
+      if ((measured_ == false) || (diff < offset_ns_)) {
+        // Until a window is complete, and when the clocks step, use the
+        // smallest difference so far
+        offset_ns_ = diff;
+        measured_ = true;
+      }
+      if (window_count_ == kWindowPackets) {
+        offset_ns_ = window_min_;
+        window_count_ = 0;
+      }
+    } else if (measured_ == false) {
+      return 0;
+    }
+    return hw_ns + offset_ns_;
+  }
+
+ private:
+  bool measured_ = false;
+  int64_t offset_ns_ = 0;
+  int64_t window_min_ = 0;
+  size_t window_count_ = 0;
+};
+
 /// Basic UDP server class based on OS sockets that supports receiving messages
 class UDPServer {
  public:
   static const bool kDebugPrintUdpServerInit = true;
 
   // Initialize a UDP server listening on this UDP port with socket buffer
-  // size = rx_buffer_size
-  explicit UDPServer(uint16_t port, size_t rx_buffer_size = 0) : port_(port) {
+  // size = rx_buffer_size. With reuse_port, the socket joins the port's
+  // SO_REUSEPORT group, which the kernel spreads received packets across.
+  explicit UDPServer(uint16_t port, size_t rx_buffer_size = 0,
+                     bool reuse_port = false)
+      : port_(port) {
     if (kDebugPrintUdpServerInit) {
       std::printf("Creating UDP server listening at port %d\n", port);
     }
@@ -53,6 +108,15 @@ class UDPServer {
       }
     }
 
+    if (reuse_port == true) {
+      int enable = 1;
+      ret = setsockopt(sock_fd_, SOL_SOCKET, SO_REUSEPORT, &enable,
+                       sizeof(enable));
+      if (ret != 0) {
+        throw std::runtime_error("UDPServer: Failed to set SO_REUSEPORT.");
+      }
+    }
+
     struct sockaddr_in serveraddr;
     serveraddr.sin_family = AF_INET;
     serveraddr.sin_addr.s_addr = htonl(INADDR_ANY);
@@ -112,6 +176,134 @@ class UDPServer {
     return ret;
   }
 
+  /**
+   * @brief Enable UDP generic receive offload (GRO) on the socket: the kernel
+   * may then coalesce consecutive same-size datagrams from one sender into a
+   * single buffer, which RecvSegments() returns in one call
+   */
+  void EnableGro() {
+    int enable = 1;
+    int ret = setsockopt(sock_fd_, SOL_UDP, UDP_GRO, &enable, sizeof(enable));
+    if (ret != 0) {
+      throw std::runtime_error("UDPServer: Failed to enable UDP GRO. Error: " +
+                               std::string(std::strerror(errno)));
+    }
+  }
+
+  /**
+   * @brief Enable kernel receive timestamps (SO_TIMESTAMPING), which
+   * Recv() and RecvSegments() return in CLOCK_REALTIME nanoseconds. Software
+   * timestamps are taken when a packet enters the network stack. With
+   * hardware, the NIC's timestamps are returned instead where the NIC has
+   * receive timestamping enabled, converted from the time of its PTP clock
+   * by HwTimestampConverter.
+   *
+   * @return True if the kernel supports receive timestamps
+   */
+  bool EnableRxTimestamps(bool hardware) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (hardware == true) {
+      flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+    rx_hw_timestamps_ = hardware;
+    return setsockopt(sock_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags,
+                      sizeof(flags)) == 0;
+  }
+
+  /**
+   * @brief Try to receive up to len bytes in buf, and the kernel's receive
+   * timestamp of the packet
+   *
+   * @param rx_time_ns Set to the receive timestamp in nanoseconds, or zero
+   * if there is none
+   *
+   * @return Return the number of bytes received if non-zero bytes are
+   * received. If no bytes are received, return zero. If there was an error
+   * in receiving, return -1.
+   */
+  ssize_t Recv(uint8_t* buf, size_t len, uint64_t& rx_time_ns) {
+    size_t segment_size = 0;
+    return RecvSegments(buf, len, segment_size, &rx_time_ns);
+  }
+
+  /**
+   * @brief Try to receive up to len bytes in buf, which may hold several
+   * datagrams coalesced by GRO. The buffer should fit the largest coalesced
+   * buffer, 64 KB, since the kernel drops what does not fit.
+   *
+   * @param segment_size Set to the length of each datagram in buf, all but
+   * the last of which are that long. Equal to the bytes received if the
+   * datagrams were not coalesced.
+   * @param rx_time_ns If not null, set to the kernel's receive timestamp of
+   * the first datagram in nanoseconds, or zero if there is none
+   *
+   * @return Return the number of bytes received if non-zero bytes are
+   * received. If no bytes are received, return zero. If there was an error
+   * in receiving, return -1.
+   */
+  ssize_t RecvSegments(uint8_t* buf, size_t len, size_t& segment_size,
+                       uint64_t* rx_time_ns = nullptr) {
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    char control[CMSG_SPACE(sizeof(int)) +
+                 CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t ret = recvmsg(sock_fd_, &msg, 0);
+    if (ret == -1) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        // These errors mean that there's no data to receive
+        ret = 0;
+      } else {
+        std::fprintf(stderr,
+                     "UDPServer: recvmsg() failed with unexpected error %s\n",
+                     std::strerror(errno));
+      }
+      return ret;
+    } else if (ret == 0) {
+      std::fprintf(stderr, "UDPServer: recv() failed with return of 0\n");
+      return ret;
+    } else if ((msg.msg_flags & MSG_TRUNC) != 0) {
+      std::fprintf(stderr, "UDPServer: recvmsg() truncated %zd bytes\n", ret);
+      return -1;
+    }
+
+    segment_size = static_cast<size_t>(ret);
+    if (rx_time_ns != nullptr) {
+      *rx_time_ns = 0;
+    }
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if ((cmsg->cmsg_level == SOL_UDP) && (cmsg->cmsg_type == UDP_GRO)) {
+        int gso_size;
+        std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+        segment_size = static_cast<size_t>(gso_size);
+      } else if ((rx_time_ns != nullptr) &&
+                 (cmsg->cmsg_level == SOL_SOCKET) &&
+                 (cmsg->cmsg_type == SCM_TIMESTAMPING)) {
+        // ts[0] is the software timestamp and ts[2] the raw hardware one
+        struct scm_timestamping tss;
+        std::memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+        const uint64_t sw_ns =
+            static_cast<uint64_t>(tss.ts[0].tv_sec) * 1000000000 +
+            static_cast<uint64_t>(tss.ts[0].tv_nsec);
+        const uint64_t hw_ns =
+            static_cast<uint64_t>(tss.ts[2].tv_sec) * 1000000000 +
+            static_cast<uint64_t>(tss.ts[2].tv_nsec);
+        *rx_time_ns = ((rx_hw_timestamps_ == true) && (hw_ns != 0))
+                          ? hw_converter_.ToRealtimeNs(hw_ns, sw_ns)
+                          : sw_ns;
+      }
+    }
+    return ret;
+  }
+
   /**
    * @brief Try once to receive up to len bytes in buf
    *
@@ -173,6 +365,10 @@ class UDPServer {
     return ret;
   }
 
+  /// The socket's file descriptor, for batched I/O outside this class. The
+  /// server keeps ownership.
+  inline int Fd() const { return sock_fd_; }
+
   /**
    * @brief Configures the socket in blocking mode.  Any calls to recv / send
    * will now block
@@ -223,6 +419,15 @@ class UDPServer {
    */
   int sock_fd_ = -1;
 
+  /**
+   * @brief If true, prefer hardware receive timestamps to software ones
+   */
+  bool rx_hw_timestamps_ = false;
+  /**
+   * @brief Converts the hardware receive timestamps to CLOCK_REALTIME
+   */
+  HwTimestampConverter hw_converter_;
+
   /**
    * @brief A cache mapping hostname:udp_port to addrinfo
    */
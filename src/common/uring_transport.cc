@@ -0,0 +1,283 @@
+/**
+ * @file uring_transport.cc
+ * @brief Implementation file for the Uring and UringBufRing classes.
+ */
+
+#include "uring_transport.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "logger.h"
+#include "utils.h"
+
+static std::string ErrnoString(const std::string& what) {
+  return what + ": " + std::strerror(errno);
+}
+
+static void* MapRing(int fd, size_t len, off_t offset) {
+  void* map = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (map == MAP_FAILED) {
+    throw std::runtime_error(ErrnoString("io_uring: Failed to map ring"));
+  }
+  return map;
+}
+
+Uring::Uring(unsigned entries, bool sqpoll) : sqpoll_(sqpoll) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  if (sqpoll == true) {
+    params.flags = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = 1000;  // ms before the kernel thread sleeps
+  } else {
+    // Run completion work only when this thread asks for it, instead of
+    // interrupting it (Linux 5.19 or later)
+    params.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG |
+                   IORING_SETUP_SINGLE_ISSUER;
+  }
+  fd_ = syscall(__NR_io_uring_setup, entries, &params);
+  if ((fd_ < 0) && (errno == EINVAL) && (sqpoll == false)) {
+    std::memset(&params, 0, sizeof(params));
+    fd_ = syscall(__NR_io_uring_setup, entries, &params);
+  }
+  if (fd_ < 0) {
+    throw std::runtime_error(ErrnoString("io_uring: Failed to set up"));
+  }
+  flags_ = params.flags;
+
+  sq_map_len_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_map_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_map_len_ = std::max(sq_map_len_, cq_map_len_);
+    sq_map_ = MapRing(fd_, sq_map_len_, IORING_OFF_SQ_RING);
+    cq_map_ = sq_map_;
+    cq_map_len_ = 0;
+  } else {
+    sq_map_ = MapRing(fd_, sq_map_len_, IORING_OFF_SQ_RING);
+    cq_map_ = MapRing(fd_, cq_map_len_, IORING_OFF_CQ_RING);
+  }
+  sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(MapRing(fd_, sqes_len_, IORING_OFF_SQES));
+
+  auto* sq = static_cast<uint8_t*>(sq_map_);
+  sq_head_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sq_flags_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.flags);
+  sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  // Submission entry i always sits in slot i
+  auto* sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  for (uint32_t i = 0; i < sq_entries_; i++) {
+    sq_array[i] = i;
+  }
+  sqe_tail_ = *sq_tail_;
+  sqe_head_ = sqe_tail_;
+
+  auto* cq = static_cast<uint8_t*>(cq_map_);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+Uring::~Uring() {
+  munmap(sqes_, sqes_len_);
+  if (cq_map_ != sq_map_) {
+    munmap(cq_map_, cq_map_len_);
+  }
+  munmap(sq_map_, sq_map_len_);
+  close(fd_);
+}
+
+int Uring::Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+  int ret;
+  do {
+    ret = syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags,
+                  nullptr, 0);
+  } while ((ret < 0) && (errno == EINTR));
+  if ((ret < 0) && (errno != EAGAIN) && (errno != EBUSY)) {
+    throw std::runtime_error(ErrnoString("io_uring: enter failed"));
+  }
+  return ret;
+}
+
+io_uring_sqe* Uring::GetSqe() {
+  uint32_t head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (sqe_tail_ - head >= sq_entries_) {
+    return nullptr;
+  }
+  io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe_tail_++;
+  return sqe;
+}
+
+void Uring::Submit() {
+  const unsigned to_submit = sqe_tail_ - sqe_head_;
+  sqe_head_ = sqe_tail_;
+  __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+  if (to_submit == 0) {
+    return;
+  }
+  if (sqpoll_ == true) {
+    // The tail store must be visible before the kernel thread's flag is read
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) &
+         IORING_SQ_NEED_WAKEUP) != 0) {
+      Enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+    }
+  } else {
+    Enter(to_submit, 0, 0);
+  }
+}
+
+void Uring::SubmitAndWait(unsigned wait_nr) {
+  const unsigned to_submit = sqe_tail_ - sqe_head_;
+  sqe_head_ = sqe_tail_;
+  __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+  unsigned flags = IORING_ENTER_GETEVENTS;
+  if (sqpoll_ == true) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) &
+         IORING_SQ_NEED_WAKEUP) != 0) {
+      flags |= IORING_ENTER_SQ_WAKEUP;
+    }
+    Enter(0, wait_nr, flags);
+  } else {
+    Enter(to_submit, wait_nr, flags);
+  }
+}
+
+io_uring_cqe* Uring::PeekCqe() {
+  const uint32_t head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    // With cooperative task running, completions that are ready in the
+    // kernel are only posted when this thread enters it
+    if (((flags_ & IORING_SETUP_TASKRUN_FLAG) == 0) ||
+        ((__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_TASKRUN) ==
+         0)) {
+      return nullptr;
+    }
+    Enter(0, 0, IORING_ENTER_GETEVENTS);
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return nullptr;
+    }
+  }
+  return &cqes_[head & cq_mask_];
+}
+
+UringBufRing::UringBufRing(Uring* uring, uint16_t bgid, uint8_t* base,
+                           size_t stride, size_t payload_offset,
+                           size_t payload_len, size_t num_bufs)
+    : uring_(uring),
+      bgid_(bgid),
+      base_(base),
+      stride_(stride),
+      payload_offset_(payload_offset),
+      buf_len_(kUringRecvHeadroom + payload_len),
+      num_bufs_(num_bufs) {
+  RtAssert(num_bufs > 0 && num_bufs <= kUringMaxBufs,
+           "io_uring: Invalid number of provided buffers");
+  RtAssert(payload_offset >= kUringRecvHeadroom,
+           "io_uring: Not enough headroom in front of the payload");
+
+  for (size_t i = 0; i < num_bufs; i++) {
+    recycled_.enqueue(static_cast<uint16_t>(i));
+  }
+  // Failures post a completion, so a NOP after each batch tells us when the
+  // batch is done without counting the successes
+  size_t num_provided = 0;
+  while (num_provided < num_bufs) {
+    const size_t num = Refill();
+    io_uring_sqe* sqe = uring_->GetSqe();
+    if (sqe == nullptr) {
+      uring_->Submit();
+      continue;
+    }
+    sqe->opcode = IORING_OP_NOP;
+    uring_->SubmitAndWait(1);
+
+    bool batch_done = false;
+    while (batch_done == false) {
+      io_uring_cqe* cqe = uring_->PeekCqe();
+      if (cqe == nullptr) {
+        uring_->SubmitAndWait(1);
+        continue;
+      }
+      if (cqe->user_data == kUringInternalUserData) {
+        errno = -cqe->res;
+        throw std::runtime_error(
+            ErrnoString("io_uring: Failed to provide buffers"));
+      }
+      batch_done = true;
+      uring_->SeenCqe();
+    }
+    num_provided += num;
+  }
+}
+
+size_t UringBufRing::Refill() {
+  static constexpr size_t kRefillBatch = 64;
+  uint16_t bids[kRefillBatch];
+  size_t num = recycled_.try_dequeue_bulk(bids, kRefillBatch);
+  for (size_t i = 0; i < num; i++) {
+    io_uring_sqe* sqe = uring_->GetSqe();
+    if (sqe == nullptr) {
+      // Submission queue is full, so retry the rest at the next refill
+      recycled_.enqueue_bulk(&bids[i], num - i);
+      return i;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;  // Number of buffers
+    sqe->addr =
+        reinterpret_cast<uint64_t>(Payload(bids[i]) - kUringRecvHeadroom);
+    sqe->len = buf_len_;
+    sqe->off = bids[i];
+    sqe->buf_group = bgid_;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = kUringInternalUserData;
+  }
+  return num;
+}
+
+void UringSendMsg::Set(const sockaddr_in& addr, void* buf, size_t len) {
+  addr_ = addr;
+  iov_.iov_base = buf;
+  iov_.iov_len = len;
+  std::memset(&msg_, 0, sizeof(msg_));
+  msg_.msg_name = &addr_;
+  msg_.msg_namelen = sizeof(addr_);
+  msg_.msg_iov = &iov_;
+  msg_.msg_iovlen = 1;
+}
+
+void UringPrepRecvMultishot(io_uring_sqe* sqe, int fd, msghdr* msg,
+                            const UringBufRing& ring, uint64_t user_data) {
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(msg);
+  sqe->len = 1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = ring.GroupId();
+  sqe->user_data = user_data;
+}
+
+void UringPrepSendMsg(io_uring_sqe* sqe, int fd, const msghdr* msg,
+                      uint64_t user_data) {
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(msg);
+  sqe->len = 1;
+  sqe->user_data = user_data;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file uring_transport.h
+ * @brief Declaration file for the Uring and UringBufRing classes, which
+ * provide batched socket I/O through io_uring using the kernel uapi directly.
+ */
+
+#ifndef URING_TRANSPORT_H_
+#define URING_TRANSPORT_H_
+
+#include <linux/io_uring.h>
+// linux/fs.h defines BLOCK_SIZE, which clashes with concurrentqueue.h
+#undef BLOCK_SIZE
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "concurrentqueue.h"
+
+static constexpr unsigned kUringEntries = 256;
+/// The most buffers in one group, so that buffer ids fit in 16 bits
+static constexpr size_t kUringMaxBufs = 32768;
+/// Bytes in front of each payload received with multishot recvmsg. No source
+/// address or control data is requested, so only the header is written.
+static constexpr size_t kUringRecvHeadroom = sizeof(io_uring_recvmsg_out);
+/// User data of internal entries, whose completions callers must skip
+static constexpr uint64_t kUringInternalUserData = UINT64_MAX;
+
+/**
+ * @brief An io_uring instance owned by one thread.
+ *
+ * Submissions are only made visible to the kernel in Submit(). Without
+ * SQPOLL this is one io_uring_enter() per batch; with SQPOLL a kernel thread
+ * polls the submission queue and Submit() only enters the kernel to wake it
+ * after it idles. Completions are read from the shared ring without syscalls.
+ */
+class Uring {
+ public:
+  /// @param sqpoll Poll submissions from a kernel thread
+  Uring(unsigned entries, bool sqpoll);
+  ~Uring();
+
+  /// Get a zeroed submission entry, or nullptr if the queue is full
+  io_uring_sqe* GetSqe();
+
+  /// The number of entries that GetSqe() can hand out right now
+  inline unsigned SqSpace() const {
+    return sq_entries_ -
+           (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+  }
+
+  /// Submit all entries from GetSqe() since the last call. Does not enter the
+  /// kernel if there are none.
+  void Submit();
+
+  /// Submit, and block until at least [wait_nr] completions are available
+  void SubmitAndWait(unsigned wait_nr);
+
+  /// The next completion, or nullptr if there is none
+  io_uring_cqe* PeekCqe();
+
+  /// Consume the completion returned by PeekCqe()
+  inline void SeenCqe() {
+    __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+  }
+
+  inline int Fd() const { return this->fd_; }
+  inline bool SqPoll() const { return this->sqpoll_; }
+
+ private:
+  int Enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+
+  int fd_;
+  bool sqpoll_;
+  unsigned flags_;
+
+  void* sq_map_;
+  size_t sq_map_len_;
+  void* cq_map_;
+  size_t cq_map_len_;
+  io_uring_sqe* sqes_;
+  size_t sqes_len_;
+
+  uint32_t* sq_head_;
+  uint32_t* sq_tail_;
+  uint32_t* sq_flags_;
+  uint32_t sq_mask_;
+  uint32_t sq_entries_;
+  uint32_t sqe_tail_;  // Entries handed out by GetSqe()
+  uint32_t sqe_head_;  // Entries already published to the kernel
+
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+/**
+ * @brief A group of provided buffers over a caller-owned array of packet
+ * slots.
+ *
+ * Slot i starts at base + i * stride, and its buffer starts
+ * kUringRecvHeadroom bytes before the slot's payload offset, so that the
+ * kernel writes the payload at the slot's aligned packet address. The kernel
+ * picks a free buffer for each received datagram and reports its id in the
+ * completion. Buffers released by the workers are queued with Recycle() from
+ * any thread and handed back to the kernel by the owning thread in Refill().
+ *
+ * Buffers are handed back with IORING_OP_PROVIDE_BUFFERS entries that post no
+ * completion on success. A registered buffer ring would save the submission
+ * entries, but buffer selection from rings was unreliable on the kernels we
+ * tested, and provided buffers work on every kernel with multishot recvmsg.
+ */
+class UringBufRing {
+ public:
+  /// Provide all [num_bufs] buffers to the kernel, blocking until they are
+  /// available for selection
+  UringBufRing(Uring* uring, uint16_t bgid, uint8_t* base, size_t stride,
+               size_t payload_offset, size_t payload_len, size_t num_bufs);
+
+  inline uint8_t* Payload(uint16_t bid) const {
+    return base_ + (bid * stride_) + payload_offset_;
+  }
+  inline size_t NumBufs() const { return this->num_bufs_; }
+  inline uint16_t GroupId() const { return this->bgid_; }
+
+  /// Return buffer [bid] to the kernel. Thread-safe.
+  inline void Recycle(uint16_t bid) { recycled_.enqueue(bid); }
+
+  /// Queue submission entries that provide recycled buffers to the kernel.
+  /// They take effect at the owner's next Submit(). Called by the owner only.
+  /// @return The number of buffers queued
+  size_t Refill();
+
+ private:
+  Uring* uring_;
+  uint16_t bgid_;
+  uint8_t* base_;
+  size_t stride_;
+  size_t payload_offset_;
+  size_t buf_len_;
+  size_t num_bufs_;
+
+  moodycamel::ConcurrentQueue<uint16_t> recycled_;
+};
+
+/// A sendmsg request, whose header must stay valid until its completion
+struct UringSendMsg {
+  msghdr msg_;
+  iovec iov_;
+  sockaddr_in addr_;
+  size_t tag_;  // Free for the caller, e.g. to report the completion
+
+  /// Point the message at [len] bytes at [buf], to be sent to [addr]
+  void Set(const sockaddr_in& addr, void* buf, size_t len);
+};
+
+/// Prepare a multishot recvmsg on [fd] into buffers of [ring]. [msg] must
+/// outlive the request and ask for no source address or control data.
+void UringPrepRecvMultishot(io_uring_sqe* sqe, int fd, msghdr* msg,
+                            const UringBufRing& ring, uint64_t user_data);
+
+/// Prepare a sendmsg of [msg] on [fd]. [msg] and the memory it points to must
+/// stay valid until the completion.
+void UringPrepSendMsg(io_uring_sqe* sqe, int fd, const msghdr* msg,
+                      uint64_t user_data);
+
+#endif  // URING_TRANSPORT_H_
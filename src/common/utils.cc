@@ -8,6 +8,8 @@
 
 #include "utils.h"
 
+#include "thread_placement.h"
+
 size_t cpu_layout[MAX_CORE_NUM];
 bool cpu_layout_initialized = false;
 
@@ -73,6 +75,11 @@ int PinToCore(int core_id) {
 
 void PinToCoreWithOffset(ThreadType thread_type, int core_offset, int thread_id,
                          bool verbose) {
+  PinToCoreWithOffset(thread_type, core_offset, thread_id, nullptr, verbose);
+}
+
+void PinToCoreWithOffset(ThreadType thread_type, int core_offset, int thread_id,
+                         const ThreadPlacement* placement, bool verbose) {
   if (kEnableThreadPinning == true) {
     int actual_core_id = core_offset + thread_id;
     int num_cores = sysconf(_SC_NPROCESSORS_ONLN);
@@ -84,6 +91,12 @@ void PinToCoreWithOffset(ThreadType thread_type, int core_offset, int thread_id,
 
     size_t physical_core_id =
         cpu_layout_initialized ? cpu_layout[actual_core_id] : actual_core_id;
+    const int planned_core_id = (placement == nullptr)
+                                    ? -1
+                                    : placement->Core(thread_type, thread_id);
+    if (planned_core_id >= 0) {
+      physical_core_id = planned_core_id;
+    }
 
     if (PinToCore(physical_core_id) != 0) {
       std::fprintf(
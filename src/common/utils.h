@@ -42,6 +42,8 @@
 
 #define MAX_CORE_NUM (200)
 
+class ThreadPlacement;
+
 void SetCpuLayoutOnNumaNodes(bool verbose = false);
 
 size_t GetPhysicalCoreId(size_t core_id);
@@ -53,6 +55,13 @@ int PinToCore(int core_id);
 void PinToCoreWithOffset(ThreadType thread, int base_core_offset, int thread_id,
                          bool verbose = true);
 
+/* Pin this thread to its core in [placement], or to core
+ * (base_core_offset + thread_id) if placement is nullptr or has no core for
+ * the thread */
+void PinToCoreWithOffset(ThreadType thread, int base_core_offset, int thread_id,
+                         const ThreadPlacement* placement,
+                         bool verbose = true);
+
 template <class T>
 struct EventHandlerContext {
   T* obj_ptr_;
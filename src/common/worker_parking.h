@@ -0,0 +1,132 @@
+/**
+ * @file worker_parking.h
+ * @brief Idle strategy for worker threads: spin, then pause, then park on a
+ * futex until the master schedules new tasks
+ */
+#ifndef WORKER_PARKING_H_
+#define WORKER_PARKING_H_
+
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+
+/**
+ * @brief The futex that idle workers park on. The master calls Wake() after
+ * it enqueues tasks, which costs one atomic load while no worker is parked.
+ *
+ * A worker announces itself with PrepareToPark(), polls its queues once more,
+ * and only then calls Park(). The master enqueues before it checks for parked
+ * workers, so either the master sees the worker and wakes it, or the worker's
+ * last poll sees the tasks.
+ */
+class WorkerParking {
+ public:
+  /// Wake all parked workers
+  inline void Wake() {
+    if (num_parked_.load() > 0) {
+      seq_.fetch_add(1);
+      syscall(SYS_futex, &seq_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr,
+              0);
+    }
+  }
+
+  /// Announce that the calling worker is about to park. Returns the wake-up
+  /// sequence number to pass to Park().
+  inline uint32_t PrepareToPark() {
+    num_parked_.fetch_add(1);
+    return seq_.load();
+  }
+
+  /// Sleep until Wake() is called after PrepareToPark() returned seq, or for
+  /// at most timeout_us. Returns true if woken by Wake().
+  inline bool Park(uint32_t seq, size_t timeout_us) {
+    if (seq_.load() == seq) {
+      struct timespec timeout;
+      timeout.tv_sec = timeout_us / 1000000;
+      timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+      syscall(SYS_futex, &seq_, FUTEX_WAIT_PRIVATE, seq, &timeout, nullptr, 0);
+    }
+    return seq_.load() != seq;
+  }
+
+  /// Undo PrepareToPark(), after Park() or if the last poll found work
+  inline void CancelPark() { num_parked_.fetch_sub(1); }
+
+  inline size_t NumParked() const { return num_parked_.load(); }
+
+ private:
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "The futex word must be a plain 32-bit integer");
+  alignas(64) std::atomic<uint32_t> seq_{0};
+  alignas(64) std::atomic<uint32_t> num_parked_{0};
+};
+
+/**
+ * @brief The idle state of one worker thread. The worker calls Busy() after a
+ * poll that found work and Idle() after a poll that found none. Idle() spins
+ * for the first spin_polls empty polls, then executes a pause instruction for
+ * the next pause_polls, and then parks the worker.
+ */
+class WorkerIdler {
+ public:
+  /// Parking is disabled if parking is nullptr or park_timeout_us is 0
+  WorkerIdler(WorkerParking* parking, size_t spin_polls, size_t pause_polls,
+              size_t park_timeout_us)
+      : parking_(park_timeout_us > 0 ? parking : nullptr),
+        spin_polls_(spin_polls),
+        pause_polls_(pause_polls),
+        park_timeout_us_(park_timeout_us) {}
+  ~WorkerIdler() { Busy(); }
+
+  inline void Busy() {
+    if (park_armed_ == true) {
+      parking_->CancelPark();
+      park_armed_ = false;
+    }
+    idle_polls_ = 0;
+  }
+
+  inline void Idle() {
+    if (idle_polls_ < spin_polls_) {
+      idle_polls_++;
+    } else if ((idle_polls_ < spin_polls_ + pause_polls_) ||
+               (parking_ == nullptr)) {
+      idle_polls_++;
+      _mm_pause();
+    } else if (park_armed_ == false) {
+      // Poll once more before sleeping
+      park_seq_ = parking_->PrepareToPark();
+      park_armed_ = true;
+    } else {
+      const bool woken = parking_->Park(park_seq_, park_timeout_us_);
+      parking_->CancelPark();
+      park_armed_ = false;
+      num_parks_++;
+      // A worker that timed out parks again after its next empty poll, a
+      // woken worker spins first since more tasks are likely to follow
+      if (woken == true) {
+        idle_polls_ = 0;
+      }
+    }
+  }
+
+  inline size_t NumParks() const { return num_parks_; }
+
+ private:
+  WorkerParking* parking_;
+  const size_t spin_polls_;
+  const size_t pause_polls_;
+  const size_t park_timeout_us_;
+  size_t idle_polls_ = 0;
+  bool park_armed_ = false;
+  uint32_t park_seq_ = 0;
+  size_t num_parks_ = 0;
+};
+
+#endif  // WORKER_PARKING_H_
@@ -0,0 +1,479 @@
+/**
+ * @file xdp_transport.cc
+ * @brief Implementation file for the XdpTransport and XdpSocket classes.
+ */
+
+#include "xdp_transport.h"
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.h"
+#include "utils.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+static int Bpf(int cmd, union bpf_attr* attr) {
+  return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static std::string ErrnoString(const std::string& what) {
+  return what + ": " + std::strerror(errno);
+}
+
+// Helpers to assemble the XDP program, following the kernel's BPF_* macros
+static bpf_insn Insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off,
+                     int32_t imm) {
+  bpf_insn insn;
+  std::memset(&insn, 0, sizeof(insn));
+  insn.code = code;
+  insn.dst_reg = dst;
+  insn.src_reg = src;
+  insn.off = off;
+  insn.imm = imm;
+  return insn;
+}
+
+static bpf_insn MovReg(uint8_t dst, uint8_t src) {
+  return Insn(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0);
+}
+
+static bpf_insn MovImm(uint8_t dst, int32_t imm) {
+  return Insn(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm);
+}
+
+static bpf_insn Load(uint8_t size, uint8_t dst, uint8_t src, int16_t off) {
+  return Insn(BPF_LDX | BPF_MEM | size, dst, src, off, 0);
+}
+
+/// Build the redirect program. Packets are redirected to the XSKMAP entry of
+/// their RX queue if they are unfragmented IPv4 UDP packets without IP
+/// options whose destination port is in [port_lo, port_hi], and passed to the
+/// kernel otherwise. A queue without a socket falls back to XDP_PASS.
+static std::vector<bpf_insn> RedirectProgram(int map_fd, uint16_t port_lo,
+                                             uint16_t port_hi) {
+  std::vector<bpf_insn> prog;
+  std::vector<size_t> jumps_to_pass;
+  auto jump_to_pass = [&](uint8_t op, uint8_t dst, int32_t imm) {
+    jumps_to_pass.push_back(prog.size());
+    prog.push_back(Insn(BPF_JMP | op | BPF_K, dst, 0, 0, imm));
+  };
+
+  prog.push_back(MovReg(BPF_REG_6, BPF_REG_1));
+  prog.push_back(Load(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(xdp_md, data)));
+  prog.push_back(Load(BPF_W, BPF_REG_3, BPF_REG_1, offsetof(xdp_md, data_end)));
+  prog.push_back(MovReg(BPF_REG_4, BPF_REG_2));
+  prog.push_back(Insn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0,
+                      kXdpPayloadOffset));
+  jumps_to_pass.push_back(prog.size());
+  prog.push_back(Insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+
+  // Ethernet type, IP version and header length, fragment bits, protocol
+  prog.push_back(Load(BPF_H, BPF_REG_5, BPF_REG_2, 12));
+  jump_to_pass(BPF_JNE, BPF_REG_5, htons(ETH_P_IP));
+  prog.push_back(Load(BPF_B, BPF_REG_5, BPF_REG_2, 14));
+  jump_to_pass(BPF_JNE, BPF_REG_5, 0x45);
+  prog.push_back(Load(BPF_H, BPF_REG_5, BPF_REG_2, 20));
+  prog.push_back(
+      Insn(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3fff)));
+  jump_to_pass(BPF_JNE, BPF_REG_5, 0);
+  prog.push_back(Load(BPF_B, BPF_REG_5, BPF_REG_2, 23));
+  jump_to_pass(BPF_JNE, BPF_REG_5, IPPROTO_UDP);
+
+  // UDP destination port
+  prog.push_back(Load(BPF_H, BPF_REG_5, BPF_REG_2, 36));
+  prog.push_back(Insn(BPF_ALU | BPF_END | BPF_TO_BE, BPF_REG_5, 0, 0, 16));
+  jump_to_pass(BPF_JLT, BPF_REG_5, port_lo);
+  jump_to_pass(BPF_JGT, BPF_REG_5, port_hi);
+
+  // bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS)
+  prog.push_back(
+      Load(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(xdp_md, rx_queue_index)));
+  prog.push_back(Insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1,
+                      BPF_PSEUDO_MAP_FD, 0, map_fd));
+  prog.push_back(Insn(0, 0, 0, 0, 0));
+  prog.push_back(MovImm(BPF_REG_3, XDP_PASS));
+  prog.push_back(
+      Insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+  prog.push_back(Insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+  const size_t pass = prog.size();
+  prog.push_back(MovImm(BPF_REG_0, XDP_PASS));
+  prog.push_back(Insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+  for (size_t jump : jumps_to_pass) {
+    prog.at(jump).off = static_cast<int16_t>(pass - (jump + 1));
+  }
+  return prog;
+}
+
+XdpTransport::XdpTransport(const std::string& ifname, uint16_t port_lo,
+                           uint16_t port_hi, size_t num_queues,
+                           bool native_mode)
+    : native_mode_(native_mode),
+      xsks_map_fd_(-1),
+      prog_fd_(-1),
+      link_fd_(-1) {
+  ifindex_ = if_nametoindex(ifname.c_str());
+  if (ifindex_ == 0) {
+    throw std::runtime_error(ErrnoString("XDP: Unknown interface " + ifname));
+  }
+
+  // UMEM and BPF maps are charged to the locked memory limit on older kernels
+  struct rlimit unlimited = {RLIM_INFINITY, RLIM_INFINITY};
+  if (setrlimit(RLIMIT_MEMLOCK, &unlimited) != 0) {
+    MLPD_WARN("XDP: Failed to raise RLIMIT_MEMLOCK: %s\n",
+              std::strerror(errno));
+  }
+
+  union bpf_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.map_type = BPF_MAP_TYPE_XSKMAP;
+  attr.key_size = sizeof(uint32_t);
+  attr.value_size = sizeof(int);
+  attr.max_entries = num_queues;
+  xsks_map_fd_ = Bpf(BPF_MAP_CREATE, &attr);
+  if (xsks_map_fd_ < 0) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to create XSKMAP"));
+  }
+
+  std::vector<bpf_insn> prog = RedirectProgram(xsks_map_fd_, port_lo, port_hi);
+  std::vector<char> log(64 * 1024, 0);
+  static const char kLicense[] = "GPL";
+  std::memset(&attr, 0, sizeof(attr));
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.insns = reinterpret_cast<uint64_t>(prog.data());
+  attr.insn_cnt = prog.size();
+  attr.license = reinterpret_cast<uint64_t>(kLicense);
+  attr.log_buf = reinterpret_cast<uint64_t>(log.data());
+  attr.log_size = log.size();
+  attr.log_level = 1;
+  prog_fd_ = Bpf(BPF_PROG_LOAD, &attr);
+  if (prog_fd_ < 0) {
+    MLPD_ERROR("XDP: Verifier log:\n%s\n", log.data());
+    throw std::runtime_error(ErrnoString("XDP: Failed to load program"));
+  }
+
+  // Needs Linux 5.9 or later. The program is detached when link_fd_ closes.
+  std::memset(&attr, 0, sizeof(attr));
+  attr.link_create.prog_fd = prog_fd_;
+  attr.link_create.target_ifindex = ifindex_;
+  attr.link_create.attach_type = BPF_XDP;
+  attr.link_create.flags =
+      native_mode ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE;
+  link_fd_ = Bpf(BPF_LINK_CREATE, &attr);
+  if (link_fd_ < 0) {
+    throw std::runtime_error(
+        ErrnoString("XDP: Failed to attach program to " + ifname));
+  }
+  MLPD_INFO("XDP: Attached to %s (%s mode), UDP ports %u-%u\n", ifname.c_str(),
+            native_mode ? "native" : "generic", port_lo, port_hi);
+}
+
+XdpTransport::~XdpTransport() {
+  for (int fd : {link_fd_, prog_fd_, xsks_map_fd_}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+void XdpTransport::AddSocket(uint32_t queue_id, int xsk_fd) {
+  union bpf_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.map_fd = xsks_map_fd_;
+  attr.key = reinterpret_cast<uint64_t>(&queue_id);
+  attr.value = reinterpret_cast<uint64_t>(&xsk_fd);
+  attr.flags = BPF_ANY;
+  if (Bpf(BPF_MAP_UPDATE_ELEM, &attr) != 0) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to update XSKMAP"));
+  }
+}
+
+XdpFlow XdpTransport::ReplyFlow(const uint8_t* rx_frame) {
+  const auto* eth = reinterpret_cast<const ethhdr*>(rx_frame);
+  const auto* ip = reinterpret_cast<const iphdr*>(rx_frame + sizeof(ethhdr));
+  XdpFlow flow;
+  std::memcpy(flow.src_mac_, eth->h_dest, ETH_ALEN);
+  std::memcpy(flow.dst_mac_, eth->h_source, ETH_ALEN);
+  flow.src_addr_ = ip->daddr;
+  flow.dst_addr_ = ip->saddr;
+  return flow;
+}
+
+size_t XdpTransport::WriteHeaders(uint8_t* frame, const XdpFlow& flow,
+                                  uint16_t src_port, uint16_t dst_port,
+                                  size_t payload_len) {
+  auto* eth = reinterpret_cast<ethhdr*>(frame);
+  std::memcpy(eth->h_dest, flow.dst_mac_, ETH_ALEN);
+  std::memcpy(eth->h_source, flow.src_mac_, ETH_ALEN);
+  eth->h_proto = htons(ETH_P_IP);
+
+  auto* ip = reinterpret_cast<iphdr*>(frame + sizeof(ethhdr));
+  ip->version = 4;
+  ip->ihl = sizeof(iphdr) / 4;
+  ip->tos = 0;
+  ip->tot_len = htons(sizeof(iphdr) + sizeof(udphdr) + payload_len);
+  ip->id = 0;
+  ip->frag_off = htons(IP_DF);
+  ip->ttl = 64;
+  ip->protocol = IPPROTO_UDP;
+  ip->check = 0;
+  ip->saddr = flow.src_addr_;
+  ip->daddr = flow.dst_addr_;
+  uint32_t sum = 0;
+  const auto* words = reinterpret_cast<const uint16_t*>(ip);
+  for (size_t i = 0; i < sizeof(iphdr) / 2; i++) {
+    sum += words[i];
+  }
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  ip->check = static_cast<uint16_t>(~sum);
+
+  // A zero UDP checksum means no checksum over IPv4
+  auto* udp = reinterpret_cast<udphdr*>(frame + sizeof(ethhdr) + sizeof(iphdr));
+  udp->source = htons(src_port);
+  udp->dest = htons(dst_port);
+  udp->len = htons(sizeof(udphdr) + payload_len);
+  udp->check = 0;
+  return kXdpPayloadOffset + payload_len;
+}
+
+static void MapRing(int fd, const xdp_ring_offset& off, size_t entry_size,
+                    uint32_t size, off_t pgoff, XdpRing& ring) {
+  ring.map_len_ = off.desc + size * entry_size;
+  ring.map_ = mmap(nullptr, ring.map_len_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, pgoff);
+  if (ring.map_ == MAP_FAILED) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to map ring"));
+  }
+  auto* base = static_cast<uint8_t*>(ring.map_);
+  ring.producer_ = reinterpret_cast<uint32_t*>(base + off.producer);
+  ring.consumer_ = reinterpret_cast<uint32_t*>(base + off.consumer);
+  ring.flags_ = reinterpret_cast<uint32_t*>(base + off.flags);
+  ring.desc_ = base + off.desc;
+  ring.size_ = size;
+  ring.mask_ = size - 1;
+}
+
+static inline uint32_t FreeEntries(XdpRing& ring) {
+  uint32_t free_entries = ring.size_ - (ring.cached_prod_ - ring.cached_cons_);
+  if (free_entries == 0) {
+    ring.cached_cons_ = __atomic_load_n(ring.consumer_, __ATOMIC_ACQUIRE);
+    free_entries = ring.size_ - (ring.cached_prod_ - ring.cached_cons_);
+  }
+  return free_entries;
+}
+
+static inline uint32_t AvailableEntries(XdpRing& ring) {
+  uint32_t entries = ring.cached_prod_ - ring.cached_cons_;
+  if (entries == 0) {
+    ring.cached_prod_ = __atomic_load_n(ring.producer_, __ATOMIC_ACQUIRE);
+    entries = ring.cached_prod_ - ring.cached_cons_;
+  }
+  return entries;
+}
+
+static inline bool NeedsWakeup(const XdpRing& ring) {
+  return (*ring.flags_ & XDP_RING_NEED_WAKEUP) != 0;
+}
+
+XdpSocket::XdpSocket(XdpTransport* transport, uint32_t queue_id,
+                     uint8_t* umem, size_t num_frames)
+    : umem_(umem), num_rx_frames_(num_frames - kXdpTxFrames) {
+  RtAssert(num_frames > kXdpTxFrames, "XDP: UMEM too small for TX frames");
+  RtAssert(reinterpret_cast<uintptr_t>(umem) % kXdpFrameSize == 0,
+           "XDP: UMEM must be page aligned");
+
+  fd_ = socket(AF_XDP, SOCK_RAW, 0);
+  if (fd_ < 0) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to create socket"));
+  }
+
+  xdp_umem_reg reg;
+  std::memset(&reg, 0, sizeof(reg));
+  reg.addr = reinterpret_cast<uint64_t>(umem);
+  reg.len = num_frames * kXdpFrameSize;
+  reg.chunk_size = kXdpFrameSize;
+  reg.headroom = kXdpFrameHeadroom;
+  if (setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) != 0) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to register UMEM"));
+  }
+
+  const int ring_size = kXdpRingSize;
+  for (int opt : {XDP_UMEM_FILL_RING, XDP_UMEM_COMPLETION_RING, XDP_RX_RING,
+                  XDP_TX_RING}) {
+    if (setsockopt(fd_, SOL_XDP, opt, &ring_size, sizeof(ring_size)) != 0) {
+      throw std::runtime_error(ErrnoString("XDP: Failed to size ring"));
+    }
+  }
+
+  xdp_mmap_offsets off;
+  socklen_t optlen = sizeof(off);
+  if (getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+    throw std::runtime_error(ErrnoString("XDP: Failed to get ring offsets"));
+  }
+  MapRing(fd_, off.fr, sizeof(uint64_t), kXdpRingSize,
+          XDP_UMEM_PGOFF_FILL_RING, fill_);
+  MapRing(fd_, off.cr, sizeof(uint64_t), kXdpRingSize,
+          XDP_UMEM_PGOFF_COMPLETION_RING, comp_);
+  MapRing(fd_, off.rx, sizeof(xdp_desc), kXdpRingSize, XDP_PGOFF_RX_RING,
+          rx_);
+  MapRing(fd_, off.tx, sizeof(xdp_desc), kXdpRingSize, XDP_PGOFF_TX_RING,
+          tx_);
+  // The producer owns the fill and TX rings; start with all entries free
+  fill_.cached_cons_ = *fill_.consumer_;
+  fill_.cached_prod_ = *fill_.producer_;
+  tx_.cached_cons_ = *tx_.consumer_;
+  tx_.cached_prod_ = *tx_.producer_;
+
+  zero_copy_ = transport->NativeMode();
+  if (zero_copy_ == true) {
+    try {
+      Bind(transport, queue_id, XDP_ZEROCOPY);
+    } catch (const std::runtime_error& e) {
+      MLPD_WARN("%s, falling back to copy mode\n", e.what());
+      zero_copy_ = false;
+    }
+  }
+  if (zero_copy_ == false) {
+    Bind(transport, queue_id, XDP_COPY);
+  }
+
+  for (size_t i = num_rx_frames_; i < num_frames; i++) {
+    free_tx_frames_.push_back(i * kXdpFrameSize);
+  }
+  for (size_t i = 0; i < num_rx_frames_; i++) {
+    recycled_.enqueue(i * kXdpFrameSize);
+  }
+  Refill();
+  transport->AddSocket(queue_id, fd_);
+}
+
+XdpSocket::~XdpSocket() {
+  for (XdpRing* ring : {&fill_, &comp_, &rx_, &tx_}) {
+    if (ring->map_ != nullptr) {
+      munmap(ring->map_, ring->map_len_);
+    }
+  }
+  close(fd_);
+}
+
+void XdpSocket::Bind(XdpTransport* transport, uint32_t queue_id,
+                     uint16_t flags) {
+  sockaddr_xdp addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sxdp_family = AF_XDP;
+  addr.sxdp_flags = flags | XDP_USE_NEED_WAKEUP;
+  addr.sxdp_ifindex = transport->IfIndex();
+  addr.sxdp_queue_id = queue_id;
+  if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    throw std::runtime_error(ErrnoString(
+        "XDP: Failed to bind socket to queue " + std::to_string(queue_id)));
+  }
+}
+
+void XdpSocket::Refill() {
+  uint32_t free_entries = FreeEntries(fill_);
+  if (free_entries == 0) {
+    return;
+  }
+  uint64_t addrs[kXdpRxBatchSize * 4];
+  size_t num = recycled_.try_dequeue_bulk(
+      addrs, std::min<size_t>(free_entries, kXdpRxBatchSize * 4));
+  if (num == 0) {
+    return;
+  }
+  auto* desc = static_cast<uint64_t*>(fill_.desc_);
+  for (size_t i = 0; i < num; i++) {
+    desc[(fill_.cached_prod_ + i) & fill_.mask_] = addrs[i];
+  }
+  fill_.cached_prod_ += num;
+  __atomic_store_n(fill_.producer_, fill_.cached_prod_, __ATOMIC_RELEASE);
+}
+
+size_t XdpSocket::Recv(uint64_t* addrs, uint32_t* lens, size_t max_pkts) {
+  size_t num = std::min<size_t>(AvailableEntries(rx_), max_pkts);
+  if (num == 0) {
+    if (NeedsWakeup(fill_) == true) {
+      recvfrom(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+    return 0;
+  }
+  auto* desc = static_cast<xdp_desc*>(rx_.desc_);
+  for (size_t i = 0; i < num; i++) {
+    const xdp_desc& d = desc[(rx_.cached_cons_ + i) & rx_.mask_];
+    addrs[i] = d.addr;
+    lens[i] = d.len;
+  }
+  rx_.cached_cons_ += num;
+  __atomic_store_n(rx_.consumer_, rx_.cached_cons_, __ATOMIC_RELEASE);
+  return num;
+}
+
+void XdpSocket::ReclaimTx() {
+  size_t num = AvailableEntries(comp_);
+  auto* desc = static_cast<uint64_t*>(comp_.desc_);
+  for (size_t i = 0; i < num; i++) {
+    free_tx_frames_.push_back(desc[(comp_.cached_cons_ + i) & comp_.mask_]);
+  }
+  comp_.cached_cons_ += num;
+  __atomic_store_n(comp_.consumer_, comp_.cached_cons_, __ATOMIC_RELEASE);
+}
+
+uint8_t* XdpSocket::AllocTx() {
+  if (free_tx_frames_.empty() == true) {
+    ReclaimTx();
+    if (free_tx_frames_.empty() == true) {
+      Kick();
+      return nullptr;
+    }
+  }
+  uint64_t addr = free_tx_frames_.back();
+  free_tx_frames_.pop_back();
+  return umem_ + addr;
+}
+
+void XdpSocket::Send(uint8_t* frame, uint32_t len) {
+  // The TX ring is larger than the number of TX frames, so it is never full
+  RtAssert(FreeEntries(tx_) > 0, "XDP: TX ring full");
+  auto* desc = static_cast<xdp_desc*>(tx_.desc_);
+  xdp_desc& d = desc[tx_.cached_prod_ & tx_.mask_];
+  d.addr = frame - umem_;
+  d.len = len;
+  d.options = 0;
+  tx_.cached_prod_++;
+  __atomic_store_n(tx_.producer_, tx_.cached_prod_, __ATOMIC_RELEASE);
+  // Copy mode transmits only from the sendto() syscall
+  if (zero_copy_ == false || NeedsWakeup(tx_) == true) {
+    Kick();
+  }
+}
+
+void XdpSocket::Kick() {
+  if (sendto(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, 0) < 0) {
+    if (errno != EAGAIN && errno != EBUSY && errno != ENOBUFS &&
+        errno != ENETDOWN) {
+      MLPD_ERROR("XDP: TX wakeup failed: %s\n", std::strerror(errno));
+    }
+  }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file xdp_transport.h
+ * @brief Declaration file for the XdpTransport and XdpSocket classes, which
+ * provide AF_XDP packet I/O through the kernel uapi without libbpf.
+ */
+
+#ifndef XDP_TRANSPORT_H_
+#define XDP_TRANSPORT_H_
+
+#include <linux/if_xdp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "concurrentqueue.h"
+
+/// Size of one UMEM frame. AF_XDP frames cannot exceed a page without
+/// multi-buffer support, so a packet and its headers must fit in one frame.
+static constexpr size_t kXdpFrameSize = 4096;
+static constexpr size_t kXdpRingSize = 2048;
+/// Number of UMEM frames at the end of each socket's region kept for TX
+static constexpr size_t kXdpTxFrames = 256;
+static constexpr size_t kXdpRxBatchSize = 16;
+
+/// Offset to the payload starting from the beginning of the Ethernet frame
+static constexpr size_t kXdpPayloadOffset = 14 + 20 + 8;
+/// Headroom the kernel reserves before each received frame
+/// (XDP_PACKET_HEADROOM)
+static constexpr size_t kXdpKernelHeadroom = 256;
+/// Extra UMEM headroom so that the payload of a frame received in copy mode
+/// starts 64-byte aligned
+static constexpr size_t kXdpFrameHeadroom = 22;
+static_assert((kXdpKernelHeadroom + kXdpFrameHeadroom + kXdpPayloadOffset) %
+                      64 ==
+                  0,
+              "");
+
+/// Addresses for transmitting to one peer, all in network byte order
+struct XdpFlow {
+  uint8_t src_mac_[6];
+  uint8_t dst_mac_[6];
+  uint32_t src_addr_;
+  uint32_t dst_addr_;
+};
+
+/**
+ * @brief An XDP program attached to one interface that redirects IPv4 UDP
+ * packets in a destination port range to the AF_XDP socket bound to the
+ * packet's RX queue. All other traffic (ARP, fragments, other ports) goes to
+ * the kernel stack.
+ */
+class XdpTransport {
+ public:
+  /**
+   * @param ifname Interface to attach to
+   * @param port_lo Lowest UDP destination port to redirect
+   * @param port_hi Highest UDP destination port to redirect
+   * @param num_queues Number of RX queues that may have a socket
+   * @param native_mode Attach in driver mode instead of generic (SKB) mode
+   */
+  XdpTransport(const std::string& ifname, uint16_t port_lo, uint16_t port_hi,
+               size_t num_queues, bool native_mode);
+  ~XdpTransport();
+
+  // Register socket [xsk_fd] to receive the packets of RX queue [queue_id]
+  void AddSocket(uint32_t queue_id, int xsk_fd);
+
+  // The flow for replying to the sender of the received Ethernet frame
+  static XdpFlow ReplyFlow(const uint8_t* rx_frame);
+
+  // Write the Ethernet, IPv4, and UDP headers for a UDP payload of
+  // [payload_len] bytes to [frame] and return the frame length
+  static size_t WriteHeaders(uint8_t* frame, const XdpFlow& flow,
+                             uint16_t src_port, uint16_t dst_port,
+                             size_t payload_len);
+
+  inline int IfIndex() const { return this->ifindex_; }
+  inline bool NativeMode() const { return this->native_mode_; }
+
+ private:
+  int ifindex_;
+  bool native_mode_;
+  int xsks_map_fd_;
+  int prog_fd_;
+  int link_fd_;
+};
+
+/// One of the four AF_XDP rings (fill, completion, RX, or TX) mapped from the
+/// kernel. The cached indices avoid touching the shared cacheline until the
+/// local view runs out.
+struct XdpRing {
+  uint32_t* producer_ = nullptr;
+  uint32_t* consumer_ = nullptr;
+  uint32_t* flags_ = nullptr;
+  void* desc_ = nullptr;
+  uint32_t mask_ = 0;
+  uint32_t size_ = 0;
+  uint32_t cached_prod_ = 0;
+  uint32_t cached_cons_ = 0;
+  void* map_ = nullptr;
+  size_t map_len_ = 0;
+};
+
+/**
+ * @brief An AF_XDP socket and its UMEM, used by one TXRX thread.
+ *
+ * The UMEM is a caller-owned, page-aligned region of kXdpFrameSize frames.
+ * Frame i of the region backs RX slot i of the thread's packet ring, and the
+ * last kXdpTxFrames frames are used for transmission. RX frames released by
+ * the workers are queued with Recycle() from any thread and handed back to
+ * the kernel by the owning thread in Refill().
+ */
+class XdpSocket {
+ public:
+  XdpSocket(XdpTransport* transport, uint32_t queue_id, uint8_t* umem,
+            size_t num_frames);
+  ~XdpSocket();
+
+  /**
+   * @brief Receive up to [max_pkts] packets
+   *
+   * @param addrs UMEM offsets of the Ethernet frames received
+   * @param lens Lengths of the Ethernet frames received
+   *
+   * @return The number of packets received
+   */
+  size_t Recv(uint64_t* addrs, uint32_t* lens, size_t max_pkts);
+
+  /// Return RX frame [addr] to the kernel. Thread-safe.
+  inline void Recycle(uint64_t addr) { recycled_.enqueue(addr); }
+
+  /// Move recycled RX frames into the fill ring. Called by the owner only.
+  void Refill();
+
+  /// Get a free TX frame, or nullptr if all TX frames are in flight
+  uint8_t* AllocTx();
+
+  /// Transmit [len] bytes from a frame returned by AllocTx()
+  void Send(uint8_t* frame, uint32_t len);
+
+  inline uint8_t* Umem() const { return this->umem_; }
+  inline size_t NumRxFrames() const { return this->num_rx_frames_; }
+  inline bool ZeroCopy() const { return this->zero_copy_; }
+
+ private:
+  void Bind(XdpTransport* transport, uint32_t queue_id, uint16_t flags);
+  void ReclaimTx();
+  void Kick();
+
+  int fd_;
+  uint8_t* umem_;
+  size_t num_rx_frames_;
+  bool zero_copy_;
+
+  XdpRing fill_;
+  XdpRing comp_;
+  XdpRing rx_;
+  XdpRing tx_;
+
+  std::vector<uint64_t> free_tx_frames_;
+  moodycamel::ConcurrentQueue<uint64_t> recycled_;
+};
+
+#endif  // XDP_TRANSPORT_H_
@@ -35,7 +35,7 @@ void DelayTicks(uint64_t start, uint64_t ticks) {
 }
 
 inline size_t MacSender::TagToTxBuffersIndex(gen_tag_t tag) const {
-  const size_t frame_slot = (tag.frame_id_ % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(tag.frame_id_);
 
   return (frame_slot * cfg_->UeAntNum()) + tag.ue_id_;
 }
@@ -80,20 +80,20 @@ MacSender::MacSender(Config* cfg, std::string& data_filename,
   ticks_wnd2_ = ticks_all_ * 15;
 
   // tx buffers will be an array of MacPackets
-  tx_buffers_.Malloc(kFrameWnd * cfg_->UeAntNum(),
+  tx_buffers_.Malloc(cfg_->FrameWnd() * cfg_->UeAntNum(),
                      (packets_per_frame_ *
                       (cfg_->MacPacketLength() + MacPacket::kOffsetOfData)),
                      Agora_memory::Alignment_t::kAlign64);
   MLPD_TRACE(
       "Tx buffer size: dim1 %zu, dim2 %zu, total %zu, start %zu, end: %zu\n",
-      (kFrameWnd * cfg_->UeAntNum()),
+      (cfg_->FrameWnd() * cfg_->UeAntNum()),
       (packets_per_frame_ *
        (cfg_->MacPacketLength() + MacPacket::kOffsetOfData)),
-      (kFrameWnd * cfg_->UeAntNum()) *
+      (cfg_->FrameWnd() * cfg_->UeAntNum()) *
           (packets_per_frame_ *
            (cfg_->MacPacketLength() + MacPacket::kOffsetOfData)),
       (size_t)tx_buffers_[0],
-      (size_t)tx_buffers_[(kFrameWnd * cfg_->UeAntNum()) - 1]);
+      (size_t)tx_buffers_[(cfg_->FrameWnd() * cfg_->UeAntNum()) - 1]);
 
   MLPD_INFO(
       "Initializing MacSender, sending to mac thread at %s:%zu, frame "
@@ -173,8 +173,7 @@ void MacSender::ScheduleFrame(size_t frame) {
 
 void* MacSender::MasterThread(size_t /*unused*/) {
   PinToCoreWithOffset(ThreadType::kMasterTX, core_offset_, 0);
-  std::array<size_t, kFrameWnd> frame_data_count;
-  frame_data_count.fill(0);
+  std::vector<size_t> frame_data_count(cfg_->FrameWnd(), 0);
 
   // Wait for all worker threads to be ready (+1 for Master)
   for (size_t i = 0; i < kFrameLoadAdvance; i++) {
@@ -204,7 +203,7 @@ void* MacSender::MasterThread(size_t /*unused*/) {
     gen_tag_t ctag(0);  // The completion tag
     int ret = static_cast<int>(completion_queue_.try_dequeue(ctag.tag_));
     if (ret > 0) {
-      const size_t comp_frame_slot = (ctag.frame_id_ % kFrameWnd);
+      const size_t comp_frame_slot = cfg_->FrameSlot(ctag.frame_id_);
       frame_data_count.at(comp_frame_slot)++;
 
       if (kDebugPrintSender) {
@@ -360,9 +359,9 @@ void* MacSender::WorkerThread(size_t tid) {
 uint64_t MacSender::GetTicksForFrame(size_t frame_id) const {
   if (enable_slow_start_ == 0) {
     return ticks_all_;
-  } else if (frame_id < kFrameWnd) {
+  } else if (frame_id < cfg_->FrameWnd()) {
     return ticks_wnd1_;
-  } else if (frame_id < (kFrameWnd * 4)) {
+  } else if (frame_id < (cfg_->FrameWnd() * 4)) {
     return ticks_wnd2_;
   } else {
     return ticks_all_;
@@ -11,7 +11,7 @@ static constexpr size_t kUdpRxBufferPadding = 2048u;
 
 MacThreadBaseStation::MacThreadBaseStation(
     Config* cfg, size_t core_offset,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
     Table<int8_t>* dl_bits_buffer, Table<int8_t>* dl_bits_buffer_status,
     moodycamel::ConcurrentQueue<EventData>* rx_queue,
     moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -80,6 +80,9 @@ void MacThreadBaseStation::ProcessRxFromPhy() {
   } else if (event.event_type_ == EventType::kSNRReport) {
     MLPD_TRACE("MAC thread event kSNRReport\n");
     ProcessSnrReportFromPhy(event);
+  } else if (event.event_type_ == EventType::kFrameDropped) {
+    MLPD_TRACE("MAC thread event kFrameDropped\n");
+    ProcessFrameDroppedFromPhy(event);
   }
 }
 
@@ -94,6 +97,12 @@ void MacThreadBaseStation::ProcessSnrReportFromPhy(EventData event) {
   server_.snr_[ue_id].push(snr);
 }
 
+void MacThreadBaseStation::ProcessFrameDroppedFromPhy(EventData event) {
+  const size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+  server_.n_filled_in_frame_.fill(0);
+  std::fprintf(log_file_, "MAC thread: PHY dropped frame %zu\n", frame_id);
+}
+
 void MacThreadBaseStation::SendRanConfigUpdate(EventData /*event*/) {
   RanConfig rc;
   rc.n_antennas_ = 0;  // TODO [arjun]: What's the correct value here?
@@ -122,7 +131,7 @@ void MacThreadBaseStation::ProcessCodeblocksFromPhy(EventData event) {
   const size_t symbol_idx_ul = this->cfg_->Frame().GetULSymbolIdx(symbol_id);
   const size_t ue_id = gen_tag_t(event.tags_[0]).ue_id_;
   const int8_t* ul_data_ptr =
-      decoded_buffer_[frame_id % kFrameWnd][symbol_idx_ul][ue_id];
+      decoded_buffer_[cfg_->FrameSlot(frame_id)][symbol_idx_ul][ue_id];
 
   std::stringstream ss;  // Debug-only
 
@@ -316,7 +325,7 @@ void MacThreadBaseStation::ProcessUdpPacketsFromApps() {
   RtAssert(tx_queue_->enqueue(msg),
            "MAC thread: Failed to enqueue uplink packet");
 
-  radio_buf_id = (radio_buf_id + 1) % kFrameWnd;
+  radio_buf_id = cfg_->FrameSlot(radio_buf_id + 1);
   next_radio_id_ = (next_radio_id_ + 1) % cfg_->UeAntNum();
   if (next_radio_id_ == 0) {
     next_tx_frame_id_++;
@@ -327,7 +336,7 @@ void MacThreadBaseStation::RunEventLoop() {
   MLPD_INFO("Running MAC thread event loop, logging to file %s\n",
             log_filename_.c_str());
   PinToCoreWithOffset(ThreadType::kWorkerMacTXRX, core_offset_,
-                      0 /* thread ID */);
+                      0 /* thread ID */, cfg_->Placement());
 
   size_t last_frame_tx_tsc = 0;
 
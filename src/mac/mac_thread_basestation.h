@@ -40,7 +40,7 @@ class MacThreadBaseStation {
 
   MacThreadBaseStation(
       Config* const cfg, size_t core_offset,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+      PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
       Table<int8_t>* dl_bits_buffer, Table<int8_t>* dl_bits_buffer_status,
       moodycamel::ConcurrentQueue<EventData>* rx_queue,
       moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -65,6 +65,10 @@ class MacThreadBaseStation {
   // TODO: process CQI report here as well.
   void ProcessSnrReportFromPhy(EventData event);
 
+  // Receive a frame dropped by the PHY master thread. Discard the partially
+  // received frame data of all UEs.
+  void ProcessFrameDroppedFromPhy(EventData event);
+
   // Push RAN config update to PHY master thread.
   void SendRanConfigUpdate(EventData event);
 
@@ -99,7 +103,7 @@ class MacThreadBaseStation {
 
   // TODO: decoded_buffer_ is used by only the server, so it should be moved
   // to server_ for clarity.
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
 
   Table<int8_t>* dl_bits_buffer_;
   Table<int8_t>* dl_bits_buffer_status_;
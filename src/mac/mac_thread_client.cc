@@ -11,7 +11,7 @@ static constexpr size_t kUdpRxBufferPadding = 2048u;
 
 MacThreadClient::MacThreadClient(
     Config* cfg, size_t core_offset,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
     Table<int8_t>* ul_bits_buffer, Table<int8_t>* ul_bits_buffer_status,
     moodycamel::ConcurrentQueue<EventData>* rx_queue,
     moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -129,7 +129,7 @@ void MacThreadClient::ProcessCodeblocksFromPhy(EventData event) {
   const size_t ue_id = gen_tag_t(event.tags_[0]).ue_id_;
 
   const int8_t* dl_data_ptr =
-      decoded_buffer_[(frame_id % kFrameWnd)][symbol_idx_dl][ue_id];
+      decoded_buffer_[cfg_->FrameSlot(frame_id)][symbol_idx_dl][ue_id];
 
   std::stringstream ss;  // Debug-only
 
@@ -356,7 +356,7 @@ void MacThreadClient::ProcessUdpPacketsFromAppsClient(const char* payload,
   RtAssert(tx_queue_->enqueue(msg),
            "MAC thread: Failed to enqueue uplink packet");
 
-  radio_buf_id = (radio_buf_id + 1) % kFrameWnd;
+  radio_buf_id = cfg_->FrameSlot(radio_buf_id + 1);
   next_radio_id_ = (next_radio_id_ + 1) % cfg_->UeAntNum();
   if (next_radio_id_ == 0) {
     next_tx_frame_id_++;
@@ -174,6 +174,7 @@ int main(int argc, char* argv[]) {
   auto cfg = std::make_unique<Config>(conf_file.c_str());
   cfg->GenData();
 
+  AsyncLogger::Start();
   int ret;
   try {
     SignalHandler signal_handler;
@@ -182,6 +183,26 @@ int main(int argc, char* argv[]) {
     agora_cli->flags_.enable_save_decode_data_to_file_ = true;
     agora_cli->flags_.enable_save_tx_data_to_file_ = true;
     agora_cli->Start();
+    // Write the queued log messages before the results
+    AsyncLogger::Stop();
+    std::printf(
+        "Frame latency: median %.1f us, p99 %.1f us, max %.1f us\n",
+        agora_cli->GetFrameLatencyUs(50), agora_cli->GetFrameLatencyUs(99),
+        agora_cli->GetFrameLatencyUs(100));
+    // Over the antennas, the worst fronthaul latency and jitter from the
+    // sender's packet timestamps
+    double fronthaul_latency_us = 0;
+    double fronthaul_jitter_us = 0;
+    for (size_t ant = 0; ant < cfg->BsAntNum(); ant++) {
+      fronthaul_latency_us = std::max(
+          fronthaul_latency_us, agora_cli->GetFronthaulLatencyUs(ant, 99));
+      fronthaul_jitter_us = std::max(fronthaul_jitter_us,
+                                     agora_cli->GetFronthaulJitterUs(ant, 99));
+    }
+    std::printf(
+        "Fronthaul one-way latency p99 %.0f us, jitter p99 %.0f us (worst "
+        "antenna)\n",
+        fronthaul_latency_us, fronthaul_jitter_us);
 
     std::printf("Start correctness check\n");
     unsigned int error_count = 0;
@@ -201,6 +222,22 @@ int main(int argc, char* argv[]) {
       assert(false);
     }
 
+    // Every frame must complete, each after the one before it, including
+    // when the uplink and downlink masters are split
+    const size_t num_frames = agora_cli->NumFramesCompleted();
+    size_t num_out_of_order = 0;
+    for (size_t frame_id = 1; frame_id < num_frames; frame_id++) {
+      if (agora_cli->GetFrameDoneTsc(frame_id) <
+          agora_cli->GetFrameDoneTsc(frame_id - 1)) {
+        num_out_of_order++;
+      }
+    }
+    std::printf("%zu of %zu frames completed, %zu out of order\n", num_frames,
+                cfg->FramesToTest(), num_out_of_order);
+    if ((num_frames != cfg->FramesToTest()) || (num_out_of_order > 0)) {
+      error_count++;
+    }
+
     std::printf("======================\n");
     std::printf("%s test: \n", test_name.c_str());
     if (error_count == 0) {
@@ -99,6 +99,20 @@ for i in `seq 1 $num_iters`; do
     sleep 1; ./build/sender --num_threads 1 --core_offset 10 --frame_duration 5000 --conf_file "data/tddconfig-correctness-test-both.json"
     echo -e "-------------------------------------------------------\n\n\n"
     wait
+
+    echo "==========================================="
+    echo "Generating data for split master combined correctness test $i......"
+    echo -e "===========================================\n"
+    ./build/data_generator --conf_file data/tddconfig-correctness-test-split-master-both.json
+
+    echo -e "-------------------------------------------------------\n\n\n"
+    echo "==========================================="
+    echo "Running split master combined correctness test $i......"
+    echo -e "===========================================\n"
+    ./build/test_agora data/tddconfig-correctness-test-split-master-both.json &
+    sleep 1; ./build/sender --num_threads 1 --core_offset 10 --frame_duration 5000 --conf_file "data/tddconfig-correctness-test-split-master-both.json"
+    echo -e "-------------------------------------------------------\n\n\n"
+    wait
   } >> $out_file
 
   # If the user supplied an output file, print pass/fail summary analysis
@@ -0,0 +1,42 @@
+#!/bin/bash
+#
+# Run the uplink, downlink, and combined correctness tests in Bigstation mode,
+# with one thread in each of the FFT, ZF, demul, and decode pools.
+#
+# Usage:
+#  * This script must be run from Agora's top-level directory
+#  * test_agora_bigstation.sh: Run the tests once
+#  * test_agora_bigstation.sh 5: Run the tests five times
+
+# Check that all required executables are present
+exe_list="build/test_agora build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit
+  fi
+done
+
+num_iters=1
+
+# Check if the user supplied a number-of-iterations argument
+if [ "$#" -ge 1 ]; then
+  num_iters=$1
+fi
+
+echo "Running Bigstation tests for $num_iters iterations"
+
+for i in `seq 1 $num_iters`; do
+  for test_type in ul dl both; do
+    conf_file="data/tddconfig-correctness-test-bigstation-${test_type}.json"
+    echo "==========================================="
+    echo "Running Bigstation ${test_type} correctness test $i......"
+    echo -e "===========================================\n"
+    ./build/data_generator --conf_file ${conf_file}
+    # We sleep before starting the sender to allow the Agora server to start
+    ./build/test_agora ${conf_file} &
+    sleep 1; ./build/sender --num_threads 1 --core_offset 10 --frame_duration 5000 --conf_file ${conf_file}
+    wait
+    echo -e "-------------------------------------------------------\n\n\n"
+  done
+done
@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# Run the uplink correctness test with the sender dropping packets at random.
+# Agora erases the antennas whose packets are missing when a symbol times out
+# (antenna_erasure_timeout_us), so every frame must still complete and decode.
+#
+# Usage:
+#  * This script must be run from Agora's top-level directory
+#  * test_agora_erasure.sh: Run the test once
+#  * test_agora_erasure.sh 5: Run the test five times
+
+# Check that all required executables are present
+exe_list="build/test_agora build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit
+  fi
+done
+
+num_iters=1
+
+# Check if the user supplied a number-of-iterations argument
+if [ "$#" -ge 1 ]; then
+  num_iters=$1
+fi
+
+conf_file="data/tddconfig-correctness-test-erasure-ul.json"
+drop_rate=0.01
+
+echo "Running antenna erasure tests for $num_iters iterations"
+
+for i in `seq 1 $num_iters`; do
+  echo "==========================================="
+  echo "Running uplink correctness test with ${drop_rate} packet loss $i......"
+  echo -e "===========================================\n"
+  ./build/data_generator --conf_file ${conf_file}
+  # We sleep before starting the sender to allow the Agora server to start
+  ./build/test_agora ${conf_file} &
+  sleep 1; ./build/sender --num_threads 1 --core_offset 10 \
+    --frame_duration 5000 --drop_rate ${drop_rate} --conf_file ${conf_file}
+  wait
+  echo -e "-------------------------------------------------------\n\n\n"
+done
@@ -0,0 +1,61 @@
+#!/bin/bash
+#
+# Run the uplink correctness test with the metrics exporter enabled, and
+# scrape the metrics socket while Agora processes the frames. Fails if a
+# scrape misses any of the expected metrics.
+#
+# Usage:
+#  * This script must be run from Agora's top-level directory
+#  * test_agora_metrics.sh
+
+# Check that all required executables are present
+exe_list="build/test_agora build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit
+  fi
+done
+if ! command -v curl > /dev/null; then
+  echo "curl not found. Exiting."
+  exit
+fi
+
+conf_file="data/tddconfig-correctness-test-metrics-ul.json"
+socket_path="/tmp/agora_metrics.sock"
+metric_list="agora_frames_done_total agora_frames_dropped_total
+  agora_rx_packets_total agora_stage_latency_us agora_ue_bler
+  agora_ue_pilot_snr_db agora_sched_queue_depth agora_complete_queue_depth
+  agora_message_queue_depth"
+
+echo "==========================================="
+echo "Running metrics test......"
+echo -e "===========================================\n"
+./build/data_generator --conf_file ${conf_file}
+./build/test_agora ${conf_file} &
+agora_pid=$!
+./build/sender --num_threads 1 --core_offset 10 --frame_duration 5000 \
+  --conf_file ${conf_file} &
+
+num_scrapes=0
+num_failures=0
+while kill -0 ${agora_pid} 2> /dev/null; do
+  sleep 0.2
+  scrape=$(curl -s --max-time 1 --unix-socket ${socket_path} \
+    http://localhost/metrics) || continue
+  num_scrapes=$((num_scrapes + 1))
+  for metric in ${metric_list}; do
+    if ! grep -q "^${metric}" <<< "${scrape}"; then
+      echo "Scrape ${num_scrapes} is missing ${metric}"
+      num_failures=$((num_failures + 1))
+    fi
+  done
+done
+wait
+
+echo "${num_scrapes} scrapes, ${num_failures} missing metrics"
+if [ ${num_scrapes} -eq 0 ] || [ ${num_failures} -ne 0 ]; then
+  echo "Metrics test failed"
+  exit 1
+fi
+echo "Metrics test passed"
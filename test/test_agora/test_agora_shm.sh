@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# Run the uplink and downlink correctness tests with Agora and the sender
+# exchanging packets through shared memory rings instead of UDP sockets, so
+# that the results reflect the PHY processing alone.
+#
+# Usage:
+#  * This script must be run from Agora's top-level directory
+#  * test_agora_shm.sh: Run the tests once
+#  * test_agora_shm.sh 5: Run the tests five times
+
+# Check that all required executables are present
+exe_list="build/test_agora build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit
+  fi
+done
+
+num_iters=1
+
+# Check if the user supplied a number-of-iterations argument
+if [ "$#" -ge 1 ]; then
+  num_iters=$1
+fi
+
+echo "Running shared memory tests for $num_iters iterations"
+
+for i in `seq 1 $num_iters`; do
+  for test_type in ul dl; do
+    conf_file="data/tddconfig-correctness-test-shm-${test_type}.json"
+    echo "==========================================="
+    echo "Running shared memory ${test_type} correctness test $i......"
+    echo -e "===========================================\n"
+    ./build/data_generator --conf_file ${conf_file}
+    # The sender waits for Agora to create the shared memory region
+    ./build/test_agora ${conf_file} &
+    sleep 1; ./build/sender --num_threads 1 --core_offset 10 \
+      --frame_duration 5000 --conf_file ${conf_file}
+    wait
+    echo -e "-------------------------------------------------------\n\n\n"
+  done
+done
@@ -0,0 +1,68 @@
+#!/bin/bash
+#
+# Run the uplink and downlink correctness tests over the AF_XDP transport.
+# Agora attaches in generic XDP mode to one end of a veth pair, and the sender
+# runs with kernel UDP sockets in a network namespace on the other end, so no
+# special NIC is needed.
+#
+# Usage:
+#  * Agora must be built with -DUSE_AF_XDP=True, and the script must be run as
+#    root from Agora's top-level directory
+#  * test_agora_xdp.sh: Run the tests once
+#  * test_agora_xdp.sh 5: Run the tests five times
+
+# Check that all required executables are present
+exe_list="build/test_agora build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit
+  fi
+done
+
+num_iters=1
+
+# Check if the user supplied a number-of-iterations argument
+if [ "$#" -ge 1 ]; then
+  num_iters=$1
+fi
+
+# Must match bs_server_addr, bs_rru_addr, and xdp_interface in the configs
+netns=agora-xdp-rru
+agora_if=agora-xdp0
+rru_if=agora-xdp1
+agora_addr=10.77.0.1
+rru_addr=10.77.0.2
+
+cleanup() {
+  ip netns del ${netns} 2>/dev/null
+}
+trap cleanup EXIT
+
+cleanup
+ip netns add ${netns} || exit 1
+ip link add ${agora_if} type veth peer name ${rru_if} netns ${netns} || exit 1
+# Packets must not be fragmented, since AF_XDP sees Ethernet frames
+ip link set ${agora_if} mtu 9000 up
+ip addr add ${agora_addr}/24 dev ${agora_if}
+ip netns exec ${netns} ip link set lo up
+ip netns exec ${netns} ip link set ${rru_if} mtu 9000 up
+ip netns exec ${netns} ip addr add ${rru_addr}/24 dev ${rru_if}
+
+echo "Running AF_XDP tests for $num_iters iterations"
+
+for i in `seq 1 $num_iters`; do
+  for test_type in ul dl; do
+    conf_file="data/tddconfig-correctness-test-xdp-${test_type}.json"
+    echo "==========================================="
+    echo "Running AF_XDP ${test_type} correctness test $i......"
+    echo -e "===========================================\n"
+    ./build/data_generator --conf_file ${conf_file}
+    # We sleep before starting the sender to allow the Agora server to start
+    ./build/test_agora ${conf_file} &
+    sleep 1; ip netns exec ${netns} ./build/sender --num_threads 1 \
+      --core_offset 10 --frame_duration 5000 --conf_file ${conf_file}
+    wait
+    echo -e "-------------------------------------------------------\n\n\n"
+  done
+done
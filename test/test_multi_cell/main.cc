@@ -0,0 +1,76 @@
+/**
+ * @file main.cc
+ * @brief Runs two Agora cells in one process on a shared pool of worker
+ * threads. Each cell receives from its own sender.
+ */
+#include "gflags/gflags.h"
+#include "multi_cell.h"
+
+DEFINE_string(
+    cell0_conf_file,
+    TOSTRING(PROJECT_DIRECTORY) "/data/tddconfig-multicell-cell0.json",
+    "Config filename of cell 0");
+DEFINE_string(
+    cell1_conf_file,
+    TOSTRING(PROJECT_DIRECTORY) "/data/tddconfig-multicell-cell1.json",
+    "Config filename of cell 1");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::vector<std::unique_ptr<Config>> cfgs;
+  cfgs.push_back(std::make_unique<Config>(FLAGS_cell0_conf_file.c_str()));
+  cfgs.push_back(std::make_unique<Config>(FLAGS_cell1_conf_file.c_str()));
+  std::vector<Config*> cfg_ptrs;
+  for (auto& cfg : cfgs) {
+    cfg->GenData();
+    cfg_ptrs.push_back(cfg.get());
+  }
+
+  int ret;
+  try {
+    SignalHandler signal_handler;
+
+    // Register signal handler to handle kill signal
+    signal_handler.SetupSignalHandlers();
+    auto multi_cell = std::make_unique<MultiCell>(cfg_ptrs);
+    multi_cell->Start();
+
+    size_t num_failed = 0;
+    std::printf("======================\n");
+    for (size_t i = 0; i < multi_cell->NumCells(); i++) {
+      Agora& cell = multi_cell->Cell(i);
+      std::printf(
+          "Cell %zu frame latency: median %.1f us, p99 %.1f us, max %.1f us\n",
+          i, cell.GetFrameLatencyUs(50), cell.GetFrameLatencyUs(99),
+          cell.GetFrameLatencyUs(100));
+      // Every frame must complete, with every uplink bit decoded correctly
+      const size_t num_frames = cell.NumFramesCompleted();
+      const size_t bit_errors = cell.GetUlBitErrors();
+      const size_t decoded_bits = cell.GetUlDecodedBits();
+      std::printf(
+          "Cell %zu: %zu of %zu frames completed, %zu bit errors in %zu "
+          "decoded bits\n",
+          i, num_frames, cfgs.at(i)->FramesToTest(), bit_errors, decoded_bits);
+      if ((num_frames != cfgs.at(i)->FramesToTest()) || (decoded_bits == 0) ||
+          (bit_errors > 0)) {
+        std::printf("Cell %zu failed\n", i);
+        num_failed++;
+      }
+    }
+    if (num_failed == 0) {
+      std::printf("Passed multi-cell test!\n");
+      ret = EXIT_SUCCESS;
+    } else {
+      std::printf("Failed multi-cell test! %zu cells failed\n", num_failed);
+      ret = EXIT_FAILURE;
+    }
+    std::printf("======================\n\n");
+  } catch (SignalException& e) {
+    std::cerr << "SignalException: " << e.what() << std::endl;
+    ret = EXIT_FAILURE;
+  }
+
+  gflags::ShutDownCommandLineFlags();
+  return ret;
+}
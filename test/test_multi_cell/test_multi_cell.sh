@@ -0,0 +1,45 @@
+#!/bin/bash
+#
+# Usage:
+#  * This script must be run from Agora's top-level directory
+#  * test_multi_cell.sh: Run two cells in one Agora process, each with its
+#    own sender on the loopback interface
+
+# Check that all required executables are present
+exe_list="build/test_multi_cell build/data_generator build/sender"
+for exe in ${exe_list}; do
+  if [ ! -f ${exe} ]; then
+      echo "${exe} not found. Exiting."
+      exit 1
+  fi
+done
+
+cell0_conf="data/tddconfig-multicell-cell0.json"
+cell1_conf="data/tddconfig-multicell-cell1.json"
+
+echo "==========================================="
+echo "Generating data for multi-cell test......"
+echo -e "===========================================\n"
+# Both cells use the same PHY parameters, so they share the generated data
+./build/data_generator --conf_file ${cell0_conf}
+
+echo -e "-------------------------------------------------------\n\n\n"
+echo "==========================================="
+echo "Running multi-cell test......"
+echo -e "===========================================\n"
+# We sleep before starting the senders to allow the Agora server to start
+./build/test_multi_cell --cell0_conf_file ${cell0_conf} \
+  --cell1_conf_file ${cell1_conf} &
+agora_pid=$!
+sleep 1
+./build/sender --num_threads 1 --core_offset 10 --frame_duration 5000 \
+  --conf_file ${cell0_conf} &
+./build/sender --num_threads 1 --core_offset 12 --frame_duration 5000 \
+  --conf_file ${cell1_conf}
+wait ${agora_pid}
+ret=$?
+wait
+if [ ${ret} -ne 0 ]; then
+  echo "Multi-cell test failed"
+fi
+exit ${ret}
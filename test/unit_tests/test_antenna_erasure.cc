@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <random>
+
+#include "buffer.h"
+
+static constexpr size_t kNumTestFrames = 400;
+static constexpr size_t kNumSymbols = 6;
+static constexpr size_t kNumAnts = 16;
+// A small window so that the slots of erased symbols are reused
+static constexpr size_t kFrameWnd = 4;
+static constexpr double kDropRate = 0.05;
+// Rate of losing all the packets of a symbol
+static constexpr double kSymbolDropRate = 0.02;
+// Clock ticks, one per packet
+static constexpr size_t kTimeoutTicks = 2 * kNumAnts;
+static constexpr size_t kLateTicks = 4 * kTimeoutTicks;
+
+struct PendingSymbol {
+  size_t frame_id_;
+  size_t symbol_id_;
+};
+
+struct LatePacket {
+  size_t frame_id_;
+  size_t symbol_id_;
+  size_t ant_id_;
+  size_t arrival_tick_;
+};
+
+/// Packets, and all the packets of some symbols, are lost or delayed at
+/// random, as by the sender's drop_rate, and handled as the master does.
+/// Every symbol completes with exactly its lost antennas erased, and delayed
+/// packets arriving after the erasure are rejected.
+TEST(TestAntennaErasure, RandomDropsCompleteEverySymbol) {
+  AntennaErasures erasures;
+  erasures.Init(kFrameWnd, kNumSymbols, kNumAnts);
+  std::mt19937 rng(1);
+  std::bernoulli_distribution drop_dist(kDropRate);
+  std::bernoulli_distribution symbol_drop_dist(kSymbolDropRate);
+  std::bernoulli_distribution delay_dist(0.5);
+
+  std::queue<PendingSymbol> pending;
+  std::queue<LatePacket> late_packets;
+  std::vector<std::bitset<kMaxAntennas>> lost(kNumTestFrames * kNumSymbols);
+  size_t num_completed = 0;
+  size_t num_lost = 0;
+  size_t num_erased = 0;
+  size_t num_late_rejected = 0;
+  size_t tick = 0;
+
+  auto receive = [&](size_t frame_id, size_t symbol_id, size_t ant_id) {
+    if (erasures.IsErased(frame_id, symbol_id, ant_id) == true) {
+      num_late_rejected++;
+      return;
+    }
+    if (erasures.MarkReceived(frame_id, symbol_id, ant_id, tick) == true) {
+      for (size_t i = 0; i < kNumSymbols; i++) {
+        pending.push({frame_id, i});
+      }
+    }
+  };
+  auto check_erasures = [&]() {
+    while (pending.empty() == false) {
+      const PendingSymbol& symbol = pending.front();
+      if (erasures.IsComplete(symbol.frame_id_, symbol.symbol_id_) == false) {
+        if (erasures.TimedOut(symbol.frame_id_, symbol.symbol_id_, tick,
+                              kTimeoutTicks) == false) {
+          break;
+        }
+        const std::bitset<kMaxAntennas> erased =
+            erasures.EraseMissing(symbol.frame_id_, symbol.symbol_id_);
+        EXPECT_EQ(erased,
+                  lost.at(symbol.frame_id_ * kNumSymbols + symbol.symbol_id_));
+        num_erased += erased.count();
+      }
+      ASSERT_TRUE(erasures.IsComplete(symbol.frame_id_, symbol.symbol_id_));
+      num_completed++;
+      pending.pop();
+    }
+  };
+
+  for (size_t frame_id = 0; frame_id < kNumTestFrames; frame_id++) {
+    for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+      // The first symbol is never lost, so that every frame has a packet
+      const bool symbol_lost =
+          (symbol_id > 0) && (symbol_drop_dist(rng) == true);
+      for (size_t ant_id = 0; ant_id < kNumAnts; ant_id++) {
+        tick++;
+        if ((symbol_lost == true) || (drop_dist(rng) == true)) {
+          lost.at(frame_id * kNumSymbols + symbol_id).set(ant_id);
+          num_lost++;
+          if (delay_dist(rng) == true) {
+            late_packets.push({frame_id, symbol_id, ant_id, tick + kLateTicks});
+          }
+        } else {
+          receive(frame_id, symbol_id, ant_id);
+        }
+        while ((late_packets.empty() == false) &&
+               (late_packets.front().arrival_tick_ <= tick)) {
+          const LatePacket& late = late_packets.front();
+          // The slot of a late packet's frame must not be reused yet
+          ASSERT_LT(frame_id, late.frame_id_ + kFrameWnd);
+          receive(late.frame_id_, late.symbol_id_, late.ant_id_);
+          late_packets.pop();
+        }
+        check_erasures();
+      }
+    }
+  }
+  while (pending.empty() == false) {
+    tick++;
+    check_erasures();
+  }
+
+  EXPECT_EQ(num_completed, kNumTestFrames * kNumSymbols);
+  EXPECT_GT(num_lost, 0);
+  EXPECT_EQ(num_erased, num_lost);
+  EXPECT_GT(num_late_rejected, 0);
+}
+
+/// A symbol whose packets are all lost times out after the latest packet of
+/// its frame, and one with packets after its own first packet
+TEST(TestAntennaErasure, LostSymbolTimesOut) {
+  AntennaErasures erasures;
+  erasures.Init(kFrameWnd, kNumSymbols, kNumAnts);
+  EXPECT_TRUE(erasures.MarkReceived(1, 0, 0, 100));
+  EXPECT_FALSE(erasures.MarkReceived(1, 3, 0, 150));
+  EXPECT_FALSE(erasures.MarkReceived(1, 3, 1, 180));
+  // Symbol 2 of frame 1 has no packets
+  EXPECT_FALSE(erasures.IsComplete(1, 2));
+  EXPECT_FALSE(erasures.TimedOut(1, 2, 180 + kTimeoutTicks, kTimeoutTicks));
+  EXPECT_TRUE(erasures.TimedOut(1, 2, 181 + kTimeoutTicks, kTimeoutTicks));
+  EXPECT_TRUE(erasures.TimedOut(1, 3, 151 + kTimeoutTicks, kTimeoutTicks));
+  EXPECT_EQ(erasures.EraseMissing(1, 2).count(), kNumAnts);
+  EXPECT_TRUE(erasures.IsComplete(1, 2));
+}
+
+/// A frame that reuses a slot starts with no erased antennas
+TEST(TestAntennaErasure, SlotReuseResetsErasures) {
+  AntennaErasures erasures;
+  erasures.Init(kFrameWnd, kNumSymbols, kNumAnts);
+  for (size_t ant_id = 1; ant_id < kNumAnts; ant_id++) {
+    erasures.MarkReceived(0, 2, ant_id);
+  }
+  EXPECT_FALSE(erasures.IsComplete(0, 2));
+  EXPECT_EQ(erasures.EraseMissing(0, 2).count(), 1);
+  EXPECT_TRUE(erasures.IsErased(0, 2, 0));
+  EXPECT_TRUE(erasures.IsComplete(0, 2));
+
+  EXPECT_TRUE(erasures.MarkReceived(kFrameWnd, 2, 0));
+  EXPECT_FALSE(erasures.IsErased(kFrameWnd, 2, 0));
+  EXPECT_TRUE(erasures.Erased(kFrameWnd, 2).none());
+  EXPECT_FALSE(erasures.IsErased(0, 2, 0));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
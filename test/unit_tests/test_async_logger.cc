@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_logger.h"
+#include "logger.h"
+
+static constexpr size_t kBenchIterations = 100000;
+
+/// Queue one message on a new thread, whose ring is empty, and format it
+template <typename... Args>
+static std::string FormatAsync(const char* format, const Args&... args) {
+  std::string formatted;
+  std::thread thread([&]() {
+    std::FILE* stream = std::tmpfile();
+    ASSERT_TRUE(AsyncLogger::Log(stream, MLPD_LOG_LEVEL_INFO, format, args...));
+    // The message is the only one in this thread's ring, which the logger
+    // never drains while it is stopped
+    AsyncLogger::Start();
+    AsyncLogger::Stop();
+    std::rewind(stream);
+    char line[1024];
+    ASSERT_NE(std::fgets(line, sizeof(line), stream), nullptr);
+    std::fclose(stream);
+    // Skip the "seconds:microseconds INFOR: " header
+    formatted = std::strstr(line, "INFOR: ") + std::strlen("INFOR: ");
+  });
+  thread.join();
+  return formatted;
+}
+
+/// Return what snprintf prints for format and args
+template <typename... Args>
+static std::string FormatSync(const char* format, const Args&... args) {
+  char buf[1024];
+  std::snprintf(buf, sizeof(buf), format, args...);
+  return buf;
+}
+
+#define EXPECT_FORMAT(...) \
+  EXPECT_EQ(FormatAsync(__VA_ARGS__), FormatSync(__VA_ARGS__))
+
+TEST(TestAsyncLogger, Format) {
+  EXPECT_FORMAT("No arguments, 100%% done\n");
+  EXPECT_FORMAT("%d %i %u %ld %lu %zu %hhu\n", -5, 7, 42u, -123456789012L,
+                18446744073709551615UL, size_t{99}, 255);
+  EXPECT_FORMAT("%x %X %o %#x %08x %-6d| %+d\n", 0xbeefu, 0xcafeu, 8u, 255u,
+                0x1234u, 17, 3);
+  // Negative ints printed with unsigned conversions wrap at their size
+  EXPECT_FORMAT("%u %x\n", -1, -2);
+  EXPECT_FORMAT("%f %.2f %10.3e %g %G\n", 3.14159, 2.71828, 12345.678,
+                0.0001, 1e20);
+  EXPECT_FORMAT("%.2f %c%c\n", 1.5f, 'o', 'k');
+  EXPECT_FORMAT("[%s] [%10s] [%-5s] [%.3s]\n", "abc", "right", "left",
+                "truncated");
+  EXPECT_FORMAT("%*d|%-*d|%.*f\n", 6, 42, 4, 7, 3, 1.23456);
+  const std::string name = "UE 3";
+  char buf[16] = "from a buffer";
+  EXPECT_FORMAT("%s: %s, %p\n", name.c_str(), buf, static_cast<void*>(buf));
+}
+
+/// Strings that do not fit in the record are truncated, and conversions
+/// without an argument are printed as is
+TEST(TestAsyncLogger, LongAndMissingArguments) {
+  const std::string long_string(500, 'x');
+  const std::string formatted = FormatAsync("%s\n", long_string.c_str());
+  EXPECT_LT(formatted.size(), long_string.size());
+  EXPECT_EQ(formatted.find_first_not_of('x'), formatted.size() - 1);
+
+  EXPECT_EQ(FormatAsync("%d %d %d %d %d %d %d %d %d %d %d %d %d\n", 1, 2, 3,
+                        4, 5, 6, 7, 8, 9, 10, 11, 12, 13),
+            "1 2 3 4 5 6 7 8 9 10 11 12 %d\n");
+}
+
+/// Conversions with long flags, widths, and precisions are clamped to the
+/// message length instead of overflowing
+TEST(TestAsyncLogger, LongConversions) {
+  EXPECT_FORMAT("[%-+ #0-+ #0-+d] [%0000012d] [%-*.*f] [%.*d]\n", 5, -7, -10,
+                -3, 1.5, -1, 42);
+  // The whole number is consumed, not parsed as the conversion
+  EXPECT_EQ(FormatAsync("[%.99999999999999999999s] [%.*s]\n", "abc",
+                        2147483647, "def"),
+            "[abc] [def]\n");
+}
+
+/// A full ring drops and counts messages instead of blocking, and the
+/// queued messages are written in order when the logger drains them
+TEST(TestAsyncLogger, DropWhenFull) {
+  std::FILE* stream = std::tmpfile();
+  const size_t dropped_before = AsyncLogger::NumDropped();
+  std::thread thread([&]() {
+    for (size_t i = 0; i < AsyncLogger::kRingSlots + 10; i++) {
+      AsyncLogger::Log(stream, MLPD_LOG_LEVEL_INFO, "Message %zu\n", i);
+    }
+  });
+  thread.join();
+  EXPECT_EQ(AsyncLogger::NumDropped() - dropped_before, 10);
+
+  AsyncLogger::Start();
+  AsyncLogger::Stop();
+  std::rewind(stream);
+  char line[256];
+  size_t num_lines = 0;
+  while (std::fgets(line, sizeof(line), stream) != nullptr) {
+    ASSERT_NE(std::strstr(line, ("Message " + std::to_string(num_lines) +
+                                 "\n")
+                                    .c_str()),
+              nullptr);
+    num_lines++;
+  }
+  EXPECT_EQ(num_lines, AsyncLogger::kRingSlots);
+  std::fclose(stream);
+}
+
+/// Messages of several threads are all written while the logger runs
+TEST(TestAsyncLogger, ConcurrentThreads) {
+  static constexpr size_t kThreads = 4;
+  static constexpr size_t kMessages = 2000;
+  std::FILE* stream = std::tmpfile();
+  const size_t dropped_before = AsyncLogger::NumDropped();
+  AsyncLogger::Start();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; t++) {
+    threads.emplace_back([stream]() {
+      for (size_t i = 0; i < kMessages; i++) {
+        while (AsyncLogger::Log(stream, MLPD_LOG_LEVEL_FRAME,
+                                "Thread message %zu\n", i) == false) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  AsyncLogger::Stop();
+
+  std::rewind(stream);
+  char line[256];
+  size_t num_lines = 0;
+  while (std::fgets(line, sizeof(line), stream) != nullptr) {
+    ASSERT_NE(std::strstr(line, "FRAME: Thread message "), nullptr);
+    num_lines++;
+  }
+  // Retried messages were counted as dropped
+  EXPECT_EQ(num_lines, kThreads * kMessages);
+  EXPECT_GE(AsyncLogger::NumDropped(), dropped_before);
+  std::fclose(stream);
+}
+
+/// Print the latency of a logging call of the logging thread, with and
+/// without the AsyncLogger
+TEST(TestAsyncLogger, Latency) {
+  std::FILE* stream = std::fopen("/dev/null", "w");
+  ASSERT_NE(stream, nullptr);
+  std::vector<uint64_t> sync_cycles(kBenchIterations);
+  std::vector<uint64_t> async_cycles(kBenchIterations);
+
+  for (size_t i = 0; i < kBenchIterations; i++) {
+    const uint64_t start = __rdtsc();
+    MlpdLog(stream, MLPD_LOG_LEVEL_INFO, "Frame %zu, symbol %d: %.3f, %s\n", i,
+            7, 0.5, "decode");
+    sync_cycles.at(i) = __rdtsc() - start;
+  }
+
+  AsyncLogger::Start();
+  for (size_t i = 0; i < kBenchIterations; i++) {
+    const uint64_t start = __rdtsc();
+    MlpdLog(stream, MLPD_LOG_LEVEL_INFO, "Frame %zu, symbol %d: %.3f, %s\n", i,
+            7, 0.5, "decode");
+    async_cycles.at(i) = __rdtsc() - start;
+    if ((i % (AsyncLogger::kRingSlots / 2)) == 0) {
+      // Let the background thread keep up on a machine with few cores
+      std::this_thread::yield();
+    }
+  }
+  AsyncLogger::Stop();
+  std::fclose(stream);
+
+  for (auto* cycles : {&sync_cycles, &async_cycles}) {
+    std::sort(cycles->begin(), cycles->end());
+    std::printf("%s logging: median %" PRIu64
+                " cycles, 99th percentile %" PRIu64 " cycles\n",
+                (cycles == &sync_cycles) ? "Synchronous" : "Asynchronous",
+                cycles->at(kBenchIterations / 2),
+                cycles->at(kBenchIterations * 99 / 100));
+  }
+  EXPECT_LT(async_cycles.at(kBenchIterations / 2),
+            sync_cycles.at(kBenchIterations / 2));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
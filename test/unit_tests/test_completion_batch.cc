@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "concurrent_queue_wrapper.h"
+#include "concurrentqueue.h"
+
+static constexpr size_t kNumWorkers = 8;
+static constexpr size_t kTasksPerWorker = (1 << 16);
+// Tasks of the same frame that a worker completes back to back
+static constexpr size_t kTasksPerFrame = 32;
+static constexpr size_t kNeverExpireTsc = SIZE_MAX;
+// Preallocate the completion queue so that the workers never wait for memory
+static constexpr size_t kQueueSize = 2 * kNumWorkers * kTasksPerWorker;
+
+static EventData DemulCompletion(size_t frame_id, size_t sc_id) {
+  return EventData(EventType::kDemul,
+                   gen_tag_t::FrmSymSc(frame_id, 0, sc_id).tag_);
+}
+
+TEST(TestCompletionBatch, CoalesceSameTypeAndFrame) {
+  moodycamel::ConcurrentQueue<EventData> queue;
+  moodycamel::ProducerToken ptok(queue);
+  CompletionBatch batch(&queue, &ptok, kNeverExpireTsc);
+
+  for (size_t i = 0; i < EventData::kMaxTags; i++) {
+    batch.Add(DemulCompletion(1, i));
+  }
+  ASSERT_EQ(batch.NumEvents(), 1);
+  // The tag array of the first event is full
+  batch.Add(DemulCompletion(1, EventData::kMaxTags));
+  ASSERT_EQ(batch.NumEvents(), 2);
+  // Another frame or type starts a new event
+  batch.Add(DemulCompletion(2, 0));
+  ASSERT_EQ(batch.NumEvents(), 3);
+  batch.Add(EventData(EventType::kDecode, gen_tag_t::FrmSymCb(2, 0, 0).tag_));
+  ASSERT_EQ(batch.NumEvents(), 4);
+  ASSERT_EQ(queue.size_approx(), 0);
+
+  batch.Flush();
+  ASSERT_EQ(batch.NumEvents(), 0);
+  EventData events[CompletionBatch::kMaxEvents];
+  ASSERT_EQ(queue.try_dequeue_bulk(events, CompletionBatch::kMaxEvents), 4);
+  ASSERT_EQ(events[0].num_tags_, EventData::kMaxTags);
+  for (size_t i = 0; i < EventData::kMaxTags; i++) {
+    ASSERT_EQ(gen_tag_t(events[0].tags_[i]).sc_id_, i);
+  }
+  ASSERT_EQ(events[1].num_tags_, 1);
+  ASSERT_EQ(gen_tag_t(events[2].tags_[0]).frame_id_, 2);
+  ASSERT_EQ(events[3].event_type_, EventType::kDecode);
+}
+
+TEST(TestCompletionBatch, FlushWhenFullOrExpired) {
+  moodycamel::ConcurrentQueue<EventData> queue;
+  moodycamel::ProducerToken ptok(queue);
+  CompletionBatch batch(&queue, &ptok, kNeverExpireTsc);
+
+  // Events of different frames are not coalesced
+  for (size_t i = 0; i < CompletionBatch::kMaxEvents - 1; i++) {
+    batch.Add(DemulCompletion(i, 0));
+  }
+  batch.FlushIfExpired();
+  ASSERT_EQ(queue.size_approx(), 0);
+  batch.Add(DemulCompletion(CompletionBatch::kMaxEvents, 0));
+  ASSERT_EQ(batch.NumEvents(), 0);
+  ASSERT_EQ(queue.size_approx(), CompletionBatch::kMaxEvents);
+
+  CompletionBatch expiring_batch(&queue, &ptok, 0);
+  expiring_batch.Add(DemulCompletion(0, 0));
+  expiring_batch.FlushIfExpired();
+  ASSERT_EQ(expiring_batch.NumEvents(), 0);
+  ASSERT_EQ(queue.size_approx(), CompletionBatch::kMaxEvents + 1);
+}
+
+static void WorkerSingle(moodycamel::ConcurrentQueue<EventData>* queue) {
+  moodycamel::ProducerToken ptok(*queue);
+  for (size_t i = 0; i < kTasksPerWorker; i++) {
+    TryEnqueueFallback(queue, &ptok,
+                       DemulCompletion(i / kTasksPerFrame, i % kTasksPerFrame));
+  }
+}
+
+static void WorkerBatched(moodycamel::ConcurrentQueue<EventData>* queue) {
+  moodycamel::ProducerToken ptok(*queue);
+  CompletionBatch batch(queue, &ptok, kNeverExpireTsc);
+  for (size_t i = 0; i < kTasksPerWorker; i++) {
+    batch.Add(DemulCompletion(i / kTasksPerFrame, i % kTasksPerFrame));
+  }
+  batch.Flush();
+}
+
+/// Return the throughput in million completions per second from the workers
+/// to a master that bulk-dequeues all events
+static double MeasureThroughput(
+    void (*worker_func)(moodycamel::ConcurrentQueue<EventData>*),
+    size_t& num_events) {
+  moodycamel::ConcurrentQueue<EventData> queue(kQueueSize);
+  const auto start = std::chrono::steady_clock::now();
+  std::thread workers[kNumWorkers];
+  for (auto& worker : workers) {
+    worker = std::thread(worker_func, &queue);
+  }
+
+  EventData events[CompletionBatch::kMaxEvents * kNumWorkers];
+  size_t num_tags = 0;
+  num_events = 0;
+  while (num_tags < kNumWorkers * kTasksPerWorker) {
+    size_t num_dequeued = queue.try_dequeue_bulk(
+        events, CompletionBatch::kMaxEvents * kNumWorkers);
+    num_events += num_dequeued;
+    for (size_t i = 0; i < num_dequeued; i++) {
+      num_tags += events[i].num_tags_;
+    }
+  }
+  const double elapsed_us = std::chrono::duration<double, std::micro>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(num_tags, kNumWorkers * kTasksPerWorker);
+  return num_tags / elapsed_us;
+}
+
+TEST(TestCompletionBatch, Throughput) {
+  size_t single_events = 0;
+  size_t batched_events = 0;
+  const double single_mops = MeasureThroughput(WorkerSingle, single_events);
+  const double batched_mops = MeasureThroughput(WorkerBatched, batched_events);
+
+  ASSERT_EQ(single_events, kNumWorkers * kTasksPerWorker);
+  ASSERT_LT(batched_events, single_events);
+  std::printf(
+      "Single enqueue: %.2f M completions/s in %zu events, batched enqueue: "
+      "%.2f M completions/s in %zu events\n",
+      single_mops, single_events, batched_mops, batched_events);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -61,10 +61,10 @@ void MasterToWorkerDynamicWorker(
     moodycamel::ConcurrentQueue<EventData>& event_queue,
     moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
     moodycamel::ProducerToken* ptok, Table<complex_float>& data_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
+    PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices,
     Table<complex_float>& ue_spec_pilot_buffer,
     Table<complex_float>& equal_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
+    PtrCube<kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
     PhyStats* phy_stats, Stats* stats) {
   PinToCoreWithOffset(ThreadType::kWorker, cfg->CoreOffset() + 1, worker_id);
 
@@ -121,35 +121,36 @@ TEST(TestDemul, VaryingConfig) {
     ptok = new moodycamel::ProducerToken(complete_task_queue);
   }
 
+  const size_t frame_wnd = cfg->FrameWnd();
   Table<complex_float> data_buffer;
   Table<complex_float> ue_spec_pilot_buffer;
   Table<complex_float> equal_buffer;
-  data_buffer.RandAllocCxFloat(cfg->Frame().NumULSyms() * kFrameWnd,
+  data_buffer.RandAllocCxFloat(cfg->Frame().NumULSyms() * frame_wnd,
                                kMaxAntennas * kMaxDataSCs,
                                Agora_memory::Alignment_t::kAlign64);
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices(kMaxAntennas *
-                                                                kMaxUEs);
-  equal_buffer.Calloc(cfg->Frame().NumULSyms() * kFrameWnd,
+  PtrGrid<kMaxDataSCs, complex_float> ul_zf_matrices(
+      frame_wnd, kMaxDataSCs, kMaxAntennas * kMaxUEs);
+  equal_buffer.Calloc(cfg->Frame().NumULSyms() * frame_wnd,
                       kMaxDataSCs * kMaxUEs,
                       Agora_memory::Alignment_t::kAlign64);
-  ue_spec_pilot_buffer.Calloc(kFrameWnd,
+  ue_spec_pilot_buffer.Calloc(frame_wnd,
                               cfg->Frame().ClientUlPilotSymbols() * kMaxUEs,
                               Agora_memory::Alignment_t::kAlign64);
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> demod_buffers(
-      kFrameWnd, cfg->Frame().NumTotalSyms(), cfg->UeNum(),
+  PtrCube<kMaxSymbols, kMaxUEs, int8_t> demod_buffers(
+      frame_wnd, cfg->Frame().NumTotalSyms(), cfg->UeNum(),
       kMaxModType * cfg->OfdmDataNum());
   std::printf(
       "Size of [data_buffer, ul_zf_matrices, equal_buffer, "
       "ue_spec_pilot_buffer, demod_soft_buffer]: [%.1f %.1f %.1f %.1f %.1f] "
       "MB\n",
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxAntennas * kMaxDataSCs * 4 *
+      cfg->Frame().NumULSyms() * frame_wnd * kMaxAntennas * kMaxDataSCs * 4 *
           1.0f / 1024 / 1024,
-      kMaxDataSCs * kFrameWnd * kMaxUEs * kMaxAntennas * 4 * 1.0f / 1024 / 1024,
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxDataSCs * kMaxUEs * 4 * 1.0f /
+      kMaxDataSCs * frame_wnd * kMaxUEs * kMaxAntennas * 4 * 1.0f / 1024 / 1024,
+      cfg->Frame().NumULSyms() * frame_wnd * kMaxDataSCs * kMaxUEs * 4 * 1.0f /
           1024 / 1024,
-      kFrameWnd * cfg->Frame().ClientUlPilotSymbols() * kMaxUEs * 4 * 1.0f /
+      frame_wnd * cfg->Frame().ClientUlPilotSymbols() * kMaxUEs * 4 * 1.0f /
           1024 / 1024,
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxModType * kMaxDataSCs *
+      cfg->Frame().NumULSyms() * frame_wnd * kMaxModType * kMaxDataSCs *
           kMaxUEs * 1.0f / 1024 / 1024);
 
   auto stats = std::make_unique<Stats>(cfg.get());
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <rte_errno.h>
+#include <rte_version.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "concurrentqueue.h"
+#include "dpdk_transport.h"
+#include "gettime.h"
+#include "memory_manage.h"
+
+// The null PMD hands out freshly allocated mbufs of a fixed size on every
+// RX burst, so it measures the host-side cost of receiving without a NIC
+static constexpr size_t kPacketLength = 4096;
+static constexpr size_t kFrameLength = kPayloadOffset + kPacketLength;
+static constexpr size_t kNumMbufs = 8191;
+static constexpr size_t kNumRxDesc = 512;
+static constexpr size_t kNumPackets = 1 << 20;
+// Packets handed to the worker but not yet released, like a frame window
+static constexpr size_t kNumSlots = 4096;
+
+static bool eal_ready = false;
+// Why the EAL or the null port is unavailable, if it is
+static std::string eal_error;
+static uint16_t null_port = 0;
+static rte_mempool* mbuf_pool = nullptr;
+
+/// Configure one RX and one TX queue on the null port and start it
+static void StartNullPort() {
+  rte_eth_conf port_conf;
+  std::memset(&port_conf, 0, sizeof(port_conf));
+  RtAssert(rte_eth_dev_configure(null_port, 1, 1, &port_conf) == 0,
+           "Failed to configure null port");
+  RtAssert(rte_eth_rx_queue_setup(null_port, 0, kNumRxDesc,
+                                  rte_eth_dev_socket_id(null_port), nullptr,
+                                  mbuf_pool) == 0,
+           "Failed to set up RX queue");
+  RtAssert(rte_eth_tx_queue_setup(null_port, 0, kNumRxDesc,
+                                  rte_eth_dev_socket_id(null_port),
+                                  nullptr) == 0,
+           "Failed to set up TX queue");
+  RtAssert(rte_eth_dev_start(null_port) == 0, "Failed to start null port");
+}
+
+/// Receive kNumPackets, copying each payload into a slot of [rx_buffer] and
+/// freeing its mbuf at once, as DpdkRecv did before zero-copy receive
+static size_t CopyRecv(uint8_t* rx_buffer,
+                       moodycamel::ConcurrentQueue<uint8_t*>& to_worker) {
+  rte_mbuf* rx_bufs[kRxBatchSize];
+  size_t num_rx = 0;
+  const size_t start_tsc = GetTime::Rdtsc();
+  while (num_rx < kNumPackets) {
+    const uint16_t nb_rx =
+        rte_eth_rx_burst(null_port, 0, rx_bufs, kRxBatchSize);
+    for (size_t i = 0; i < nb_rx; i++) {
+      uint8_t* slot = rx_buffer + (num_rx % kNumSlots) * kPacketLength;
+      DpdkTransport::FastMemcpy(
+          slot, rte_pktmbuf_mtod(rx_bufs[i], uint8_t*) + kPayloadOffset,
+          kPacketLength);
+      rte_pktmbuf_free(rx_bufs[i]);
+      to_worker.enqueue(slot);
+      num_rx++;
+    }
+  }
+  return GetTime::Rdtsc() - start_tsc;
+}
+
+/// Receive kNumPackets, handing the mbufs themselves to the worker and
+/// freeing the ones it released in bulk
+static size_t ZeroCopyRecv(DpdkMbufCollector& collector,
+                           moodycamel::ConcurrentQueue<rte_mbuf*>& to_worker,
+                           size_t& num_freed) {
+  rte_mbuf* rx_bufs[kRxBatchSize];
+  size_t num_rx = 0;
+  const size_t start_tsc = GetTime::Rdtsc();
+  while (num_rx < kNumPackets) {
+    num_freed += collector.FreeReleased();
+    // Bound the packets held by the worker, as the RX slots do in Agora
+    if (num_rx - num_freed + kRxBatchSize > kNumSlots) {
+      continue;
+    }
+    const uint16_t nb_rx =
+        rte_eth_rx_burst(null_port, 0, rx_bufs, kRxBatchSize);
+    to_worker.enqueue_bulk(rx_bufs, nb_rx);
+    num_rx += nb_rx;
+  }
+  return GetTime::Rdtsc() - start_tsc;
+}
+
+/// Compare copying received payloads with handing out the mbufs and freeing
+/// them in bulk. Every packet must reach the worker and every mbuf must get
+/// back to the pool; the time spent receiving is printed rather than checked.
+TEST(TestDpdkZeroCopy, CopyVsZeroCopy) {
+  if (eal_ready == false) {
+    GTEST_SKIP() << "DPDK EAL or the null PMD is unavailable: " << eal_error;
+  }
+  StartNullPort();
+  const size_t pool_size = rte_mempool_avail_count(mbuf_pool);
+
+  // Copy: the worker only sees the copied payloads
+  auto* rx_buffer = static_cast<uint8_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, kNumSlots * kPacketLength));
+  moodycamel::ConcurrentQueue<uint8_t*> slot_queue;
+  std::atomic<size_t> num_copied(0);
+  std::thread copy_worker([&]() {
+    uint8_t* slots[kRxBatchSize];
+    while (num_copied.load() < kNumPackets) {
+      num_copied += slot_queue.try_dequeue_bulk(slots, kRxBatchSize);
+    }
+  });
+  const size_t copy_tsc = CopyRecv(rx_buffer, slot_queue);
+  copy_worker.join();
+  EXPECT_EQ(num_copied.load(), kNumPackets);
+
+  // Zero-copy: the worker releases each mbuf to the collector
+  DpdkMbufCollector collector;
+  moodycamel::ConcurrentQueue<rte_mbuf*> mbuf_queue;
+  std::atomic<size_t> num_released(0);
+  std::thread zero_copy_worker([&]() {
+    rte_mbuf* mbufs[kRxBatchSize];
+    while (num_released.load() < kNumPackets) {
+      const size_t num = mbuf_queue.try_dequeue_bulk(mbufs, kRxBatchSize);
+      for (size_t i = 0; i < num; i++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(
+                      rte_pktmbuf_mtod(mbufs[i], uint8_t*) + kPayloadOffset) %
+                      64,
+                  0);
+        collector.Release(mbufs[i]);
+      }
+      num_released += num;
+    }
+  });
+  size_t num_freed = 0;
+  const size_t zero_copy_tsc = ZeroCopyRecv(collector, mbuf_queue, num_freed);
+  zero_copy_worker.join();
+  while (num_freed < kNumPackets) {
+    num_freed += collector.FreeReleased();
+  }
+  EXPECT_EQ(num_freed, kNumPackets);
+
+  rte_eth_dev_stop(null_port);
+  EXPECT_EQ(rte_mempool_avail_count(mbuf_pool), pool_size);
+
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  std::printf(
+      "%s, %zu-byte packets: copy %.0f ns/packet, zero-copy %.0f ns/packet "
+      "(%.2fx)\n",
+      rte_version(), kPacketLength,
+      GetTime::CyclesToNs(copy_tsc, freq_ghz) / kNumPackets,
+      GetTime::CyclesToNs(zero_copy_tsc, freq_ghz) / kNumPackets,
+      static_cast<double>(copy_tsc) / zero_copy_tsc);
+  std::free(rx_buffer);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+
+  const std::string vdev =
+      "--vdev=net_null0,size=" + std::to_string(kFrameLength);
+  // Without hugepages or shared runtime files, so that the test runs
+  // without root and alongside other DPDK processes
+  const char* rte_argv[] = {
+      "test_dpdk_zero_copy", "-l",          "0",  "--no-pci",
+      vdev.c_str(),          "--no-huge",   "-m", "512",
+      "--in-memory",         "--log-level", "0",  nullptr};
+  int rte_argc = static_cast<int>(sizeof(rte_argv) / sizeof(rte_argv[0])) - 1;
+  if (rte_eal_init(rte_argc, const_cast<char**>(rte_argv)) < 0) {
+    eal_error = std::string("rte_eal_init: ") + rte_strerror(rte_errno);
+  } else if (rte_eth_dev_get_port_by_name("net_null0", &null_port) != 0) {
+    eal_error = "no net_null0 port, is the null PMD built?";
+  } else {
+    mbuf_pool =
+        DpdkTransport::CreateMempool("TEST_POOL", kNumMbufs, kFrameLength);
+    eal_ready = true;
+  }
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "buffer.h"
+#include "concurrentqueue.h"
+
+static constexpr size_t kNumWorkers = 14;
+static constexpr size_t kNumTestFrames = 500;
+static constexpr size_t kNumSymbols = 12;
+static constexpr size_t kTasksPerSymbol = 25;
+static constexpr size_t kFrameWnd = kDefaultFrameWnd;
+// Number of frames the master keeps in flight, well within kFrameWnd
+static constexpr size_t kFramesInFlight = 4;
+static_assert(kFramesInFlight < kFrameWnd);
+
+// Each task request carries one tag, like a demodulation task
+static void WorkerLoop(moodycamel::ConcurrentQueue<EventData>* task_queue,
+                       moodycamel::ConcurrentQueue<EventData>* complete_queue,
+                       AtomicFrameCounters* task_counters,
+                       std::atomic<bool>* running) {
+  moodycamel::ProducerToken ptok(*complete_queue);
+  EventData req_event;
+  while (running->load() == true) {
+    if (task_queue->try_dequeue(req_event) == false) {
+      continue;
+    }
+    const size_t tag = req_event.tags_[0];
+    if ((task_counters != nullptr) &&
+        (task_counters->CompleteTask(gen_tag_t(tag).frame_id_,
+                                     gen_tag_t(tag).symbol_id_) == false)) {
+      continue;
+    }
+    complete_queue->enqueue(ptok, EventData(EventType::kDemul, tag));
+  }
+}
+
+static void ScheduleFrame(moodycamel::ConcurrentQueue<EventData>* task_queue,
+                          size_t frame_id) {
+  for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+    for (size_t sc_id = 0; sc_id < kTasksPerSymbol; sc_id++) {
+      task_queue->enqueue(EventData(
+          EventType::kDemul,
+          gen_tag_t::FrmSymSc(frame_id, symbol_id, sc_id).tag_));
+    }
+  }
+}
+
+/// Run kNumTestFrames frames through the workers and return the number of
+/// completion events handled by the master
+static size_t RunMaster(bool use_atomic_counters, double& elapsed_ms) {
+  moodycamel::ConcurrentQueue<EventData> task_queue;
+  moodycamel::ConcurrentQueue<EventData> complete_queue;
+  FrameCounters counters;
+  AtomicFrameCounters task_counters;
+  counters.Init(kFrameWnd, kNumSymbols, kTasksPerSymbol);
+  task_counters.Init(kFrameWnd, kNumSymbols, kTasksPerSymbol);
+  std::array<size_t, kNumSymbols> symbol_done_count;
+  symbol_done_count.fill(0);
+
+  std::atomic<bool> running(true);
+  std::thread workers[kNumWorkers];
+  for (auto& worker : workers) {
+    worker = std::thread(WorkerLoop, &task_queue, &complete_queue,
+                         use_atomic_counters ? &task_counters : nullptr,
+                         &running);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  size_t next_sched_frame = 0;
+  size_t frames_done = 0;
+  size_t num_events = 0;
+  EventData events_list[kNumWorkers * 8];
+  while (frames_done < kNumTestFrames) {
+    while ((next_sched_frame < kNumTestFrames) &&
+           (next_sched_frame < frames_done + kFramesInFlight)) {
+      ScheduleFrame(&task_queue, next_sched_frame);
+      next_sched_frame++;
+    }
+
+    size_t num_dequeued =
+        complete_queue.try_dequeue_bulk(events_list, kNumWorkers * 8);
+    num_events += num_dequeued;
+    for (size_t i = 0; i < num_dequeued; i++) {
+      const size_t frame_id = gen_tag_t(events_list[i].tags_[0]).frame_id_;
+      const size_t symbol_id = gen_tag_t(events_list[i].tags_[0]).symbol_id_;
+      bool last_task = use_atomic_counters ||
+                       counters.CompleteTask(frame_id, symbol_id);
+      if (last_task == true) {
+        symbol_done_count.at(symbol_id)++;
+        if (counters.CompleteSymbol(frame_id) == true) {
+          counters.Reset(frame_id);
+          frames_done++;
+        }
+      }
+    }
+  }
+  elapsed_ms = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  running = false;
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+    EXPECT_EQ(symbol_done_count.at(symbol_id), kNumTestFrames);
+  }
+  EXPECT_EQ(next_sched_frame, kNumTestFrames);
+  return num_events;
+}
+
+TEST(TestFrameCounters, AtomicSingleCompleter) {
+  static constexpr size_t kNumThreads = 8;
+  static constexpr size_t kTasksPerThread = 1000;
+  AtomicFrameCounters counters;
+  counters.Init(kFrameWnd, kNumSymbols, kNumThreads * kTasksPerThread);
+
+  std::atomic<size_t> num_last(0);
+  std::thread threads[kNumThreads];
+  for (auto& thread : threads) {
+    thread = std::thread([&counters, &num_last]() {
+      for (size_t i = 0; i < kTasksPerThread; i++) {
+        for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+          for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+            if (counters.CompleteTask(frame_id, symbol_id) == true) {
+              num_last++;
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Exactly one completer per symbol, and completed counters are reset
+  ASSERT_EQ(num_last.load(), kFrameWnd * kNumSymbols);
+  for (size_t frame_id = 0; frame_id < kFrameWnd; frame_id++) {
+    for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+      ASSERT_EQ(counters.GetTaskCount(frame_id, symbol_id), 0);
+    }
+  }
+}
+
+TEST(TestFrameCounters, CompareWithMasterCounting) {
+  double master_ms = 0;
+  double atomic_ms = 0;
+  const size_t master_events = RunMaster(false, master_ms);
+  const size_t atomic_events = RunMaster(true, atomic_ms);
+
+  ASSERT_EQ(master_events, kNumTestFrames * kNumSymbols * kTasksPerSymbol);
+  ASSERT_EQ(atomic_events, kNumTestFrames * kNumSymbols);
+  std::printf(
+      "Master counting: %zu events in %.2f ms, worker atomic counting: %zu "
+      "events in %.2f ms\n",
+      master_events, master_ms, atomic_events, atomic_ms);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "agora.h"
+#include "shm_transport.h"
+
+// Time between the frames that the test sends, longer than the deadline and
+// the stall of the workers together
+static constexpr size_t kFramePeriodMs = 150;
+// The number of packets missing from incomplete frames
+static constexpr size_t kNumMissingPackets = 3;
+// How long Agora may run past the last frame before the test stops it
+static constexpr size_t kTimeoutMs = 10000;
+// A small window, so that the slots of dropped frames are reused
+static constexpr size_t kFrameWnd = 4;
+
+enum class SlowFrame { kNone, kStalled, kIncomplete };
+
+// Frames that miss the deadline: the workers stall on some, and the others
+// miss packets
+static SlowFrame GetSlowFrame(size_t frame_id) {
+  if ((frame_id == 2) || (frame_id == 9)) {
+    return SlowFrame::kStalled;
+  } else if ((frame_id == 5) || (frame_id == 12)) {
+    return SlowFrame::kIncomplete;
+  }
+  return SlowFrame::kNone;
+}
+
+/// A worker of the Agora object that runs no tasks while [stalled] is set,
+/// as if it were stuck in a slow doer
+static void WorkerLoop(Agora* agora, int tid, std::atomic<bool>* stalled) {
+  auto context = agora->CreateWorkerContext(tid);
+  while (agora->GetConfig()->Running() == true) {
+    if (stalled->load() == true) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+    agora->WorkerPoll(*context);
+  }
+}
+
+/// Send the pilot and uplink packets of each frame through the shared
+/// memory rings, as the sender does, stalling the workers on slow frames
+static void SendFrames(Config* cfg, std::atomic<bool>* stalled) {
+  ShmTransport shm_transport(
+      cfg->ShmName(), false /* create */, cfg->NumRadios(),
+      cfg->ShmRingSlots(),
+      std::max(cfg->PacketLength(), cfg->DlPacketLength()));
+  std::vector<size_t> symbols;
+  for (size_t i = 0; i < cfg->Frame().NumPilotSyms(); i++) {
+    symbols.push_back(cfg->Frame().GetPilotSymbol(i));
+  }
+  for (size_t i = 0; i < cfg->Frame().NumULSyms(); i++) {
+    symbols.push_back(cfg->Frame().GetULSymbol(i));
+  }
+  const size_t num_packets = symbols.size() * cfg->BsAntNum();
+  const size_t num_samples =
+      (cfg->PacketLength() - Packet::kOffsetOfData) / sizeof(short);
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<short> sample_dist(-2048, 2047);
+
+  auto next_frame_time = std::chrono::steady_clock::now();
+  for (size_t frame_id = 0; frame_id < cfg->FramesToTest(); frame_id++) {
+    std::this_thread::sleep_until(next_frame_time);
+    next_frame_time += std::chrono::milliseconds(kFramePeriodMs);
+    const SlowFrame slow = GetSlowFrame(frame_id);
+    stalled->store(slow == SlowFrame::kStalled);
+
+    const size_t num_sent = (slow == SlowFrame::kIncomplete)
+                                ? num_packets - kNumMissingPackets
+                                : num_packets;
+    for (size_t i = 0; i < num_sent; i++) {
+      const size_t symbol_id = symbols.at(i / cfg->BsAntNum());
+      const size_t ant_id = i % cfg->BsAntNum();
+      ShmRing& ring = shm_transport.Uplink(ant_id / cfg->NumChannels());
+      uint8_t* slot = ring.Reserve();
+      while ((slot == nullptr) && (cfg->Running() == true)) {
+        std::this_thread::yield();
+        slot = ring.Reserve();
+      }
+      if (slot == nullptr) {
+        return;
+      }
+      auto* pkt =
+          new (slot) Packet(frame_id, symbol_id, 0 /* cell_id */, ant_id);
+      for (size_t j = 0; j < num_samples; j++) {
+        pkt->data_[j] = sample_dist(rng);
+      }
+      ring.Commit();
+    }
+
+    // Hold the workers until the master has dropped the frame
+    if (slow == SlowFrame::kStalled) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(2 * cfg->FrameDeadlineUs()));
+      stalled->store(false);
+    }
+  }
+}
+
+/// Agora drops the frames that miss their deadline, because the workers
+/// stall or packets are lost, and completes the others in order. The queued
+/// tasks and completions of a dropped frame are discarded, and its received
+/// packets are released: a packet left held would stop the TXRX thread once
+/// the RX buffers wrap around, and no later frame would complete. The
+/// notification to the MAC thread needs kEnableMac and is not covered.
+///
+/// The uplink data is read from the file that the data generator writes for
+/// tddconfig-correctness-test-erasure-ul.json.
+TEST(TestFrameDeadline, AgoraDropsLateFrames) {
+  auto cfg = std::make_unique<Config>("data/tddconfig-frame-deadline-ul.json");
+  cfg->GenData();
+  ASSERT_GT(cfg->FrameDeadlineUs(), 0);
+  ASSERT_EQ(cfg->FrameWnd(), kFrameWnd);
+  ASSERT_GT(cfg->FramesToTest(), kFrameWnd * 3);
+  ASSERT_EQ(GetSlowFrame(cfg->FramesToTest() - 1), SlowFrame::kNone);
+  // Incomplete frames keep packets in the FFT queue of their slot
+  ASSERT_NE(kNumMissingPackets % cfg->FftBlockSize(), 0);
+  auto agora = std::make_unique<Agora>(cfg.get(), false /* create_workers */);
+
+  std::atomic<bool> stalled(false);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < cfg->WorkerThreadNum(); i++) {
+    workers.emplace_back(WorkerLoop, agora.get(), i, &stalled);
+  }
+  std::thread sender(SendFrames, cfg.get(), &stalled);
+  std::atomic<bool> finished(false);
+  std::thread watchdog([&]() {
+    const auto timeout =
+        std::chrono::steady_clock::now() +
+        std::chrono::milliseconds((kFramePeriodMs * cfg->FramesToTest()) +
+                                  kTimeoutMs);
+    while ((finished.load() == false) &&
+           (std::chrono::steady_clock::now() < timeout)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    cfg->Running(false);
+  });
+
+  agora->Start();
+  finished = true;
+  watchdog.join();
+  sender.join();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  size_t num_slow = 0;
+  for (size_t frame_id = 0; frame_id < cfg->FramesToTest(); frame_id++) {
+    if (GetSlowFrame(frame_id) == SlowFrame::kNone) {
+      // Later frames in the slot of a dropped frame complete normally
+      EXPECT_NE(agora->GetFrameDoneTsc(frame_id), 0) << "frame " << frame_id;
+    } else {
+      EXPECT_EQ(agora->GetFrameDoneTsc(frame_id), 0) << "frame " << frame_id;
+      num_slow++;
+    }
+  }
+  EXPECT_EQ(agora->NumFramesDropped(FrameDropReason::kDeadline), num_slow);
+  EXPECT_EQ(agora->NumFramesDropped(FrameDropReason::kWindowFull), 0);
+  EXPECT_EQ(agora->NumFramesCompleted(), cfg->FramesToTest() - num_slow);
+}
+
+TEST(TestFrameDeadline, DroppedFramesGeneration) {
+  DroppedFrames dropped_frames;
+  dropped_frames.Init(kFrameWnd);
+  for (size_t frame_id = 0; frame_id < kFrameWnd * 4; frame_id++) {
+    ASSERT_FALSE(dropped_frames.IsDropped(frame_id));
+  }
+
+  dropped_frames.Drop(kFrameWnd + 1);
+  ASSERT_TRUE(dropped_frames.IsDropped(kFrameWnd + 1));
+  // Frames sharing the slot in other windows are not dropped
+  ASSERT_FALSE(dropped_frames.IsDropped(1));
+  ASSERT_FALSE(dropped_frames.IsDropped((kFrameWnd * 2) + 1));
+  ASSERT_FALSE(dropped_frames.IsDropped(kFrameWnd + 2));
+
+  dropped_frames.Drop((kFrameWnd * 2) + 1);
+  ASSERT_FALSE(dropped_frames.IsDropped(kFrameWnd + 1));
+  ASSERT_TRUE(dropped_frames.IsDropped((kFrameWnd * 2) + 1));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
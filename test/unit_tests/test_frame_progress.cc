@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "buffer.h"
+
+static constexpr size_t kFrameWnd = 4;
+static constexpr size_t kNumFrames = 20000;
+// Frames in processing at once, as with the two schedule queues in Agora
+static constexpr size_t kScheduleQueues = 2;
+
+TEST(TestFrameProgress, MarkPerSlot) {
+  FrameProgress progress;
+  progress.Init(kFrameWnd);
+  ASSERT_FALSE(progress.Done(0));
+  progress.MarkDone(5);
+  ASSERT_TRUE(progress.Done(5));
+  // Another frame in the same slot is not done
+  ASSERT_FALSE(progress.Done(1));
+  ASSERT_FALSE(progress.Done(9));
+  progress.MarkDone(9);
+  ASSERT_TRUE(progress.Done(9));
+  ASSERT_FALSE(progress.Done(5));
+}
+
+/// The uplink master computes ZF for each frame and completes a frame once
+/// the downlink master has transmitted it. The downlink master transmits a
+/// frame once it has seen its ZF. Frames must complete in order, and each
+/// side must see the data the other side wrote before marking a frame.
+TEST(TestFrameProgress, SplitMasterFrameOrder) {
+  FrameProgress zf_progress;
+  FrameProgress tx_progress;
+  zf_progress.Init(kFrameWnd);
+  tx_progress.Init(kFrameWnd);
+  // Written before a mark, checked after it
+  std::vector<size_t> zf_data(kFrameWnd, SIZE_MAX);
+  std::vector<size_t> tx_data(kFrameWnd, SIZE_MAX);
+
+  std::vector<size_t> completed_frames;
+  size_t zf_data_errors = 0;
+  size_t tx_data_errors = 0;
+
+  std::thread downlink_master([&]() {
+    size_t zf_last_frame = SIZE_MAX;
+    size_t proc_frame_id = 0;
+    while (proc_frame_id < kNumFrames) {
+      while (zf_progress.Done(zf_last_frame + 1) == true) {
+        zf_last_frame++;
+        if (zf_data.at(zf_last_frame % kFrameWnd) != zf_last_frame) {
+          zf_data_errors++;
+        }
+      }
+      if ((zf_last_frame != SIZE_MAX) && (proc_frame_id <= zf_last_frame)) {
+        tx_data.at(proc_frame_id % kFrameWnd) = proc_frame_id;
+        tx_progress.MarkDone(proc_frame_id);
+        proc_frame_id++;
+      } else {
+        // Let the other master run on machines with few cores
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  size_t cur_sche_frame_id = 0;
+  size_t cur_proc_frame_id = 0;
+  while (cur_proc_frame_id < kNumFrames) {
+    if ((cur_sche_frame_id < cur_proc_frame_id + kScheduleQueues) &&
+        (cur_sche_frame_id < kNumFrames)) {
+      zf_data.at(cur_sche_frame_id % kFrameWnd) = cur_sche_frame_id;
+      zf_progress.MarkDone(cur_sche_frame_id);
+      cur_sche_frame_id++;
+    }
+    if (tx_progress.Done(cur_proc_frame_id) == true) {
+      if (tx_data.at(cur_proc_frame_id % kFrameWnd) != cur_proc_frame_id) {
+        tx_data_errors++;
+      }
+      completed_frames.push_back(cur_proc_frame_id);
+      cur_proc_frame_id++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  downlink_master.join();
+
+  ASSERT_EQ(zf_data_errors, 0);
+  ASSERT_EQ(tx_data_errors, 0);
+  ASSERT_EQ(completed_frames.size(), kNumFrames);
+  for (size_t i = 0; i < kNumFrames; i++) {
+    ASSERT_EQ(completed_frames.at(i), i);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "buffer.h"
+#include "memory_manage.h"
+
+static constexpr size_t kFrameWnds[] = {4, 8, 16, 32, 64};
+static constexpr size_t kNumSymbols = 6;
+static constexpr size_t kTasksPerSymbol = 3;
+static constexpr size_t kNEntries = 16;
+
+/// Frames that are one window apart share a slot, frames within the window
+/// do not
+TEST(TestFrameWindow, FrameCountersWrap) {
+  for (size_t frame_wnd : kFrameWnds) {
+    FrameCounters counters;
+    counters.Init(frame_wnd, kNumSymbols, kTasksPerSymbol);
+
+    for (size_t frame_id = 0; frame_id < frame_wnd; frame_id++) {
+      for (size_t i = 0; i <= frame_id % kTasksPerSymbol; i++) {
+        counters.CompleteTask(frame_id, 0);
+      }
+      counters.CompleteSymbol(frame_id);
+    }
+    for (size_t frame_id = 0; frame_id < frame_wnd; frame_id++) {
+      const size_t next_wnd_frame = frame_id + frame_wnd;
+      ASSERT_EQ(counters.GetTaskCount(next_wnd_frame, 0),
+                (frame_id % kTasksPerSymbol) + 1);
+      ASSERT_EQ(counters.GetSymbolCount(next_wnd_frame), 1);
+    }
+
+    // Completing a whole frame one window later lands in the same slot
+    const size_t frame_id = (frame_wnd * 3) + 1;
+    counters.Reset(frame_id);
+    for (size_t symbol_id = 0; symbol_id < kNumSymbols; symbol_id++) {
+      for (size_t i = 0; i < kTasksPerSymbol; i++) {
+        ASSERT_EQ(counters.CompleteTask(frame_id, symbol_id),
+                  i == kTasksPerSymbol - 1);
+      }
+      ASSERT_EQ(counters.CompleteSymbol(frame_id),
+                symbol_id == kNumSymbols - 1);
+    }
+    ASSERT_EQ(counters.GetSymbolCount(1), kNumSymbols);
+    ASSERT_EQ(counters.GetSymbolCount(2), 1);
+  }
+}
+
+TEST(TestFrameWindow, AtomicFrameCountersWrap) {
+  for (size_t frame_wnd : kFrameWnds) {
+    AtomicFrameCounters counters;
+    counters.Init(frame_wnd, kNumSymbols, kTasksPerSymbol);
+
+    for (size_t frame_id = 0; frame_id < frame_wnd * 4; frame_id++) {
+      const size_t symbol_id = frame_id % kNumSymbols;
+      for (size_t i = 0; i < kTasksPerSymbol - 1; i++) {
+        ASSERT_FALSE(counters.CompleteTask(frame_id, symbol_id));
+      }
+      // The slot is still in use by frame_id, so the frame one window later
+      // sees its count
+      ASSERT_EQ(counters.GetTaskCount(frame_id + frame_wnd, symbol_id),
+                kTasksPerSymbol - 1);
+      ASSERT_TRUE(counters.CompleteTask(frame_id, symbol_id));
+      ASSERT_EQ(counters.GetTaskCount(frame_id + frame_wnd, symbol_id), 0);
+    }
+  }
+}
+
+TEST(TestFrameWindow, RxCountersSize) {
+  for (size_t frame_wnd : kFrameWnds) {
+    RxCounters counters;
+    counters.Init(frame_wnd);
+    ASSERT_EQ(counters.num_pkts_.size(), frame_wnd);
+    ASSERT_EQ(counters.num_pilot_pkts_.size(), frame_wnd);
+    ASSERT_EQ(counters.num_reciprocity_pkts_.size(), frame_wnd);
+    for (size_t frame_slot = 0; frame_slot < frame_wnd; frame_slot++) {
+      ASSERT_EQ(counters.num_pkts_.at(frame_slot), 0);
+    }
+  }
+}
+
+TEST(TestFrameWindow, PtrGridAndCubeRows) {
+  static constexpr size_t kCols = 8;
+  static constexpr size_t kDim3 = 4;
+  for (size_t frame_wnd : kFrameWnds) {
+    PtrGrid<kCols, float> ptr_grid(frame_wnd, kCols, kNEntries);
+    ASSERT_EQ(ptr_grid.Rows(), frame_wnd);
+    PtrCube<kCols, kDim3, float> ptr_cube(frame_wnd, kCols, kDim3, kNEntries);
+    ASSERT_EQ(ptr_cube.Dim1(), frame_wnd);
+
+    // Every cell of the last slot is backed by its own zeroed array
+    for (size_t j = 0; j < kCols; j++) {
+      ASSERT_NE(ptr_grid[frame_wnd - 1][j], nullptr);
+      ASSERT_EQ(ptr_grid[frame_wnd - 1][j][kNEntries - 1], 0.0f);
+      for (size_t k = 0; k < kDim3; k++) {
+        ASSERT_NE(ptr_cube[frame_wnd - 1][j][k], nullptr);
+        ASSERT_EQ(ptr_cube[frame_wnd - 1][j][k][kNEntries - 1], 0.0f);
+      }
+    }
+    ASSERT_EQ(ptr_grid[frame_wnd - 1][kCols - 1] + kNEntries,
+              ptr_grid[0][0] + (frame_wnd * kCols * kNEntries));
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
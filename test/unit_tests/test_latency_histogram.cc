@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "latency_histogram.h"
+
+// The largest relative error of a value in a linear bucket
+static constexpr double kMaxRelativeError =
+    1.0 / (LatencyHistogram::kSubBuckets / 2);
+
+/// The exact value at [percentile] of [sorted], ranked as LatencyHistogram
+/// ranks its values
+static uint64_t ExactPercentile(const std::vector<uint64_t>& sorted,
+                                double percentile) {
+  const auto rank = std::max(
+      size_t{1}, static_cast<size_t>(std::ceil(percentile / 100.0 *
+                                               static_cast<double>(
+                                                   sorted.size()))));
+  return sorted.at(rank - 1);
+}
+
+/// Every value falls into a bucket whose range contains it, and the buckets
+/// are contiguous and not wider than the relative error allows
+TEST(TestLatencyHistogram, Buckets) {
+  for (size_t bucket = 0; bucket + 1 < LatencyHistogram::kNumBuckets;
+       bucket++) {
+    const uint64_t max = LatencyHistogram::BucketMax(bucket);
+    ASSERT_EQ(LatencyHistogram::BucketOf(max), bucket);
+    ASSERT_EQ(LatencyHistogram::BucketOf(max + 1), bucket + 1);
+    if (bucket > 0) {
+      const uint64_t min = LatencyHistogram::BucketMax(bucket - 1) + 1;
+      ASSERT_LE(static_cast<double>(max - min),
+                kMaxRelativeError * static_cast<double>(min));
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::BucketOf(UINT64_MAX),
+            LatencyHistogram::kNumBuckets - 1);
+}
+
+/// Percentiles of heavy-tailed samples are within the relative error of the
+/// exact percentiles, and the maximum is exact
+TEST(TestLatencyHistogram, Accuracy) {
+  std::mt19937_64 rng(7);
+  // Task durations of around 10k cycles with a long tail
+  std::lognormal_distribution<double> dist(std::log(10000.0), 1.0);
+  std::vector<uint64_t> samples(1000000);
+  LatencyHistogram histogram;
+  for (uint64_t& sample : samples) {
+    sample = static_cast<uint64_t>(dist(rng));
+    histogram.Record(sample);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  EXPECT_EQ(histogram.Count(), samples.size());
+  EXPECT_EQ(histogram.Max(), samples.back());
+  for (double percentile : {0.0, 1.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0}) {
+    const auto exact =
+        static_cast<double>(ExactPercentile(samples, percentile));
+    const auto value = static_cast<double>(histogram.Percentile(percentile));
+    EXPECT_GE(value, exact) << "p" << percentile;
+    EXPECT_LE(value, exact * (1 + kMaxRelativeError)) << "p" << percentile;
+  }
+}
+
+/// Small values are exact, and values beyond the tracked range are counted
+TEST(TestLatencyHistogram, SmallAndLargeValues) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Percentile(50), 0);
+  for (uint64_t i = 1; i <= 100; i++) {
+    histogram.Record(i);
+  }
+  EXPECT_EQ(histogram.Percentile(50), 50);
+  EXPECT_EQ(histogram.Percentile(99), 99);
+
+  const uint64_t huge = uint64_t{1} << 50;
+  histogram.Record(huge);
+  EXPECT_EQ(histogram.Max(), huge);
+  EXPECT_EQ(histogram.Percentile(100), huge);
+}
+
+/// Merging the histograms of several writers matches one histogram of all
+/// their values
+TEST(TestLatencyHistogram, Merge) {
+  std::mt19937_64 rng(11);
+  std::exponential_distribution<double> dist(1.0 / 50000);
+  LatencyHistogram all;
+  LatencyHistogram merged;
+  std::vector<LatencyHistogram> threads(4);
+  for (size_t i = 0; i < 100000; i++) {
+    const auto value = static_cast<uint64_t>(dist(rng));
+    all.Record(value);
+    threads.at(i % threads.size()).Record(value);
+  }
+  for (const LatencyHistogram& histogram : threads) {
+    merged.Merge(histogram);
+  }
+  EXPECT_EQ(merged.Count(), all.Count());
+  EXPECT_EQ(merged.Max(), all.Max());
+  for (double percentile : {50.0, 99.0, 99.9}) {
+    EXPECT_EQ(merged.Percentile(percentile), all.Percentile(percentile));
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "metrics.h"
+
+static const std::string kSocketPath = "/tmp/agora_test_metrics.sock";
+
+/// Connect to the exporter, optionally send [request], and return all the
+/// bytes the exporter sends back
+static std::string Scrape(const std::string& request) {
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  EXPECT_GE(fd, 0);
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, kSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+  EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  if (request.empty() == false) {
+    EXPECT_EQ(send(fd, request.data(), request.size(), 0),
+              static_cast<ssize_t>(request.size()));
+  }
+
+  std::string response;
+  char buf[4096];
+  ssize_t len;
+  while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    response.append(buf, len);
+  }
+  close(fd);
+  return response;
+}
+
+TEST(TestMetrics, Render) {
+  Metrics metrics;
+  MetricValue* done = metrics.AddCounter("frames_total", "Frames");
+  MetricValue* ue0 = metrics.AddGauge("snr_db", "SNR", "ue=\"0\"");
+  metrics.AddCounter("drops_total", "Drops", "reason=\"a\"");
+  MetricValue* ue1 = metrics.AddGauge("snr_db", "SNR", "ue=\"1\"");
+  metrics.AddSampledGauge("depth", "Depth", "", []() { return 7.0; });
+  done->Add(3);
+  done->Add(2);
+  ue0->Set(12.5);
+  ue1->Set(-1);
+
+  // The samples of a name are rendered together, after its HELP and TYPE
+  EXPECT_EQ(metrics.Render(),
+            "# HELP frames_total Frames\n"
+            "# TYPE frames_total counter\n"
+            "frames_total 5\n"
+            "# HELP snr_db SNR\n"
+            "# TYPE snr_db gauge\n"
+            "snr_db{ue=\"0\"} 12.5\n"
+            "snr_db{ue=\"1\"} -1\n"
+            "# HELP drops_total Drops\n"
+            "# TYPE drops_total counter\n"
+            "drops_total{reason=\"a\"} 0\n"
+            "# HELP depth Depth\n"
+            "# TYPE depth gauge\n"
+            "depth 7\n");
+}
+
+/// Scrapes while a writer updates its counter see monotonically increasing
+/// values, in plain text and over HTTP
+TEST(TestMetrics, ScrapeWhileUpdating) {
+  Metrics metrics;
+  MetricValue* counter = metrics.AddCounter("updates_total", "Updates");
+  MetricsExporter exporter(kSocketPath, &metrics);
+
+  std::atomic<bool> running(true);
+  std::thread writer([&]() {
+    while (running == true) {
+      counter->Add(1);
+      std::this_thread::yield();
+    }
+  });
+
+  double last_value = -1;
+  for (size_t i = 0; i < 10; i++) {
+    const bool http = (i % 2 == 1);
+    const std::string response =
+        Scrape(http ? "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n" : "");
+    if (http == true) {
+      ASSERT_EQ(response.rfind("HTTP/1.0 200 OK\r\n", 0), 0) << response;
+      ASSERT_NE(response.find("text/plain; version=0.0.4"), std::string::npos);
+    } else {
+      ASSERT_EQ(response.rfind("# HELP updates_total Updates\n", 0), 0)
+          << response;
+    }
+    const std::string sample = "\nupdates_total ";
+    const size_t pos = response.find(sample);
+    ASSERT_NE(pos, std::string::npos) << response;
+    const double value = std::stod(response.substr(pos + sample.size()));
+    EXPECT_GE(value, last_value);
+    last_value = value;
+  }
+  running = false;
+  writer.join();
+  EXPECT_GT(counter->Get(), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
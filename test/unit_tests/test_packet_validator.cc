@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "buffer.h"
+#include "packet_validator.h"
+
+static constexpr size_t kFrameWnd = 4;
+static constexpr size_t kNumCells = 2;
+static constexpr size_t kAntPerCell = 8;
+static constexpr size_t kNumSymbols = 10;
+// Symbols 0 -- 5 are received, the rest are downlink
+static constexpr size_t kNumRxSymbols = 6;
+static constexpr size_t kPacketLength = Packet::kOffsetOfData + 256;
+static constexpr size_t kNumFuzzIterations = 200000;
+
+static std::vector<bool> RxSymbols() {
+  std::vector<bool> is_rx_symbol(kNumSymbols, false);
+  for (size_t i = 0; i < kNumRxSymbols; i++) {
+    is_rx_symbol.at(i) = true;
+  }
+  return is_rx_symbol;
+}
+
+/// Whether the header of [pkt] is within the configured ranges
+static bool InRange(const Packet* pkt) {
+  return (pkt->magic_ == Packet::kMagic) && (pkt->symbol_id_ < kNumRxSymbols) &&
+         (pkt->cell_id_ < kNumCells) && (pkt->ant_id_ < kAntPerCell) &&
+         (pkt->frame_id_ != UINT32_MAX);
+}
+
+/// Mutated and random headers never get past the validator out of range,
+/// and the validator never reads outside its tracking state
+TEST(TestPacketValidator, FuzzHeaders) {
+  PacketValidator validator;
+  validator.Init(kFrameWnd, kNumCells, kAntPerCell, RxSymbols(),
+                 kPacketLength, true /* check_checksum */);
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<uint32_t> word_dist;
+  std::uniform_int_distribution<size_t> field_dist(0, 7);
+  std::uniform_int_distribution<uint32_t> small_dist(0, 12);
+  std::vector<uint8_t> buf(kPacketLength);
+  auto* pkt = reinterpret_cast<Packet*>(buf.data());
+
+  size_t num_accepted = 0;
+  for (size_t i = 0; i < kNumFuzzIterations; i++) {
+    // Mostly plausible headers, with one field corrupted
+    new (pkt) Packet(i / 64, small_dist(rng) % kNumRxSymbols,
+                     small_dist(rng) % kNumCells,
+                     small_dist(rng) % kAntPerCell);
+    auto* words = reinterpret_cast<uint32_t*>(buf.data());
+    switch (field_dist(rng)) {
+      case 0:
+        words[word_dist(rng) % 4] = small_dist(rng);
+        break;
+      case 1:
+        words[word_dist(rng) % 4] = word_dist(rng);
+        break;
+      case 2:
+        pkt->magic_ = word_dist(rng);
+        break;
+      case 3:
+        buf.at(Packet::kOffsetOfData + (word_dist(rng) % 256)) ^= 1;
+        break;
+      case 4:
+        for (uint8_t& byte : buf) {
+          byte = static_cast<uint8_t>(word_dist(rng));
+        }
+        break;
+      default:
+        break;
+    }
+    const bool corrupt_data = (field_dist(rng) == 0);
+    PacketValidator::StampChecksum(pkt, kPacketLength);
+    if (corrupt_data == true) {
+      buf.back() ^= 0x80;
+    }
+
+    if (validator.Check(pkt) == true) {
+      ASSERT_TRUE(InRange(pkt)) << pkt->ToString();
+      ASSERT_FALSE(corrupt_data);
+      num_accepted++;
+    }
+  }
+
+  size_t num_dropped = 0;
+  for (size_t i = 0; i < kNumRxDropReasons; i++) {
+    num_dropped += validator.NumDrops(static_cast<RxDropReason>(i));
+  }
+  EXPECT_EQ(num_accepted + num_dropped, kNumFuzzIterations);
+  EXPECT_GT(num_accepted, 0);
+  EXPECT_GT(validator.NumDrops(RxDropReason::kBadMagic), 0);
+  EXPECT_GT(validator.NumDrops(RxDropReason::kOutOfRange), 0);
+  EXPECT_GT(validator.NumDrops(RxDropReason::kBadChecksum), 0);
+}
+
+/// Every packet of a stream with injected duplicates is accepted exactly
+/// once, and packets of frames older than the window are dropped as stale
+TEST(TestPacketValidator, DuplicateInjection) {
+  std::vector<size_t> drops(kNumRxDropReasons, 0);
+  PacketValidator validator;
+  validator.Init(kFrameWnd, kNumCells, kAntPerCell, RxSymbols(),
+                 kPacketLength, false /* check_checksum */, drops.data());
+  std::mt19937 rng(5);
+  std::bernoulli_distribution dup_dist(0.1);
+  std::vector<uint8_t> buf(kPacketLength, 0);
+  auto* pkt = reinterpret_cast<Packet*>(buf.data());
+
+  static constexpr size_t kNumFrames = 50;
+  size_t num_accepted = 0;
+  size_t num_duplicates = 0;
+  for (size_t frame_id = 0; frame_id < kNumFrames; frame_id++) {
+    for (size_t symbol_id = 0; symbol_id < kNumRxSymbols; symbol_id++) {
+      for (size_t ant = 0; ant < kNumCells * kAntPerCell; ant++) {
+        new (pkt)
+            Packet(frame_id, symbol_id, ant / kAntPerCell, ant % kAntPerCell);
+        ASSERT_TRUE(validator.Check(pkt));
+        num_accepted++;
+        if (dup_dist(rng) == true) {
+          ASSERT_FALSE(validator.Check(pkt));
+          num_duplicates++;
+        }
+      }
+    }
+    // A late duplicate of the previous frame, still within the window
+    if (frame_id > 0) {
+      new (pkt) Packet(frame_id - 1, 0, 0, 0);
+      EXPECT_FALSE(validator.Check(pkt));
+      num_duplicates++;
+    }
+  }
+  EXPECT_EQ(num_accepted, kNumFrames * kNumRxSymbols * kNumCells * kAntPerCell);
+  EXPECT_EQ(drops.at(static_cast<size_t>(RxDropReason::kDuplicate)),
+            num_duplicates);
+
+  // The slot of this frame now tracks a frame kFrameWnd later
+  new (pkt) Packet(kNumFrames - 1 - kFrameWnd, 1, 1, 1);
+  EXPECT_FALSE(validator.Check(pkt));
+  EXPECT_EQ(drops.at(static_cast<size_t>(RxDropReason::kStale)), 1);
+
+  // Downlink symbols are never received
+  new (pkt) Packet(kNumFrames, kNumRxSymbols, 0, 0);
+  EXPECT_FALSE(validator.Check(pkt));
+  EXPECT_EQ(drops.at(static_cast<size_t>(RxDropReason::kOutOfRange)), 1);
+}
+
+/// Copies of a validator, e.g., when a vector of validators grows, count
+/// drops in their own counters
+TEST(TestPacketValidator, CopyKeepsOwnCounters) {
+  std::vector<PacketValidator> validators(1);
+  validators.at(0).Init(kFrameWnd, kNumCells, kAntPerCell, RxSymbols(),
+                        kPacketLength, false /* check_checksum */);
+  validators.at(0).CountDrop(RxDropReason::kBadLength);
+  validators.resize(64);
+  validators.at(0).CountDrop(RxDropReason::kBadLength);
+  EXPECT_EQ(validators.at(0).NumDrops(RxDropReason::kBadLength), 2);
+
+  PacketValidator copy = validators.at(0);
+  copy.CountDrop(RxDropReason::kBadLength);
+  EXPECT_EQ(copy.NumDrops(RxDropReason::kBadLength), 3);
+  EXPECT_EQ(validators.at(0).NumDrops(RxDropReason::kBadLength), 2);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
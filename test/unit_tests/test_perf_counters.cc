@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "perf_counters.h"
+#include "stats.h"
+
+static constexpr size_t kNumTasks = 100;
+
+/// Busy work of about a few hundred microseconds that touches memory
+static uint64_t Work(std::vector<uint64_t>& buffer) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer.at(i) = (buffer.at(i) * 31) + i;
+    sum += buffer.at(i);
+  }
+  return sum;
+}
+
+static bool Counted(const PerfCounters& counters,
+                    PerfCounters::Event event) {
+  return (counters.CountedMask() & (1u << static_cast<size_t>(event))) != 0;
+}
+
+/// The counters of the thread grow with its work. Without hardware counters,
+/// e.g., in a VM or with kernel.perf_event_paranoid > 2, software counters
+/// are used.
+TEST(TestPerfCounters, CountsWork) {
+  PerfCounters counters;
+  if (counters.IsOpen() == false) {
+    GTEST_SKIP() << "perf_event_open() is not permitted";
+  }
+  std::printf("Counting %s events\n",
+              Counted(counters, PerfCounters::Event::kCycles) ? "hardware"
+                                                              : "software");
+  std::vector<uint64_t> buffer(1 << 16, 1);
+  PerfCounters::Values before{};
+  counters.Read(before);
+  uint64_t sum = 0;
+  for (size_t i = 0; i < kNumTasks; i++) {
+    sum += Work(buffer);
+  }
+  PerfCounters::Values after{};
+  counters.Read(after);
+  EXPECT_NE(sum, 0);
+
+  for (auto event : {PerfCounters::Event::kCycles,
+                     PerfCounters::Event::kInstructions,
+                     PerfCounters::Event::kTaskClockNs}) {
+    if (Counted(counters, event) == true) {
+      const auto i = static_cast<size_t>(event);
+      EXPECT_GT(after.at(i), before.at(i)) << PerfCounters::kEventNames.at(i);
+    }
+  }
+  for (size_t i = 0; i < PerfCounters::kNumEvents; i++) {
+    EXPECT_GE(after.at(i), before.at(i)) << PerfCounters::kEventNames.at(i);
+  }
+}
+
+/// PerfStat accumulates the events of each task, and the counters of
+/// another thread do not count this thread's work
+TEST(TestPerfCounters, PerfStatPerThread) {
+  PerfCounters counters;
+  if (counters.IsOpen() == false) {
+    GTEST_SKIP() << "perf_event_open() is not permitted";
+  }
+  const auto busy_event = Counted(counters, PerfCounters::Event::kCycles)
+                              ? PerfCounters::Event::kCycles
+                              : PerfCounters::Event::kTaskClockNs;
+  const auto busy_index = static_cast<size_t>(busy_event);
+
+  std::vector<uint64_t> buffer(1 << 16, 1);
+  PerfStat busy_stat;
+  for (size_t i = 0; i < kNumTasks; i++) {
+    PerfCounters::Values start{};
+    counters.Read(start);
+    Work(buffer);
+    busy_stat.Add(counters, start);
+  }
+  EXPECT_EQ(busy_stat.task_count_, kNumTasks);
+  EXPECT_GT(busy_stat.counts_.at(busy_index), 0);
+
+  // A thread that sleeps while this one works counts far fewer events
+  PerfStat idle_stat;
+  std::thread idle_thread([&]() {
+    PerfCounters idle_counters;
+    ASSERT_TRUE(idle_counters.IsOpen());
+    PerfCounters::Values start{};
+    idle_counters.Read(start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    idle_stat.Add(idle_counters, start);
+  });
+  for (size_t i = 0; i < kNumTasks; i++) {
+    Work(buffer);
+  }
+  idle_thread.join();
+  EXPECT_LT(idle_stat.counts_.at(busy_index),
+            busy_stat.counts_.at(busy_index));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
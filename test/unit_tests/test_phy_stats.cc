@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+// For some reason, gtest include order matters
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "gettime.h"
+#include "memory_manage.h"
+#include "phy_stats.h"
+
+static constexpr size_t kNumWorkers = 8;
+static constexpr size_t kBitsPerUpdate = 64;
+static constexpr size_t kNumBenchUpdates = 10000000;
+
+/// Workers update the counters of every UE and symbol of each frame, like
+/// the decoders of several code blocks, while the master reduces each frame
+/// as soon as all workers are done with it
+TEST(TestPhyStats, ConcurrentUpdates) {
+  auto cfg = std::make_unique<Config>("data/tddconfig-sim-ul.json");
+  cfg->GenData();
+  ASSERT_GE(cfg->WorkerThreadNum(), kNumWorkers);
+  const size_t num_frames = cfg->FrameWnd();
+  const size_t num_ul_syms = cfg->Frame().NumULSyms();
+  auto phy_stats = std::make_unique<PhyStats>(cfg.get());
+
+  std::vector<std::atomic<size_t>> workers_done(num_frames);
+  for (auto& count : workers_done) {
+    count = 0;
+  }
+  std::vector<std::thread> workers;
+  for (size_t tid = 0; tid < kNumWorkers; tid++) {
+    workers.emplace_back([&, tid]() {
+      for (size_t frame_id = 0; frame_id < num_frames; frame_id++) {
+        for (size_t ue_id = 0; ue_id < cfg->UeNum(); ue_id++) {
+          for (size_t i = 0; i < num_ul_syms; i++) {
+            const size_t offset = cfg->GetTotalDataSymbolIdxUl(frame_id, i);
+            phy_stats->UpdateDecodedBits(tid, ue_id, offset, kBitsPerUpdate);
+            phy_stats->IncrementDecodedBlocks(tid, ue_id, offset);
+            // UE 0 has no errors, the others one bit error per update
+            phy_stats->UpdateBitErrors(tid, ue_id, offset, 0,
+                                       static_cast<uint8_t>(ue_id > 0));
+            // Worker 0 has a block error in every update
+            phy_stats->UpdateBlockErrors(tid, ue_id, offset,
+                                         static_cast<size_t>(tid == 0));
+          }
+        }
+        workers_done.at(frame_id)++;
+      }
+    });
+  }
+  for (size_t frame_id = 0; frame_id < num_frames; frame_id++) {
+    while (workers_done.at(frame_id) < kNumWorkers) {
+      std::this_thread::yield();
+    }
+    phy_stats->ReduceFrame(frame_id);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const size_t updates_per_ue = kNumWorkers * num_frames * num_ul_syms;
+  for (size_t ue_id = 0; ue_id < cfg->UeNum(); ue_id++) {
+    EXPECT_EQ(phy_stats->GetDecodedBits(ue_id),
+              updates_per_ue * kBitsPerUpdate);
+    EXPECT_EQ(phy_stats->GetBitErrors(ue_id),
+              (ue_id > 0) ? updates_per_ue : 0);
+    EXPECT_FLOAT_EQ(phy_stats->GetBlockErrorRate(ue_id),
+                    1.0f / static_cast<float>(kNumWorkers));
+  }
+}
+
+/// Compare counters of several workers in one shared table with the sharded
+/// layout of PhyStats, where each worker writes its own allocation
+TEST(TestPhyStats, FalseSharing) {
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  Table<size_t> shared;
+  shared.Calloc(1, kNumWorkers, Agora_memory::Alignment_t::kAlign64);
+  std::vector<Table<size_t>> shards(kNumWorkers);
+  for (auto& shard : shards) {
+    shard.Calloc(1, 1, Agora_memory::Alignment_t::kAlign64);
+  }
+
+  for (const bool sharded : {false, true}) {
+    const size_t start_tsc = GetTime::Rdtsc();
+    std::vector<std::thread> workers;
+    for (size_t tid = 0; tid < kNumWorkers; tid++) {
+      workers.emplace_back([&, tid]() {
+        size_t* counter = sharded ? &shards.at(tid)[0][0] : &shared[0][tid];
+        for (size_t i = 0; i < kNumBenchUpdates; i++) {
+          *reinterpret_cast<volatile size_t*>(counter) += 1;
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    std::printf("%s counters: %.1f ms for %zu updates by %zu workers\n",
+                sharded ? "Sharded" : "Shared",
+                GetTime::CyclesToMs(GetTime::Rdtsc() - start_tsc, freq_ghz),
+                kNumBenchUpdates, kNumWorkers);
+  }
+
+  for (size_t tid = 0; tid < kNumWorkers; tid++) {
+    EXPECT_EQ(shared[0][tid], kNumBenchUpdates);
+    EXPECT_EQ(shards.at(tid)[0][0], kNumBenchUpdates);
+  }
+  shared.Free();
+  for (auto& shard : shards) {
+    shard.Free();
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
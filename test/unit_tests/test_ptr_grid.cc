@@ -8,7 +8,8 @@ static constexpr size_t kCol2s = 64;
 const size_t kNEntries = 64;
 
 TEST(TestPtrGrid, Basic) {
-  PtrGrid<kRows, kCols, float> ptr_grid(kNEntries);
+  PtrGrid<kCols, float> ptr_grid(kRows, kCols, kNEntries);
+  ASSERT_EQ(ptr_grid.Rows(), kRows);
 
   // Test basic accesses and zero-initialization
   float sum = 0;
@@ -26,7 +27,8 @@ TEST(TestPtrGrid, Basic) {
 }
 
 TEST(TestPtrCube, Basic) {
-  PtrCube<kRows, kCols, kCol2s, float> ptr_cube(kNEntries);
+  PtrCube<kCols, kCol2s, float> ptr_cube(kRows, kCols, kCol2s, kNEntries);
+  ASSERT_EQ(ptr_cube.Dim1(), kRows);
 
   // Test basic accesses and zero-initialization
   float sum = 0;
@@ -18,11 +18,12 @@ TEST(TestRecip, Correctness) {
   Table<complex_float> calib_buffer;
   Table<complex_float> recip_buffer_0;
   Table<complex_float> recip_buffer_1;
-  recip_buffer_0.Calloc(kFrameWnd, cfg->OfdmDataNum() * cfg->BsAntNum(),
+  recip_buffer_0.Calloc(cfg->FrameWnd(), cfg->OfdmDataNum() * cfg->BsAntNum(),
                         Agora_memory::Alignment_t::kAlign64);
-  recip_buffer_1.Calloc(kFrameWnd, cfg->OfdmDataNum() * cfg->BsAntNum(),
+  recip_buffer_1.Calloc(cfg->FrameWnd(), cfg->OfdmDataNum() * cfg->BsAntNum(),
                         Agora_memory::Alignment_t::kAlign64);
-  calib_buffer.RandAllocCxFloat(kFrameWnd, cfg->OfdmDataNum() * cfg->BsAntNum(),
+  calib_buffer.RandAllocCxFloat(cfg->FrameWnd(),
+                                cfg->OfdmDataNum() * cfg->BsAntNum(),
                                 Agora_memory::Alignment_t::kAlign64);
 
   std::printf("Reference antenna: %zu\n", cfg->RefAnt());
@@ -32,11 +33,11 @@ TEST(TestRecip, Correctness) {
   // Algorithm in reciprocity.cpp (use as ground truth)
   for (size_t i = 0; i < kMaxFrameNum; i++) {
     auto* ptr_in =
-        reinterpret_cast<arma::cx_float*>(calib_buffer[i % kFrameWnd]);
+        reinterpret_cast<arma::cx_float*>(calib_buffer[cfg->FrameSlot(i)]);
     arma::cx_fmat mat_input(ptr_in, cfg->OfdmDataNum(), cfg->BsAntNum(), false);
     arma::cx_fvec vec_calib_ref = mat_input.col(cfg->RefAnt());
     auto* recip_buff =
-        reinterpret_cast<arma::cx_float*>(recip_buffer_0[i % kFrameWnd]);
+        reinterpret_cast<arma::cx_float*>(recip_buffer_0[cfg->FrameSlot(i)]);
     arma::cx_fmat calib_mat = mat_input.each_col() / vec_calib_ref;
 
     arma::cx_fmat recip_mat(recip_buff, cfg->BsAntNum(), cfg->OfdmDataNum(),
@@ -62,7 +63,8 @@ TEST(TestRecip, Correctness) {
   for (size_t i = 0; i < kMaxFrameNum; i++) {
     // In dofft
     for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
-      auto* ptr_in = calib_buffer[i % kFrameWnd] + ant_id * cfg->OfdmDataNum();
+      auto* ptr_in =
+          calib_buffer[cfg->FrameSlot(i)] + ant_id * cfg->OfdmDataNum();
       for (size_t sc_id = 0; sc_id < cfg->OfdmDataNum();
            sc_id += cfg->BsAntNum()) {
         for (size_t j = 0; j < cfg->BsAntNum(); j++) {
@@ -72,11 +74,11 @@ TEST(TestRecip, Correctness) {
     }
     // Transpose
     auto* ptr_calib =
-        reinterpret_cast<arma::cx_float*>(calib_buffer[i % kFrameWnd]);
+        reinterpret_cast<arma::cx_float*>(calib_buffer[cfg->FrameSlot(i)]);
     arma::cx_fmat calib_mat(ptr_calib, cfg->OfdmDataNum(), cfg->BsAntNum(),
                             false);
     auto* recip_buff =
-        reinterpret_cast<arma::cx_float*>(recip_buffer_1[i % kFrameWnd]);
+        reinterpret_cast<arma::cx_float*>(recip_buffer_1[cfg->FrameSlot(i)]);
     arma::cx_fmat recip_mat(recip_buff, cfg->BsAntNum(), cfg->OfdmDataNum(),
                             false);
     recip_mat = calib_mat.st();
@@ -84,7 +86,7 @@ TEST(TestRecip, Correctness) {
     // In dozf
     for (size_t sc_id = 0; sc_id < cfg->OfdmDataNum(); sc_id++) {
       auto* ptr_in = reinterpret_cast<arma::cx_float*>(
-          recip_buffer_1[i % kFrameWnd] + sc_id * cfg->BsAntNum());
+          recip_buffer_1[cfg->FrameSlot(i)] + sc_id * cfg->BsAntNum());
       arma::cx_fvec recip_vec(ptr_in, cfg->BsAntNum(), false);
       recip_vec = recip_vec / recip_vec(cfg->RefAnt());
     }
@@ -98,8 +100,8 @@ TEST(TestRecip, Correctness) {
   // Check correctness
   constexpr float kAllowedError = 1e-3;
   for (size_t i = 0; i < kMaxFrameNum; i++) {
-    auto* buf0 = reinterpret_cast<float*>(recip_buffer_0[i % kFrameWnd]);
-    auto* buf1 = reinterpret_cast<float*>(recip_buffer_1[i % kFrameWnd]);
+    auto* buf0 = reinterpret_cast<float*>(recip_buffer_0[cfg->FrameSlot(i)]);
+    auto* buf1 = reinterpret_cast<float*>(recip_buffer_1[cfg->FrameSlot(i)]);
     for (size_t j = 0; j < cfg->OfdmDataNum() * cfg->BsAntNum(); j++) {
       ASSERT_LE(abs(buf0[j] - buf1[j]), kAllowedError);
     }
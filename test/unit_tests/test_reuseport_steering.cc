@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "buffer.h"
+#include "reuseport_steering.h"
+#include "udp_client.h"
+#include "udp_server.h"
+
+static constexpr uint16_t kPort = 3485;
+static constexpr size_t kPacketLength = 256;
+static constexpr size_t kNumThreads = 4;
+static constexpr size_t kNumAnts = 16;
+static constexpr size_t kAntPerCell = 8;
+static constexpr size_t kNumPackets = 16384;
+// Small enough to fit in the socket buffers while receivers catch up
+static constexpr size_t kBurst = 256;
+
+/// Receive on [udp_server] until [num_total] packets have been received by
+/// all threads, recording the sequence number of each packet in [seen]
+static void RecvUntil(UDPServer& udp_server, std::vector<size_t>& seen,
+                      std::atomic<size_t>& num_rx, size_t num_total) {
+  std::vector<uint8_t> buf(kPacketLength);
+  while (num_rx.load() < num_total) {
+    if (udp_server.Recv(&buf[0], kPacketLength) ==
+        static_cast<ssize_t>(kPacketLength)) {
+      auto* pkt = reinterpret_cast<Packet*>(&buf[0]);
+      seen.push_back(pkt->frame_id_);
+      num_rx++;
+    }
+  }
+}
+
+/// Send packets [first_seq, first_seq + num) with the antenna of packet i
+/// being i % kNumAnts, split into cells of kAntPerCell antennas
+static void SendPackets(UDPClient& udp_client, size_t first_seq, size_t num,
+                        const std::atomic<size_t>& num_rx) {
+  std::vector<uint8_t> buf(kPacketLength, 0);
+  for (size_t seq = first_seq; seq < first_seq + num; seq++) {
+    const size_t ant = seq % kNumAnts;
+    new (&buf[0]) Packet(seq, 0, ant / kAntPerCell, ant % kAntPerCell);
+    udp_client.Send("127.0.0.1", kPort, &buf[0], kPacketLength);
+    while (seq + 1 - num_rx.load() >= kBurst) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+/// Packets from all antennas reach the socket group exactly once, each on
+/// the socket its antenna is mapped to, before and after the mapping changes
+TEST(TestReuseportSteering, ExactlyOnceAcrossThreads) {
+  std::vector<std::unique_ptr<UDPServer>> servers;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    servers.push_back(std::make_unique<UDPServer>(
+        kPort, kPacketLength * kBurst * 4, true /* reuse_port */));
+  }
+  AntennaBalancer balancer(kNumAnts, kNumThreads);
+  AttachReuseportProgram(
+      servers.at(0)->Fd(),
+      BuildAntennaSteeringProgram(balancer.AntToThread(), kAntPerCell,
+                                  kNumThreads));
+  const std::vector<size_t> first_mapping = balancer.AntToThread();
+
+  // Make thread 0 look backed up, so that one of its antennas moves
+  std::vector<size_t> depths(kNumThreads, 0);
+  depths.at(0) = 1000;
+  std::vector<size_t> ant_packets(kNumAnts, 10);
+  for (size_t ant = 0; ant < kNumAnts / kNumThreads; ant++) {
+    ant_packets.at(ant) = 30;
+  }
+  ASSERT_TRUE(balancer.Rebalance(depths, ant_packets, 100));
+  const std::vector<size_t> second_mapping = balancer.AntToThread();
+  ASSERT_NE(first_mapping, second_mapping);
+
+  std::vector<std::vector<size_t>> seen(kNumThreads);
+  std::atomic<size_t> num_rx(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back(RecvUntil, std::ref(*servers.at(i)),
+                         std::ref(seen.at(i)), std::ref(num_rx), kNumPackets);
+  }
+
+  UDPClient udp_client;
+  SendPackets(udp_client, 0, kNumPackets / 2, num_rx);
+  // Wait for the first half so that every packet has a known mapping
+  while (num_rx.load() < kNumPackets / 2) {
+    std::this_thread::yield();
+  }
+  AttachReuseportProgram(
+      servers.at(kNumThreads - 1)->Fd(),
+      BuildAntennaSteeringProgram(second_mapping, kAntPerCell, kNumThreads));
+  SendPackets(udp_client, kNumPackets / 2, kNumPackets / 2, num_rx);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<size_t> times_seen(kNumPackets, 0);
+  for (size_t i = 0; i < kNumThreads; i++) {
+    for (size_t seq : seen.at(i)) {
+      ASSERT_LT(seq, kNumPackets);
+      times_seen.at(seq)++;
+      const auto& mapping =
+          seq < kNumPackets / 2 ? first_mapping : second_mapping;
+      EXPECT_EQ(mapping.at(seq % kNumAnts), i) << "Packet " << seq;
+    }
+  }
+  for (size_t seq = 0; seq < kNumPackets; seq++) {
+    ASSERT_EQ(times_seen.at(seq), 1) << "Packet " << seq;
+  }
+}
+
+/// The busiest antenna that narrows the gap moves to the shallowest thread,
+/// and balanced or lightly loaded threads are left alone
+TEST(TestReuseportSteering, BalancerMovesBusiestAntenna) {
+  AntennaBalancer balancer(8, 2);
+  const std::vector<size_t> initial = {0, 0, 0, 0, 1, 1, 1, 1};
+  ASSERT_EQ(balancer.AntToThread(), initial);
+
+  // Below the minimum depth, or not twice as deep: no change
+  EXPECT_FALSE(balancer.Rebalance({50, 0}, {9, 9, 9, 9, 1, 1, 1, 1}, 100));
+  EXPECT_FALSE(balancer.Rebalance({150, 100}, {9, 9, 9, 9, 1, 1, 1, 1}, 100));
+
+  // Thread 0 has 43 packets against 20. Moving antenna 3 (40) would only
+  // flip the imbalance, so antenna 2 (2) is the busiest one that narrows it.
+  EXPECT_TRUE(balancer.Rebalance({300, 10}, {0, 1, 2, 40, 5, 5, 5, 5}, 100));
+  const std::vector<size_t> moved = {0, 0, 1, 0, 1, 1, 1, 1};
+  EXPECT_EQ(balancer.AntToThread(), moved);
+
+  // A thread keeps its last antenna
+  AntennaBalancer single(2, 2);
+  EXPECT_FALSE(single.Rebalance({300, 0}, {50, 0}, 100));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
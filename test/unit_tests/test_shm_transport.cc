@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "buffer.h"
+#include "shm_transport.h"
+
+static constexpr size_t kNumRadios = 4;
+// Small enough that the rings wrap around many times
+static constexpr size_t kNumSlots = 64;
+static constexpr size_t kPacketLength = 256;
+static constexpr size_t kNumPackets = 100000;
+
+static std::string TestRegionName() {
+  return "/agora_test_shm_" + std::to_string(getpid());
+}
+
+/// The payload byte of packet [seq] of radio [radio_id]
+static uint8_t PayloadByte(size_t seq, size_t radio_id) {
+  return static_cast<uint8_t>((seq * 7) + radio_id);
+}
+
+/// Produce kNumPackets packets into every radio's uplink ring in turn, as a
+/// sender attached from another process would
+static void ProduceUplink(const std::string& name) {
+  ShmTransport shm(name, false /* create */, kNumRadios, kNumSlots,
+                   kPacketLength);
+  for (size_t seq = 0; seq < kNumPackets; seq++) {
+    for (size_t radio_id = 0; radio_id < kNumRadios; radio_id++) {
+      ShmRing& ring = shm.Uplink(radio_id);
+      uint8_t* slot = ring.Reserve();
+      while (slot == nullptr) {
+        std::this_thread::yield();
+        slot = ring.Reserve();
+      }
+      auto* pkt = new (slot) Packet(seq, 0, 0, radio_id);
+      std::memset(pkt->data_, PayloadByte(seq, radio_id),
+                  kPacketLength - Packet::kOffsetOfData);
+      ring.Commit();
+    }
+  }
+}
+
+/// Packets produced by another process arrive exactly once and in order on
+/// every radio's ring, with their payloads intact
+TEST(TestShmTransport, ExactlyOnceAcrossProcesses) {
+  const std::string name = TestRegionName();
+  ShmTransport shm(name, true /* create */, kNumRadios, kNumSlots,
+                   kPacketLength);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    int status = 0;
+    try {
+      ProduceUplink(name);
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "Producer failed: %s\n", e.what());
+      status = 1;
+    }
+    _exit(status);
+  }
+
+  std::vector<size_t> next_seq(kNumRadios, 0);
+  size_t num_rx = 0;
+  size_t num_corrupt = 0;
+  while (num_rx < kNumRadios * kNumPackets) {
+    for (size_t radio_id = 0; radio_id < kNumRadios; radio_id++) {
+      ShmRing& ring = shm.Uplink(radio_id);
+      const uint8_t* slot = ring.Front();
+      if (slot == nullptr) {
+        // Let the producer run if both processes share a core
+        std::this_thread::yield();
+        continue;
+      }
+      const auto* pkt = reinterpret_cast<const Packet*>(slot);
+      ASSERT_EQ(pkt->ant_id_, radio_id);
+      ASSERT_EQ(pkt->frame_id_, next_seq.at(radio_id));
+      for (size_t i = 0; i < kPacketLength - Packet::kOffsetOfData; i++) {
+        if (reinterpret_cast<const uint8_t*>(pkt->data_)[i] !=
+            PayloadByte(pkt->frame_id_, radio_id)) {
+          num_corrupt++;
+          break;
+        }
+      }
+      ring.Pop();
+      next_seq.at(radio_id)++;
+      num_rx++;
+    }
+  }
+
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  EXPECT_EQ(num_corrupt, 0);
+  for (size_t radio_id = 0; radio_id < kNumRadios; radio_id++) {
+    EXPECT_EQ(shm.Uplink(radio_id).Front(), nullptr);
+  }
+}
+
+/// A full ring refuses new packets until the consumer frees a slot, and the
+/// two directions of a radio are independent
+TEST(TestShmTransport, FullRingRejectsReserve) {
+  ShmTransport shm(TestRegionName(), true /* create */, kNumRadios, 4,
+                   kPacketLength);
+  ShmRing& ring = shm.Downlink(1);
+  for (size_t i = 0; i < ring.NumSlots(); i++) {
+    uint8_t* slot = ring.Reserve();
+    ASSERT_NE(slot, nullptr);
+    new (slot) Packet(i, 0, 0, 1);
+    ring.Commit();
+  }
+  EXPECT_EQ(ring.Reserve(), nullptr);
+  EXPECT_EQ(shm.Uplink(1).Front(), nullptr);
+  EXPECT_NE(shm.Uplink(1).Reserve(), nullptr);
+
+  ASSERT_NE(ring.Front(), nullptr);
+  EXPECT_EQ(reinterpret_cast<const Packet*>(ring.Front())->frame_id_, 0);
+  ring.Pop();
+  EXPECT_NE(ring.Reserve(), nullptr);
+  EXPECT_EQ(reinterpret_cast<const Packet*>(ring.Front())->frame_id_, 1);
+}
+
+/// Attaching with a different geometry fails instead of misreading the rings
+TEST(TestShmTransport, AttachChecksGeometry) {
+  const std::string name = TestRegionName();
+  ShmTransport shm(name, true /* create */, kNumRadios, kNumSlots,
+                   kPacketLength);
+  EXPECT_THROW(ShmTransport(name, false /* create */, kNumRadios * 2,
+                            kNumSlots, kPacketLength),
+               std::runtime_error);
+  EXPECT_THROW(ShmTransport(name, true /* create */, kNumRadios, 48,
+                            kPacketLength),
+               std::runtime_error);
+  ShmTransport attached(name, false /* create */, kNumRadios, kNumSlots,
+                        kPacketLength);
+  EXPECT_EQ(attached.NumRadios(), kNumRadios);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
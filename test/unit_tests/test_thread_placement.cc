@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#include "thread_placement.h"
+
+// An AMD EPYC-like processor: 8 cores with 2 SMT threads each, where CPUs i
+// and i + 8 are siblings, and two CCXs of 4 cores each
+static constexpr size_t kNumCores = 8;
+static constexpr size_t kNumCpus = kNumCores * 2;
+static constexpr size_t kCoresPerCcx = 4;
+
+/// A sysfs tree in a temporary directory
+class MockSysfs {
+ public:
+  /// With two_nodes set, each CCX is its own NUMA node
+  explicit MockSysfs(bool two_nodes) {
+    char root_template[] = "/tmp/agora_sysfs_XXXXXX";
+    root_ = mkdtemp(root_template);
+    WriteFile(CpuDir() + "/online", "0-" + std::to_string(kNumCpus - 1));
+    for (size_t cpu_id = 0; cpu_id < kNumCpus; cpu_id++) {
+      const size_t core_id = cpu_id % kNumCores;
+      const size_t ccx = core_id / kCoresPerCcx;
+      const std::string cpu_path = CpuDir() + "/cpu" + std::to_string(cpu_id);
+      WriteFile(cpu_path + "/topology/thread_siblings_list",
+                std::to_string(core_id) + "," +
+                    std::to_string(core_id + kNumCores));
+      WriteFile(cpu_path + "/topology/physical_package_id", "0");
+      // L2 per core, L3 per CCX
+      WriteFile(cpu_path + "/cache/index2/level", "2");
+      WriteFile(cpu_path + "/cache/index2/shared_cpu_list",
+                std::to_string(core_id) + "," +
+                    std::to_string(core_id + kNumCores));
+      const size_t first_core = ccx * kCoresPerCcx;
+      const size_t last_core = first_core + kCoresPerCcx - 1;
+      WriteFile(cpu_path + "/cache/index3/level", "3");
+      WriteFile(cpu_path + "/cache/index3/shared_cpu_list",
+                std::to_string(first_core) + "-" + std::to_string(last_core) +
+                    "," + std::to_string(first_core + kNumCores) + "-" +
+                    std::to_string(last_core + kNumCores));
+      const size_t node = two_nodes ? ccx : 0;
+      std::filesystem::create_directories(cpu_path + "/node" +
+                                          std::to_string(node));
+    }
+    WriteFile(NetDir() + "/eth1/device/numa_node", "1");
+  }
+  ~MockSysfs() { std::filesystem::remove_all(root_); }
+
+  std::string CpuDir() const { return root_ + "/devices/system/cpu"; }
+  std::string NetDir() const { return root_ + "/class/net"; }
+
+ private:
+  static void WriteFile(const std::string& path, const std::string& line) {
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path());
+    std::ofstream file(path);
+    file << line << "\n";
+  }
+
+  std::string root_;
+};
+
+static size_t Llc(const CpuTopology& topology, int cpu_id) {
+  return topology.Cpu(cpu_id).llc_id_;
+}
+
+static size_t CoreId(const CpuTopology& topology, int cpu_id) {
+  return topology.Cpu(cpu_id).core_id_;
+}
+
+TEST(TestThreadPlacement, ParseSysfs) {
+  ASSERT_EQ(CpuTopology::ParseCpuList("0-3,8,10-11\n"),
+            std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}));
+
+  MockSysfs sysfs(true);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  ASSERT_EQ(topology.Cpus().size(), kNumCpus);
+  ASSERT_EQ(topology.Cpu(9).core_id_, 1);
+  ASSERT_EQ(topology.Cpu(9).llc_id_, 0);
+  ASSERT_EQ(topology.Cpu(9).numa_node_, 0);
+  ASSERT_EQ(topology.Cpu(13).core_id_, 5);
+  ASSERT_EQ(topology.Cpu(13).llc_id_, 4);
+  ASSERT_EQ(topology.Cpu(13).numa_node_, 1);
+  ASSERT_EQ(CpuTopology::NicNumaNode(sysfs.NetDir(), "eth1"), 1);
+  ASSERT_EQ(CpuTopology::NicNumaNode(sysfs.NetDir(), "eth0"), -1);
+}
+
+TEST(TestThreadPlacement, WorkersAvoidSmtSiblingsAndIoCcx) {
+  MockSysfs sysfs(false);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  PlacementRoles roles;
+  roles.num_txrx_ = 2;
+  roles.num_workers_ = 4;
+  ThreadPlacement placement(topology, roles, PlacementConstraints());
+
+  std::set<size_t> io_cores;
+  io_cores.insert(CoreId(topology, placement.Core(ThreadType::kMaster, 0)));
+  ASSERT_NE(placement.Core(ThreadType::kMaster, 0), 0);
+  for (size_t i = 0; i < roles.num_txrx_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorkerTXRX, i);
+    ASSERT_EQ(Llc(topology, cpu_id), 0);
+    io_cores.insert(CoreId(topology, cpu_id));
+  }
+  ASSERT_EQ(io_cores.size(), 1 + roles.num_txrx_);
+
+  std::set<size_t> worker_cores;
+  for (size_t i = 0; i < roles.num_workers_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorker, i);
+    // The workers fill the CCX without I/O threads
+    ASSERT_EQ(Llc(topology, cpu_id), kCoresPerCcx);
+    worker_cores.insert(CoreId(topology, cpu_id));
+  }
+  ASSERT_EQ(worker_cores.size(), roles.num_workers_);
+  ASSERT_EQ(placement.Core(ThreadType::kWorker, roles.num_workers_), -1);
+  ASSERT_EQ(placement.Core(ThreadType::kMasterTX, 0), -1);
+}
+
+TEST(TestThreadPlacement, IoOnNicNumaNode) {
+  MockSysfs sysfs(true);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  PlacementRoles roles;
+  roles.num_txrx_ = 2;
+  roles.num_mac_ = 1;
+  roles.num_workers_ = 4;
+  PlacementConstraints constraints;
+  constraints.nic_numa_node_ = CpuTopology::NicNumaNode(sysfs.NetDir(), "eth1");
+  ThreadPlacement placement(topology, roles, constraints);
+
+  ASSERT_EQ(topology.Cpu(placement.Core(ThreadType::kMaster, 0)).numa_node_,
+            1);
+  ASSERT_EQ(
+      topology.Cpu(placement.Core(ThreadType::kWorkerMacTXRX, 0)).numa_node_,
+      1);
+  for (size_t i = 0; i < roles.num_txrx_; i++) {
+    ASSERT_EQ(
+        topology.Cpu(placement.Core(ThreadType::kWorkerTXRX, i)).numa_node_,
+        1);
+  }
+  std::set<size_t> worker_cores;
+  for (size_t i = 0; i < roles.num_workers_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorker, i);
+    ASSERT_EQ(topology.Cpu(cpu_id).numa_node_, 0);
+    worker_cores.insert(CoreId(topology, cpu_id));
+  }
+  ASSERT_EQ(worker_cores.size(), roles.num_workers_);
+}
+
+TEST(TestThreadPlacement, FallBackToSmtSiblings) {
+  MockSysfs sysfs(false);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  PlacementRoles roles;
+  roles.num_txrx_ = 1;
+  roles.num_workers_ = 12;
+  ThreadPlacement placement(topology, roles, PlacementConstraints());
+
+  std::set<int> cpus = {placement.Core(ThreadType::kMaster, 0),
+                        placement.Core(ThreadType::kWorkerTXRX, 0)};
+  std::set<size_t> whole_cores;
+  for (size_t i = 0; i < roles.num_workers_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorker, i);
+    ASSERT_NE(cpu_id, 0);
+    cpus.insert(cpu_id);
+    if (i < kNumCores - 2) {
+      whole_cores.insert(CoreId(topology, cpu_id));
+    }
+  }
+  // Workers take the free physical cores first, then their siblings
+  ASSERT_EQ(whole_cores.size(), kNumCores - 2);
+  ASSERT_EQ(cpus.size(), 2 + roles.num_workers_);
+}
+
+TEST(TestThreadPlacement, ExplicitCores) {
+  MockSysfs sysfs(false);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  PlacementRoles roles;
+  roles.num_txrx_ = 1;
+  roles.num_workers_ = 2;
+  PlacementConstraints constraints;
+  constraints.cores_["master"] = {5};
+  constraints.cores_["worker"] = {6, 7};
+  ThreadPlacement placement(topology, roles, constraints);
+
+  ASSERT_EQ(placement.Core(ThreadType::kMaster, 0), 5);
+  ASSERT_EQ(placement.Core(ThreadType::kWorker, 0), 6);
+  ASSERT_EQ(placement.Core(ThreadType::kWorker, 1), 7);
+  // The planned TXRX thread avoids the explicit cores and their siblings
+  const int txrx_cpu = placement.Core(ThreadType::kWorkerTXRX, 0);
+  for (int cpu_id : {5, 6, 7}) {
+    ASSERT_NE(CoreId(topology, txrx_cpu), CoreId(topology, cpu_id));
+  }
+}
+
+TEST(TestThreadPlacement, ColocateFftAndDemul) {
+  MockSysfs sysfs(false);
+  const CpuTopology topology = CpuTopology::FromSysfs(sysfs.CpuDir());
+  PlacementRoles roles;
+  roles.num_txrx_ = 1;
+  roles.num_workers_ = 8;
+  roles.bigstation_ = true;
+  roles.num_fft_ = 2;
+  roles.num_zf_ = 2;
+  roles.num_demul_ = 2;
+  ThreadPlacement placement(topology, roles, PlacementConstraints());
+
+  std::set<size_t> fft_llcs;
+  std::set<size_t> demul_llcs;
+  std::set<int> cpus;
+  for (size_t i = 0; i < roles.num_fft_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorkerFFT, i);
+    fft_llcs.insert(Llc(topology, cpu_id));
+  }
+  const size_t first_demul = roles.num_fft_ + roles.num_zf_;
+  for (size_t i = first_demul; i < first_demul + roles.num_demul_; i++) {
+    const int cpu_id = placement.Core(ThreadType::kWorkerDemul, i);
+    demul_llcs.insert(Llc(topology, cpu_id));
+  }
+  for (size_t i = 0; i < roles.num_workers_; i++) {
+    cpus.insert(placement.Core(ThreadType::kWorker, i));
+  }
+  ASSERT_EQ(fft_llcs, demul_llcs);
+  ASSERT_EQ(cpus.size(), roles.num_workers_);
+  std::printf("%s", placement.ToString().c_str());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "gettime.h"
+#include "tx_scheduler.h"
+#include "txrx.h"
+#include "udp_client.h"
+#include "udp_server.h"
+
+static constexpr size_t kServerUDPPort = 3195;
+static constexpr size_t kNumBuckets = 64;
+static constexpr uint64_t kTickTsc = 10;
+
+/// Every tag is released exactly once, at the first Expire() at or after its
+/// release time, including tags due in the past and tags more than one turn
+/// of the wheel ahead
+TEST(TestTxScheduler, WheelReleasesOnceOnTime) {
+  const uint64_t start_tsc = 1000;
+  const uint64_t horizon_tsc = kNumBuckets * kTickTsc * 5;
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<uint64_t> release_dist(
+      0, start_tsc + horizon_tsc);
+  std::uniform_int_distribution<uint64_t> step_dist(1, kTickTsc * 3);
+
+  TxTimingWheel wheel(kNumBuckets, kTickTsc, start_tsc);
+  std::vector<uint64_t> release_tsc(2000);
+  std::vector<size_t> num_released(release_tsc.size(), 0);
+  for (size_t tag = 0; tag < release_tsc.size(); tag++) {
+    release_tsc.at(tag) = release_dist(rng);
+    wheel.Insert(release_tsc.at(tag), tag);
+  }
+  EXPECT_EQ(wheel.Size(), release_tsc.size());
+
+  size_t num_late_inserts = 0;
+  for (uint64_t now_tsc = start_tsc; wheel.Size() > 0;
+       now_tsc += step_dist(rng)) {
+    // Tags inserted while the wheel turns, some of them already due
+    if ((now_tsc < start_tsc + horizon_tsc) && (now_tsc % 7 == 0)) {
+      release_tsc.push_back(now_tsc - std::min(now_tsc, kTickTsc * 20));
+      num_released.push_back(0);
+      wheel.Insert(release_tsc.back(), release_tsc.size() - 1);
+      num_late_inserts++;
+    }
+    wheel.Expire(now_tsc, [&](size_t tag) {
+      ASSERT_LT(tag, release_tsc.size());
+      EXPECT_LE(release_tsc.at(tag), now_tsc);
+      num_released.at(tag)++;
+    });
+    // Nothing due is left behind
+    for (size_t tag = 0; tag < release_tsc.size(); tag++) {
+      if (num_released.at(tag) == 0) {
+        ASSERT_GT(release_tsc.at(tag), now_tsc) << tag;
+      }
+    }
+    ASSERT_LT(now_tsc, start_tsc + (horizon_tsc * 2));
+  }
+  EXPECT_GT(num_late_inserts, 0);
+  EXPECT_EQ(std::count(num_released.begin(), num_released.end(), 1),
+            static_cast<long>(num_released.size()));
+}
+
+/// The closed form of the frame schedule matches the slow start of the
+/// beacon loop, which lengthens its delay as frames go out
+TEST(TestTxScheduler, FrameScheduleMatchesBeaconLoop) {
+  const uint64_t first_tsc = 12345;
+  const uint64_t frame_tsc = 1000;
+  const size_t thresh1 = 10;
+  const size_t thresh2 = 40;
+  const uint64_t gap1_tsc = 40 * frame_tsc;
+  const uint64_t gap2_tsc = 15 * frame_tsc;
+  const uint64_t steady_tsc = 4 * frame_tsc;
+  const uint64_t symbol_tsc = frame_tsc / 70;
+
+  FrameSchedule schedule(first_tsc, steady_tsc, symbol_tsc);
+  schedule.SetSlowStart(thresh1, gap1_tsc, thresh2, gap2_tsc);
+
+  uint64_t send_time = first_tsc;
+  uint64_t delay_tsc = gap1_tsc;
+  for (size_t frame_id = 0; frame_id < thresh2 * 3;) {
+    ASSERT_EQ(schedule.FrameStart(frame_id), send_time) << frame_id;
+    ASSERT_EQ(schedule.SymbolStart(frame_id, 3),
+              send_time + (3 * symbol_tsc));
+    frame_id++;
+    if (frame_id == thresh1) {
+      delay_tsc = gap2_tsc;
+    } else if (frame_id == thresh2) {
+      delay_tsc = steady_tsc;
+    }
+    send_time += delay_tsc;
+  }
+
+  FrameSchedule steady(first_tsc, frame_tsc, symbol_tsc);
+  EXPECT_EQ(steady.FrameStart(5), first_tsc + (5 * frame_tsc));
+}
+
+/// Packets sent by the wheel to a local UDP receiver arrive in order of
+/// release time, never before it, and mostly within a millisecond of it
+TEST(TestTxScheduler, UdpReleaseTiming) {
+  static constexpr size_t kNumPackets = 200;
+  static constexpr double kSpacingUs = 100;
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  const uint64_t spacing_tsc = kSpacingUs * 1e3 * freq_ghz;
+  const uint64_t one_ms_tsc = 1e6 * freq_ghz;
+
+  UDPServer udp_server(kServerUDPPort, kNumPackets * 64);
+  UDPClient udp_client;
+
+  const uint64_t start_tsc = GetTime::Rdtsc();
+  TxTimingWheel wheel(4096, 1e3 * freq_ghz /* 1 us */, start_tsc);
+  std::vector<uint64_t> release_tsc(kNumPackets);
+  std::vector<size_t> order(kNumPackets);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937(7));
+  for (size_t tag : order) {
+    release_tsc.at(tag) = start_tsc + (2 * one_ms_tsc) + (tag * spacing_tsc);
+    wheel.Insert(release_tsc.at(tag), tag);
+  }
+
+  auto send = [&](size_t tag) {
+    udp_client.Send("localhost", kServerUDPPort,
+                    reinterpret_cast<uint8_t*>(&tag), sizeof(tag));
+  };
+  size_t num_rx = 0;
+  size_t num_on_time = 0;
+  const uint64_t deadline_tsc = release_tsc.back() + (1000 * one_ms_tsc);
+  while ((num_rx < kNumPackets) && (GetTime::Rdtsc() < deadline_tsc)) {
+    wheel.Expire(GetTime::Rdtsc(), send);
+    size_t tag = SIZE_MAX;
+    const ssize_t ret =
+        udp_server.Recv(reinterpret_cast<uint8_t*>(&tag), sizeof(tag));
+    ASSERT_GE(ret, 0);
+    if (ret == 0) {
+      continue;
+    }
+    const uint64_t rx_tsc = GetTime::Rdtsc();
+    ASSERT_EQ(tag, num_rx);
+    EXPECT_GE(rx_tsc, release_tsc.at(tag));
+    if (rx_tsc - release_tsc.at(tag) < one_ms_tsc) {
+      num_on_time++;
+    }
+    num_rx++;
+  }
+  EXPECT_EQ(num_rx, kNumPackets);
+  EXPECT_EQ(wheel.Size(), 0);
+  EXPECT_GE(num_on_time, kNumPackets * 9 / 10);
+}
+
+/// The socket thread of PacketTXRX in DL TX scheduler mode sends each
+/// downlink packet dl_tx_advance_us before the air time of its symbol. The
+/// air time of a frame is taken from the arrival of its beacon, which the
+/// thread sends on the same schedule, at the start of the frame.
+TEST(TestTxScheduler, SocketThreadTimesDownlink) {
+  // Frames after the first gap of the slow start
+  static constexpr size_t kFirstFrame = 2;
+  static constexpr size_t kNumFrames = 4;
+  static constexpr size_t kNumRxPackets = 64;
+  static constexpr double kEarlyUs = 100;
+  static constexpr double kLateUs = 500;
+  static constexpr double kTimeoutSec = 5;
+  auto cfg = std::make_unique<Config>("data/tddconfig-dl-tx-scheduler.json");
+  ASSERT_TRUE(PacketTXRX::UseDlTxScheduler(cfg.get()));
+  // Downlink packets go to the port of their antenna, beacons to every port
+  ASSERT_EQ(cfg->NumChannels(), 1);
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  const double symbol_us =
+      cfg->GetFrameDurationSec() * 1e6 / cfg->Frame().NumTotalSyms();
+  ASSERT_GT(cfg->Frame().GetDLSymbol(0) * symbol_us,
+            static_cast<double>(cfg->DlTxAdvanceUs()));
+
+  // The radios, which receive the beacons and the downlink packets
+  std::vector<std::unique_ptr<UDPServer>> radios;
+  for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
+    radios.push_back(std::make_unique<UDPServer>(
+        cfg->BsRruPort() + ant_id,
+        cfg->DlPacketLength() * cfg->Frame().NumTotalSyms() * kNumFrames));
+  }
+
+  moodycamel::ConcurrentQueue<EventData> message_queue;
+  moodycamel::ConcurrentQueue<EventData> tx_queue;
+  moodycamel::ProducerToken rx_ptok(message_queue);
+  moodycamel::ProducerToken tx_ptok(tx_queue);
+  moodycamel::ProducerToken* rx_ptoks[PacketTXRX::kMaxSocketNum] = {&rx_ptok};
+  moodycamel::ProducerToken* tx_ptoks[PacketTXRX::kMaxSocketNum] = {&tx_ptok};
+  Table<char> rx_buffer;
+  rx_buffer.Malloc(cfg->SocketThreadNum(),
+                   kNumRxPackets * PacketTXRX::RxPacketStride(cfg.get()),
+                   PacketTXRX::kRxBufferAlignment);
+  Table<size_t> frame_start;
+  frame_start.Calloc(cfg->SocketThreadNum(), kNumStatsFrames,
+                     Agora_memory::Alignment_t::kAlign64);
+  std::vector<char> tx_buffer(cfg->FrameWnd() * cfg->Frame().NumDLSyms() *
+                              cfg->BsAntNum() * cfg->DlPacketLength());
+  // Only used with real radios
+  Table<complex_float> calib_dl_buffer;
+  Table<complex_float> calib_ul_buffer;
+
+  // The packets are queued long before their air time, as the master does
+  // for frames that it processes early
+  size_t num_dl = 0;
+  for (size_t frame_id = kFirstFrame; frame_id < kFirstFrame + kNumFrames;
+       frame_id++) {
+    for (size_t i = 0; i < cfg->Frame().NumDLSyms(); i++) {
+      for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
+        tx_queue.enqueue(
+            tx_ptok,
+            EventData(EventType::kPacketTX,
+                      gen_tag_t::FrmSymAnt(frame_id,
+                                           cfg->Frame().GetDLSymbol(i), ant_id)
+                          .tag_));
+        num_dl++;
+      }
+    }
+  }
+
+  auto txrx = std::make_unique<PacketTXRX>(cfg.get(), cfg->CoreOffset() + 1,
+                                           &message_queue, &tx_queue, rx_ptoks,
+                                           tx_ptoks);
+  ASSERT_TRUE(txrx->StartTxRx(rx_buffer,
+                              kNumRxPackets * cfg->SocketThreadNum(),
+                              frame_start, tx_buffer.data(), calib_dl_buffer,
+                              calib_ul_buffer));
+
+  struct DlArrival {
+    size_t frame_id_;
+    size_t symbol_id_;
+    uint64_t rx_tsc_;
+  };
+  std::vector<DlArrival> arrivals;
+  // The first arrival of each frame's beacon
+  std::map<size_t, uint64_t> beacon_rx_tsc;
+  std::vector<uint8_t> pkt_buf(
+      std::max(cfg->PacketLength(), cfg->DlPacketLength()));
+  bool recv_failed = false;
+  const uint64_t timeout_tsc =
+      GetTime::Rdtsc() + static_cast<uint64_t>(kTimeoutSec * 1e9 * freq_ghz);
+  while ((arrivals.size() < num_dl) && (recv_failed == false) &&
+         (GetTime::Rdtsc() < timeout_tsc)) {
+    for (auto& radio : radios) {
+      const ssize_t ret = radio->Recv(pkt_buf.data(), pkt_buf.size());
+      if (ret <= 0) {
+        recv_failed = (ret < 0);
+        continue;
+      }
+      const uint64_t rx_tsc = GetTime::Rdtsc();
+      const auto* pkt = reinterpret_cast<const Packet*>(pkt_buf.data());
+      if (cfg->GetSymbolType(pkt->symbol_id_) == SymbolType::kBeacon) {
+        beacon_rx_tsc.emplace(pkt->frame_id_, rx_tsc);
+      } else {
+        arrivals.push_back({pkt->frame_id_, pkt->symbol_id_, rx_tsc});
+      }
+    }
+  }
+  // The socket thread exits once Agora stops running
+  cfg->Running(false);
+  txrx.reset();
+
+  EXPECT_FALSE(recv_failed);
+  ASSERT_EQ(arrivals.size(), num_dl);
+  size_t num_on_time = 0;
+  for (const DlArrival& arrival : arrivals) {
+    const auto beacon = beacon_rx_tsc.find(arrival.frame_id_);
+    ASSERT_NE(beacon, beacon_rx_tsc.end()) << "frame " << arrival.frame_id_;
+    const double expected_us =
+        (arrival.symbol_id_ * symbol_us) - cfg->DlTxAdvanceUs();
+    const double offset_us =
+        static_cast<double>(static_cast<int64_t>(arrival.rx_tsc_) -
+                            static_cast<int64_t>(beacon->second)) /
+        (freq_ghz * 1e3);
+    // Sent with the frame, not when the packet was queued
+    EXPECT_GT(offset_us, 0) << "frame " << arrival.frame_id_ << " symbol "
+                            << arrival.symbol_id_;
+    if ((offset_us > expected_us - kEarlyUs) &&
+        (offset_us < expected_us + kLateUs)) {
+      num_on_time++;
+    }
+  }
+  EXPECT_GE(num_on_time, num_dl * 9 / 10);
+
+  // Every packet sent is reported to the master
+  size_t num_tx_reports = 0;
+  EventData event;
+  while (message_queue.try_dequeue_from_producer(rx_ptok, event) == true) {
+    EXPECT_EQ(event.event_type_, EventType::kPacketTX);
+    num_tx_reports++;
+  }
+  EXPECT_EQ(num_tx_reports, num_dl);
+
+  rx_buffer.Free();
+  frame_start.Free();
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
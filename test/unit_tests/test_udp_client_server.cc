@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <random>
 #include <thread>
 
+#include "buffer.h"
 #include "gettime.h"
 #include "udp_client.h"
 #include "udp_server.h"
@@ -13,6 +15,13 @@ static constexpr size_t kMessageSize = 9000;
 static constexpr size_t kNumPackets = 10000;
 std::atomic<size_t> server_ready;
 
+// A Packet header with 1024 IQ samples, so that a GSO send holds 15 packets
+static constexpr size_t kGsoPacketSize = Packet::kOffsetOfData + 4096;
+static constexpr size_t kNumGsoPackets = 1200;
+// More packets than fit in one GSO send, and few enough that a batch fits in
+// the socket buffer
+static constexpr size_t kGsoBatchSize = 24;
+
 void ClientFunc() {
   std::vector<uint8_t> packet(kMessageSize);
   UDPClient udp_client;
@@ -87,6 +96,137 @@ TEST(UDPClientServer, ServerIsNonBlocking) {
   ASSERT_EQ(ret, 0);
 }
 
+/// Fill [buf] with packet [seq]: a header and a payload that depend on [seq]
+static void FillGsoPacket(uint8_t* buf, size_t seq) {
+  new (buf) Packet(seq, seq % 14, 0, seq % 64);
+  for (size_t i = Packet::kOffsetOfData; i < kGsoPacketSize; i++) {
+    buf[i] = static_cast<uint8_t>((seq * 31) + i);
+  }
+}
+
+/// Send kNumGsoPackets to a server with GSO, and split what the server
+/// receives into packet slots. Every packet must arrive whole and in order.
+/// Sets [max_coalesced] to the most packets returned by one receive.
+static void CheckGsoLoopback(bool enable_gro, size_t& max_coalesced) {
+  UDPServer udp_server(kServerUDPPort, kGsoPacketSize * kGsoBatchSize * 4);
+  if (enable_gro == true) {
+    udp_server.EnableGro();
+  }
+  UDPClient udp_client;
+
+  std::vector<uint8_t> tx_buf(kGsoBatchSize * kGsoPacketSize);
+  std::vector<struct iovec> datagrams(kGsoBatchSize);
+  std::vector<uint8_t> rx_buf(65536);
+  std::vector<uint8_t> slot(kGsoPacketSize);
+  std::vector<uint8_t> expected(kGsoPacketSize);
+  size_t num_rx = 0;
+  max_coalesced = 0;
+  for (size_t first = 0; first < kNumGsoPackets; first += kGsoBatchSize) {
+    const size_t num = std::min(kGsoBatchSize, kNumGsoPackets - first);
+    for (size_t i = 0; i < num; i++) {
+      FillGsoPacket(&tx_buf.at(i * kGsoPacketSize), first + i);
+      datagrams.at(i).iov_base = &tx_buf.at(i * kGsoPacketSize);
+      datagrams.at(i).iov_len = kGsoPacketSize;
+    }
+    udp_client.SendSegmented("localhost", kServerUDPPort, datagrams.data(),
+                             num);
+
+    // Receive the whole batch before sending the next one
+    while (num_rx < first + num) {
+      size_t segment_size = 0;
+      ssize_t ret =
+          udp_server.RecvSegments(rx_buf.data(), rx_buf.size(), segment_size);
+      ASSERT_GE(ret, 0);
+      if (ret == 0) {
+        continue;
+      }
+      ASSERT_EQ(segment_size, kGsoPacketSize);
+      ASSERT_EQ(static_cast<size_t>(ret) % kGsoPacketSize, 0);
+      const size_t num_packets = static_cast<size_t>(ret) / kGsoPacketSize;
+      max_coalesced = std::max(max_coalesced, num_packets);
+      for (size_t i = 0; i < num_packets; i++) {
+        std::memcpy(slot.data(), &rx_buf.at(i * kGsoPacketSize),
+                    kGsoPacketSize);
+        FillGsoPacket(expected.data(), num_rx);
+        ASSERT_EQ(slot, expected) << "Packet " << num_rx;
+        num_rx++;
+      }
+    }
+  }
+}
+
+// Test that packets sent with GSO reach a GRO socket coalesced and intact
+TEST(UDPClientServer, GsoToGroServer) {
+  size_t max_coalesced = 0;
+  CheckGsoLoopback(true, max_coalesced);
+  EXPECT_GT(max_coalesced, 1);
+}
+
+// Test that packets sent with GSO reach a plain socket one by one and intact
+TEST(UDPClientServer, GsoToPlainServer) {
+  size_t max_coalesced = 0;
+  CheckGsoLoopback(false, max_coalesced);
+  EXPECT_EQ(max_coalesced, 1);
+}
+
+// Test that the server timestamps each received packet after the client
+// sent it, within a second on loopback
+TEST(UDPClientServer, RxTimestamps) {
+  static constexpr size_t kNumTimestampedPackets = 100;
+  UDPServer udp_server(kServerUDPPort);
+  ASSERT_TRUE(udp_server.EnableRxTimestamps(false));
+  UDPClient udp_client;
+  std::vector<uint8_t> packet(kGsoPacketSize);
+  for (size_t i = 0; i < kNumTimestampedPackets; i++) {
+    FillGsoPacket(packet.data(), i);
+    reinterpret_cast<Packet*>(packet.data())->tx_time_ns_ =
+        GetTime::RealtimeNs();
+    udp_client.Send("localhost", kServerUDPPort, packet.data(),
+                    kGsoPacketSize);
+
+    uint64_t rx_time_ns = 0;
+    ssize_t ret = 0;
+    while (ret == 0) {
+      ret = udp_server.Recv(packet.data(), kGsoPacketSize, rx_time_ns);
+    }
+    ASSERT_EQ(ret, static_cast<ssize_t>(kGsoPacketSize));
+    const uint64_t tx_time_ns =
+        reinterpret_cast<Packet*>(packet.data())->tx_time_ns_;
+    ASSERT_NE(rx_time_ns, 0);
+    EXPECT_GE(rx_time_ns, tx_time_ns);
+    EXPECT_LT(rx_time_ns - tx_time_ns, 1000000000);
+  }
+}
+
+// Test that hardware timestamps of a PHC in TAI, which drifts from
+// CLOCK_REALTIME, are converted to within the shortest delivery delay of the
+// true receive time
+TEST(UDPClientServer, HwTimestampConversion) {
+  static constexpr uint64_t kTaiOffsetNs = 37000000000;
+  static constexpr uint64_t kMinDelayNs = 2000;
+  static constexpr uint64_t kPacketIntervalNs = 10000;
+  static constexpr double kDriftPpm = 20.0;
+  std::mt19937 rng(3);
+  std::exponential_distribution<double> delay_dist(1.0 / 5000.0);
+  HwTimestampConverter converter;
+  const uint64_t start_ns = GetTime::RealtimeNs();
+  for (size_t i = 0; i < 20 * HwTimestampConverter::kWindowPackets; i++) {
+    // The true CLOCK_REALTIME time the packet reached the NIC
+    const uint64_t rx_ns = start_ns + (i * kPacketIntervalNs);
+    const auto drift_ns = static_cast<uint64_t>(
+        static_cast<double>(i * kPacketIntervalNs) * kDriftPpm / 1e6);
+    const uint64_t hw_ns = rx_ns + kTaiOffsetNs + drift_ns;
+    const uint64_t sw_ns =
+        rx_ns + kMinDelayNs + static_cast<uint64_t>(delay_dist(rng));
+    const uint64_t converted_ns = converter.ToRealtimeNs(hw_ns, sw_ns);
+    if (i >= HwTimestampConverter::kWindowPackets) {
+      // Up to the shortest delay of a window, and the drift over two windows
+      EXPECT_NEAR(static_cast<double>(converted_ns),
+                  static_cast<double>(rx_ns + kMinDelayNs), 1000.0);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,205 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "gettime.h"
+#include "memory_manage.h"
+#include "udp_client.h"
+#include "udp_server.h"
+#include "uring_transport.h"
+
+static constexpr uint16_t kRecvLoopPort = 3385;
+static constexpr uint16_t kUringPort = 3386;
+static constexpr size_t kPayloadSize = 2112;
+// Room in front of each slot for the recvmsg header, keeping slots aligned
+static constexpr size_t kSlotHeadroom = 64;
+static constexpr size_t kSlotStride = kSlotHeadroom + kPayloadSize;
+static constexpr size_t kNumBufs = 256;
+// Packets per burst, small enough to fit in the socket buffer on loopback
+static constexpr size_t kBurst = 128;
+static constexpr size_t kNumBursts = 64;
+
+static std::unique_ptr<Uring> MakeUring(bool sqpoll) {
+  try {
+    return std::make_unique<Uring>(kUringEntries, sqpoll);
+  } catch (const std::runtime_error& e) {
+    std::printf("Skipping: %s\n", e.what());
+    return nullptr;
+  }
+}
+
+static void SendBurst(UDPClient& udp_client, uint16_t port, size_t first_seq) {
+  std::vector<uint8_t> packet(kPayloadSize, 0);
+  for (size_t i = 0; i < kBurst; i++) {
+    *reinterpret_cast<size_t*>(&packet[0]) = first_seq + i;
+    packet.back() = static_cast<uint8_t>(first_seq + i);
+    udp_client.Send("127.0.0.1", port, &packet[0], kPayloadSize);
+  }
+}
+
+/// Drain kBurst packets with one recv() per packet, as PacketTXRX does
+static size_t RecvLoop(UDPServer& udp_server, size_t first_seq) {
+  std::vector<uint8_t> packet(kPayloadSize);
+  const size_t start_tsc = GetTime::Rdtsc();
+  for (size_t i = 0; i < kBurst;) {
+    ssize_t ret = udp_server.Recv(&packet[0], kPayloadSize);
+    if (ret == static_cast<ssize_t>(kPayloadSize)) {
+      EXPECT_EQ(*reinterpret_cast<size_t*>(&packet[0]), first_seq + i);
+      i++;
+    }
+  }
+  return GetTime::Rdtsc() - start_tsc;
+}
+
+/// Drain kBurst packets through a multishot recvmsg, checking that each one
+/// lands intact at a 64-byte aligned slot
+static size_t UringLoop(Uring& uring, UringBufRing& buf_ring, int fd,
+                        msghdr* msg, size_t first_seq, uint8_t* slots) {
+  const size_t start_tsc = GetTime::Rdtsc();
+  for (size_t i = 0; i < kBurst;) {
+    io_uring_cqe* cqe = uring.PeekCqe();
+    if (cqe == nullptr) {
+      if (buf_ring.Refill() > 0) {
+        uring.Submit();
+      }
+      continue;
+    }
+    EXPECT_NE(cqe->user_data, kUringInternalUserData);
+    // Running out of buffers ends the request but loses no packets
+    EXPECT_TRUE(cqe->res > 0 || cqe->res == -ENOBUFS);
+    if (cqe->res > 0) {
+      auto bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+      uint8_t* payload = buf_ring.Payload(bid);
+      auto* out = reinterpret_cast<io_uring_recvmsg_out*>(payload -
+                                                          kUringRecvHeadroom);
+      EXPECT_EQ(out->payloadlen, kPayloadSize);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(payload) % 64, 0);
+      EXPECT_EQ(payload, slots + bid * kSlotStride + kSlotHeadroom);
+      EXPECT_EQ(*reinterpret_cast<size_t*>(payload), first_seq + i);
+      EXPECT_EQ(payload[kPayloadSize - 1],
+                static_cast<uint8_t>(first_seq + i));
+      buf_ring.Recycle(bid);
+      i++;
+    }
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+      // The kernel ended the multishot request, e.g. on running out of
+      // buffers, so arm it again after handing buffers back
+      buf_ring.Refill();
+      UringPrepRecvMultishot(uring.GetSqe(), fd, msg, buf_ring, 0);
+      uring.Submit();
+    }
+    uring.SeenCqe();
+  }
+  while (buf_ring.Refill() > 0) {
+    uring.Submit();
+  }
+  return GetTime::Rdtsc() - start_tsc;
+}
+
+/// Compare a recv() loop with multishot recvmsg on the same loopback traffic.
+/// Both must deliver every packet in order; the time spent receiving is
+/// printed rather than checked, since it depends on the machine.
+TEST(TestUringTransport, RecvThroughputVsRecvLoop) {
+  auto uring = MakeUring(false);
+  if (uring == nullptr) {
+    GTEST_SKIP();
+  }
+  auto* slots = static_cast<uint8_t*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, kNumBufs * kSlotStride));
+  UringBufRing buf_ring(uring.get(), 0, slots, kSlotStride, kSlotHeadroom,
+                        kPayloadSize, kNumBufs);
+
+  const size_t sock_buf_size = kPayloadSize * kBurst * 4;
+  UDPServer recv_loop_server(kRecvLoopPort, sock_buf_size);
+  UDPServer uring_server(kUringPort, sock_buf_size);
+  UDPClient udp_client;
+
+  const int uring_fd = uring_server.Fd();
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  UringPrepRecvMultishot(uring->GetSqe(), uring_fd, &msg, buf_ring, 0);
+  uring->Submit();
+
+  size_t recv_loop_tsc = 0;
+  size_t uring_tsc = 0;
+  for (size_t burst = 0; burst < kNumBursts; burst++) {
+    SendBurst(udp_client, kRecvLoopPort, burst * kBurst);
+    recv_loop_tsc += RecvLoop(recv_loop_server, burst * kBurst);
+    SendBurst(udp_client, kUringPort, burst * kBurst);
+    uring_tsc += UringLoop(*uring, buf_ring, uring_fd, &msg,
+                           burst * kBurst, slots);
+  }
+
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  const double num_pkts = kBurst * kNumBursts;
+  std::printf("recv loop: %.0f ns/packet, io_uring: %.0f ns/packet\n",
+              GetTime::CyclesToNs(recv_loop_tsc, freq_ghz) / num_pkts,
+              GetTime::CyclesToNs(uring_tsc, freq_ghz) / num_pkts);
+  std::free(slots);
+}
+
+/// Batches of sendmsg entries reach a UDP socket intact and in order
+TEST(TestUringTransport, BatchedSendMsg) {
+  for (bool sqpoll : {false, true}) {
+    auto uring = MakeUring(sqpoll);
+    if (uring == nullptr) {
+      continue;
+    }
+    UDPServer udp_server(kUringPort, kPayloadSize * kBurst * 4);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_in dest;
+    std::memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(kUringPort);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<uint8_t> packets(kBurst * kPayloadSize);
+    std::vector<iovec> iovs(kBurst);
+    std::vector<msghdr> msgs(kBurst);
+    for (size_t burst = 0; burst < kNumBursts / 8; burst++) {
+      for (size_t i = 0; i < kBurst; i++) {
+        uint8_t* packet = &packets[i * kPayloadSize];
+        *reinterpret_cast<size_t*>(packet) = burst * kBurst + i;
+        iovs[i] = {packet, kPayloadSize};
+        std::memset(&msgs[i], 0, sizeof(msghdr));
+        msgs[i].msg_name = &dest;
+        msgs[i].msg_namelen = sizeof(dest);
+        msgs[i].msg_iov = &iovs[i];
+        msgs[i].msg_iovlen = 1;
+        io_uring_sqe* sqe = uring->GetSqe();
+        ASSERT_NE(sqe, nullptr);
+        UringPrepSendMsg(sqe, fd, &msgs[i], i);
+      }
+      uring->SubmitAndWait(kBurst);
+
+      size_t num_done = 0;
+      while (num_done < kBurst) {
+        io_uring_cqe* cqe = uring->PeekCqe();
+        if (cqe == nullptr) {
+          uring->SubmitAndWait(1);
+          continue;
+        }
+        ASSERT_EQ(cqe->res, static_cast<int>(kPayloadSize));
+        uring->SeenCqe();
+        num_done++;
+      }
+
+      std::vector<uint8_t> rx(kPayloadSize);
+      for (size_t i = 0; i < kBurst;) {
+        if (udp_server.Recv(&rx[0], kPayloadSize) ==
+            static_cast<ssize_t>(kPayloadSize)) {
+          ASSERT_EQ(*reinterpret_cast<size_t*>(&rx[0]), burst * kBurst + i);
+          i++;
+        }
+      }
+    }
+    close(fd);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
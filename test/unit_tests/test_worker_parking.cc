@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "concurrentqueue.h"
+#include "worker_parking.h"
+
+static constexpr size_t kNumWorkers = 4;
+static constexpr size_t kSpinPolls = 1024;
+static constexpr size_t kPausePolls = 4096;
+// Long enough that only Wake() ends a park within the test
+static constexpr size_t kParkTimeoutUs = 200000;
+static constexpr size_t kNumWakeups = 200;
+static constexpr size_t kIdleMs = 200;
+
+using Clock = std::chrono::steady_clock;
+
+static double ThreadCpuMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+/// A worker that records the time from when a task was enqueued to when the
+/// worker dequeued it, and the CPU time it used
+static void WorkerLoop(moodycamel::ConcurrentQueue<Clock::time_point>* queue,
+                       WorkerParking* parking, size_t park_timeout_us,
+                       std::vector<double>* wake_latency_us,
+                       std::atomic<bool>* running, double* cpu_ms) {
+  WorkerIdler idler(parking, kSpinPolls, kPausePolls, park_timeout_us);
+  Clock::time_point enqueue_time;
+  const double cpu_start_ms = ThreadCpuMs();
+  while (running->load() == true) {
+    if (queue->try_dequeue(enqueue_time) == true) {
+      wake_latency_us->push_back(std::chrono::duration<double, std::micro>(
+                                     Clock::now() - enqueue_time)
+                                     .count());
+      idler.Busy();
+    } else {
+      idler.Idle();
+    }
+  }
+  *cpu_ms = ThreadCpuMs() - cpu_start_ms;
+}
+
+/// Wait until all workers are parked, or for timeout_ms
+static bool WaitAllParked(const WorkerParking& parking, size_t timeout_ms) {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (Clock::now() < deadline) {
+    if (parking.NumParked() == kNumWorkers) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return false;
+}
+
+TEST(TestWorkerParking, WakeLatency) {
+  moodycamel::ConcurrentQueue<Clock::time_point> queue;
+  WorkerParking parking;
+  std::atomic<bool> running(true);
+  std::vector<std::vector<double>> wake_latency_us(kNumWorkers);
+  double cpu_ms[kNumWorkers];
+  std::thread workers[kNumWorkers];
+  for (size_t i = 0; i < kNumWorkers; i++) {
+    workers[i] = std::thread(WorkerLoop, &queue, &parking, kParkTimeoutUs,
+                             &wake_latency_us.at(i), &running, &cpu_ms[i]);
+  }
+
+  size_t num_parked_wakeups = 0;
+  for (size_t i = 0; i < kNumWakeups; i++) {
+    if (WaitAllParked(parking, 100) == true) {
+      num_parked_wakeups++;
+    }
+    queue.enqueue(Clock::now());
+    parking.Wake();
+  }
+  while (queue.size_approx() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  running = false;
+  parking.Wake();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::vector<double> latency_us;
+  for (const auto& worker_latency_us : wake_latency_us) {
+    latency_us.insert(latency_us.end(), worker_latency_us.begin(),
+                      worker_latency_us.end());
+  }
+  ASSERT_EQ(latency_us.size(), kNumWakeups);
+  ASSERT_GT(num_parked_wakeups, 0);
+  std::sort(latency_us.begin(), latency_us.end());
+  const double median_us = latency_us.at(latency_us.size() / 2);
+  const double p99_us = latency_us.at(latency_us.size() * 99 / 100);
+  std::printf(
+      "Wake latency from parked workers (%zu of %zu wakeups): median %.1f us, "
+      "p99 %.1f us, max %.1f us\n",
+      num_parked_wakeups, kNumWakeups, median_us, p99_us, latency_us.back());
+  // A lost wakeup would wait for the park timeout
+  ASSERT_LT(latency_us.back(), kParkTimeoutUs / 2);
+}
+
+/// Return the average CPU utilization of idle workers in percent
+static double IdleCpuUtilization(size_t park_timeout_us) {
+  moodycamel::ConcurrentQueue<Clock::time_point> queue;
+  WorkerParking parking;
+  std::atomic<bool> running(true);
+  std::vector<std::vector<double>> wake_latency_us(kNumWorkers);
+  double cpu_ms[kNumWorkers];
+  std::thread workers[kNumWorkers];
+  for (size_t i = 0; i < kNumWorkers; i++) {
+    workers[i] = std::thread(WorkerLoop, &queue, &parking, park_timeout_us,
+                             &wake_latency_us.at(i), &running, &cpu_ms[i]);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(kIdleMs));
+  running = false;
+  parking.Wake();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  double total_cpu_ms = 0;
+  for (double worker_cpu_ms : cpu_ms) {
+    total_cpu_ms += worker_cpu_ms;
+  }
+  return 100.0 * total_cpu_ms / (kNumWorkers * kIdleMs);
+}
+
+TEST(TestWorkerParking, IdleCpuUtilization) {
+  const double spin_util = IdleCpuUtilization(0);
+  const double park_util = IdleCpuUtilization(kParkTimeoutUs);
+  std::printf("Idle worker CPU utilization: spinning %.1f%%, parked %.1f%%\n",
+              spin_util, park_util);
+  ASSERT_LT(park_util, spin_util);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,21 +14,22 @@ TEST(TestZF, Perf) {
 
   int tid = 0;
 
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffers;
-  csi_buffers.RandAllocCxFloat(cfg->BsAntNum() * cfg->OfdmDataNum());
+  PtrGrid<kMaxUEs, complex_float> csi_buffers;
+  csi_buffers.RandAllocCxFloat(cfg->FrameWnd(),
+                               cfg->BsAntNum() * cfg->OfdmDataNum());
 
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices(
-      cfg->BsAntNum() * cfg->UeNum());
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_zf_matrices(
-      cfg->UeNum() * cfg->BsAntNum());
+  PtrGrid<kMaxDataSCs, complex_float> ul_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, cfg->BsAntNum() * cfg->UeNum());
+  PtrGrid<kMaxDataSCs, complex_float> dl_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, cfg->UeNum() * cfg->BsAntNum());
 
   Table<complex_float> calib_dl_buffer;
-  calib_dl_buffer.RandAllocCxFloat(kFrameWnd,
+  calib_dl_buffer.RandAllocCxFloat(cfg->FrameWnd(),
                                    cfg->OfdmDataNum() * cfg->BsAntNum(),
                                    Agora_memory::Alignment_t::kAlign64);
 
   Table<complex_float> calib_ul_buffer;
-  calib_ul_buffer.RandAllocCxFloat(kFrameWnd,
+  calib_ul_buffer.RandAllocCxFloat(cfg->FrameWnd(),
                                    cfg->OfdmDataNum() * cfg->BsAntNum(),
                                    Agora_memory::Alignment_t::kAlign64);
 
@@ -55,6 +56,76 @@ TEST(TestZF, Perf) {
   calib_ul_buffer.Free();
 }
 
+/// Zeroforcing leaves out the antennas erased from a pilot symbol: their
+/// columns of the detector are zero, and it still inverts the channel of the
+/// other antennas
+TEST(TestZF, ErasedAntennasDropOut) {
+  static constexpr size_t kErasedAnt = 3;
+  auto cfg = std::make_unique<Config>(
+      "data/tddconfig-correctness-test-erasure-ul.json");
+  cfg->GenData();
+  ASSERT_FALSE(cfg->FreqOrthogonalPilot());
+  ASSERT_GT(cfg->BsAntNum() - 1, cfg->UeNum());
+
+  PtrGrid<kMaxUEs, complex_float> csi_buffers;
+  csi_buffers.RandAllocCxFloat(cfg->FrameWnd(),
+                               cfg->BsAntNum() * cfg->OfdmDataNum());
+  PtrGrid<kMaxDataSCs, complex_float> ul_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, cfg->BsAntNum() * cfg->UeNum());
+  PtrGrid<kMaxDataSCs, complex_float> dl_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, cfg->UeNum() * cfg->BsAntNum());
+  Table<complex_float> calib_dl_buffer;
+  calib_dl_buffer.RandAllocCxFloat(cfg->FrameWnd(),
+                                   cfg->OfdmDataNum() * cfg->BsAntNum(),
+                                   Agora_memory::Alignment_t::kAlign64);
+  Table<complex_float> calib_ul_buffer;
+  calib_ul_buffer.RandAllocCxFloat(cfg->FrameWnd(),
+                                   cfg->OfdmDataNum() * cfg->BsAntNum(),
+                                   Agora_memory::Alignment_t::kAlign64);
+  auto stats = std::make_unique<Stats>(cfg.get());
+
+  // The packet of kErasedAnt is lost for the first pilot symbol of frame 0
+  AntennaErasures erasures;
+  erasures.Init(cfg->FrameWnd(), cfg->Frame().NumTotalSyms(), cfg->BsAntNum());
+  for (size_t i = 0; i < cfg->Frame().NumPilotSyms(); i++) {
+    for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
+      if ((i > 0) || (ant_id != kErasedAnt)) {
+        erasures.MarkReceived(0, cfg->Frame().GetPilotSymbol(i), ant_id);
+      }
+    }
+  }
+  ASSERT_EQ(erasures.EraseMissing(0, cfg->Frame().GetPilotSymbol(0)).count(),
+            1);
+
+  auto compute_zf = std::make_unique<DoZF>(
+      cfg.get(), 0, csi_buffers, calib_dl_buffer, calib_ul_buffer,
+      ul_zf_matrices, dl_zf_matrices, stats.get(), &erasures);
+  compute_zf->Launch(gen_tag_t::FrmSc(0, 0).tag_);
+
+  // Subcarrier 0 of each antenna is the first of its transpose block
+  arma::cx_fmat mat_csi(cfg->BsAntNum(), cfg->UeNum());
+  for (size_t ue_id = 0; ue_id < cfg->UeNum(); ue_id++) {
+    for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
+      const complex_float csi =
+          csi_buffers[0][ue_id][kUsePartialTrans
+                                    ? ant_id * kTransposeBlockSize
+                                    : ant_id * cfg->OfdmDataNum()];
+      mat_csi(ant_id, ue_id) = arma::cx_float(csi.re, csi.im);
+    }
+  }
+  arma::cx_fmat mat_ul_zf(
+      reinterpret_cast<arma::cx_float*>(ul_zf_matrices[0][0]), cfg->UeNum(),
+      cfg->BsAntNum(), false);
+  EXPECT_EQ(arma::norm(mat_ul_zf.col(kErasedAnt)), 0.0f);
+  arma::cx_fmat identity = mat_ul_zf * mat_csi;
+  EXPECT_LT(arma::norm(identity - arma::eye<arma::cx_fmat>(cfg->UeNum(),
+                                                           cfg->UeNum())),
+            1e-3);
+
+  calib_dl_buffer.Free();
+  calib_ul_buffer.Free();
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -53,11 +53,11 @@ void MasterToWorkerDynamicWorker(
     moodycamel::ConcurrentQueue<EventData>& event_queue,
     moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
     moodycamel::ProducerToken* ptok,
-    PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+    PtrGrid<kMaxUEs, complex_float>& csi_buffers,
     Table<complex_float>& calib_dl_buffer,
     Table<complex_float>& calib_ul_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_zf_matrices,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_zf_matrices,
+    PtrGrid<kMaxDataSCs, complex_float>& ul_zf_matrices,
+    PtrGrid<kMaxDataSCs, complex_float>& dl_zf_matrices,
     Stats* stats) {
   PinToCoreWithOffset(ThreadType::kWorker, cfg->CoreOffset() + 1, worker_id);
 
@@ -117,17 +117,17 @@ TEST(TestZF, VaryingConfig) {
   Table<complex_float> calib_dl_buffer;
   Table<complex_float> calib_ul_buffer;
 
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffers;
-  csi_buffers.RandAllocCxFloat(kMaxAntennas * kMaxDataSCs);
+  PtrGrid<kMaxUEs, complex_float> csi_buffers;
+  csi_buffers.RandAllocCxFloat(cfg->FrameWnd(), kMaxAntennas * kMaxDataSCs);
 
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices(kMaxAntennas *
-                                                                kMaxUEs);
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_zf_matrices(kMaxUEs *
-                                                                kMaxAntennas);
+  PtrGrid<kMaxDataSCs, complex_float> ul_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, kMaxAntennas * kMaxUEs);
+  PtrGrid<kMaxDataSCs, complex_float> dl_zf_matrices(
+      cfg->FrameWnd(), kMaxDataSCs, kMaxUEs * kMaxAntennas);
 
-  calib_dl_buffer.RandAllocCxFloat(kFrameWnd, kMaxDataSCs * kMaxAntennas,
+  calib_dl_buffer.RandAllocCxFloat(cfg->FrameWnd(), kMaxDataSCs * kMaxAntennas,
                                    Agora_memory::Alignment_t::kAlign64);
-  calib_ul_buffer.RandAllocCxFloat(kFrameWnd, kMaxDataSCs * kMaxAntennas,
+  calib_ul_buffer.RandAllocCxFloat(cfg->FrameWnd(), kMaxDataSCs * kMaxAntennas,
                                    Agora_memory::Alignment_t::kAlign64);
 
   auto stats = std::make_unique<Stats>(cfg.get());